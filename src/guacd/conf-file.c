@@ -25,6 +25,7 @@
 
 #include <guacamole/client.h>
 #include <guacamole/mem.h>
+#include <guacamole/socket-constants.h>
 #include <guacamole/string.h>
 
 #include <errno.h>
@@ -74,6 +75,20 @@ static int guacd_conf_callback(const char* section, const char* param, const cha
             return 0;
         }
 
+        /* Metrics file */
+        else if (strcmp(param, "metrics_file") == 0) {
+            guac_mem_free(config->metrics_file);
+            config->metrics_file = guac_strdup(value);
+            return 0;
+        }
+
+        /* Trace directory */
+        else if (strcmp(param, "trace_dir") == 0) {
+            guac_mem_free(config->trace_dir);
+            config->trace_dir = guac_strdup(value);
+            return 0;
+        }
+
         /* Max log level */
         else if (strcmp(param, "log_level") == 0) {
 
@@ -91,6 +106,91 @@ static int guacd_conf_callback(const char* section, const char* param, const cha
 
         }
 
+        /* Socket output buffer size */
+        else if (strcmp(param, "socket_buffer_size") == 0) {
+
+            char* end;
+            long size = strtol(value, &end, 10);
+
+            /* Invalid buffer size */
+            if (*value == '\0' || *end != '\0'
+                    || size < GUACD_MIN_SOCKET_BUFFER_SIZE
+                    || size > GUACD_MAX_SOCKET_BUFFER_SIZE) {
+                guacd_conf_parse_error = "Invalid socket buffer size. The "
+                    "socket buffer size must be a number of bytes between "
+                    "1024 and 16777216.";
+                return 1;
+            }
+
+            /* Valid buffer size */
+            config->socket_buffer_size = size;
+            return 0;
+
+        }
+
+        /* Concurrent image encoding limit */
+        else if (strcmp(param, "encoder_threads") == 0) {
+
+            char* end;
+            long threads = strtol(value, &end, 10);
+
+            /* Invalid number of encoder threads */
+            if (*value == '\0' || *end != '\0'
+                    || threads < 0 || threads > GUACD_MAX_ENCODER_THREADS) {
+                guacd_conf_parse_error = "Invalid number of encoder threads. "
+                    "The number of encoder threads must be between 0 "
+                    "(unlimited) and 4096.";
+                return 1;
+            }
+
+            /* Valid number of encoder threads */
+            config->encoder_threads = threads;
+            return 0;
+
+        }
+
+        /* Minimum frame duration */
+        else if (strcmp(param, "min_frame_duration") == 0) {
+
+            char* end;
+            long duration = strtol(value, &end, 10);
+
+            /* Invalid frame duration */
+            if (*value == '\0' || *end != '\0'
+                    || duration < 0 || duration > GUACD_MAX_FRAME_DURATION) {
+                guacd_conf_parse_error = "Invalid minimum frame duration. "
+                    "The minimum frame duration must be a number of "
+                    "milliseconds between 0 and 1000.";
+                return 1;
+            }
+
+            /* Valid frame duration */
+            config->min_frame_duration = duration;
+            return 0;
+
+        }
+
+        /* Maximum frame duration */
+        else if (strcmp(param, "max_frame_duration") == 0) {
+
+            char* end;
+            long duration = strtol(value, &end, 10);
+
+            /* Invalid frame duration */
+            if (*value == '\0' || *end != '\0'
+                    || duration < 0 || duration > GUACD_MAX_FRAME_DURATION) {
+                guacd_conf_parse_error = "Invalid maximum frame duration. "
+                    "The maximum frame duration must be a number of "
+                    "milliseconds between 0 and 1000.";
+                return 1;
+            }
+
+            /* Valid frame duration */
+            config->max_frame_duration = duration;
+            return 0;
+
+        }
+
     }
 
     /* SSL-specific options */
@@ -184,6 +284,12 @@ guacd_config* guacd_conf_load() {
     conf->foreground = 0;
     conf->print_version = 0;
     conf->max_log_level = GUAC_LOG_INFO;
+    conf->socket_buffer_size = GUAC_SOCKET_OUTPUT_BUFFER_SIZE;
+    conf->encoder_threads = 0;
+    conf->min_frame_duration = -1;
+    conf->max_frame_duration = -1;
+    conf->metrics_file = NULL;
+    conf->trace_dir = NULL;
 
 #ifdef ENABLE_SSL
     conf->cert_file = NULL;
@@ -36,6 +36,28 @@
  */
 #define GUACD_DEFAULT_BIND_PORT "4822"
 
+/**
+ * The smallest socket output buffer size that may be configured, in bytes.
+ */
+#define GUACD_MIN_SOCKET_BUFFER_SIZE 1024
+
+/**
+ * The largest socket output buffer size that may be configured, in bytes.
+ */
+#define GUACD_MAX_SOCKET_BUFFER_SIZE 16777216
+
+/**
+ * The largest number of concurrent image encoding operations that may be
+ * configured for all connections combined.
+ */
+#define GUACD_MAX_ENCODER_THREADS 4096
+
+/**
+ * The largest minimum or maximum frame duration that may be configured, in
+ * milliseconds.
+ */
+#define GUACD_MAX_FRAME_DURATION 1000
+
 /**
  * The contents of a guacd configuration file.
  */
@@ -83,6 +105,46 @@ typedef struct guacd_config {
      */
     guac_client_log_level max_log_level;
 
+    /**
+     * The number of bytes of output to buffer for each connected user before
+     * writing to that user's socket.
+     */
+    int socket_buffer_size;
+
+    /**
+     * The maximum number of images that may be encoded concurrently across
+     * all connections, or zero if the number of concurrent encoding
+     * operations should be limited only per connection.
+     */
+    int encoder_threads;
+
+    /**
+     * The minimum amount of time that graphical updates should be coalesced
+     * into a single frame, in milliseconds, or -1 if the default minimum
+     * should be used.
+     */
+    int min_frame_duration;
+
+    /**
+     * The maximum duration of any frame, in milliseconds, or -1 if the
+     * default maximum should be used.
+     */
+    int max_frame_duration;
+
+    /**
+     * The path of the file to which the performance metrics of all
+     * connections should be periodically written, or NULL if metrics should
+     * not be collected.
+     */
+    char* metrics_file;
+
+    /**
+     * The path of the directory to which the render pipeline trace of any
+     * connection should be written when that connection's process receives
+     * SIGUSR1, or NULL if traces should not be written.
+     */
+    char* trace_dir;
+
 } guacd_config;
 
 #endif
@@ -21,6 +21,7 @@
 
 #include "connection.h"
 #include "log.h"
+#include "metrics.h"
 #include "move-fd.h"
 #include "proc.h"
 #include "proc-map.h"
@@ -328,11 +329,12 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
             /* Store process, allowing other users to join */
             guacd_proc_map_add(map, proc);
 
-            /* Wait for child to finish */
+            /* Wait for child to finish, receiving any metrics it reports */
+            guacd_metrics_receive(proc);
             waitpid(proc->pid, NULL, 0);
 
             /* Remove client */
-            if (guacd_proc_map_remove(map, proc->client->connection_id) == NULL)
+            if (guacd_metrics_remove_proc(map, proc) == NULL)
                 guacd_log(GUAC_LOG_ERROR, "Internal failure removing "
                         "client \"%s\". Client record will never be freed.",
                         proc->client->connection_id);
@@ -354,6 +356,8 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
 
         /* Clean up */
         close(proc->fd_socket);
+        if (proc->fd_metrics != -1)
+            close(proc->fd_metrics);
         guac_mem_free(proc);
 
     }
@@ -24,8 +24,11 @@
 #include "conf-file.h"
 #include "connection.h"
 #include "log.h"
+#include "metrics.h"
+#include "proc.h"
 #include "proc-map.h"
 
+#include <guacamole/display.h>
 #include <guacamole/mem.h>
 
 #ifdef ENABLE_SSL
@@ -343,11 +346,34 @@ int main(int argc, char* argv[]) {
 
     /* Init logging as early as possible */
     guacd_log_level = config->max_log_level;
+
+    /* Apply socket tuning to all future connections */
+    guacd_socket_buffer_size = config->socket_buffer_size;
+    guacd_trace_dir = config->trace_dir;
     openlog(GUACD_LOG_NAME, LOG_PID, LOG_DAEMON);
 
     /* Log start */
     guacd_log(GUAC_LOG_INFO, "Guacamole proxy daemon (guacd) version " VERSION " started");
 
+    /* Share a single image encoding budget across all future connections */
+    if (config->encoder_threads > 0) {
+
+        if (guac_display_set_encoder_budget(config->encoder_threads)) {
+            guacd_log_guac_error(GUAC_LOG_ERROR, "Unable to limit concurrent "
+                    "image encoding");
+            exit(EXIT_FAILURE);
+        }
+
+        guacd_log(GUAC_LOG_INFO, "Image encoding is limited to %i concurrent "
+                "operation(s) across all connections.", config->encoder_threads);
+
+    }
+
+    /* Apply any configured bounds on frame duration to all future
+     * connections */
+    guac_display_render_thread_set_frame_duration(config->min_frame_duration,
+            config->max_frame_duration);
+
     /* Get addresses for binding */
     if ((retval = getaddrinfo(config->bind_host, config->bind_port,
                     &hints, &addresses))) {
@@ -499,6 +525,20 @@ int main(int argc, char* argv[]) {
 
     }
 
+    /* Periodically write metrics of all connections if requested (this must
+     * happen after daemonizing, as threads do not survive fork()) */
+    if (config->metrics_file != NULL) {
+
+        if (guacd_metrics_start(map, config->metrics_file)) {
+            guacd_log(GUAC_LOG_ERROR, "Unable to start writing metrics.");
+            exit(EXIT_FAILURE);
+        }
+
+        guacd_log(GUAC_LOG_INFO, "Metrics will be written to \"%s\".",
+                config->metrics_file);
+
+    }
+
     /* Ignore SIGPIPE */
     if (signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
         guacd_log(GUAC_LOG_INFO, "Could not set handler for SIGPIPE to ignore. "
@@ -0,0 +1,644 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "log.h"
+#include "metrics.h"
+#include "proc.h"
+#include "proc-map.h"
+
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+#include <guacamole/metrics.h>
+#include <guacamole/string.h>
+#include <guacamole/timestamp.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct guacd_metrics_reporter {
+
+    /**
+     * The guac_client whose metrics are being reported.
+     */
+    guac_client* client;
+
+    /**
+     * The file descriptor of the socket used to report metrics to the main
+     * guacd process.
+     */
+    int fd;
+
+    /**
+     * The thread periodically reporting metrics.
+     */
+    pthread_t thread;
+
+    /**
+     * Mutex which must be acquired before any changes are made to the
+     * stopped flag.
+     */
+    pthread_mutex_t stopped_mutex;
+
+    /**
+     * The condition which is signalled when the stopped flag is set.
+     */
+    pthread_cond_t stopped_cond;
+
+    /**
+     * Whether the reporting thread has been requested to stop.
+     */
+    int stopped;
+
+};
+
+/**
+ * Whether metrics are being collected from connection processes.
+ */
+static int guacd_metrics_collecting = 0;
+
+/**
+ * The map of all active connection processes, as provided to
+ * guacd_metrics_start().
+ */
+static guacd_proc_map* guacd_metrics_map = NULL;
+
+/**
+ * The path of the file receiving all metrics, as provided to
+ * guacd_metrics_start().
+ */
+static char* guacd_metrics_path = NULL;
+
+/**
+ * The totals of the final metrics of all connections which are no longer
+ * active.
+ */
+static guac_metrics guacd_metrics_completed;
+
+/**
+ * Lock which is held while the metrics file is being written and while
+ * connection processes are being removed, such that the final metrics of a
+ * connection are always included in the metrics file exactly once.
+ */
+static pthread_mutex_t guacd_metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Sends the current metrics of the guac_client associated with the given
+ * reporter to the main guacd process. If the main guacd process is not
+ * keeping up with reports, the report is dropped rather than blocking.
+ *
+ * @param reporter
+ *     The reporter whose guac_client's metrics should be sent.
+ */
+static void guacd_metrics_report(guacd_metrics_reporter* reporter) {
+
+    guac_metrics snapshot;
+    guac_metrics_copy(&snapshot, reporter->client->metrics);
+
+    if (send(reporter->fd, &snapshot, sizeof(snapshot),
+                MSG_DONTWAIT | MSG_NOSIGNAL) < 0 && errno != EAGAIN)
+        guacd_log(GUAC_LOG_DEBUG, "Unable to report connection metrics: %s",
+                strerror(errno));
+
+}
+
+/**
+ * Thread which reports the metrics of a guac_client every
+ * GUACD_METRICS_INTERVAL milliseconds until requested to stop.
+ *
+ * @param data
+ *     A pointer to the guacd_metrics_reporter associated with the thread.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacd_metrics_reporter_thread(void* data) {
+
+    guacd_metrics_reporter* reporter = (guacd_metrics_reporter*) data;
+
+    pthread_mutex_lock(&reporter->stopped_mutex);
+    while (!reporter->stopped) {
+
+        /* Calculate time of next report */
+        struct timeval current_time;
+        gettimeofday(&current_time, NULL);
+
+        long usec = current_time.tv_usec + GUACD_METRICS_INTERVAL * 1000L;
+        struct timespec deadline = {
+            .tv_sec  = current_time.tv_sec + usec / 1000000,
+            .tv_nsec = (usec % 1000000) * 1000
+        };
+
+        /* Report only once the interval has elapsed without a stop request */
+        if (pthread_cond_timedwait(&reporter->stopped_cond,
+                    &reporter->stopped_mutex, &deadline) == ETIMEDOUT
+                && !reporter->stopped)
+            guacd_metrics_report(reporter);
+
+    }
+    pthread_mutex_unlock(&reporter->stopped_mutex);
+
+    return NULL;
+
+}
+
+guacd_metrics_reporter* guacd_metrics_reporter_alloc(guac_client* client,
+        int fd) {
+
+    guacd_metrics_reporter* reporter = guac_mem_zalloc(sizeof(guacd_metrics_reporter));
+    reporter->client = client;
+    reporter->fd = fd;
+
+    pthread_mutex_init(&reporter->stopped_mutex, NULL);
+    pthread_cond_init(&reporter->stopped_cond, NULL);
+
+    if (pthread_create(&reporter->thread, NULL,
+                guacd_metrics_reporter_thread, reporter)) {
+        guacd_log(GUAC_LOG_WARNING, "Unable to start reporting of "
+                "connection metrics.");
+        pthread_cond_destroy(&reporter->stopped_cond);
+        pthread_mutex_destroy(&reporter->stopped_mutex);
+        guac_mem_free(reporter);
+        return NULL;
+    }
+
+    return reporter;
+
+}
+
+void guacd_metrics_reporter_free(guacd_metrics_reporter* reporter) {
+
+    if (reporter == NULL)
+        return;
+
+    /* Stop reporting thread */
+    pthread_mutex_lock(&reporter->stopped_mutex);
+    reporter->stopped = 1;
+    pthread_cond_signal(&reporter->stopped_cond);
+    pthread_mutex_unlock(&reporter->stopped_mutex);
+    pthread_join(reporter->thread, NULL);
+
+    /* Include everything up to this point within the final report */
+    guacd_metrics_report(reporter);
+
+    pthread_cond_destroy(&reporter->stopped_cond);
+    pthread_mutex_destroy(&reporter->stopped_mutex);
+    guac_mem_free(reporter);
+
+}
+
+void guacd_metrics_receive(guacd_proc* proc) {
+
+    if (proc->fd_metrics == -1)
+        return;
+
+    guac_metrics report;
+    struct pollfd fd = {
+        .fd = proc->fd_metrics,
+        .events = POLLIN
+    };
+
+    for (;;) {
+
+        int result = poll(&fd, 1, GUACD_METRICS_INTERVAL);
+        if (result < 0 && errno != EINTR)
+            break;
+
+        /* Reports are normally received until the process closes its end of
+         * the socket, but any processes spawned by the connection process may
+         * also hold that socket open, thus the process is also periodically
+         * checked for termination. This does not reap the process if SIGCHLD
+         * has been ignored. */
+        if (result <= 0) {
+            if (waitpid(proc->pid, NULL, WNOHANG) != 0)
+                break;
+            continue;
+        }
+
+        ssize_t length = recv(proc->fd_metrics, &report, sizeof(report), 0);
+
+        /* Stop after the process closes its end of the socket */
+        if (length == 0 || (length < 0 && errno != EINTR))
+            break;
+
+        /* Ignore any malformed reports */
+        if (length != sizeof(report))
+            continue;
+
+        guac_metrics_copy(proc->client->metrics, &report);
+
+    }
+
+}
+
+guacd_proc* guacd_metrics_remove_proc(guacd_proc_map* map, guacd_proc* proc) {
+
+    pthread_mutex_lock(&guacd_metrics_lock);
+
+    guacd_proc* removed = guacd_proc_map_remove(map,
+            proc->client->connection_id);
+
+    if (removed != NULL)
+        guac_metrics_merge(&guacd_metrics_completed, removed->client->metrics);
+
+    pthread_mutex_unlock(&guacd_metrics_lock);
+
+    return removed;
+
+}
+
+/**
+ * Writes the given counter of the given guac_metrics to the given file in the
+ * Prometheus text exposition format.
+ *
+ * @param file
+ *     The file to write to.
+ *
+ * @param metrics
+ *     The guac_metrics containing the counter to write.
+ *
+ * @param counter
+ *     The counter to write.
+ *
+ * @param connection_id
+ *     The ID of the connection that the guac_metrics describes, or NULL if
+ *     the guac_metrics describes all connections.
+ */
+static void guacd_metrics_write_counter(FILE* file,
+        const guac_metrics* metrics, guac_metrics_counter counter,
+        const char* connection_id) {
+
+    const char* prefix = GUACD_METRICS_PREFIX;
+    const char* name = guac_metrics_counter_name(counter);
+
+    if (connection_id != NULL)
+        fprintf(file, "%s" GUACD_METRICS_CONNECTION_PREFIX "%s_total"
+                "{connection=\"%s\"} %" PRIu64 "\n", prefix, name,
+                connection_id, metrics->counters[counter]);
+    else
+        fprintf(file, "%s%s_total %" PRIu64 "\n", prefix, name,
+                metrics->counters[counter]);
+
+}
+
+/**
+ * Writes the given histogram of the given guac_metrics to the given file in
+ * the Prometheus text exposition format.
+ *
+ * @param file
+ *     The file to write to.
+ *
+ * @param metrics
+ *     The guac_metrics containing the histogram to write.
+ *
+ * @param histogram
+ *     The histogram to write.
+ *
+ * @param connection_id
+ *     The ID of the connection that the guac_metrics describes, or NULL if
+ *     the guac_metrics describes all connections.
+ */
+static void guacd_metrics_write_histogram(FILE* file,
+        const guac_metrics* metrics, guac_metrics_histogram histogram,
+        const char* connection_id) {
+
+    const guac_metrics_distribution* distribution =
+        &metrics->histograms[histogram];
+
+    /* Per-connection metrics are distinguished by name and label */
+    char name[256];
+    char labels[256];
+    char bucket_labels[256];
+
+    if (connection_id != NULL) {
+        snprintf(name, sizeof(name), GUACD_METRICS_PREFIX
+                GUACD_METRICS_CONNECTION_PREFIX "%s",
+                guac_metrics_histogram_name(histogram));
+        snprintf(labels, sizeof(labels), "{connection=\"%s\"}", connection_id);
+        snprintf(bucket_labels, sizeof(bucket_labels), "connection=\"%s\",",
+                connection_id);
+    }
+    else {
+        snprintf(name, sizeof(name), GUACD_METRICS_PREFIX "%s",
+                guac_metrics_histogram_name(histogram));
+        labels[0] = '\0';
+        bucket_labels[0] = '\0';
+    }
+
+    /* Prometheus histogram buckets are cumulative */
+    uint64_t cumulative = 0;
+    for (int i = 0; i < GUAC_METRICS_BUCKETS; i++) {
+
+        cumulative += distribution->buckets[i];
+
+        uint64_t bound = guac_metrics_bucket_bound(i);
+        if (bound == UINT64_MAX)
+            fprintf(file, "%s_bucket{%sle=\"+Inf\"} %" PRIu64 "\n",
+                    name, bucket_labels, cumulative);
+        else
+            fprintf(file, "%s_bucket{%sle=\"%" PRIu64 "\"} %" PRIu64 "\n",
+                    name, bucket_labels, bound, cumulative);
+
+    }
+
+    fprintf(file, "%s_sum%s %" PRIu64 "\n", name, labels, distribution->sum);
+    fprintf(file, "%s_count%s %" PRIu64 "\n", name, labels, distribution->count);
+
+}
+
+/**
+ * The state of a single update of the metrics file, shared by the callbacks
+ * invoked for each active connection process.
+ */
+typedef struct guacd_metrics_update {
+
+    /**
+     * The file being written.
+     */
+    FILE* file;
+
+    /**
+     * The totals of the metrics of all connections, both completed and
+     * active.
+     */
+    guac_metrics totals;
+
+    /**
+     * The number of active connections.
+     */
+    int connections;
+
+    /**
+     * The counter or histogram currently being written for each active
+     * connection.
+     */
+    int current;
+
+} guacd_metrics_update;
+
+/**
+ * Callback for guacd_proc_map_foreach() which adds the metrics of the given
+ * connection process to the totals of the given update.
+ *
+ * @param proc
+ *     The connection process whose metrics should be added.
+ *
+ * @param data
+ *     The guacd_metrics_update being performed.
+ */
+static void guacd_metrics_add_proc(guacd_proc* proc, void* data) {
+
+    guacd_metrics_update* update = (guacd_metrics_update*) data;
+
+    guac_metrics_merge(&update->totals, proc->client->metrics);
+    update->connections++;
+
+}
+
+/**
+ * Callback for guacd_proc_map_foreach() which writes the current counter of
+ * the given update for the given connection process.
+ *
+ * @param proc
+ *     The connection process whose counter should be written.
+ *
+ * @param data
+ *     The guacd_metrics_update being performed.
+ */
+static void guacd_metrics_write_proc_counter(guacd_proc* proc, void* data) {
+
+    guacd_metrics_update* update = (guacd_metrics_update*) data;
+
+    guac_metrics snapshot;
+    guac_metrics_copy(&snapshot, proc->client->metrics);
+
+    guacd_metrics_write_counter(update->file, &snapshot, update->current,
+            proc->client->connection_id);
+
+}
+
+/**
+ * Callback for guacd_proc_map_foreach() which writes the current histogram
+ * of the given update for the given connection process.
+ *
+ * @param proc
+ *     The connection process whose histogram should be written.
+ *
+ * @param data
+ *     The guacd_metrics_update being performed.
+ */
+static void guacd_metrics_write_proc_histogram(guacd_proc* proc, void* data) {
+
+    guacd_metrics_update* update = (guacd_metrics_update*) data;
+
+    guac_metrics snapshot;
+    guac_metrics_copy(&snapshot, proc->client->metrics);
+
+    guacd_metrics_write_histogram(update->file, &snapshot, update->current,
+            proc->client->connection_id);
+
+}
+
+/**
+ * Writes the metrics of all connections to the given file, both as totals
+ * for all connections handled by guacd and individually for each active
+ * connection.
+ *
+ * @param file
+ *     The file to write to.
+ *
+ * @param map
+ *     The map of all active connection processes.
+ */
+static void guacd_metrics_write(FILE* file, guacd_proc_map* map) {
+
+    guacd_metrics_update* update = guac_mem_zalloc(sizeof(guacd_metrics_update));
+    update->file = file;
+
+    /* Calculate totals across all connections */
+    guac_metrics_copy(&update->totals, &guacd_metrics_completed);
+    guacd_proc_map_foreach(map, guacd_metrics_add_proc, update);
+
+    fprintf(file, "# HELP " GUACD_METRICS_PREFIX "connections Number of "
+            "active connections.\n");
+    fprintf(file, "# TYPE " GUACD_METRICS_PREFIX "connections gauge\n");
+    fprintf(file, GUACD_METRICS_PREFIX "connections %i\n",
+            update->connections);
+
+    for (int i = 0; i < GUAC_METRICS_COUNTERS; i++) {
+
+        const char* name = guac_metrics_counter_name(i);
+        const char* description = guac_metrics_counter_description(i);
+
+        /* Totals for all connections */
+        fprintf(file, "# HELP " GUACD_METRICS_PREFIX "%s_total %s\n",
+                name, description);
+        fprintf(file, "# TYPE " GUACD_METRICS_PREFIX "%s_total counter\n",
+                name);
+        guacd_metrics_write_counter(file, &update->totals, i, NULL);
+
+        /* Values for each active connection */
+        fprintf(file, "# HELP " GUACD_METRICS_PREFIX
+                GUACD_METRICS_CONNECTION_PREFIX "%s_total %s\n",
+                name, description);
+        fprintf(file, "# TYPE " GUACD_METRICS_PREFIX
+                GUACD_METRICS_CONNECTION_PREFIX "%s_total counter\n", name);
+        update->current = i;
+        guacd_proc_map_foreach(map, guacd_metrics_write_proc_counter, update);
+
+    }
+
+    for (int i = 0; i < GUAC_METRICS_HISTOGRAMS; i++) {
+
+        const char* name = guac_metrics_histogram_name(i);
+        const char* description = guac_metrics_histogram_description(i);
+
+        /* Totals for all connections */
+        fprintf(file, "# HELP " GUACD_METRICS_PREFIX "%s %s\n",
+                name, description);
+        fprintf(file, "# TYPE " GUACD_METRICS_PREFIX "%s histogram\n", name);
+        guacd_metrics_write_histogram(file, &update->totals, i, NULL);
+
+        /* Values for each active connection */
+        fprintf(file, "# HELP " GUACD_METRICS_PREFIX
+                GUACD_METRICS_CONNECTION_PREFIX "%s %s\n",
+                name, description);
+        fprintf(file, "# TYPE " GUACD_METRICS_PREFIX
+                GUACD_METRICS_CONNECTION_PREFIX "%s histogram\n", name);
+        update->current = i;
+        guacd_proc_map_foreach(map, guacd_metrics_write_proc_histogram, update);
+
+    }
+
+    guac_mem_free(update);
+
+}
+
+/**
+ * Replaces the metrics file with the current metrics of all connections. The
+ * new contents are first written to a temporary file, which is then renamed
+ * over the metrics file, such that readers never observe a partial update.
+ *
+ * @param level
+ *     The level at which any failure to update the metrics file should be
+ *     logged.
+ *
+ * @return
+ *     Zero if the metrics file was updated successfully, non-zero otherwise.
+ */
+static int guacd_metrics_update_file(guac_client_log_level level) {
+
+    char temp_path[4096];
+    if (guac_strlcpy(temp_path, guacd_metrics_path, sizeof(temp_path))
+                >= sizeof(temp_path)
+            || guac_strlcat(temp_path, ".tmp", sizeof(temp_path))
+                >= sizeof(temp_path)) {
+        guacd_log(level, "Path of metrics file is too long.");
+        return 1;
+    }
+
+    FILE* file = fopen(temp_path, "w");
+    if (file == NULL) {
+        guacd_log(level, "Unable to write metrics file \"%s\": %s",
+                temp_path, strerror(errno));
+        return 1;
+    }
+
+    pthread_mutex_lock(&guacd_metrics_lock);
+    guacd_metrics_write(file, guacd_metrics_map);
+    pthread_mutex_unlock(&guacd_metrics_lock);
+
+    if (fclose(file)) {
+        guacd_log(level, "Unable to write metrics file \"%s\": %s",
+                temp_path, strerror(errno));
+        unlink(temp_path);
+        return 1;
+    }
+
+    if (rename(temp_path, guacd_metrics_path)) {
+        guacd_log(level, "Unable to replace metrics file \"%s\": %s",
+                guacd_metrics_path, strerror(errno));
+        unlink(temp_path);
+        return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Thread which updates the metrics file every GUACD_METRICS_INTERVAL
+ * milliseconds for the life of guacd.
+ *
+ * @param data
+ *     Unused.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacd_metrics_thread(void* data) {
+
+    int failed = 0;
+
+    for (;;) {
+
+        /* Log only the first of any consecutive failures as an error */
+        failed = guacd_metrics_update_file(failed ? GUAC_LOG_DEBUG
+                : GUAC_LOG_ERROR);
+
+        guac_timestamp_msleep(GUACD_METRICS_INTERVAL);
+
+    }
+
+    return NULL;
+
+}
+
+int guacd_metrics_start(guacd_proc_map* map, const char* path) {
+
+    guacd_metrics_map = map;
+    guacd_metrics_path = guac_strdup(path);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, guacd_metrics_thread, NULL)) {
+        guac_mem_free(guacd_metrics_path);
+        return 1;
+    }
+
+    pthread_detach(thread);
+    guacd_metrics_collecting = 1;
+    return 0;
+
+}
+
+int guacd_metrics_enabled() {
+    return guacd_metrics_collecting;
+}
+
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACD_METRICS_H
+#define GUACD_METRICS_H
+
+#include "config.h"
+#include "proc.h"
+#include "proc-map.h"
+
+#include <guacamole/client.h>
+
+/**
+ * The number of milliseconds between each report of the performance metrics
+ * of a connection from its process to the main guacd process, and between
+ * each update of the metrics file.
+ */
+#define GUACD_METRICS_INTERVAL 1000
+
+/**
+ * The prefix of the names of all metrics written to the metrics file.
+ */
+#define GUACD_METRICS_PREFIX "guacd_"
+
+/**
+ * The prefix of the names of all per-connection metrics written to the
+ * metrics file, following GUACD_METRICS_PREFIX.
+ */
+#define GUACD_METRICS_CONNECTION_PREFIX "connection_"
+
+/**
+ * The state of the thread which periodically reports the performance metrics
+ * of the connection handled by a guacd process to the main guacd process.
+ */
+typedef struct guacd_metrics_reporter guacd_metrics_reporter;
+
+/**
+ * Starts periodically writing the performance metrics of all connections to
+ * the given file in the Prometheus text exposition format, such that the file
+ * may be read by the textfile collector of the Prometheus node exporter. The
+ * file is replaced atomically with each update. Metrics are reported by
+ * connection processes only if this function has been called successfully
+ * before those processes are created. This function must be called by the
+ * main guacd process after that process has finished daemonizing.
+ *
+ * @param map
+ *     The map of all active connection processes.
+ *
+ * @param path
+ *     The path of the file that should receive all metrics.
+ *
+ * @return
+ *     Zero if metrics will be written to the given file, non-zero if the
+ *     thread writing those metrics could not be started.
+ */
+int guacd_metrics_start(guacd_proc_map* map, const char* path);
+
+/**
+ * Returns whether metrics are being collected from connection processes, as
+ * requested through a successful call to guacd_metrics_start().
+ *
+ * @return
+ *     Non-zero if metrics are being collected, zero otherwise.
+ */
+int guacd_metrics_enabled();
+
+/**
+ * Receives the performance metrics reported by the given connection process,
+ * storing those metrics within the skeleton guac_client of that process,
+ * until the process terminates. This function must be called by the main
+ * guacd process, and returns immediately if metrics are not being collected.
+ *
+ * @param proc
+ *     The connection process to receive metrics from.
+ */
+void guacd_metrics_receive(guacd_proc* proc);
+
+/**
+ * Removes the given connection process from the given map, as
+ * guacd_proc_map_remove() would, while adding the final metrics of that
+ * process to the totals for all connections. Removal and addition occur
+ * atomically with respect to the metrics file, such that the totals written
+ * to that file never decrease.
+ *
+ * @param map
+ *     The map to remove the connection process from.
+ *
+ * @param proc
+ *     The connection process to remove.
+ *
+ * @return
+ *     The removed connection process, or NULL if the process was not present
+ *     within the given map.
+ */
+guacd_proc* guacd_metrics_remove_proc(guacd_proc_map* map, guacd_proc* proc);
+
+/**
+ * Starts a thread which periodically reports the performance metrics of the
+ * given guac_client to the main guacd process using the given socket. This
+ * function must be called by the connection process.
+ *
+ * @param client
+ *     The guac_client whose metrics should be reported.
+ *
+ * @param fd
+ *     The file descriptor of the connection process end of the socket used
+ *     to report metrics, as stored within the fd_metrics member of
+ *     guacd_proc.
+ *
+ * @return
+ *     A newly-allocated guacd_metrics_reporter, or NULL if the reporting
+ *     thread could not be started.
+ */
+guacd_metrics_reporter* guacd_metrics_reporter_alloc(guac_client* client,
+        int fd);
+
+/**
+ * Stops the given reporting thread, sending one final report containing the
+ * current metrics of the guac_client associated with that thread, and frees
+ * the guacd_metrics_reporter. This function must be called before that
+ * guac_client is freed. If NULL is provided, this function has no effect.
+ *
+ * @param reporter
+ *     The guacd_metrics_reporter to stop and free.
+ */
+void guacd_metrics_reporter_free(guacd_metrics_reporter* reporter);
+
+#endif
+
@@ -20,30 +20,41 @@
 #include "config.h"
 
 #include "log.h"
+#include "metrics.h"
 #include "move-fd.h"
 #include "proc.h"
 #include "proc-map.h"
 
 #include <guacamole/client.h>
+#include <guacamole/display.h>
 #include <guacamole/error.h>
 #include <guacamole/mem.h>
 #include <guacamole/parser.h>
 #include <guacamole/plugin.h>
 #include <guacamole/protocol.h>
 #include <guacamole/socket.h>
+#include <guacamole/trace.h>
 #include <guacamole/user.h>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 
+int guacd_socket_buffer_size = GUAC_SOCKET_OUTPUT_BUFFER_SIZE;
+
+const char* guacd_trace_dir = NULL;
+
 /**
  * Parameters for the user thread.
  */
@@ -85,7 +96,8 @@ static void* guacd_user_thread(void* data) {
     guac_client* client = proc->client;
 
     /* Get guac_socket for user's file descriptor */
-    guac_socket* socket = guac_socket_open(params->fd);
+    guac_socket* socket = guac_socket_open_buffered(params->fd,
+            guacd_socket_buffer_size);
     if (socket == NULL)
         return NULL;
 
@@ -308,6 +320,40 @@ static void signal_stop_handler(int signal) {
 
 }
 
+/**
+ * The path of the file that the render pipeline trace of the current guacd
+ * process should be written to when SIGUSR1 is received. This is determined
+ * in advance, as the signal handler may only invoke async-signal-safe
+ * functions.
+ */
+static char guacd_trace_path[PATH_MAX];
+
+/**
+ * A signal handler that will be invoked when a signal is caught requesting
+ * that the render pipeline trace of this guacd process be written to
+ * guacd_trace_path, replacing any previously-written trace.
+ *
+ * @param signal
+ *     The signal that was received. Unused in this function since only
+ *     signals that should result in writing the trace should invoke this.
+ */
+static void signal_trace_handler(int signal) {
+
+    /* Preserve errno for whatever code was interrupted */
+    int saved_errno = errno;
+
+    int fd = open(guacd_trace_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            S_IRUSR | S_IWUSR);
+
+    if (fd != -1) {
+        guac_trace_dump(fd);
+        close(fd);
+    }
+
+    errno = saved_errno;
+
+}
+
 /**
  * Starts protocol-specific handling on the given process by loading the client
  * plugin for that protocol. This function does NOT return. It initializes the
@@ -325,6 +371,7 @@ static void signal_stop_handler(int signal) {
 static void guacd_exec_proc(guacd_proc* proc, const char* protocol) {
 
     int result = 1;
+    guacd_metrics_reporter* reporter = NULL;
    
     /* Set process group ID to match PID */ 
     if (setpgid(0, 0)) {
@@ -354,6 +401,10 @@ static void guacd_exec_proc(guacd_proc* proc, const char* protocol) {
     /* Enable keep alive on the broadcast socket */
     guac_socket_require_keep_alive(client->socket);
 
+    /* Report performance metrics to parent if requested */
+    if (proc->fd_metrics != -1)
+        reporter = guacd_metrics_reporter_alloc(client, proc->fd_metrics);
+
     guacd_proc_self = proc;
 
     /* Clean up and exit if SIGINT or SIGTERM signals are caught */
@@ -361,6 +412,30 @@ static void guacd_exec_proc(guacd_proc* proc, const char* protocol) {
     sigaction(SIGINT, &signal_stop_action, NULL);
     sigaction(SIGTERM, &signal_stop_action, NULL);
 
+    /* Write the render pipeline trace of the connection if SIGUSR1 is
+     * caught */
+    if (guacd_trace_dir != NULL) {
+
+        int length = snprintf(guacd_trace_path, sizeof(guacd_trace_path),
+                "%s/%s.trace", guacd_trace_dir, client->connection_id);
+
+        if (length >= 0 && length < sizeof(guacd_trace_path)) {
+            struct sigaction signal_trace_action = {
+                .sa_handler = signal_trace_handler,
+                .sa_flags = SA_RESTART
+            };
+            sigaction(SIGUSR1, &signal_trace_action, NULL);
+            guacd_log(GUAC_LOG_DEBUG, "Render pipeline trace of this "
+                    "connection will be written to \"%s\" upon SIGUSR1.",
+                    guacd_trace_path);
+        }
+        else
+            guacd_log(GUAC_LOG_WARNING, "Path of render pipeline trace is "
+                    "too long. Traces will not be written for this "
+                    "connection.");
+
+    }
+
     /* Add each received file descriptor as a new user */
     int received_fd;
     while ((received_fd = guacd_recv_fd(proc->fd_socket)) != -1) {
@@ -377,6 +452,9 @@ cleanup_client:
     /* Request client to stop/disconnect */
     guac_client_stop(client);
 
+    /* Send final metrics to parent while the client still exists */
+    guacd_metrics_reporter_free(reporter);
+
     /* Attempt to free client cleanly */
     guacd_log(GUAC_LOG_DEBUG, "Requesting termination of client...");
     result = guacd_timed_client_free(client, GUACD_CLIENT_FREE_TIMEOUT);
@@ -410,12 +488,36 @@ cleanup_process:
 
     /* Free up all internal resources outside the client */
     close(proc->fd_socket);
+    if (proc->fd_metrics != -1)
+        close(proc->fd_metrics);
     guac_mem_free(proc);
 
     exit(result);
 
 }
 
+/**
+ * Closes both ends of the socket pair used for reporting metrics, if that
+ * socket pair was opened.
+ *
+ * @param parent_metrics
+ *     The file descriptor of the parent end of the socket pair, or -1 if the
+ *     socket pair was not opened.
+ *
+ * @param child_metrics
+ *     The file descriptor of the child end of the socket pair, or -1 if the
+ *     socket pair was not opened.
+ */
+static void guacd_close_metrics_sockets(int parent_metrics, int child_metrics) {
+
+    if (parent_metrics != -1)
+        close(parent_metrics);
+
+    if (child_metrics != -1)
+        close(child_metrics);
+
+}
+
 guacd_proc* guacd_create_proc(const char* protocol) {
 
     int sockets[2];
@@ -429,11 +531,27 @@ guacd_proc* guacd_create_proc(const char* protocol) {
     int parent_socket = sockets[0];
     int child_socket = sockets[1];
 
+    /* Open separate UNIX socket pair for reporting metrics, if requested. A
+     * SOCK_SEQPACKET socket preserves the boundaries of each report while
+     * also allowing the parent to detect when the child closes its end. */
+    int parent_metrics = -1;
+    int child_metrics = -1;
+    if (guacd_metrics_enabled()) {
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) < 0)
+            guacd_log(GUAC_LOG_WARNING, "Metrics will not be collected for "
+                    "this connection: %s", strerror(errno));
+        else {
+            parent_metrics = sockets[0];
+            child_metrics = sockets[1];
+        }
+    }
+
     /* Allocate process */
     guacd_proc* proc = guac_mem_zalloc(sizeof(guacd_proc));
     if (proc == NULL) {
         close(parent_socket);
         close(child_socket);
+        guacd_close_metrics_sockets(parent_metrics, child_metrics);
         return NULL;
     }
 
@@ -443,6 +561,7 @@ guacd_proc* guacd_create_proc(const char* protocol) {
         guacd_log_guac_error(GUAC_LOG_ERROR, "Unable to create client");
         close(parent_socket);
         close(child_socket);
+        guacd_close_metrics_sockets(parent_metrics, child_metrics);
         guac_mem_free(proc);
         return NULL;
     }
@@ -450,12 +569,18 @@ guacd_proc* guacd_create_proc(const char* protocol) {
     /* Init logging */
     proc->client->log_handler = guacd_client_log;
 
+    /* Track any image encoder slots held by the child separately from those
+     * of all other connections */
+    proc->encoder_lease = guac_display_open_encoder_lease();
+
     /* Fork */
     proc->pid = fork();
     if (proc->pid < 0) {
         guacd_log(GUAC_LOG_ERROR, "Cannot fork child process: %s", strerror(errno));
+        guac_display_close_encoder_lease(proc->encoder_lease);
         close(parent_socket);
         close(child_socket);
+        guacd_close_metrics_sockets(parent_metrics, child_metrics);
         guac_client_free(proc->client);
         guac_mem_free(proc);
         return NULL;
@@ -468,6 +593,12 @@ guacd_proc* guacd_create_proc(const char* protocol) {
         proc->fd_socket = parent_socket;
         close(child_socket);
 
+        proc->fd_metrics = parent_metrics;
+        if (child_metrics != -1)
+            close(child_metrics);
+
+        guac_display_use_encoder_lease(proc->encoder_lease);
+
         /* Start protocol-specific handling */
         guacd_exec_proc(proc, protocol);
 
@@ -480,6 +611,10 @@ guacd_proc* guacd_create_proc(const char* protocol) {
         proc->fd_socket = child_socket;
         close(parent_socket);
 
+        proc->fd_metrics = child_metrics;
+        if (parent_metrics != -1)
+            close(parent_metrics);
+
     }
 
     return proc;
@@ -511,6 +646,9 @@ static void guacd_proc_kill(guacd_proc* proc) {
     guacd_log(GUAC_LOG_DEBUG, "All child processes for connection \"%s\" have been terminated.",
         proc->client->connection_id);
 
+    /* Release any image encoder slots abandoned by those processes */
+    guac_display_close_encoder_lease(proc->encoder_lease);
+
 }
 
 void guacd_proc_stop(guacd_proc* proc) {
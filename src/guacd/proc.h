@@ -25,6 +25,7 @@
 #include <guacamole/client.h>
 #include <guacamole/parser.h>
 
+#include <stdint.h>
 #include <unistd.h>
 
 /**
@@ -48,6 +49,19 @@
  */
 #define GUACD_CLIENT_FREE_TIMEOUT 5
 
+/**
+ * The number of bytes of output to buffer for each user before writing to
+ * that user's socket, as configured via guacd.conf.
+ */
+extern int guacd_socket_buffer_size;
+
+/**
+ * The path of the directory to which the render pipeline trace of each
+ * connection process should be written upon receiving SIGUSR1, as configured
+ * via guacd.conf, or NULL if traces should not be written.
+ */
+extern const char* guacd_trace_dir;
+
 /**
  * Process information of the internal remote desktop client.
  */
@@ -67,6 +81,24 @@ typedef struct guacd_proc {
      */
     int fd_socket;
 
+    /**
+     * The file descriptor of the UNIX domain socket used by the child process
+     * to report the performance metrics of its client to the parent process,
+     * or -1 if metrics are not being collected. This parent will see this as
+     * the file descriptor for receiving metrics from the child and vice
+     * versa.
+     */
+    int fd_metrics;
+
+    /**
+     * The lease of the shared image encoding budget used by the child
+     * process, as returned by guac_display_open_encoder_lease(), or zero if
+     * no such budget has been established. The parent process closes this
+     * lease once all processes of the connection have terminated, releasing
+     * anything the child process still held.
+     */
+    uint64_t encoder_lease;
+
     /**
      * The actual client instance. This will be visible to both child and
      * parent process, but only the child will have a full guac_client
@@ -25,61 +25,141 @@
 #include <guacamole/client.h>
 #include <guacamole/error.h>
 #include <guacamole/parser.h>
-#include <guacamole/socket.h>
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <string.h>
 #include <unistd.h>
 
 /**
- * Reads and handles all Guacamole instructions from the given guac_socket
- * until end-of-stream is reached.
+ * The number of bytes of the memory-mapped recording which must have been
+ * processed before the pages containing those bytes are released. The parser
+ * writes to each page it parses, and thus each such page becomes a private
+ * copy that would otherwise remain resident until the file is unmapped.
+ */
+#define GUACENC_RELEASE_INTERVAL 1048576
+
+/**
+ * Releases the pages of the given memory-mapped recording which lie entirely
+ * before the given offset and have not yet been released, provided at least
+ * GUACENC_RELEASE_INTERVAL bytes have been processed since pages were last
+ * released. No data within released pages may be referenced afterward.
+ *
+ * @param mapped
+ *     The start of the memory-mapped recording.
+ *
+ * @param released
+ *     A pointer to the offset of the first byte of the recording that has not
+ *     yet been released. This value is updated if pages are released.
+ *
+ * @param processed
+ *     The offset of the first byte of the recording that has not yet been
+ *     processed.
+ */
+static void guacenc_release_processed(char* mapped, size_t* released,
+        size_t processed) {
+
+    if (processed - *released < GUACENC_RELEASE_INTERVAL)
+        return;
+
+    /* Release only whole pages */
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t end = processed - processed % page_size;
+
+    madvise(mapped + *released, end - *released, MADV_DONTNEED);
+    *released = end;
+
+}
+
+/**
+ * Reads and handles all Guacamole instructions from the given file until
+ * end-of-file is reached. The file is memory-mapped and each instruction is
+ * parsed in place, without first being copied into a separate buffer.
  *
  * @param display
  *     The current internal display of the Guacamole video encoder.
  *
  * @param path
  *     The name of the file being parsed (for logging purposes). This file
- *     must already be open and available through the given socket.
+ *     must already be open and available through the given file descriptor.
  *
- * @param socket
- *     The guac_socket through which instructions should be read.
+ * @param fd
+ *     The file descriptor of the open file being parsed.
  *
  * @return
- *     Zero on success, non-zero if parsing of Guacamole protocol data through
- *     the given socket fails.
+ *     Zero on success, non-zero if the file cannot be mapped or parsing of
+ *     Guacamole protocol data within the file fails.
  */
 static int guacenc_read_instructions(guacenc_display* display,
-        const char* path, guac_socket* socket) {
+        const char* path, int fd) {
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat)) {
+        guacenc_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* Empty files contain no instructions (and cannot be mapped) */
+    size_t remaining = file_stat.st_size;
+    if (remaining == 0)
+        return 0;
+
+    /* Map a private, writable copy of the file, as the parser NULL-terminates
+     * each element in place. Pages are released once processed, such that
+     * only the unprocessed remainder of the file is ever privately copied. */
+    char* mapped = mmap(NULL, remaining, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+            fd, 0);
+    if (mapped == MAP_FAILED) {
+        guacenc_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* The file will be read exactly once, from beginning to end */
+    madvise(mapped, remaining, MADV_SEQUENTIAL);
 
     /* Obtain Guacamole protocol parser */
     guac_parser* parser = guac_parser_alloc();
-    if (parser == NULL)
+    if (parser == NULL) {
+        munmap(mapped, file_stat.st_size);
         return 1;
+    }
 
     /* Continuously read and handle all instructions */
-    while (!guac_parser_read(parser, socket, -1)) {
+    int length;
+    size_t released = 0;
+    char* current = mapped;
+    while ((length = guac_parser_read_buffer(parser, current,
+                    remaining > INT_MAX ? INT_MAX : remaining)) > 0) {
+
         if (guacenc_handle_instruction(display, parser->opcode,
                 parser->argc, parser->argv)) {
             guacenc_log(GUAC_LOG_DEBUG, "Handling of \"%s\" instruction "
                     "failed.", parser->opcode);
         }
+
+        current += length;
+        remaining -= length;
+
+        guacenc_release_processed(mapped, &released, current - mapped);
+
     }
 
-    /* Fail on read/parse error */
+    guac_parser_free(parser);
+    munmap(mapped, file_stat.st_size);
+
+    /* Fail on parse error */
     if (guac_error != GUAC_STATUS_CLOSED) {
         guacenc_log(GUAC_LOG_ERROR, "%s: %s",
                 path, guac_status_string(guac_error));
-        guac_parser_free(parser);
         return 1;
     }
 
     /* Parse complete */
-    guac_parser_free(parser);
     return 0;
 
 }
@@ -129,27 +209,18 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
         return 1;
     }
 
-    /* Obtain guac_socket wrapping file descriptor */
-    guac_socket* socket = guac_socket_open(fd);
-    if (socket == NULL) {
-        guacenc_log(GUAC_LOG_ERROR, "%s: %s", path,
-                guac_status_string(guac_error));
-        close(fd);
-        guacenc_display_free(display);
-        return 1;
-    }
-
     guacenc_log(GUAC_LOG_INFO, "Encoding \"%s\" to \"%s\" ...", path, out_path);
 
     /* Attempt to read all instructions in the file */
-    if (guacenc_read_instructions(display, path, socket)) {
-        guac_socket_free(socket);
+    int failed = guacenc_read_instructions(display, path, fd);
+    close(fd);
+
+    if (failed) {
         guacenc_display_free(display);
         return 1;
     }
 
-    /* Close input and finish encoding process */
-    guac_socket_free(socket);
+    /* Finish encoding process */
     return guacenc_display_free(display);
 
 }
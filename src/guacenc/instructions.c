@@ -23,8 +23,9 @@
 #include "log.h"
 
 #include <guacamole/client.h>
+#include <guacamole/opcode.h>
 
-#include <string.h>
+#include <pthread.h>
 
 guacenc_instruction_handler_mapping guacenc_instruction_handler_map[] = {
     {"blob",     guacenc_handle_blob},
@@ -44,31 +45,51 @@ guacenc_instruction_handler_mapping guacenc_instruction_handler_map[] = {
     {NULL,       NULL}
 };
 
+/**
+ * Index of all opcodes within guacenc_instruction_handler_map.
+ */
+static guac_opcode_index guacenc_instruction_handler_index;
+
+/**
+ * Control object which ensures guacenc_instruction_handler_index is built
+ * exactly once.
+ */
+static pthread_once_t guacenc_instruction_handler_index_init = PTHREAD_ONCE_INIT;
+
+/**
+ * Builds guacenc_instruction_handler_index. This function is invoked once, via
+ * pthread_once(), prior to the first lookup of any handler.
+ */
+static void guacenc_build_instruction_handler_index(void) {
+    guac_opcode_index_init(&guacenc_instruction_handler_index,
+            guacenc_instruction_handler_map,
+            sizeof(guacenc_instruction_handler_mapping));
+}
+
 int guacenc_handle_instruction(guacenc_display* display, const char* opcode,
         int argc, char** argv) {
 
-    /* Search through mapping for instruction handler having given opcode */
-    guacenc_instruction_handler_mapping* current = guacenc_instruction_handler_map;
-    while (current->opcode != NULL) {
-
-        /* Invoke handler if opcode matches (if defined) */
-        if (strcmp(current->opcode, opcode) == 0) {
+    pthread_once(&guacenc_instruction_handler_index_init,
+            guacenc_build_instruction_handler_index);
 
-            /* Invoke defined handler */
-            guacenc_instruction_handler* handler = current->handler;
-            if (handler != NULL)
-                return handler(display, argc, argv);
+    /* Look up instruction handler having given opcode */
+    const guacenc_instruction_handler_mapping* mapping =
+        guac_opcode_index_lookup(&guacenc_instruction_handler_index,
+                guacenc_instruction_handler_map,
+                sizeof(guacenc_instruction_handler_mapping), opcode);
 
-            /* Log defined but unimplemented instructions */
-            guacenc_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
-            return 0;
+    if (mapping != NULL) {
 
-        }
+        /* Invoke defined handler */
+        guacenc_instruction_handler* handler = mapping->handler;
+        if (handler != NULL)
+            return handler(display, argc, argv);
 
-        /* Next candidate handler */
-        current++;
+        /* Log defined but unimplemented instructions */
+        guacenc_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
+        return 0;
 
-    } /* end opcode search */
+    }
 
     /* Ignore any unknown instructions */
     return 0;
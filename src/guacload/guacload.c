@@ -0,0 +1,317 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacload.h"
+#include "log.h"
+#include "session.h"
+#include "stats.h"
+
+#include <guacamole/mem.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Runs a single simulated session within a new child process, as guacd runs
+ * each connection within its own process. The statistics describing the
+ * session are written to a pipe once the session has completed.
+ *
+ * @param options
+ *     The options controlling the session.
+ *
+ * @param pid
+ *     Pointer to a pid_t which should receive the process ID of the child
+ *     process.
+ *
+ * @return
+ *     The file descriptor of the read end of the pipe which will receive the
+ *     statistics describing the session, or -1 if the child process could
+ *     not be created.
+ */
+static int guacload_spawn_session(const guacload_options* options, pid_t* pid) {
+
+    int fds[2];
+    if (pipe(fds)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to create pipe: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    *pid = fork();
+    if (*pid < 0) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to fork: %s", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    /* Parent process receives statistics */
+    if (*pid > 0) {
+        close(fds[1]);
+        return fds[0];
+    }
+
+    /* Child process runs session and writes statistics */
+    close(fds[0]);
+
+    guacload_stats* stats = guac_mem_zalloc(sizeof(guacload_stats));
+    guacload_session_run(options, stats);
+
+    const char* buffer = (const char*) stats;
+    size_t remaining = sizeof(guacload_stats);
+    while (remaining > 0) {
+
+        ssize_t written = write(fds[1], buffer, remaining);
+        if (written <= 0)
+            _exit(1);
+
+        buffer += written;
+        remaining -= written;
+
+    }
+
+    _exit(0);
+
+}
+
+/**
+ * Reads the statistics written by a child process created with
+ * guacload_spawn_session(), merging those statistics into the given
+ * statistics.
+ *
+ * @param fd
+ *     The file descriptor returned by guacload_spawn_session().
+ *
+ * @param pid
+ *     The process ID of the child process.
+ *
+ * @param stats
+ *     The statistics to merge the statistics of the session into.
+ */
+static void guacload_collect_session(int fd, pid_t pid, guacload_stats* stats) {
+
+    guacload_stats* session = guac_mem_zalloc(sizeof(guacload_stats));
+
+    char* buffer = (char*) session;
+    size_t remaining = sizeof(guacload_stats);
+    while (remaining > 0) {
+
+        ssize_t received = read(fd, buffer, remaining);
+        if (received <= 0)
+            break;
+
+        buffer += received;
+        remaining -= received;
+
+    }
+
+    /* Consider the session failed if it did not report its results */
+    if (remaining > 0) {
+        memset(session, 0, sizeof(guacload_stats));
+        session->sessions = 1;
+        session->failures = 1;
+    }
+
+    guacload_stats_merge(stats, session);
+    guac_mem_free(session);
+
+    close(fd);
+    waitpid(pid, NULL, 0);
+
+}
+
+/**
+ * Runs the given number of concurrent simulated sessions, writing the
+ * combined statistics of all sessions to STDOUT.
+ *
+ * @param options
+ *     The options controlling each session.
+ *
+ * @param sessions
+ *     The number of sessions to run concurrently.
+ *
+ * @return
+ *     Zero if all sessions ran successfully, non-zero otherwise.
+ */
+static int guacload_run(const guacload_options* options, int sessions) {
+
+    guacload_log(GUAC_LOG_INFO, "Running %i concurrent session(s) for %i "
+            "second(s) ...", sessions, options->duration);
+
+    int* fds = guac_mem_alloc(sizeof(int), sessions);
+    pid_t* pids = guac_mem_alloc(sizeof(pid_t), sessions);
+
+    /* Sessions which could not be started are counted as failures */
+    guacload_stats* stats = guac_mem_zalloc(sizeof(guacload_stats));
+
+    /* Child processes must not inherit unwritten output */
+    fflush(stdout);
+
+    for (int i = 0; i < sessions; i++) {
+        fds[i] = guacload_spawn_session(options, &pids[i]);
+        if (fds[i] < 0) {
+            stats->sessions++;
+            stats->failures++;
+        }
+    }
+
+    for (int i = 0; i < sessions; i++) {
+        if (fds[i] >= 0)
+            guacload_collect_session(fds[i], pids[i], stats);
+    }
+
+    guacload_stats_write(stats, stdout);
+
+    int failures = stats->failures;
+    if (failures)
+        guacload_log(GUAC_LOG_WARNING, "%i of %i session(s) failed.",
+                failures, sessions);
+
+    guac_mem_free(stats);
+    guac_mem_free(pids);
+    guac_mem_free(fds);
+
+    return failures != 0;
+
+}
+
+int main(int argc, char* argv[]) {
+
+    /* Load defaults */
+    guacload_options options = {
+        .duration = GUACLOAD_DEFAULT_DURATION,
+        .latency = 0,
+        .speed = 100
+    };
+
+    const char* session_counts = "1";
+
+    /* Parse arguments */
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:l:s:v")) != -1) {
+
+        /* -n: Comma-separated list of concurrent session counts */
+        if (opt == 'n')
+            session_counts = optarg;
+
+        /* -d: Duration of each run, in seconds */
+        else if (opt == 'd') {
+            options.duration = atoi(optarg);
+            if (options.duration <= 0) {
+                guacload_log(GUAC_LOG_ERROR, "Invalid duration: \"%s\"",
+                        optarg);
+                goto invalid_options;
+            }
+        }
+
+        /* -l: Simulated client latency, in milliseconds */
+        else if (opt == 'l') {
+            options.latency = atoi(optarg);
+            if (options.latency < 0) {
+                guacload_log(GUAC_LOG_ERROR, "Invalid latency: \"%s\"",
+                        optarg);
+                goto invalid_options;
+            }
+        }
+
+        /* -s: Replay speed, as a percentage */
+        else if (opt == 's') {
+            options.speed = atoi(optarg);
+            if (options.speed < 0) {
+                guacload_log(GUAC_LOG_ERROR, "Invalid speed: \"%s\"",
+                        optarg);
+                goto invalid_options;
+            }
+        }
+
+        /* -v: Verbose logging (including log messages from each session) */
+        else if (opt == 'v')
+            guacload_log_level = GUAC_LOG_INFO;
+
+        /* Invalid option */
+        else {
+            goto invalid_options;
+        }
+
+    }
+
+    /* Exactly one recording must be given */
+    if (argc - optind != 1)
+        goto invalid_options;
+
+    options.recording_path = argv[optind];
+
+    /* Log start */
+    guacload_log(GUAC_LOG_INFO, "Guacamole load generator (guacload) "
+            "version " VERSION);
+
+    /* Ignore SIGPIPE, as guacd does, such that each session can detect its
+     * connection closing */
+    if (signal(SIGPIPE, SIG_IGN) == SIG_ERR)
+        guacload_log(GUAC_LOG_WARNING, "Could not set handler for SIGPIPE to "
+                "ignore. SIGPIPE may cause sessions to terminate abnormally.");
+
+    printf("# guacload %s latency=%ims speed=%i%% duration=%is\n",
+            options.recording_path, options.latency, options.speed,
+            options.duration);
+
+    /* Run each requested number of concurrent sessions in turn */
+    int failed = 0;
+    const char* current = session_counts;
+    while (*current != '\0') {
+
+        char* end;
+        long sessions = strtol(current, &end, 10);
+        if (end == current || sessions <= 0 || (*end != ',' && *end != '\0')) {
+            guacload_log(GUAC_LOG_ERROR, "Invalid session count list: \"%s\"",
+                    session_counts);
+            goto invalid_options;
+        }
+
+        failed |= guacload_run(&options, sessions);
+
+        current = (*end == ',') ? end + 1 : end;
+
+    }
+
+    return failed;
+
+    /* Display usage and exit with error if options are invalid */
+invalid_options:
+
+    fprintf(stderr, "USAGE: %s"
+            " [-n SESSIONS[,SESSIONS...]]"
+            " [-d SECONDS]"
+            " [-l LATENCY]"
+            " [-s SPEED]"
+            " [-v]"
+            " RECORDING\n", argv[0]);
+
+    return 1;
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOAD_H
+#define GUACLOAD_H
+
+#include "config.h"
+
+/**
+ * The default log level below which no messages should be logged. Each
+ * simulated session is a complete connection, and logging its routine
+ * progress at the usual level would bury the results.
+ */
+#define GUACLOAD_DEFAULT_LOG_LEVEL GUAC_LOG_WARNING
+
+/**
+ * The default number of seconds that each set of concurrent sessions should
+ * run for.
+ */
+#define GUACLOAD_DEFAULT_DURATION 10
+
+/**
+ * The name of the protocol plugin which replays recordings. This plugin is
+ * loaded with guac_client_load_plugin() exactly as guacd would load any other
+ * protocol, and thus must be installed or otherwise present on the library
+ * search path.
+ */
+#define GUACLOAD_PROTOCOL "replay"
+
+/**
+ * The options controlling each simulated session.
+ */
+typedef struct guacload_options {
+
+    /**
+     * The path of the session recording to replay within each session.
+     */
+    const char* recording_path;
+
+    /**
+     * The number of seconds that each session should run for.
+     */
+    int duration;
+
+    /**
+     * The number of milliseconds that each simulated client should wait
+     * after receiving a frame before acknowledging that frame, simulating
+     * network and rendering latency.
+     */
+    int latency;
+
+    /**
+     * The speed at which the recording should be replayed, as a percentage
+     * of the speed at which it was recorded, or zero to replay the recording
+     * as quickly as possible.
+     */
+    int speed;
+
+} guacload_options;
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "guacload.h"
+#include "log.h"
+#include "session.h"
+#include "stats.h"
+#include "viewer.h"
+
+#include <guacamole/client.h>
+#include <guacamole/error.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The number of microseconds that the server side of each session should wait
+ * for data from the simulated client before considering that client
+ * unresponsive, matching the timeout used by guacd.
+ */
+#define GUACLOAD_SESSION_USEC_TIMEOUT 15000000
+
+/**
+ * The number of milliseconds to wait between checks of whether the session
+ * has completed.
+ */
+#define GUACLOAD_SESSION_POLL_INTERVAL 100
+
+/**
+ * Thread which handles the server side of the simulated client's connection,
+ * from handshake until disconnect.
+ *
+ * @param data
+ *     The guac_user representing the simulated client.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacload_session_user_thread(void* data) {
+
+    guac_user* user = (guac_user*) data;
+    guac_user_handle_connection(user, GUACLOAD_SESSION_USEC_TIMEOUT);
+
+    return NULL;
+
+}
+
+/**
+ * Returns the total CPU time consumed by the current process, in
+ * microseconds.
+ *
+ * @return
+ *     The total CPU time consumed by the current process, in microseconds.
+ */
+static uint64_t guacload_session_cpu() {
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return 0;
+
+    return (uint64_t) usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec
+         + (uint64_t) usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+
+}
+
+void guacload_session_run(const guacload_options* options,
+        guacload_stats* stats) {
+
+    stats->sessions = 1;
+    stats->failures = 1;
+
+    guac_client* client = guac_client_alloc();
+    if (client == NULL) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to allocate client: %s",
+                guac_status_string(guac_error));
+        return;
+    }
+
+    client->log_handler = guacload_client_log;
+
+    /* Load the replay plugin just as guacd would load any protocol */
+    if (guac_client_load_plugin(client, GUACLOAD_PROTOCOL)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to load \"%s\" protocol "
+                "plugin: %s", GUACLOAD_PROTOCOL, guac_status_string(guac_error));
+        goto fail_plugin;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to create socket pair: %s",
+                strerror(errno));
+        goto fail_plugin;
+    }
+
+    /* Server side of the connection */
+    guac_user* user = guac_user_alloc();
+    user->socket = guac_socket_open(fds[0]);
+    user->client = client;
+    user->owner = 1;
+
+    uint64_t cpu_start = guacload_session_cpu();
+    guac_timestamp start = guac_timestamp_current();
+
+    pthread_t user_thread;
+    if (pthread_create(&user_thread, NULL, guacload_session_user_thread, user)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to start user thread.");
+        close(fds[1]);
+        goto fail_user_thread;
+    }
+
+    /* Client side of the connection */
+    guacload_viewer* viewer = guacload_viewer_alloc(fds[1], options, stats);
+    if (viewer == NULL) {
+        guac_client_stop(client);
+        pthread_join(user_thread, NULL);
+        goto fail_user_thread;
+    }
+
+    /* Run until the requested duration has elapsed, or until the session
+     * ends prematurely */
+    guac_timestamp end = start + options->duration * 1000;
+    guac_timestamp now;
+    while ((now = guac_timestamp_current()) < end
+            && client->state == GUAC_CLIENT_RUNNING)
+        guac_timestamp_msleep(GUACLOAD_SESSION_POLL_INTERVAL);
+
+    if (client->state == GUAC_CLIENT_RUNNING)
+        stats->failures = 0;
+    else
+        guacload_log(GUAC_LOG_ERROR, "Session ended after %" PRId64 "ms.",
+                (int64_t) (now - start));
+
+    stats->duration = now - start;
+
+    /* Measure CPU before teardown, excluding the simulated client */
+    stats->cpu = guacload_session_cpu() - cpu_start;
+
+    guac_client_stop(client);
+    guacload_viewer_stop(viewer);
+    pthread_join(user_thread, NULL);
+
+    if (viewer->cpu < stats->cpu)
+        stats->cpu -= viewer->cpu;
+
+    guacload_viewer_free(viewer);
+
+fail_user_thread:
+    guac_socket_free(user->socket);
+    guac_user_free(user);
+
+fail_plugin:
+    guac_client_free(client);
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOAD_SESSION_H
+#define GUACLOAD_SESSION_H
+
+#include "config.h"
+#include "guacload.h"
+#include "stats.h"
+
+/**
+ * Runs a single simulated session within the current process for the
+ * duration given in the options, exactly as guacd would run a connection
+ * within a dedicated process: the replay protocol plugin is loaded into a new
+ * guac_client, and a simulated client joins that guac_client as its owner
+ * through a local socket pair. Any failure is noted within the statistics.
+ *
+ * @param options
+ *     The options controlling the session.
+ *
+ * @param stats
+ *     The statistics to populate with the results of the session. These
+ *     statistics must be zeroed prior to calling this function.
+ */
+void guacload_session_run(const guacload_options* options,
+        guacload_stats* stats);
+
+#endif
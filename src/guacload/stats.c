@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "stats.h"
+
+#include <guacamole/timestamp.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+void guacload_stats_add_frame(guacload_stats* stats, guac_timestamp latency) {
+
+    /* Clocks of the client and server are the same, but may still appear to
+     * differ slightly due to rounding */
+    if (latency < 0)
+        latency = 0;
+
+    if (latency > stats->max_latency)
+        stats->max_latency = latency;
+
+    if (latency > GUACLOAD_MAX_TRACKED_LATENCY)
+        latency = GUACLOAD_MAX_TRACKED_LATENCY;
+
+    stats->latencies[latency]++;
+    stats->frames++;
+
+}
+
+void guacload_stats_merge(guacload_stats* dst, const guacload_stats* src) {
+
+    dst->sessions += src->sessions;
+    dst->failures += src->failures;
+    dst->duration += src->duration;
+    dst->frames   += src->frames;
+    dst->bytes    += src->bytes;
+    dst->cpu      += src->cpu;
+
+    if (src->max_latency > dst->max_latency)
+        dst->max_latency = src->max_latency;
+
+    for (int i = 0; i <= GUACLOAD_MAX_TRACKED_LATENCY; i++)
+        dst->latencies[i] += src->latencies[i];
+
+}
+
+guac_timestamp guacload_stats_latency_percentile(const guacload_stats* stats,
+        double percentile) {
+
+    uint64_t threshold = (uint64_t) (stats->frames * percentile / 100.0 + 0.5);
+    if (threshold == 0)
+        threshold = 1;
+
+    uint64_t frames = 0;
+    for (int i = 0; i <= GUACLOAD_MAX_TRACKED_LATENCY; i++) {
+        frames += stats->latencies[i];
+        if (frames >= threshold)
+            return (i == GUACLOAD_MAX_TRACKED_LATENCY) ? stats->max_latency : i;
+    }
+
+    return stats->max_latency;
+
+}
+
+void guacload_stats_write(const guacload_stats* stats, FILE* output) {
+
+    char name[64];
+    snprintf(name, sizeof(name), "guacload_%i", stats->sessions);
+
+    /* Average duration of a single session, in seconds */
+    double duration = stats->sessions > 0
+        ? stats->duration / 1000.0 / stats->sessions : 0;
+
+    double frames = stats->frames > 0 ? stats->frames : 1;
+
+    fprintf(output, "%s\tsessions\t%i\tcount\n", name, stats->sessions);
+    fprintf(output, "%s\tfailures\t%i\tcount\n", name, stats->failures);
+
+    if (duration > 0) {
+        fprintf(output, "%s\tframes_total\t%.2f\tframes/s\n", name,
+                stats->frames / duration);
+        fprintf(output, "%s\tframes_per_session\t%.2f\tframes/s\n", name,
+                stats->frames / duration / stats->sessions);
+    }
+
+    fprintf(output, "%s\tbytes_per_frame\t%.0f\tbytes\n", name,
+            stats->bytes / frames);
+    fprintf(output, "%s\tcpu_per_frame\t%.3f\tms\n", name,
+            stats->cpu / 1000.0 / frames);
+
+    fprintf(output, "%s\tlatency_p50\t%" PRId64 "\tms\n", name,
+            (int64_t) guacload_stats_latency_percentile(stats, 50));
+    fprintf(output, "%s\tlatency_p95\t%" PRId64 "\tms\n", name,
+            (int64_t) guacload_stats_latency_percentile(stats, 95));
+    fprintf(output, "%s\tlatency_p99\t%" PRId64 "\tms\n", name,
+            (int64_t) guacload_stats_latency_percentile(stats, 99));
+    fprintf(output, "%s\tlatency_max\t%" PRId64 "\tms\n", name,
+            (int64_t) stats->max_latency);
+
+    fflush(output);
+
+}
@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOAD_STATS_H
+#define GUACLOAD_STATS_H
+
+#include "config.h"
+
+#include <guacamole/timestamp.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * The largest frame latency, in milliseconds, that is tracked exactly.
+ * Greater latencies are counted as this latency within the latency
+ * histogram, though the overall maximum is still tracked separately.
+ */
+#define GUACLOAD_MAX_TRACKED_LATENCY 10000
+
+/**
+ * Statistics describing one or more simulated sessions. The statistics of a
+ * single session are gathered within the process running that session, and
+ * then passed as-is to the parent process to be merged with those of all
+ * other concurrent sessions.
+ */
+typedef struct guacload_stats {
+
+    /**
+     * The number of sessions described by these statistics.
+     */
+    int sessions;
+
+    /**
+     * The number of sessions which failed to run for their full duration.
+     */
+    int failures;
+
+    /**
+     * The sum of the durations of all sessions, in milliseconds.
+     */
+    uint64_t duration;
+
+    /**
+     * The total number of frames received by all simulated clients.
+     */
+    uint64_t frames;
+
+    /**
+     * The total number of bytes of Guacamole protocol data received by all
+     * simulated clients.
+     */
+    uint64_t bytes;
+
+    /**
+     * The total CPU time consumed on the server side of all sessions,
+     * including decoding the recording, rendering, and encoding, in
+     * microseconds. CPU time consumed by the simulated clients themselves is
+     * excluded.
+     */
+    uint64_t cpu;
+
+    /**
+     * The largest latency of any frame, in milliseconds.
+     */
+    guac_timestamp max_latency;
+
+    /**
+     * Histogram of frame latencies, where each element is the number of
+     * frames that took that many milliseconds to be received from the time
+     * they were sent.
+     */
+    uint64_t latencies[GUACLOAD_MAX_TRACKED_LATENCY + 1];
+
+} guacload_stats;
+
+/**
+ * Records that a frame has been received with the given latency.
+ *
+ * @param stats
+ *     The statistics to update.
+ *
+ * @param latency
+ *     The number of milliseconds elapsed between the frame being sent and
+ *     being received.
+ */
+void guacload_stats_add_frame(guacload_stats* stats, guac_timestamp latency);
+
+/**
+ * Adds all statistics from the given source to the given destination.
+ *
+ * @param dst
+ *     The statistics to update.
+ *
+ * @param src
+ *     The statistics to add to dst.
+ */
+void guacload_stats_merge(guacload_stats* dst, const guacload_stats* src);
+
+/**
+ * Returns the smallest frame latency which is greater than or equal to the
+ * given percentage of all frame latencies.
+ *
+ * @param stats
+ *     The statistics to search.
+ *
+ * @param percentile
+ *     The percentage of frames whose latency must not exceed the returned
+ *     value, between 0 and 100 inclusive.
+ *
+ * @return
+ *     The requested percentile frame latency, in milliseconds.
+ */
+guac_timestamp guacload_stats_latency_percentile(const guacload_stats* stats,
+        double percentile);
+
+/**
+ * Writes the given statistics to the given file using the same format as
+ * "make bench": one line per metric, each line consisting of the benchmark
+ * name, metric name, value, and unit, separated by tabs.
+ *
+ * @param stats
+ *     The statistics to write.
+ *
+ * @param output
+ *     The file to write to.
+ */
+void guacload_stats_write(const guacload_stats* stats, FILE* output);
+
+#endif
@@ -0,0 +1,585 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "guacload.h"
+#include "log.h"
+#include "stats.h"
+#include "viewer.h"
+
+#include <guacamole/error.h>
+#include <guacamole/mem.h>
+#include <guacamole/parser.h>
+#include <guacamole/parser-constants.h>
+#include <guacamole/protocol.h>
+#include <guacamole/protocol-constants.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/unicode.h>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The number of microseconds to wait for the server to send the "args"
+ * instruction which begins the handshake.
+ */
+#define GUACLOAD_VIEWER_HANDSHAKE_TIMEOUT 15000000
+
+/**
+ * The fixed portion of the handshake sent by each simulated client after
+ * receiving "args", declaring the client's screen size and supported
+ * formats.
+ */
+#define GUACLOAD_VIEWER_HANDSHAKE          \
+    "4.size,4.1024,3.768,2.96;"            \
+    "5.audio;"                             \
+    "5.video;"                             \
+    "5.image,9.image/png,10.image/jpeg,10.image/webp;"
+
+/**
+ * Returns the number of bytes occupied by the complete instruction at the
+ * beginning of the given buffer, without parsing that instruction in place.
+ * The location of each of the first GUACLOAD_VIEWER_MAX_ELEMENTS elements of
+ * the instruction is additionally stored in the given array.
+ *
+ * @param buffer
+ *     The buffer containing the instruction.
+ *
+ * @param length
+ *     The number of bytes available within the buffer.
+ *
+ * @param elements
+ *     An array of at least GUACLOAD_VIEWER_MAX_ELEMENTS elements which should
+ *     receive the locations of the elements of the instruction, beginning
+ *     with the opcode. Elements beyond those present in the instruction are
+ *     set to empty.
+ *
+ * @return
+ *     The number of bytes occupied by the instruction, zero if the buffer
+ *     does not yet contain the entire instruction, or -1 if the instruction
+ *     is malformed.
+ */
+static int guacload_viewer_scan(const char* buffer, int length,
+        guacload_viewer_element* elements) {
+
+    int offset = 0;
+    int element = 0;
+
+    memset(elements, 0, sizeof(guacload_viewer_element)
+            * GUACLOAD_VIEWER_MAX_ELEMENTS);
+
+    while (offset < length) {
+
+        /* Parse element length */
+        int element_length = 0;
+        int digits = 0;
+        while (offset < length && buffer[offset] >= '0'
+                && buffer[offset] <= '9') {
+
+            element_length = element_length * 10 + buffer[offset++] - '0';
+
+            if (++digits > GUAC_INSTRUCTION_MAX_DIGITS)
+                return -1;
+
+        }
+
+        if (offset >= length)
+            return 0;
+
+        if (digits == 0 || buffer[offset++] != '.')
+            return -1;
+
+        int content = offset;
+
+        /* Skip element content, which is measured in characters, skipping
+         * runs of ASCII (such as base64-encoded image data) in bulk */
+        int chars = element_length;
+        while (chars > 0) {
+
+            int available = length - offset;
+            int ascii_length = guac_utf8_ascii_length(buffer + offset,
+                    available < chars ? available : chars);
+
+            offset += ascii_length;
+            chars -= ascii_length;
+
+            if (chars == 0)
+                break;
+
+            if (offset >= length)
+                return 0;
+
+            offset += guac_utf8_charsize((unsigned char) buffer[offset]);
+            chars--;
+
+        }
+
+        if (offset >= length)
+            return 0;
+
+        if (element < GUACLOAD_VIEWER_MAX_ELEMENTS)
+            elements[element] = (guacload_viewer_element) {
+                .value = buffer + content,
+                .length = offset - content
+            };
+
+        /* Instruction ends with a semicolon */
+        char terminator = buffer[offset++];
+        if (terminator == ';')
+            return offset;
+
+        /* Elements are separated by commas */
+        if (terminator != ',')
+            return -1;
+
+        element++;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Returns whether the given element is equal to the given string.
+ *
+ * @param element
+ *     The element to test.
+ *
+ * @param str
+ *     The string to compare the element against.
+ *
+ * @return
+ *     Non-zero if the element is equal to the given string, zero otherwise.
+ */
+static int guacload_viewer_element_equals(const guacload_viewer_element* element,
+        const char* str) {
+    return element->length == strlen(str)
+        && memcmp(element->value, str, element->length) == 0;
+}
+
+/**
+ * Returns the integer value of the given element, which must contain only
+ * decimal digits and an optional leading minus sign.
+ *
+ * @param element
+ *     The element to parse.
+ *
+ * @return
+ *     The integer value of the given element.
+ */
+static int64_t guacload_viewer_element_int(const guacload_viewer_element* element) {
+
+    int64_t value = 0;
+    int sign = 1;
+
+    for (int i = 0; i < element->length; i++) {
+        if (i == 0 && element->value[i] == '-')
+            sign = -1;
+        else
+            value = value * 10 + element->value[i] - '0';
+    }
+
+    return sign * value;
+
+}
+
+/**
+ * Returns whether the given instruction only affects the off-screen buffers
+ * which the server uses to track the content already sent to the client.
+ * Such instructions are sent after each frame, followed by an additional
+ * "sync", and do not themselves constitute a frame.
+ *
+ * @param elements
+ *     The elements of the instruction, as located by guacload_viewer_scan().
+ *
+ * @return
+ *     Non-zero if the given instruction only affects off-screen buffers,
+ *     zero otherwise.
+ */
+static int guacload_viewer_is_buffer_only(const guacload_viewer_element* elements) {
+
+    const guacload_viewer_element* opcode = &elements[0];
+
+    if (guacload_viewer_element_equals(opcode, "rect"))
+        return guacload_viewer_element_int(&elements[1]) < 0;
+
+    if (guacload_viewer_element_equals(opcode, "cfill"))
+        return guacload_viewer_element_int(&elements[2]) < 0;
+
+    if (guacload_viewer_element_equals(opcode, "copy"))
+        return guacload_viewer_element_int(&elements[7]) < 0;
+
+    return 0;
+
+}
+
+/**
+ * Adds the total CPU time consumed by the current thread to the CPU time
+ * consumed by the given viewer. This function must be invoked by each thread
+ * of the viewer immediately before that thread terminates.
+ *
+ * @param viewer
+ *     The viewer that the current thread belongs to.
+ */
+static void guacload_viewer_add_thread_cpu(guacload_viewer* viewer) {
+
+#ifdef RUSAGE_THREAD
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage))
+        return;
+
+    pthread_mutex_lock(&viewer->lock);
+    viewer->cpu += (uint64_t) usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec
+                 + (uint64_t) usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+    pthread_mutex_unlock(&viewer->lock);
+#endif
+
+}
+
+/**
+ * Sends a "sync" instruction acknowledging the frame having the given
+ * timestamp.
+ *
+ * @param viewer
+ *     The viewer acknowledging the frame.
+ *
+ * @param timestamp
+ *     The timestamp of the frame being acknowledged, as sent by the server.
+ */
+static void guacload_viewer_send_ack(guacload_viewer* viewer,
+        guac_timestamp timestamp) {
+    guac_protocol_send_sync(viewer->socket, timestamp, 1);
+    guac_socket_flush(viewer->socket);
+}
+
+/**
+ * Records receipt of a "sync" instruction having the given timestamp,
+ * scheduling that instruction to be acknowledged once the configured latency
+ * has elapsed.
+ *
+ * @param viewer
+ *     The viewer that received the "sync" instruction.
+ *
+ * @param timestamp
+ *     The timestamp of the "sync" instruction, as sent by the server.
+ *
+ * @param frame
+ *     Non-zero if the "sync" instruction ends a frame, zero if the "sync"
+ *     instruction only follows updates to off-screen buffers.
+ */
+static void guacload_viewer_receive_sync(guacload_viewer* viewer,
+        guac_timestamp timestamp, int frame) {
+
+    guac_timestamp now = guac_timestamp_current();
+
+    if (frame)
+        guacload_stats_add_frame(viewer->stats, now - timestamp);
+
+    pthread_mutex_lock(&viewer->lock);
+
+    /* Acknowledge immediately if too many frames are already pending */
+    if (viewer->ack_count == GUACLOAD_VIEWER_MAX_PENDING_ACKS) {
+        pthread_mutex_unlock(&viewer->lock);
+        guacload_viewer_send_ack(viewer, timestamp);
+        return;
+    }
+
+    int index = (viewer->ack_head + viewer->ack_count)
+        % GUACLOAD_VIEWER_MAX_PENDING_ACKS;
+
+    viewer->acks[index] = (guacload_viewer_ack) {
+        .timestamp = timestamp,
+        .due = now + viewer->latency
+    };
+
+    viewer->ack_count++;
+    pthread_cond_signal(&viewer->acks_modified);
+
+    pthread_mutex_unlock(&viewer->lock);
+
+}
+
+/**
+ * Thread which receives all data sent by the server, counting that data and
+ * recording the receipt of each frame, until the connection is closed.
+ *
+ * @param data
+ *     The guacload_viewer receiving the data.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacload_viewer_receive_thread(void* data) {
+
+    guacload_viewer* viewer = (guacload_viewer*) data;
+    char* buffer = guac_mem_alloc(GUACLOAD_VIEWER_BUFFER_SIZE);
+    int length = 0;
+
+    /* Whether anything other than off-screen buffers has been modified since
+     * the last "sync" */
+    int frame_modified = 0;
+
+    for (;;) {
+
+        int received = read(viewer->fd, buffer + length,
+                GUACLOAD_VIEWER_BUFFER_SIZE - length);
+
+        /* Stop once the connection is closed */
+        if (received <= 0)
+            break;
+
+        viewer->stats->bytes += received;
+        length += received;
+
+        /* Handle all complete instructions */
+        int offset = 0;
+        int instruction_length;
+        guacload_viewer_element elements[GUACLOAD_VIEWER_MAX_ELEMENTS];
+        while ((instruction_length = guacload_viewer_scan(buffer + offset,
+                        length - offset, elements)) > 0) {
+
+            /* Each sync ends a frame only if preceded by something other than
+             * updates to off-screen buffers */
+            if (guacload_viewer_element_equals(&elements[0], "sync")) {
+                guacload_viewer_receive_sync(viewer,
+                        guacload_viewer_element_int(&elements[1]),
+                        frame_modified);
+                frame_modified = 0;
+            }
+
+            else if (!guacload_viewer_is_buffer_only(elements))
+                frame_modified = 1;
+
+            offset += instruction_length;
+
+        }
+
+        if (instruction_length < 0) {
+            guacload_log(GUAC_LOG_ERROR, "Server sent malformed data.");
+            break;
+        }
+
+        /* Retain any partial instruction for the next read */
+        length -= offset;
+        memmove(buffer, buffer + offset, length);
+
+        if (length == GUACLOAD_VIEWER_BUFFER_SIZE) {
+            guacload_log(GUAC_LOG_ERROR, "Server sent an instruction "
+                    "exceeding the maximum length.");
+            break;
+        }
+
+    }
+
+    guac_mem_free(buffer);
+    guacload_viewer_add_thread_cpu(viewer);
+    return NULL;
+
+}
+
+/**
+ * Thread which acknowledges each received frame once its configured latency
+ * has elapsed, until the viewer is stopped.
+ *
+ * @param data
+ *     The guacload_viewer acknowledging frames.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacload_viewer_ack_thread(void* data) {
+
+    guacload_viewer* viewer = (guacload_viewer*) data;
+
+    pthread_mutex_lock(&viewer->lock);
+
+    while (!viewer->stopping) {
+
+        /* Wait for frames to acknowledge */
+        if (viewer->ack_count == 0) {
+            pthread_cond_wait(&viewer->acks_modified, &viewer->lock);
+            continue;
+        }
+
+        guacload_viewer_ack ack = viewer->acks[viewer->ack_head];
+
+        /* Wait for the oldest frame to become due */
+        guac_timestamp now = guac_timestamp_current();
+        if (ack.due > now) {
+            pthread_mutex_unlock(&viewer->lock);
+            guac_timestamp_msleep(ack.due - now);
+            pthread_mutex_lock(&viewer->lock);
+            continue;
+        }
+
+        viewer->ack_head = (viewer->ack_head + 1)
+            % GUACLOAD_VIEWER_MAX_PENDING_ACKS;
+        viewer->ack_count--;
+
+        pthread_mutex_unlock(&viewer->lock);
+        guacload_viewer_send_ack(viewer, ack.timestamp);
+        pthread_mutex_lock(&viewer->lock);
+
+    }
+
+    pthread_mutex_unlock(&viewer->lock);
+
+    guacload_viewer_add_thread_cpu(viewer);
+    return NULL;
+
+}
+
+/**
+ * Performs the client side of the Guacamole protocol handshake, requesting
+ * that the server replay the given recording.
+ *
+ * @param viewer
+ *     The viewer performing the handshake.
+ *
+ * @param options
+ *     The options controlling the simulated session.
+ *
+ * @return
+ *     Zero if the handshake was sent successfully, non-zero otherwise.
+ */
+static int guacload_viewer_handshake(guacload_viewer* viewer,
+        const guacload_options* options) {
+
+    /* The server names the arguments it expects via "args" */
+    guac_parser* parser = guac_parser_alloc();
+    if (guac_parser_expect(parser, viewer->socket,
+                GUACLOAD_VIEWER_HANDSHAKE_TIMEOUT, "args")) {
+        guacload_log(GUAC_LOG_ERROR, "Server did not begin handshake: %s",
+                guac_status_string(guac_error));
+        guac_parser_free(parser);
+        return 1;
+    }
+
+    char speed[16];
+    snprintf(speed, sizeof(speed), "%i", options->speed);
+
+    /* Provide values for all arguments recognized by the replay plugin,
+     * leaving all others blank */
+    const char** values = guac_mem_alloc(sizeof(char*), parser->argc + 1);
+    values[0] = GUACAMOLE_PROTOCOL_VERSION;
+    for (int i = 1; i < parser->argc; i++) {
+
+        const char* name = parser->argv[i];
+
+        if (strcmp(name, "recording-path") == 0)
+            values[i] = options->recording_path;
+        else if (strcmp(name, "speed") == 0)
+            values[i] = speed;
+        else if (strcmp(name, "loop") == 0)
+            values[i] = "true";
+        else
+            values[i] = "";
+
+    }
+    values[parser->argc] = NULL;
+
+    int result = guac_socket_write_string(viewer->socket, GUACLOAD_VIEWER_HANDSHAKE)
+        || guac_protocol_send_connect(viewer->socket, values)
+        || guac_socket_flush(viewer->socket);
+
+    guac_mem_free(values);
+    guac_parser_free(parser);
+
+    if (result)
+        guacload_log(GUAC_LOG_ERROR, "Unable to send handshake: %s",
+                guac_status_string(guac_error));
+
+    return result;
+
+}
+
+guacload_viewer* guacload_viewer_alloc(int fd, const guacload_options* options,
+        guacload_stats* stats) {
+
+    guacload_viewer* viewer = guac_mem_zalloc(sizeof(guacload_viewer));
+    viewer->fd = fd;
+    viewer->socket = guac_socket_open(fd);
+    viewer->latency = options->latency;
+    viewer->stats = stats;
+
+    pthread_mutex_init(&viewer->lock, NULL);
+    pthread_cond_init(&viewer->acks_modified, NULL);
+
+    if (guacload_viewer_handshake(viewer, options))
+        goto fail_handshake;
+
+    if (pthread_create(&viewer->receive_thread, NULL,
+                guacload_viewer_receive_thread, viewer)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to start receive thread.");
+        goto fail_handshake;
+    }
+
+    if (pthread_create(&viewer->ack_thread, NULL,
+                guacload_viewer_ack_thread, viewer)) {
+        guacload_log(GUAC_LOG_ERROR, "Unable to start acknowledgement "
+                "thread.");
+        shutdown(viewer->fd, SHUT_RDWR);
+        pthread_join(viewer->receive_thread, NULL);
+        goto fail_handshake;
+    }
+
+    return viewer;
+
+fail_handshake:
+    guacload_viewer_free(viewer);
+    return NULL;
+
+}
+
+void guacload_viewer_stop(guacload_viewer* viewer) {
+
+    pthread_mutex_lock(&viewer->lock);
+    viewer->stopping = true;
+    pthread_cond_signal(&viewer->acks_modified);
+    pthread_mutex_unlock(&viewer->lock);
+
+    /* Closing the connection unblocks the receive thread and informs the
+     * server that the user has left */
+    shutdown(viewer->fd, SHUT_RDWR);
+
+    pthread_join(viewer->ack_thread, NULL);
+    pthread_join(viewer->receive_thread, NULL);
+
+}
+
+void guacload_viewer_free(guacload_viewer* viewer) {
+
+    pthread_cond_destroy(&viewer->acks_modified);
+    pthread_mutex_destroy(&viewer->lock);
+
+    /* Closes the underlying file descriptor */
+    guac_socket_free(viewer->socket);
+
+    guac_mem_free(viewer);
+
+}
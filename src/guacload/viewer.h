@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOAD_VIEWER_H
+#define GUACLOAD_VIEWER_H
+
+#include "config.h"
+#include "guacload.h"
+#include "stats.h"
+
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The maximum number of frames which may be awaiting acknowledgement by a
+ * simulated client at any one time. Frames received while this many frames
+ * are already pending are acknowledged immediately.
+ */
+#define GUACLOAD_VIEWER_MAX_PENDING_ACKS 1024
+
+/**
+ * The size of the buffer used to receive Guacamole protocol data, in bytes.
+ * This buffer must be large enough to contain any single instruction, the
+ * length of which is limited to GUAC_INSTRUCTION_MAX_LENGTH characters of up
+ * to four bytes each.
+ */
+#define GUACLOAD_VIEWER_BUFFER_SIZE 65536
+
+/**
+ * The maximum number of elements of each received instruction, including
+ * the opcode, that are located for inspection by a simulated client.
+ */
+#define GUACLOAD_VIEWER_MAX_ELEMENTS 8
+
+/**
+ * The location of a single element of a received instruction, within the
+ * buffer containing that instruction.
+ */
+typedef struct guacload_viewer_element {
+
+    /**
+     * The first byte of the element's value. This value is not
+     * NULL-terminated.
+     */
+    const char* value;
+
+    /**
+     * The length of the element's value, in bytes.
+     */
+    int length;
+
+} guacload_viewer_element;
+
+/**
+ * A frame which has been received by a simulated client but not yet
+ * acknowledged.
+ */
+typedef struct guacload_viewer_ack {
+
+    /**
+     * The timestamp of the frame, as sent by the server.
+     */
+    guac_timestamp timestamp;
+
+    /**
+     * The local time at which the frame should be acknowledged.
+     */
+    guac_timestamp due;
+
+} guacload_viewer_ack;
+
+/**
+ * A simulated client which performs the Guacamole protocol handshake,
+ * receives and counts all data sent by the server, and acknowledges each
+ * frame after a configurable delay, as a real client would once that frame
+ * has been rendered. The simulated client does not render anything.
+ */
+typedef struct guacload_viewer {
+
+    /**
+     * The file descriptor of the client side of the connection.
+     */
+    int fd;
+
+    /**
+     * The socket used to send data to the server, wrapping fd.
+     */
+    guac_socket* socket;
+
+    /**
+     * The number of milliseconds to wait after receiving each frame before
+     * acknowledging that frame.
+     */
+    int latency;
+
+    /**
+     * Statistics describing all data received. These statistics are updated
+     * only by the receiving thread and must not be read until the viewer has
+     * been stopped.
+     */
+    guacload_stats* stats;
+
+    /**
+     * The thread receiving all data sent by the server.
+     */
+    pthread_t receive_thread;
+
+    /**
+     * The thread acknowledging all received frames.
+     */
+    pthread_t ack_thread;
+
+    /**
+     * Lock which guards access to all pending acknowledgements, the stopping
+     * flag, and the CPU time consumed by the viewer.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever a new acknowledgement is pending
+     * or the viewer is stopping.
+     */
+    pthread_cond_t acks_modified;
+
+    /**
+     * Ring buffer of all frames received but not yet acknowledged.
+     */
+    guacload_viewer_ack acks[GUACLOAD_VIEWER_MAX_PENDING_ACKS];
+
+    /**
+     * The index of the oldest pending acknowledgement within acks.
+     */
+    int ack_head;
+
+    /**
+     * The number of pending acknowledgements within acks.
+     */
+    int ack_count;
+
+    /**
+     * Whether the viewer is stopping.
+     */
+    bool stopping;
+
+    /**
+     * The total CPU time consumed by the threads of this viewer, in
+     * microseconds. This value is updated as each thread terminates.
+     */
+    uint64_t cpu;
+
+} guacload_viewer;
+
+/**
+ * Connects a new simulated client to the server at the other end of the given
+ * file descriptor, requesting that the given recording be replayed. The
+ * handshake is sent immediately, and all data from the server is received
+ * and acknowledged in the background until guacload_viewer_stop() is called.
+ *
+ * @param fd
+ *     The file descriptor of the client side of the connection. This file
+ *     descriptor will be closed when the viewer is freed.
+ *
+ * @param options
+ *     The options controlling the simulated session.
+ *
+ * @param stats
+ *     The statistics to update with all data received.
+ *
+ * @return
+ *     The newly-connected viewer, or NULL if the viewer could not be
+ *     started.
+ */
+guacload_viewer* guacload_viewer_alloc(int fd, const guacload_options* options,
+        guacload_stats* stats);
+
+/**
+ * Disconnects the given viewer from the server, waiting for all of its
+ * threads to terminate. The statistics provided when the viewer was created
+ * may be safely read once this function returns.
+ *
+ * @param viewer
+ *     The viewer to stop.
+ */
+void guacload_viewer_stop(guacload_viewer* viewer);
+
+/**
+ * Frees the given viewer, closing its connection. The viewer must already
+ * have been stopped with guacload_viewer_stop().
+ *
+ * @param viewer
+ *     The viewer to free.
+ */
+void guacload_viewer_free(guacload_viewer* viewer);
+
+#endif
@@ -22,10 +22,141 @@
 #include "guaclog.h"
 #include "interpret.h"
 #include "log.h"
+#include "output.h"
+
+#include <guacamole/mem.h>
 
 #include <getopt.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * The set of input files being interpreted, shared between all worker threads
+ * interpreting those files.
+ */
+typedef struct guaclog_job {
+
+    /**
+     * The paths of all input files to interpret.
+     */
+    char** paths;
+
+    /**
+     * The total number of input files to interpret.
+     */
+    int total_files;
+
+    /**
+     * The index of the next input file to be interpreted by a worker thread.
+     */
+    int next_file;
+
+    /**
+     * The number of input files which could not be interpreted.
+     */
+    int failures;
+
+    /**
+     * Interpret even if input files appear to be in-progress logs.
+     */
+    bool force;
+
+    /**
+     * The consolidated output to write all interpreted logs to, or NULL if
+     * each log should be written to its own file.
+     */
+    guaclog_output* output;
+
+    /**
+     * Lock which guards access to next_file and failures.
+     */
+    pthread_mutex_t lock;
+
+} guaclog_job;
+
+/**
+ * Interprets the given input file, writing the interpreted log either to the
+ * consolidated output of the given job or to a new file named after the
+ * input file.
+ *
+ * @param job
+ *     The job that the input file is part of.
+ *
+ * @param path
+ *     The path of the input file to interpret.
+ *
+ * @return
+ *     Zero if the input file was successfully interpreted, non-zero
+ *     otherwise.
+ */
+static int guaclog_interpret_file(guaclog_job* job, const char* path) {
+
+    /* Write to consolidated output, if requested */
+    if (job->output != NULL)
+        return guaclog_interpret_json(path, job->output, job->force);
+
+    /* Generate output filename */
+    char out_path[4096];
+    int len = snprintf(out_path, sizeof(out_path), "%s.txt", path);
+
+    /* Do not write if filename exceeds maximum length */
+    if (len >= sizeof(out_path)) {
+        guaclog_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
+                "Name too long", path);
+        return 1;
+    }
+
+    return guaclog_interpret(path, out_path, job->force);
+
+}
+
+/**
+ * Worker thread which repeatedly interprets the next input file of the given
+ * job until no input files remain.
+ *
+ * @param data
+ *     The guaclog_job being processed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guaclog_worker_thread(void* data) {
+
+    guaclog_job* job = (guaclog_job*) data;
+
+    for (;;) {
+
+        /* Claim next input file, if any */
+        pthread_mutex_lock(&job->lock);
+        int index = job->next_file++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (index >= job->total_files)
+            break;
+
+        /* Attempt interpreting, log granular success/failure at debug level */
+        const char* path = job->paths[index];
+        if (guaclog_interpret_file(job, path)) {
+
+            pthread_mutex_lock(&job->lock);
+            job->failures++;
+            pthread_mutex_unlock(&job->lock);
+
+            guaclog_log(GUAC_LOG_DEBUG,
+                    "%s was NOT successfully interpreted.", path);
+
+        }
+        else
+            guaclog_log(GUAC_LOG_DEBUG, "%s was successfully "
+                    "interpreted.", path);
+
+    }
+
+    return NULL;
+
+}
 
 int main(int argc, char* argv[]) {
 
@@ -33,15 +164,31 @@ int main(int argc, char* argv[]) {
 
     /* Load defaults */
     bool force = false;
+    int threads = 1;
+    const char* output_path = NULL;
 
     /* Parse arguments */
     int opt;
-    while ((opt = getopt(argc, argv, "s:r:f")) != -1) {
+    while ((opt = getopt(argc, argv, "s:r:fj:o:")) != -1) {
 
         /* -f: Force */
         if (opt == 'f')
             force = true;
 
+        /* -j: Number of files to interpret concurrently */
+        else if (opt == 'j') {
+            threads = atoi(optarg);
+            if (threads <= 0) {
+                guaclog_log(GUAC_LOG_ERROR, "Invalid number of concurrent "
+                        "jobs: \"%s\"", optarg);
+                goto invalid_options;
+            }
+        }
+
+        /* -o: Consolidated JSON lines output file */
+        else if (opt == 'o')
+            output_path = optarg;
+
         /* Invalid option */
         else {
             goto invalid_options;
@@ -55,7 +202,6 @@ int main(int argc, char* argv[]) {
 
     /* Track number of overall failures */
     int total_files = argc - optind;
-    int failures = 0;
 
     /* Abort if no files given */
     if (total_files <= 0) {
@@ -65,39 +211,56 @@ int main(int argc, char* argv[]) {
 
     guaclog_log(GUAC_LOG_INFO, "%i input file(s) provided.", total_files);
 
-    /* Interpret all input files */
-    for (i = optind; i < argc; i++) {
+    guaclog_job job = {
+        .paths = &argv[optind],
+        .total_files = total_files,
+        .force = force
+    };
 
-        /* Get current filename */
-        const char* path = argv[i];
+    /* Open consolidated output file, if requested */
+    if (output_path != NULL) {
+        job.output = guaclog_output_alloc(output_path);
+        if (job.output == NULL)
+            return 1;
+    }
 
-        /* Generate output filename */
-        char out_path[4096];
-        int len = snprintf(out_path, sizeof(out_path), "%s.txt", path);
+    pthread_mutex_init(&job.lock, NULL);
 
-        /* Do not write if filename exceeds maximum length */
-        if (len >= sizeof(out_path)) {
-            guaclog_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
-                    "Name too long", path);
-            continue;
-        }
+    /* No more threads than files are needed */
+    if (threads > total_files)
+        threads = total_files;
 
-        /* Attempt interpreting, log granular success/failure at debug level */
-        if (guaclog_interpret(path, out_path, force)) {
-            failures++;
-            guaclog_log(GUAC_LOG_DEBUG,
-                    "%s was NOT successfully interpreted.", path);
+    /* Interpret all input files, using the current thread as the first
+     * worker */
+    pthread_t* workers = guac_mem_alloc(sizeof(pthread_t), threads);
+    for (i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, guaclog_worker_thread, &job)) {
+            guaclog_log(GUAC_LOG_WARNING, "Unable to start worker thread. "
+                    "Continuing with %i concurrent job(s).", i);
+            threads = i;
+            break;
         }
-        else
-            guaclog_log(GUAC_LOG_DEBUG, "%s was successfully "
-                    "interpreted.", path);
+    }
+
+    guaclog_worker_thread(&job);
 
+    for (i = 1; i < threads; i++)
+        pthread_join(workers[i], NULL);
+
+    guac_mem_free(workers);
+    pthread_mutex_destroy(&job.lock);
+
+    /* Finish consolidated output, if any */
+    if (guaclog_output_free(job.output)) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to write output file \"%s\".",
+                output_path);
+        return 1;
     }
 
     /* Warn if at least one file failed */
-    if (failures != 0)
+    if (job.failures != 0)
         guaclog_log(GUAC_LOG_WARNING, "Interpreting failed for %i of %i "
-                "file(s).", failures, total_files);
+                "file(s).", job.failures, total_files);
 
     /* Notify of success */
     else
@@ -111,9 +274,10 @@ invalid_options:
 
     fprintf(stderr, "USAGE: %s"
             " [-f]"
+            " [-j JOBS]"
+            " [-o OUTPUT]"
             " [FILE]...\n", argv[0]);
 
     return 1;
 
 }
-
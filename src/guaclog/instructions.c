@@ -22,38 +22,60 @@
 #include "instructions.h"
 #include "log.h"
 
-#include <string.h>
+#include <guacamole/opcode.h>
+
+#include <pthread.h>
 
 guaclog_instruction_handler_mapping guaclog_instruction_handler_map[] = {
     {"key", guaclog_handle_key},
     {NULL,  NULL}
 };
 
+/**
+ * Index of all opcodes within guaclog_instruction_handler_map.
+ */
+static guac_opcode_index guaclog_instruction_handler_index;
+
+/**
+ * Control object which ensures guaclog_instruction_handler_index is built
+ * exactly once.
+ */
+static pthread_once_t guaclog_instruction_handler_index_init = PTHREAD_ONCE_INIT;
+
+/**
+ * Builds guaclog_instruction_handler_index. This function is invoked once, via
+ * pthread_once(), prior to the first lookup of any handler.
+ */
+static void guaclog_build_instruction_handler_index(void) {
+    guac_opcode_index_init(&guaclog_instruction_handler_index,
+            guaclog_instruction_handler_map,
+            sizeof(guaclog_instruction_handler_mapping));
+}
+
 int guaclog_handle_instruction(guaclog_state* state, const char* opcode,
         int argc, char** argv) {
 
-    /* Search through mapping for instruction handler having given opcode */
-    guaclog_instruction_handler_mapping* current = guaclog_instruction_handler_map;
-    while (current->opcode != NULL) {
-
-        /* Invoke handler if opcode matches (if defined) */
-        if (strcmp(current->opcode, opcode) == 0) {
+    pthread_once(&guaclog_instruction_handler_index_init,
+            guaclog_build_instruction_handler_index);
 
-            /* Invoke defined handler */
-            guaclog_instruction_handler* handler = current->handler;
-            if (handler != NULL)
-                return handler(state, argc, argv);
+    /* Look up instruction handler having given opcode */
+    const guaclog_instruction_handler_mapping* mapping =
+        guac_opcode_index_lookup(&guaclog_instruction_handler_index,
+                guaclog_instruction_handler_map,
+                sizeof(guaclog_instruction_handler_mapping), opcode);
 
-            /* Log defined but unimplemented instructions */
-            guaclog_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
-            return 0;
+    if (mapping != NULL) {
 
-        }
+        /* Invoke defined handler */
+        guaclog_instruction_handler* handler = mapping->handler;
+        if (handler != NULL)
+            return handler(state, argc, argv);
 
-        /* Next candidate handler */
-        current++;
+        /* Log defined but unimplemented instructions */
+        guaclog_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
+        return 0;
 
-    } /* end opcode search */
+    }
 
     /* Ignore any unknown instructions */
     return 0;
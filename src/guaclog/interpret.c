@@ -20,74 +20,320 @@
 #include "config.h"
 #include "instructions.h"
 #include "log.h"
+#include "output.h"
 #include "state.h"
 
 #include <guacamole/client.h>
 #include <guacamole/error.h>
 #include <guacamole/parser.h>
-#include <guacamole/socket.h>
+#include <guacamole/parser-constants.h>
+#include <guacamole/unicode.h>
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
 /**
- * Reads and handles all Guacamole instructions from the given guac_socket
- * until end-of-stream is reached.
+ * Returns the number of bytes occupied by the given number of UTF-8
+ * characters at the beginning of the given buffer. Runs of ASCII, such as
+ * base64-encoded image data, are skipped in bulk.
+ *
+ * @param buffer
+ *     The buffer containing the characters to skip.
+ *
+ * @param length
+ *     The number of bytes available within the buffer.
+ *
+ * @param chars
+ *     The number of UTF-8 characters to skip.
+ *
+ * @return
+ *     The number of bytes occupied by the given number of characters, or
+ *     zero if the buffer ends before that many characters.
+ */
+static size_t guaclog_skip_chars(const char* buffer, size_t length,
+        size_t chars) {
+
+    size_t skipped = 0;
+
+    while (chars > 0) {
+
+        /* Skip any run of ASCII characters in bulk */
+        size_t available = length - skipped;
+        size_t ascii_length = guac_utf8_ascii_length(buffer + skipped,
+                available < chars ? available : chars);
+
+        skipped += ascii_length;
+        chars -= ascii_length;
+
+        if (chars == 0)
+            break;
+
+        /* Skip multibyte characters individually */
+        if (skipped >= length)
+            return 0;
+
+        size_t char_length = guac_utf8_charsize((unsigned char) buffer[skipped]);
+        if (skipped + char_length > length)
+            return 0;
+
+        skipped += char_length;
+        chars--;
+
+    }
+
+    return skipped;
+
+}
+
+/**
+ * Returns the number of bytes occupied by the instruction at the beginning
+ * of the given buffer if that instruction can safely be ignored. Only "key"
+ * instructions are relevant to the interpreter. All other instructions are
+ * skipped using their length prefixes alone, without being parsed or copied.
+ *
+ * @param buffer
+ *     The buffer containing the instruction to test.
+ *
+ * @param length
+ *     The number of bytes available within the buffer.
+ *
+ * @return
+ *     The number of bytes occupied by the instruction if it can be ignored,
+ *     or zero if the instruction must be fully parsed, including if the
+ *     instruction is a "key" instruction, is malformed, or is incomplete.
+ */
+static size_t guaclog_skip_instruction(const char* buffer, size_t length) {
+
+    size_t offset = 0;
+    int element = 0;
+
+    while (offset < length) {
+
+        /* Parse element length */
+        size_t element_length = 0;
+        int digits = 0;
+        while (offset < length && buffer[offset] >= '0'
+                && buffer[offset] <= '9') {
+
+            element_length = element_length * 10 + buffer[offset++] - '0';
+
+            /* Leave overly-long lengths to the parser to reject */
+            if (++digits > GUAC_INSTRUCTION_MAX_DIGITS)
+                return 0;
+
+        }
+
+        if (digits == 0 || offset >= length || buffer[offset++] != '.')
+            return 0;
+
+        /* Key instructions must be parsed */
+        if (element == 0 && element_length == 3 && offset + 3 <= length
+                && memcmp(buffer + offset, "key", 3) == 0)
+            return 0;
+
+        /* Skip element content */
+        size_t content_length = guaclog_skip_chars(buffer + offset,
+                length - offset, element_length);
+        if (content_length == 0 && element_length != 0)
+            return 0;
+
+        offset += content_length;
+        if (offset >= length)
+            return 0;
+
+        /* Instruction ends with a semicolon */
+        char terminator = buffer[offset++];
+        if (terminator == ';')
+            return offset;
+
+        /* Elements are separated by commas */
+        if (terminator != ',')
+            return 0;
+
+        element++;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * The number of bytes of the memory-mapped recording which must have been
+ * processed before the pages containing those bytes are released. The parser
+ * writes to each page it parses, and thus each such page becomes a private
+ * copy that would otherwise remain resident until the file is unmapped.
+ */
+#define GUACLOG_RELEASE_INTERVAL 1048576
+
+/**
+ * Releases the pages of the given memory-mapped recording which lie entirely
+ * before the given offset and have not yet been released, provided at least
+ * GUACLOG_RELEASE_INTERVAL bytes have been processed since pages were last
+ * released. No data within released pages may be referenced afterward.
+ *
+ * @param mapped
+ *     The start of the memory-mapped recording.
+ *
+ * @param released
+ *     A pointer to the offset of the first byte of the recording that has not
+ *     yet been released. This value is updated if pages are released.
+ *
+ * @param processed
+ *     The offset of the first byte of the recording that has not yet been
+ *     processed.
+ */
+static void guaclog_release_processed(char* mapped, size_t* released,
+        size_t processed) {
+
+    if (processed - *released < GUACLOG_RELEASE_INTERVAL)
+        return;
+
+    /* Release only whole pages */
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t end = processed - processed % page_size;
+
+    madvise(mapped + *released, end - *released, MADV_DONTNEED);
+    *released = end;
+
+}
+
+/**
+ * Reads and handles all Guacamole instructions from the given file until
+ * end-of-file is reached. The file is memory-mapped and each instruction is
+ * parsed in place, without first being copied into a separate buffer.
+ * Instructions which are irrelevant to the interpreter are skipped without
+ * being parsed at all.
  *
  * @param state
  *     The current state of the Guacamole input log interpreter.
  *
  * @param path
  *     The name of the file being parsed (for logging purposes). This file
- *     must already be open and available through the given socket.
+ *     must already be open and available through the given file descriptor.
  *
- * @param socket
- *     The guac_socket through which instructions should be read.
+ * @param fd
+ *     The file descriptor of the open file being parsed.
  *
  * @return
- *     Zero on success, non-zero if parsing of Guacamole protocol data through
- *     the given socket fails.
+ *     Zero on success, non-zero if the file cannot be mapped or parsing of
+ *     Guacamole protocol data within the file fails.
  */
 static int guaclog_read_instructions(guaclog_state* state,
-        const char* path, guac_socket* socket) {
+        const char* path, int fd) {
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat)) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* Empty files contain no instructions (and cannot be mapped) */
+    size_t remaining = file_stat.st_size;
+    if (remaining == 0)
+        return 0;
+
+    /* Map a private, writable copy of the file, as the parser NULL-terminates
+     * each element in place. Pages are released once processed, such that
+     * only the unprocessed remainder of the file is ever privately copied. */
+    char* mapped = mmap(NULL, remaining, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+            fd, 0);
+    if (mapped == MAP_FAILED) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* The file will be read exactly once, from beginning to end */
+    madvise(mapped, remaining, MADV_SEQUENTIAL);
 
     /* Obtain Guacamole protocol parser */
     guac_parser* parser = guac_parser_alloc();
-    if (parser == NULL)
+    if (parser == NULL) {
+        munmap(mapped, file_stat.st_size);
         return 1;
+    }
+
+    /* Continuously read and handle all relevant instructions */
+    int failed = 0;
+    size_t released = 0;
+    char* current = mapped;
+    while (remaining > 0) {
+
+        /* Skip irrelevant instructions without parsing */
+        size_t skipped = guaclog_skip_instruction(current, remaining);
+        if (skipped > 0) {
+            current += skipped;
+            remaining -= skipped;
+            guaclog_release_processed(mapped, &released, current - mapped);
+            continue;
+        }
+
+        /* Fully parse all other instructions */
+        int length = guac_parser_read_buffer(parser, current,
+                remaining > INT_MAX ? INT_MAX : remaining);
+
+        /* Stop at end of file, failing only on parse errors */
+        if (length <= 0) {
+            failed = (guac_error != GUAC_STATUS_CLOSED);
+            break;
+        }
 
-    /* Continuously read and handle all instructions */
-    while (!guac_parser_read(parser, socket, -1)) {
         guaclog_handle_instruction(state, parser->opcode,
                 parser->argc, parser->argv);
+
+        current += length;
+        remaining -= length;
+
+        guaclog_release_processed(mapped, &released, current - mapped);
+
     }
 
-    /* Fail on read/parse error */
-    if (guac_error != GUAC_STATUS_CLOSED) {
+    guac_parser_free(parser);
+    munmap(mapped, file_stat.st_size);
+
+    /* Fail on parse error */
+    if (failed) {
         guaclog_log(GUAC_LOG_ERROR, "%s: %s",
                 path, guac_status_string(guac_error));
-        guac_parser_free(parser);
         return 1;
     }
 
     /* Parse complete */
-    guac_parser_free(parser);
     return 0;
 
 }
 
-int guaclog_interpret(const char* path, const char* out_path, bool force) {
+/**
+ * Opens the given input file for reading, acquiring a read lock on the file
+ * to ensure that in-progress logs are not interpreted unless the force
+ * parameter is true. Failures are logged automatically.
+ *
+ * @param path
+ *     The path to the file containing the raw Guacamole protocol dump.
+ *
+ * @param force
+ *     Open the file even if it appears to be an in-progress log (has an
+ *     associated lock).
+ *
+ * @return
+ *     The file descriptor of the opened file, or -1 if the file could not be
+ *     opened.
+ */
+static int guaclog_open_input(const char* path, bool force) {
 
     /* Open input file */
     int fd = open(path, O_RDONLY);
     if (fd < 0) {
         guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
-        return 1;
+        return -1;
     }
 
     /* Lock entire input file for reading by the current process */
@@ -114,9 +360,20 @@ int guaclog_interpret(const char* path, const char* out_path, bool force) {
                     path, strerror(errno));
 
         close(fd);
-        return 1;
+        return -1;
     }
 
+    return fd;
+
+}
+
+int guaclog_interpret(const char* path, const char* out_path, bool force) {
+
+    /* Open input file */
+    int fd = guaclog_open_input(path, force);
+    if (fd < 0)
+        return 1;
+
     /* Allocate input state for interpreting process */
     guaclog_state* state = guaclog_state_alloc(out_path);
     if (state == NULL) {
@@ -124,29 +381,53 @@ int guaclog_interpret(const char* path, const char* out_path, bool force) {
         return 1;
     }
 
-    /* Obtain guac_socket wrapping file descriptor */
-    guac_socket* socket = guac_socket_open(fd);
-    if (socket == NULL) {
-        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path,
-                guac_status_string(guac_error));
-        close(fd);
-        guaclog_state_free(state);
-        return 1;
-    }
-
     guaclog_log(GUAC_LOG_INFO, "Writing input events from \"%s\" "
             "to \"%s\" ...", path, out_path);
 
     /* Attempt to read all instructions in the file */
-    if (guaclog_read_instructions(state, path, socket)) {
-        guac_socket_free(socket);
+    int failed = guaclog_read_instructions(state, path, fd);
+    close(fd);
+
+    if (failed) {
         guaclog_state_free(state);
         return 1;
     }
 
-    /* Close input and finish interpreting process */
-    guac_socket_free(socket);
+    /* Finish interpreting process */
     return guaclog_state_free(state);
 
 }
 
+int guaclog_interpret_json(const char* path, guaclog_output* output,
+        bool force) {
+
+    /* Open input file */
+    int fd = guaclog_open_input(path, force);
+    if (fd < 0)
+        return 1;
+
+    /* Allocate input state which buffers output in memory */
+    guaclog_state* state = guaclog_state_alloc_buffered();
+    if (state == NULL) {
+        close(fd);
+        return 1;
+    }
+
+    guaclog_log(GUAC_LOG_INFO, "Writing input events from \"%s\" ...",
+            path);
+
+    /* Attempt to read all instructions in the file */
+    int failed = guaclog_read_instructions(state, path, fd);
+    close(fd);
+
+    /* Write the entire interpreted log as a single line */
+    if (!failed) {
+        fflush(state->output);
+        failed = guaclog_output_write(output, path,
+                state->buffer, state->buffer_length);
+    }
+
+    guaclog_state_free(state);
+    return failed;
+
+}
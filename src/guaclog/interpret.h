@@ -21,6 +21,7 @@
 #define GUACLOG_INTERPRET_H
 
 #include "config.h"
+#include "output.h"
 
 #include <stdbool.h>
 
@@ -47,5 +48,29 @@
  */
 int guaclog_interpret(const char* path, const char* out_path, bool force);
 
+/**
+ * Interprets all input events within the given Guacamole protocol dump,
+ * identically to guaclog_interpret(), except that the human-readable log of
+ * those input events is written as a single JSON line to the given
+ * consolidated output rather than to a separate file. This function may be
+ * invoked concurrently from multiple threads.
+ *
+ * @param path
+ *     The path to the file containing the raw Guacamole protocol dump.
+ *
+ * @param output
+ *     The consolidated output to which the interpreted log should be written.
+ *
+ * @param force
+ *     Interpret even if the input file appears to be an in-progress log (has
+ *     an associated lock).
+ *
+ * @return
+ *     Zero on success, non-zero if an error prevented successful
+ *     interpretation of the log.
+ */
+int guaclog_interpret_json(const char* path, guaclog_output* output,
+        bool force);
+
 #endif
 
@@ -173,20 +173,53 @@ static guaclog_keydef* guaclog_get_known_key(int keysym) {
 }
 
 /**
- * Returns a statically-allocated guaclog_keydef representing an unknown key,
- * deriving the name of the key from the hexadecimal value of the keysym.
+ * Copies the given guaclog_keydef into a newly-allocated guaclog_keydef
+ * structure. The resulting guaclog_keydef must eventually be freed through a
+ * call to guaclog_keydef_free().
+ *
+ * @param keydef
+ *     The guaclog_keydef to copy.
+ *
+ * @return
+ *     A newly-allocated guaclog_keydef structure copied from the given
+ *     guaclog_keydef.
+ */
+static guaclog_keydef* guaclog_copy_key(guaclog_keydef* keydef) {
+
+    guaclog_keydef* copy = guac_mem_alloc(sizeof(guaclog_keydef));
+
+    /* Always copy keysym and name */
+    copy->keysym = keydef->keysym;
+    copy->name = guac_strdup(keydef->name);
+    copy->modifier = keydef->modifier;
+
+    /* Copy value only if defined */
+    if (keydef->value != NULL)
+        copy->value = guac_strdup(keydef->value);
+    else
+        copy->value = NULL;
+
+    return copy;
+
+}
+
+/**
+ * Returns a newly-allocated guaclog_keydef representing an unknown key,
+ * deriving the name of the key from the hexadecimal value of the keysym. The
+ * resulting guaclog_keydef must eventually be freed through a call to
+ * guaclog_keydef_free().
  *
  * @param keysym
  *     The X11 keysym of the key.
  *
  * @return
- *     A statically-allocated guaclog_keydef representing the key associated
- *     with the given keysym.
+ *     A newly-allocated guaclog_keydef representing the key associated with
+ *     the given keysym.
  */
 static guaclog_keydef* guaclog_get_unknown_key(int keysym) {
 
-    static char unknown_keydef_name[64];
-    static guaclog_keydef unknown_keydef;
+    char unknown_keydef_name[64];
+    guaclog_keydef unknown_keydef = { 0 };
 
     /* Write keysym as hex */
     int size = snprintf(unknown_keydef_name, sizeof(unknown_keydef_name),
@@ -195,31 +228,32 @@ static guaclog_keydef* guaclog_get_unknown_key(int keysym) {
     /* Hex string is guaranteed to fit within the provided 64 bytes */
     assert(size < sizeof(unknown_keydef_name));
 
-    /* Return static key definition */
+    /* Return copy of key definition */
     unknown_keydef.keysym = keysym;
     unknown_keydef.name = unknown_keydef_name;
-    return &unknown_keydef;
+    return guaclog_copy_key(&unknown_keydef);
 
 }
 
 /**
- * Returns a statically-allocated guaclog_keydef representing the key
- * associated with the given keysym, deriving the name and value of the key
- * using its corresponding Unicode character.
+ * Returns a newly-allocated guaclog_keydef representing the key associated
+ * with the given keysym, deriving the name and value of the key using its
+ * corresponding Unicode character. The resulting guaclog_keydef must
+ * eventually be freed through a call to guaclog_keydef_free().
  *
  * @param keysym
  *     The X11 keysym of the key.
  *
  * @return
- *     A statically-allocated guaclog_keydef representing the key associated
- *     with the given keysym, or NULL if the given keysym has no corresponding
+ *     A newly-allocated guaclog_keydef representing the key associated with
+ *     the given keysym, or NULL if the given keysym has no corresponding
  *     Unicode character.
  */
 static guaclog_keydef* guaclog_get_unicode_key(int keysym) {
 
-    static char unicode_keydef_name[8];
+    char unicode_keydef_name[8];
 
-    static guaclog_keydef unicode_keydef;
+    guaclog_keydef unicode_keydef;
 
     int i;
     int mask, bytes;
@@ -260,42 +294,11 @@ static guaclog_keydef* guaclog_get_unicode_key(int keysym) {
     /* Set initial byte */
     *key_name = mask | codepoint;
 
-    /* Return static key definition */
+    /* Return copy of key definition */
     unicode_keydef.keysym = keysym;
     unicode_keydef.name = unicode_keydef.value = unicode_keydef_name;
     unicode_keydef.modifier = false;
-    return &unicode_keydef;
-
-}
-
-/**
- * Copies the given guaclog_keydef into a newly-allocated guaclog_keydef
- * structure. The resulting guaclog_keydef must eventually be freed through a
- * call to guaclog_keydef_free().
- *
- * @param keydef
- *     The guaclog_keydef to copy.
- *
- * @return
- *     A newly-allocated guaclog_keydef structure copied from the given
- *     guaclog_keydef.
- */
-static guaclog_keydef* guaclog_copy_key(guaclog_keydef* keydef) {
-
-    guaclog_keydef* copy = guac_mem_alloc(sizeof(guaclog_keydef));
-
-    /* Always copy keysym and name */
-    copy->keysym = keydef->keysym;
-    copy->name = guac_strdup(keydef->name);
-    copy->modifier = keydef->modifier;
-
-    /* Copy value only if defined */
-    if (keydef->value != NULL)
-        copy->value = guac_strdup(keydef->value);
-    else
-        copy->value = NULL;
-
-    return copy;
+    return guaclog_copy_key(&unicode_keydef);
 
 }
 
@@ -311,11 +314,11 @@ guaclog_keydef* guaclog_keydef_alloc(int keysym) {
     /* Failing that, attempt to translate straight into a Unicode character */
     keydef = guaclog_get_unicode_key(keysym);
     if (keydef != NULL)
-        return guaclog_copy_key(keydef);
+        return keydef;
 
     /* Key not known */
     guaclog_log(GUAC_LOG_DEBUG, "Definition not found for key 0x%X.", keysym);
-    return guaclog_copy_key(guaclog_get_unknown_key(keysym));
+    return guaclog_get_unknown_key(keysym);
 
 }
 
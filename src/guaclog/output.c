@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "log.h"
+#include "output.h"
+
+#include <guacamole/mem.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+guaclog_output* guaclog_output_alloc(const char* path) {
+
+    /* Open output file, refusing to overwrite existing files */
+    int fd = open(path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to open output file \"%s\": %s",
+                path, strerror(errno));
+        return NULL;
+    }
+
+    /* Create stream for output file */
+    FILE* file = fdopen(fd, "wb");
+    if (file == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to allocate stream for output "
+                "file \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    guaclog_output* output = guac_mem_alloc(sizeof(guaclog_output));
+    output->file = file;
+    pthread_mutex_init(&output->lock, NULL);
+
+    return output;
+
+}
+
+/**
+ * Writes the given string to the given stream as a JSON string, including
+ * surrounding quotes and escaping any characters which may not appear
+ * unescaped within a JSON string. UTF-8 is written as-is.
+ *
+ * @param file
+ *     The stream to write to.
+ *
+ * @param str
+ *     The string to write, which need not be NULL-terminated.
+ *
+ * @param length
+ *     The length of the string to write, in bytes.
+ */
+static void guaclog_output_write_string(FILE* file, const char* str,
+        size_t length) {
+
+    fputc('"', file);
+
+    for (size_t i = 0; i < length; i++) {
+
+        unsigned char c = str[i];
+
+        /* Escape quotes and backslashes */
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        }
+
+        /* Escape control characters, which includes newlines */
+        else if (c < 0x20)
+            fprintf(file, "\\u%04X", c);
+
+        else
+            fputc(c, file);
+
+    }
+
+    fputc('"', file);
+
+}
+
+int guaclog_output_write(guaclog_output* output, const char* path,
+        const char* log, size_t length) {
+
+    pthread_mutex_lock(&output->lock);
+
+    fputs("{\"file\":", output->file);
+    guaclog_output_write_string(output->file, path, strlen(path));
+    fputs(",\"log\":", output->file);
+    guaclog_output_write_string(output->file, log, length);
+    fputs("}\n", output->file);
+
+    int failed = ferror(output->file);
+
+    pthread_mutex_unlock(&output->lock);
+    return failed;
+
+}
+
+int guaclog_output_free(guaclog_output* output) {
+
+    /* Ignore NULL output */
+    if (output == NULL)
+        return 0;
+
+    int failed = fclose(output->file);
+
+    pthread_mutex_destroy(&output->lock);
+    guac_mem_free(output);
+
+    return failed;
+
+}
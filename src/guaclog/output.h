@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOG_OUTPUT_H
+#define GUACLOG_OUTPUT_H
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * A single, consolidated output file to which the interpreted logs of any
+ * number of input files are written as JSON lines. Each line is a JSON object
+ * with two properties: "file", the path of the input file, and "log", the
+ * human-readable log interpreted from that file. Lines may be written
+ * concurrently from multiple threads.
+ */
+typedef struct guaclog_output {
+
+    /**
+     * The stream of the consolidated output file.
+     */
+    FILE* file;
+
+    /**
+     * Lock which guarantees that each line is written atomically.
+     */
+    pthread_mutex_t lock;
+
+} guaclog_output;
+
+/**
+ * Creates a new consolidated output file at the given path. Existing files
+ * will not be overwritten.
+ *
+ * @param path
+ *     The full path to the file to create.
+ *
+ * @return
+ *     The newly-allocated consolidated output, or NULL if the file could not
+ *     be created.
+ */
+guaclog_output* guaclog_output_alloc(const char* path);
+
+/**
+ * Writes a single JSON line to the given consolidated output describing the
+ * interpreted log of the given input file. This function is threadsafe.
+ *
+ * @param output
+ *     The consolidated output to write to.
+ *
+ * @param path
+ *     The path to the input file that was interpreted.
+ *
+ * @param log
+ *     The human-readable log interpreted from the input file. This log need
+ *     not be NULL-terminated.
+ *
+ * @param length
+ *     The length of the interpreted log, in bytes.
+ *
+ * @return
+ *     Zero if the line was written successfully, non-zero otherwise.
+ */
+int guaclog_output_write(guaclog_output* output, const char* path,
+        const char* log, size_t length);
+
+/**
+ * Closes the given consolidated output file and frees all associated
+ * memory. If the given output is NULL, this function has no effect.
+ *
+ * @param output
+ *     The consolidated output to free, which may be NULL.
+ *
+ * @return
+ *     Zero if all output was written successfully, non-zero otherwise.
+ */
+int guaclog_output_free(guaclog_output* output);
+
+#endif
+
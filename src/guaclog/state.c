@@ -78,6 +78,28 @@ fail_output_fd:
 
 }
 
+guaclog_state* guaclog_state_alloc_buffered() {
+
+    /* Allocate state */
+    guaclog_state* state = (guaclog_state*) guac_mem_zalloc(sizeof(guaclog_state));
+
+    /* Create stream for in-memory output, which will update the buffer and
+     * buffer_length of the state whenever it is flushed */
+    state->output = open_memstream(&state->buffer, &state->buffer_length);
+    if (state->output == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to allocate stream for output "
+                "buffer: %s", strerror(errno));
+        guac_mem_free(state);
+        return NULL;
+    }
+
+    /* No keys are initially tracked */
+    state->active_keys = 0;
+
+    return state;
+
+}
+
 int guaclog_state_free(guaclog_state* state) {
 
     int i;
@@ -93,6 +115,9 @@ int guaclog_state_free(guaclog_state* state) {
     /* Close output file */
     fclose(state->output);
 
+    /* Free in-memory output, if any (allocated by open_memstream()) */
+    free(state->buffer);
+
     guac_mem_free(state);
     return 0;
 
@@ -59,6 +59,20 @@ typedef struct guaclog_state {
      */
     FILE* output;
 
+    /**
+     * The contents of all output written thus far, if this state was
+     * allocated with guaclog_state_alloc_buffered(), or NULL otherwise. This
+     * buffer is updated only when the output stream is flushed.
+     */
+    char* buffer;
+
+    /**
+     * The number of bytes within the output buffer, if this state was
+     * allocated with guaclog_state_alloc_buffered(). This value is updated
+     * only when the output stream is flushed.
+     */
+    size_t buffer_length;
+
     /**
      * The number of keys currently being tracked within the key_states array.
      */
@@ -88,6 +102,19 @@ typedef struct guaclog_state {
  */
 guaclog_state* guaclog_state_alloc(const char* path);
 
+/**
+ * Allocates a new state structure for the Guacamole input log interpreter
+ * which writes its human-readable output to an in-memory buffer rather than
+ * to a file. After the output stream is flushed, the output written thus far
+ * is available through the buffer and buffer_length members of the returned
+ * state.
+ *
+ * @return
+ *     The newly-allocated Guacamole input log interpreter state, or NULL if
+ *     the state could not be allocated.
+ */
+guaclog_state* guaclog_state_alloc_buffered();
+
 /**
  * Frees all memory associated with the given Guacamole input log interpreter
  * state, and finishes any remaining interpreting process. If the given state
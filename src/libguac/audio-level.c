@@ -0,0 +1,203 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "audio-level.h"
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Returns the integer square root of the given value, rounded down.
+ *
+ * @param value
+ *     The value whose square root should be calculated.
+ *
+ * @return
+ *     The largest integer whose square does not exceed the given value.
+ */
+static uint32_t guac_audio_level_sqrt(uint64_t value) {
+
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    /* Start with the highest power of four not exceeding the value */
+    while (bit > value)
+        bit >>= 2;
+
+    /* Determine each bit of the root, from most to least significant */
+    while (bit != 0) {
+
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+
+        bit >>= 2;
+
+    }
+
+    return (uint32_t) root;
+
+}
+
+/**
+ * Measures the sum of squares and peak absolute value of the given signed,
+ * little-endian 16-bit samples.
+ *
+ * @param data
+ *     The 16-bit PCM data to measure.
+ *
+ * @param count
+ *     The number of samples within the PCM data.
+ *
+ * @param peak
+ *     Pointer to an int which will receive the peak absolute sample value.
+ *
+ * @return
+ *     The sum of the squares of all samples.
+ */
+static uint64_t guac_audio_level_measure16(const unsigned char* data,
+        int count, int* peak) {
+
+    uint64_t sum = 0;
+    int max = 0;
+    int min = 0;
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128i sum_vec = _mm_setzero_si128();
+    __m128i max_vec = _mm_setzero_si128();
+    __m128i min_vec = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+
+    /* Process 8 samples at a time. Each pair of squares produced by
+     * _mm_madd_epi16() is at most 2^31 and thus fits within an unsigned
+     * 32-bit integer, which is then widened before accumulation. */
+    for (; count - i >= 8; i += 8) {
+
+        __m128i samples = _mm_loadu_si128((const __m128i*) (data + i * 2));
+        __m128i squares = _mm_madd_epi16(samples, samples);
+
+        sum_vec = _mm_add_epi64(sum_vec, _mm_unpacklo_epi32(squares, zero));
+        sum_vec = _mm_add_epi64(sum_vec, _mm_unpackhi_epi32(squares, zero));
+
+        max_vec = _mm_max_epi16(max_vec, samples);
+        min_vec = _mm_min_epi16(min_vec, samples);
+
+    }
+
+    /* Reduce vector accumulators */
+    uint64_t sums[2];
+    int16_t maxs[8];
+    int16_t mins[8];
+    _mm_storeu_si128((__m128i*) sums, sum_vec);
+    _mm_storeu_si128((__m128i*) maxs, max_vec);
+    _mm_storeu_si128((__m128i*) mins, min_vec);
+
+    sum = sums[0] + sums[1];
+    for (int j = 0; j < 8; j++) {
+        if (maxs[j] > max) max = maxs[j];
+        if (mins[j] < min) min = mins[j];
+    }
+#endif
+
+    /* Process any remaining samples individually */
+    for (; i < count; i++) {
+
+        int sample = (int16_t) (data[i * 2] | (data[i * 2 + 1] << 8));
+        sum += (uint64_t) (sample * sample);
+
+        if (sample > max) max = sample;
+        if (sample < min) min = sample;
+
+    }
+
+    *peak = (-min > max) ? -min : max;
+    return sum;
+
+}
+
+/**
+ * Measures the sum of squares and peak absolute value of the given unsigned
+ * 8-bit samples, scaling each sample to the range of a signed 16-bit sample.
+ *
+ * @param data
+ *     The 8-bit PCM data to measure.
+ *
+ * @param count
+ *     The number of samples within the PCM data.
+ *
+ * @param peak
+ *     Pointer to an int which will receive the peak absolute sample value.
+ *
+ * @return
+ *     The sum of the squares of all samples.
+ */
+static uint64_t guac_audio_level_measure8(const unsigned char* data,
+        int count, int* peak) {
+
+    uint64_t sum = 0;
+    int max = 0;
+
+    for (int i = 0; i < count; i++) {
+
+        /* 8-bit PCM is unsigned, centered at 128 */
+        int sample = data[i] - 128;
+        int magnitude = (sample < 0) ? -sample : sample;
+
+        sum += (uint64_t) (magnitude * magnitude) << 16;
+        if (magnitude > max)
+            max = magnitude;
+
+    }
+
+    *peak = max << 8;
+    return sum;
+
+}
+
+void guac_audio_level_measure(const unsigned char* data, int length, int bps,
+        guac_audio_level* level) {
+
+    int bytes_per_sample = bps / 8;
+    int count = length / bytes_per_sample;
+
+    /* Empty buffers are silent */
+    if (count <= 0) {
+        level->rms = 0;
+        level->peak = 0;
+        return;
+    }
+
+    uint64_t sum;
+    if (bps == 16)
+        sum = guac_audio_level_measure16(data, count, &level->peak);
+    else
+        sum = guac_audio_level_measure8(data, count, &level->peak);
+
+    level->rms = guac_audio_level_sqrt(sum / count);
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_AUDIO_LEVEL_H
+#define GUAC_AUDIO_LEVEL_H
+
+#include "config.h"
+
+/**
+ * The signal level of a buffer of PCM data, with all values scaled to the
+ * range of a signed 16-bit sample regardless of the actual sample size.
+ */
+typedef struct guac_audio_level {
+
+    /**
+     * The root mean square of all samples within the buffer, across all
+     * channels.
+     */
+    int rms;
+
+    /**
+     * The largest absolute value of any sample within the buffer, across all
+     * channels.
+     */
+    int peak;
+
+} guac_audio_level;
+
+/**
+ * Measures the RMS and peak levels of the given buffer of signed,
+ * little-endian PCM data. Any trailing partial sample is ignored.
+ *
+ * @param data
+ *     The PCM data to measure.
+ *
+ * @param length
+ *     The number of bytes of PCM data provided.
+ *
+ * @param bps
+ *     The number of bits per sample of the PCM data. Legal values are 8 or
+ *     16.
+ *
+ * @param level
+ *     The guac_audio_level to populate with the measured levels. If the
+ *     buffer contains no complete samples, both levels will be zero.
+ */
+void guac_audio_level_measure(const unsigned char* data, int length, int bps,
+        guac_audio_level* level);
+
+#endif
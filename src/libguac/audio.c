@@ -19,17 +19,125 @@
 
 #include "config.h"
 
+#include "audio-level.h"
 #include "guacamole/mem.h"
 #include "guacamole/audio.h"
 #include "guacamole/client.h"
+#include "guacamole/flag.h"
 #include "guacamole/protocol.h"
 #include "guacamole/stream.h"
 #include "guacamole/user.h"
+#include "ima_adpcm_encoder.h"
 #include "raw_encoder.h"
 
+#ifdef ENABLE_OPUS
+#include "opus_audio_encoder.h"
+#endif
+
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Bitwise flag that is set on the flush_state of a guac_audio_stream when PCM
+ * data has been written.
+ */
+#define GUAC_AUDIO_STREAM_PCM_WRITTEN 1
+
+/**
+ * Bitwise flag that is set on the flush_state of a guac_audio_stream when its
+ * flush thread should stop.
+ */
+#define GUAC_AUDIO_STREAM_STOPPING 2
+
+/**
+ * Returns the number of bytes of PCM data which would be required to cover
+ * the given duration, given the format of the given audio stream. The number
+ * of bytes returned is always a multiple of the size of a single frame.
+ *
+ * @param audio
+ *     The guac_audio_stream whose PCM format should be used.
+ *
+ * @param duration
+ *     The duration to convert, in milliseconds.
+ *
+ * @return
+ *     The number of bytes of PCM data covering the given duration.
+ */
+static int guac_audio_stream_duration_length(guac_audio_stream* audio,
+        int duration) {
+
+    int frame_size = audio->channels * audio->bps / 8;
+    int64_t frames = (int64_t) audio->rate * duration / 1000;
+
+    return (int) (frames * frame_size);
+
+}
+
+/**
+ * Updates the silence state of the given audio stream to account for the
+ * given PCM data, returning whether that PCM data should be discarded. The
+ * stream is suppressed only after the configured duration of continuous
+ * silence, and resumes only once the signal clearly exceeds the silence
+ * threshold. Any pending PCM data is flushed as the stream is suppressed.
+ *
+ * @param audio
+ *     The guac_audio_stream receiving the PCM data. Silence suppression must
+ *     be enabled for this stream.
+ *
+ * @param data
+ *     The PCM data being written.
+ *
+ * @param length
+ *     The number of bytes of PCM data provided.
+ *
+ * @return
+ *     Non-zero if the given PCM data should be discarded, zero otherwise.
+ */
+static int guac_audio_stream_suppress(guac_audio_stream* audio,
+        const unsigned char* data, int length) {
+
+    int threshold = audio->silence_threshold;
+    int peak_threshold = threshold * GUAC_AUDIO_SILENCE_PEAK_FACTOR;
+
+    guac_audio_level level;
+    guac_audio_level_measure(data, length, audio->bps, &level);
+
+    /* Resume a suppressed stream only once the signal is clearly audible */
+    if (audio->suppressed) {
+
+        if (level.rms < threshold * GUAC_AUDIO_SILENCE_RESUME_FACTOR
+                && level.peak < peak_threshold)
+            return 1;
+
+        audio->suppressed = 0;
+        audio->silence_length = 0;
+        return 0;
+
+    }
+
+    /* Any non-silent data restarts the wait for continuous silence */
+    if (level.rms >= threshold || level.peak >= peak_threshold) {
+        audio->silence_length = 0;
+        return 0;
+    }
+
+    /* Continue sending silence until the hold duration has elapsed */
+    audio->silence_length += length;
+    if (audio->silence_length < guac_audio_stream_duration_length(audio,
+                audio->silence_hold))
+        return 0;
+
+    /* Send all remaining audio before going silent */
+    audio->suppressed = 1;
+    audio->sound_ended = 1;
+    guac_audio_stream_flush(audio);
+    audio->sound_ended = 0;
+    return 1;
+
+}
+
 /**
  * Sets the encoder associated with the given guac_audio_stream, automatically
  * invoking its begin_handler. The guac_audio_stream MUST NOT already be
@@ -53,11 +161,171 @@ static void guac_audio_stream_set_encoder(guac_audio_stream* audio,
 
 }
 
+/**
+ * Returns whether the given built-in encoder is capable of encoding audio
+ * having the properties of the given guac_audio_stream.
+ *
+ * @param encoder
+ *     The built-in encoder to test.
+ *
+ * @param audio
+ *     The guac_audio_stream whose properties (rate, channels, and bits per
+ *     sample) should be tested.
+ *
+ * @return
+ *     Non-zero if the given encoder can encode audio from the given stream,
+ *     zero otherwise.
+ */
+static int guac_audio_encoder_supports(guac_audio_encoder* encoder,
+        guac_audio_stream* audio) {
+
+#ifdef ENABLE_OPUS
+    /* Opus supports only 16-bit PCM at specific rates */
+    if (encoder == opus_audio_encoder)
+        return audio->bps == 16 && guac_opus_rate_supported(audio->rate)
+            && audio->channels >= 1 && audio->channels <= 2;
+#endif
+
+    /* IMA ADPCM compresses 16-bit PCM only */
+    if (encoder == ima_adpcm_encoder)
+        return audio->bps == 16 && audio->channels >= 1
+            && audio->channels <= GUAC_IMA_ADPCM_MAX_CHANNELS;
+
+    /* Raw encoders pass through PCM of their own sample size */
+    if (encoder == raw16_encoder)
+        return audio->bps == 16;
+
+    if (encoder == raw8_encoder)
+        return audio->bps == 8;
+
+    return 0;
+
+}
+
+/**
+ * Returns whether the given user has declared support for the mimetype of the
+ * given encoder.
+ *
+ * @param user
+ *     The user whose supported audio mimetypes should be checked.
+ *
+ * @param encoder
+ *     The encoder whose mimetype should be checked.
+ *
+ * @return
+ *     Non-zero if the user supports the mimetype of the given encoder, zero
+ *     otherwise.
+ */
+static int guac_audio_user_supports(guac_user* user,
+        guac_audio_encoder* encoder) {
+
+    for (int i = 0; user->info.audio_mimetypes[i] != NULL; i++) {
+        if (strcmp(user->info.audio_mimetypes[i], encoder->mimetype) == 0)
+            return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Returns whether the given built-in encoder produces raw PCM, which is
+ * assumed to be the most widely supported format.
+ *
+ * @param encoder
+ *     The built-in encoder to test.
+ *
+ * @return
+ *     Non-zero if the given encoder produces raw PCM, zero if the encoder
+ *     produces compressed audio.
+ */
+static int guac_audio_encoder_is_raw(guac_audio_encoder* encoder) {
+    return encoder == raw16_encoder || encoder == raw8_encoder;
+}
+
+/**
+ * The state of a search for any user that does not support a particular
+ * audio encoder.
+ */
+typedef struct guac_audio_support_search {
+
+    /**
+     * The encoder whose support is being checked.
+     */
+    guac_audio_encoder* encoder;
+
+    /**
+     * Non-zero if every user checked so far supports the encoder, zero
+     * otherwise.
+     */
+    int supported;
+
+} guac_audio_support_search;
+
+/**
+ * Callback for guac_client_foreach_user() and
+ * guac_client_foreach_pending_user() which clears the supported flag of the
+ * given guac_audio_support_search if the given user does not support its
+ * encoder.
+ *
+ * @param user
+ *     The user to check.
+ *
+ * @param data
+ *     The guac_audio_support_search being performed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_audio_check_user_support(guac_user* user, void* data) {
+
+    guac_audio_support_search* search = (guac_audio_support_search*) data;
+
+    if (!guac_audio_user_supports(user, search->encoder))
+        search->supported = 0;
+
+    return NULL;
+
+}
+
+/**
+ * Returns whether every user of the given client, including users that have
+ * not yet been fully joined, supports the mimetype of the given encoder.
+ *
+ * @param client
+ *     The client whose users should be checked.
+ *
+ * @param encoder
+ *     The encoder whose mimetype should be checked.
+ *
+ * @return
+ *     Non-zero if all users support the mimetype of the given encoder, zero
+ *     otherwise.
+ */
+static int guac_audio_all_users_support(guac_client* client,
+        guac_audio_encoder* encoder) {
+
+    guac_audio_support_search search = {
+        .encoder = encoder,
+        .supported = 1
+    };
+
+    guac_client_foreach_user(client, guac_audio_check_user_support, &search);
+    guac_client_foreach_pending_user(client, guac_audio_check_user_support,
+            &search);
+
+    return search.supported;
+
+}
+
 /**
  * Assigns a new audio encoder to the given guac_audio_stream based on the
- * audio mimetypes declared as supported by the given user. If no audio encoder
- * can be found, no new audio encoder is assigned, and the existing encoder is
- * left untouched (if any).
+ * audio mimetypes declared as supported by the given user. Compressed formats
+ * are preferred over raw PCM whenever the given user and all other users of
+ * the connection support them, as a single encoded stream is shared by all
+ * users. If no audio
+ * encoder can be found, no new audio encoder is assigned, and the existing
+ * encoder is left untouched (if any).
  *
  * @param user
  *     The user whose supported audio mimetypes should determine the audio
@@ -74,40 +342,97 @@ static void guac_audio_stream_set_encoder(guac_audio_stream* audio,
  */
 static void* guac_audio_assign_encoder(guac_user* user, void* data) {
 
-    int i;
-
     guac_audio_stream* audio = (guac_audio_stream*) data;
-    int bps = audio->bps;
 
     /* If no user is provided, or an encoder has already been assigned,
      * do not attempt to assign a new encoder */
     if (user == NULL || audio->encoder != NULL)
         return audio->encoder;
 
-    /* For each supported mimetype, check for an associated encoder */
-    for (i=0; user->info.audio_mimetypes[i] != NULL; i++) {
-
-        const char* mimetype = user->info.audio_mimetypes[i];
-
-        /* If 16-bit raw audio is supported, done. */
-        if (bps == 16 && strcmp(mimetype, raw16_encoder->mimetype) == 0) {
-            guac_audio_stream_set_encoder(audio, raw16_encoder);
-            break;
-        }
-
-        /* If 8-bit raw audio is supported, done. */
-        if (bps == 8 && strcmp(mimetype, raw8_encoder->mimetype) == 0) {
-            guac_audio_stream_set_encoder(audio, raw8_encoder);
+    /* All built-in encoders, in order of preference */
+    guac_audio_encoder* encoders[] = {
+#ifdef ENABLE_OPUS
+        opus_audio_encoder,
+#endif
+        ima_adpcm_encoder,
+        raw16_encoder,
+        raw8_encoder
+    };
+
+    /* Use the first encoder supported by both the user and the stream */
+    for (size_t i = 0; i < sizeof(encoders) / sizeof(encoders[0]); i++) {
+
+        guac_audio_encoder* encoder = encoders[i];
+
+        if (guac_audio_encoder_supports(encoder, audio)
+                && guac_audio_user_supports(user, encoder)
+                && (guac_audio_encoder_is_raw(encoder)
+                    || guac_audio_all_users_support(audio->client, encoder))) {
+            guac_audio_stream_set_encoder(audio, encoder);
             break;
         }
 
-    } /* end for each mimetype */
+    }
 
     /* Return assigned encoder, if any */
     return audio->encoder;
 
 }
 
+/**
+ * Thread which flushes the PCM data pending within a guac_audio_stream once no
+ * further PCM data has been written for the packet duration of that stream.
+ * Sources of audio typically stop sending PCM data entirely once a sound has
+ * ended, thus the end of each sound would otherwise remain pending until the
+ * next sound begins.
+ *
+ * @param data
+ *     The guac_audio_stream to flush.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_audio_stream_flush_thread(void* data) {
+
+    guac_audio_stream* audio = (guac_audio_stream*) data;
+    guac_flag* flush_state = &audio->flush_state;
+
+    for (;;) {
+
+        /* Wait indefinitely for PCM data to be written */
+        guac_flag_wait_and_lock(flush_state,
+                GUAC_AUDIO_STREAM_PCM_WRITTEN | GUAC_AUDIO_STREAM_STOPPING);
+
+        /* Continue waiting for as long as PCM data continues to be written */
+        do {
+
+            if (flush_state->value & GUAC_AUDIO_STREAM_STOPPING) {
+                guac_flag_unlock(flush_state);
+                return NULL;
+            }
+
+            guac_flag_clear(flush_state, GUAC_AUDIO_STREAM_PCM_WRITTEN);
+            guac_flag_unlock(flush_state);
+
+        } while (guac_flag_timedwait_and_lock(flush_state,
+                    GUAC_AUDIO_STREAM_PCM_WRITTEN | GUAC_AUDIO_STREAM_STOPPING,
+                    audio->packet_duration));
+
+        /* Send whatever remains of the sound that has now ended */
+        pthread_mutex_lock(&audio->lock);
+        if (audio->pending_length > 0) {
+            audio->sound_ended = 1;
+            guac_audio_stream_flush(audio);
+            audio->sound_ended = 0;
+        }
+        pthread_mutex_unlock(&audio->lock);
+
+    }
+
+    return NULL;
+
+}
+
 guac_audio_stream* guac_audio_stream_alloc(guac_client* client,
         guac_audio_encoder* encoder, int rate, int channels, int bps) {
 
@@ -129,6 +454,16 @@ guac_audio_stream* guac_audio_stream_alloc(guac_client* client,
     audio->channels = channels;
     audio->bps = bps;
 
+    /* The same thread may reacquire the lock while flushing from within an
+     * encoder */
+    pthread_mutexattr_t lock_attributes;
+    pthread_mutexattr_init(&lock_attributes);
+    pthread_mutexattr_settype(&lock_attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&audio->lock, &lock_attributes);
+    pthread_mutexattr_destroy(&lock_attributes);
+
+    guac_flag_init(&audio->flush_state);
+
     /* Assign encoder if explicitly provided */
     if (encoder != NULL)
         guac_audio_stream_set_encoder(audio, encoder);
@@ -148,6 +483,8 @@ guac_audio_stream* guac_audio_stream_alloc(guac_client* client,
 void guac_audio_stream_reset(guac_audio_stream* audio,
         guac_audio_encoder* encoder, int rate, int channels, int bps) {
 
+    pthread_mutex_lock(&audio->lock);
+
     /* Pull assigned encoder if no other encoder is requested */
     if (encoder == NULL)
         encoder = audio->encoder;
@@ -157,6 +494,7 @@ void guac_audio_stream_reset(guac_audio_stream* audio,
             && rate     == audio->rate
             && channels == audio->channels
             && bps      == audio->bps) {
+        pthread_mutex_unlock(&audio->lock);
         return;
     }
 
@@ -169,25 +507,65 @@ void guac_audio_stream_reset(guac_audio_stream* audio,
     audio->channels = channels;
     audio->bps = bps;
 
+    /* Nothing is pending within the new encoder */
+    audio->pending_length = 0;
+    audio->silence_length = 0;
+    audio->suppressed = 0;
+
     /* Re-init encoder */
     guac_audio_stream_set_encoder(audio, encoder);
 
+    pthread_mutex_unlock(&audio->lock);
+
 }
 
 void guac_audio_stream_add_user(guac_audio_stream* audio, guac_user* user) {
 
+    pthread_mutex_lock(&audio->lock);
+
     /* Attempt to assign encoder if no encoder has yet been assigned */
     if (audio->encoder == NULL)
         guac_audio_assign_encoder(user, audio);
 
+    /* If the new user cannot decode the compressed audio already being sent,
+     * fall back to raw PCM for all users */
+    else if (!guac_audio_encoder_is_raw(audio->encoder)
+            && !guac_audio_user_supports(user, audio->encoder)) {
+
+        guac_audio_encoder* raw = audio->bps == 16 ? raw16_encoder : raw8_encoder;
+
+        if (guac_audio_user_supports(user, raw)) {
+            guac_client_log(audio->client, GUAC_LOG_DEBUG, "Joining user "
+                    "does not support \"%s\". Falling back to \"%s\" for "
+                    "all users.", audio->encoder->mimetype, raw->mimetype);
+            guac_audio_stream_flush(audio);
+            guac_audio_stream_reset(audio, raw, audio->rate,
+                    audio->channels, audio->bps);
+        }
+
+        else
+            guac_client_log(audio->client, GUAC_LOG_WARNING, "Joining user "
+                    "supports neither \"%s\" nor raw PCM. Audio will not be "
+                    "playable for that user.", audio->encoder->mimetype);
+
+    }
+
     /* Notify encoder that a new user is present */
     if (audio->encoder != NULL && audio->encoder->join_handler)
         audio->encoder->join_handler(audio, user);
 
+    pthread_mutex_unlock(&audio->lock);
+
 }
 
 void guac_audio_stream_free(guac_audio_stream* audio) {
 
+    /* Stop flushing automatically */
+    if (audio->flush_thread_started) {
+        guac_flag_set(&audio->flush_state, GUAC_AUDIO_STREAM_STOPPING);
+        pthread_join(audio->flush_thread, NULL);
+    }
+
     /* Flush stream encoding */
     guac_audio_stream_flush(audio);
 
@@ -198,25 +576,93 @@ void guac_audio_stream_free(guac_audio_stream* audio) {
     /* Release stream back to client pool */
     guac_client_free_stream(audio->client, audio->stream);
 
+    pthread_mutex_destroy(&audio->lock);
+    guac_flag_destroy(&audio->flush_state);
+
     /* Free associated data */
     guac_mem_free(audio);
 
 }
 
+void guac_audio_stream_set_packet_duration(guac_audio_stream* audio,
+        int duration) {
+
+    pthread_mutex_lock(&audio->lock);
+    audio->packet_duration = duration;
+
+    /* Flush the end of each sound once PCM data stops arriving */
+    if (duration > 0 && !audio->flush_thread_started) {
+        if (pthread_create(&audio->flush_thread, NULL,
+                    guac_audio_stream_flush_thread, audio) == 0)
+            audio->flush_thread_started = 1;
+        else
+            guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                    "start audio flush thread. The end of each sound may be "
+                    "delayed.");
+    }
+
+    pthread_mutex_unlock(&audio->lock);
+
+}
+
+void guac_audio_stream_set_silence_threshold(guac_audio_stream* audio,
+        int threshold, int hold) {
+
+    pthread_mutex_lock(&audio->lock);
+
+    audio->silence_threshold = threshold;
+    audio->silence_hold = hold;
+
+    /* Restart silence detection with new parameters */
+    audio->silence_length = 0;
+    audio->suppressed = 0;
+
+    pthread_mutex_unlock(&audio->lock);
+
+}
+
 void guac_audio_stream_write_pcm(guac_audio_stream* audio, 
         const unsigned char* data, int length) {
 
+    pthread_mutex_lock(&audio->lock);
+
+    /* Discard silence if suppression is enabled */
+    if (audio->silence_threshold > 0
+            && guac_audio_stream_suppress(audio, data, length)) {
+        pthread_mutex_unlock(&audio->lock);
+        return;
+    }
+
     /* Write data */
     if (audio->encoder != NULL && audio->encoder->write_handler)
         audio->encoder->write_handler(audio, data, length);
 
+    /* Automatically flush once a full packet is pending */
+    audio->pending_length += length;
+    if (audio->packet_duration > 0 && audio->pending_length
+            >= guac_audio_stream_duration_length(audio, audio->packet_duration))
+        guac_audio_stream_flush(audio);
+
+    /* Delay any automatic flush of the remainder */
+    if (audio->flush_thread_started)
+        guac_flag_set(&audio->flush_state, GUAC_AUDIO_STREAM_PCM_WRITTEN);
+
+    pthread_mutex_unlock(&audio->lock);
+
 }
 
 void guac_audio_stream_flush(guac_audio_stream* audio) {
 
+    pthread_mutex_lock(&audio->lock);
+
+    /* Nothing remains pending after flush */
+    audio->pending_length = 0;
+
     /* Flush any buffered data */
     if (audio->encoder != NULL && audio->encoder->flush_handler)
         audio->encoder->flush_handler(audio);
 
+    pthread_mutex_unlock(&audio->lock);
+
 }
 
@@ -0,0 +1,276 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "display-plan.h"
+#include "display-priv.h"
+
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/rect.h>
+#include <guacamole/rwlock.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * The width of the display, in pixels.
+ */
+#define BENCH_DISPLAY_WIDTH 1920
+
+/**
+ * The height of the display, in pixels.
+ */
+#define BENCH_DISPLAY_HEIGHT 1080
+
+/**
+ * The number of times a display plan is created for each scenario.
+ */
+#define BENCH_DISPLAY_ROUNDS 50
+
+/**
+ * The number of pixels by which the display is scrolled in the "scroll"
+ * scenario (a single line of typical terminal text).
+ */
+#define BENCH_DISPLAY_SCROLL 16
+
+/**
+ * The number of characters changed in the "typing" scenario.
+ */
+#define BENCH_DISPLAY_TYPED 8
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Returns the color of the pixel at the given coordinates of a synthetic
+ * frame resembling a terminal or document: dark, evenly-spaced glyph-like
+ * strokes on a light background. The given line offset shifts the text
+ * vertically by whole lines, as if scrolled.
+ */
+static uint32_t bench_text_pixel(int x, int y, int line_offset) {
+
+    int row = y / BENCH_DISPLAY_SCROLL + line_offset;
+    int cell_x = x % 8;
+    int cell_y = y % BENCH_DISPLAY_SCROLL;
+    int glyph = (uint32_t) ((x / 8) * 2654435761U ^ row * 40503U) >> 16;
+
+    if (cell_y >= 3 && cell_y < 13 && cell_x < 6
+            && (glyph % 5 != 0) && ((cell_x + cell_y + glyph) % 3 == 0))
+        return 0xFF202020;
+
+    return 0xFFF8F8F8;
+
+}
+
+/**
+ * Returns the color of the pixel at the given coordinates of a synthetic
+ * frame consisting of pseudo-random noise which varies with the given seed.
+ */
+static uint32_t bench_noise_pixel(int x, int y, int seed) {
+    return 0xFF000000
+        | ((uint32_t) ((x + seed) * 2654435761U ^ y * 40503U) >> 8);
+}
+
+/**
+ * Redraws the entire default layer of the given display using the given
+ * pixel function.
+ */
+static void bench_draw(guac_display* display,
+        uint32_t (*pixel)(int x, int y, int param), int param) {
+
+    guac_display_layer* layer = guac_display_default_layer(display);
+    guac_display_layer_raw_context* context = guac_display_layer_open_raw(layer);
+
+    for (int y = 0; y < BENCH_DISPLAY_HEIGHT; y++) {
+        uint32_t* row = (uint32_t*) (context->buffer + y * context->stride);
+        for (int x = 0; x < BENCH_DISPLAY_WIDTH; x++)
+            row[x] = pixel(x, y, param);
+    }
+
+    guac_rect_init(&context->dirty, 0, 0,
+            BENCH_DISPLAY_WIDTH, BENCH_DISPLAY_HEIGHT);
+    guac_display_layer_close_raw(layer, context);
+
+}
+
+/**
+ * Replaces a few characters near the middle of the default layer of the
+ * given display, as happens while a user is typing.
+ */
+static void bench_type(guac_display* display) {
+
+    guac_display_layer* layer = guac_display_default_layer(display);
+    guac_display_layer_raw_context* context = guac_display_layer_open_raw(layer);
+
+    int top = BENCH_DISPLAY_HEIGHT / 2;
+    int left = BENCH_DISPLAY_WIDTH / 2;
+
+    for (int y = top; y < top + BENCH_DISPLAY_SCROLL; y++) {
+        uint32_t* row = (uint32_t*) (context->buffer + y * context->stride);
+        for (int x = left; x < left + BENCH_DISPLAY_TYPED * 8; x++)
+            row[x] = (x % 8 < 6 && y % 4) ? 0xFF202020 : 0xFFF8F8F8;
+    }
+
+    guac_display_layer_close_raw(layer, context);
+
+}
+
+/**
+ * Marks the entire default layer of the given display as dirty without
+ * changing its contents, such that the next display plan must compare every
+ * pixel against the last frame, as happens when a caller reports a larger
+ * modified region than was actually changed.
+ */
+static void bench_mark_dirty(guac_display* display) {
+
+    guac_display_layer* layer = guac_display_default_layer(display);
+    guac_display_layer_raw_context* context = guac_display_layer_open_raw(layer);
+
+    guac_rect_init(&context->dirty, 0, 0,
+            BENCH_DISPLAY_WIDTH, BENCH_DISPLAY_HEIGHT);
+    guac_display_layer_close_raw(layer, context);
+
+}
+
+/**
+ * Repeatedly creates and optimizes a display plan for the changes between
+ * the last frame and the pending frame of the given display, measuring the
+ * time taken to create the plan (PFW_LFR_guac_display_plan_create()) and to
+ * search the last frame for copyable content (including every call to
+ * guac_hash_foreach_image_rect()). Results are printed in the tab-separated
+ * format shared by all benchmarks: one line per metric, each consisting of
+ * the benchmark name, the metric name, the value of the metric, and its unit.
+ */
+static void bench_plan(const char* name, guac_display* display) {
+
+    uint64_t create_duration = 0;
+    uint64_t search_duration = 0;
+    size_t operations = 0;
+    size_t copies = 0;
+
+    for (int i = 0; i < BENCH_DISPLAY_ROUNDS; i++) {
+
+        bench_mark_dirty(display);
+
+        guac_rwlock_acquire_write_lock(&display->pending_frame.lock);
+        guac_rwlock_acquire_read_lock(&display->last_frame.lock);
+
+        uint64_t start = bench_now();
+        guac_display_plan* plan = PFW_LFR_guac_display_plan_create(display);
+        uint64_t created = bench_now();
+
+        if (plan != NULL) {
+
+            PFR_guac_display_plan_rewrite_as_rects(plan);
+
+            uint64_t search_start = bench_now();
+            PFR_guac_display_plan_index_dirty_cells(plan);
+            PFR_LFR_guac_display_plan_rewrite_as_copies(plan);
+            search_duration += bench_now() - search_start;
+
+            /* Count operations once (all rounds produce the same plan) */
+            if (i == 0) {
+                for (size_t j = 0; j < plan->length; j++) {
+                    if (plan->ops[j].type == GUAC_DISPLAY_PLAN_OPERATION_COPY)
+                        copies++;
+                    if (plan->ops[j].type != GUAC_DISPLAY_PLAN_OPERATION_NOP
+                            && plan->ops[j].type != GUAC_DISPLAY_PLAN_END_FRAME)
+                        operations++;
+                }
+            }
+
+            guac_display_plan_free(plan);
+
+        }
+
+        create_duration += created - start;
+
+        guac_rwlock_release_lock(&display->last_frame.lock);
+        guac_rwlock_release_lock(&display->pending_frame.lock);
+
+    }
+
+    printf("%s\ttime_create\t%.2f\tns\n", name,
+            (double) create_duration / BENCH_DISPLAY_ROUNDS);
+    printf("%s\ttime_search\t%.2f\tns\n", name,
+            (double) search_duration / BENCH_DISPLAY_ROUNDS);
+    printf("%s\toperations\t%zu\tcount\n", name, operations);
+    printf("%s\tcopies\t%zu\tcount\n", name, copies);
+
+}
+
+/**
+ * Allocates a new guac_display for the given client whose last frame
+ * contains synthetic text.
+ */
+static guac_display* bench_display_alloc(guac_client* client) {
+
+    guac_display* display = guac_display_alloc(client);
+    guac_display_layer_resize(guac_display_default_layer(display),
+            BENCH_DISPLAY_WIDTH, BENCH_DISPLAY_HEIGHT);
+
+    bench_draw(display, bench_text_pixel, 0);
+    guac_display_end_frame(display);
+
+    return display;
+
+}
+
+int main(int argc, char** argv) {
+
+    guac_client* client = guac_client_alloc();
+    guac_display* display;
+
+    /* Nothing changed despite the entire display being marked dirty */
+    display = bench_display_alloc(client);
+    bench_plan("display_plan_unchanged", display);
+    guac_display_free(display);
+
+    /* A few characters typed */
+    display = bench_display_alloc(client);
+    bench_type(display);
+    bench_plan("display_plan_typing", display);
+    guac_display_free(display);
+
+    /* Text scrolled by a single line */
+    display = bench_display_alloc(client);
+    bench_draw(display, bench_text_pixel, 1);
+    bench_plan("display_plan_scroll", display);
+    guac_display_free(display);
+
+    /* Entire display replaced with new content */
+    display = bench_display_alloc(client);
+    bench_draw(display, bench_noise_pixel, 1);
+    bench_plan("display_plan_full_update", display);
+    guac_display_free(display);
+
+    guac_client_free(client);
+    return 0;
+
+}
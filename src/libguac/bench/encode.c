@@ -0,0 +1,279 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "encode-jpeg.h"
+#include "encode-png.h"
+#include "palette.h"
+
+#ifdef ENABLE_WEBP
+#include "encode-webp.h"
+#endif
+
+#include <cairo/cairo.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * The width of each synthetic image, in pixels. This is the width of a
+ * typical image operation after the display has combined adjacent 64x64
+ * cells.
+ */
+#define BENCH_ENCODE_WIDTH 256
+
+/**
+ * The height of each synthetic image, in pixels.
+ */
+#define BENCH_ENCODE_HEIGHT 256
+
+/**
+ * The number of times each image is encoded by each encoder.
+ */
+#define BENCH_ENCODE_ROUNDS 100
+
+/**
+ * The quality used for lossy encoding, matching the highest quality chosen by
+ * the display worker threads for connections without lag.
+ */
+#define BENCH_ENCODE_QUALITY 90
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Socket write handler which discards all data written, counting the number
+ * of bytes written within the size_t pointed to by the socket's data member.
+ */
+static ssize_t bench_count_write(guac_socket* socket, const void* buf,
+        size_t count) {
+    *((size_t*) socket->data) += count;
+    return count;
+}
+
+/**
+ * Returns the color of the pixel at the given coordinates of a synthetic
+ * image resembling terminal or document text: dark, evenly-spaced glyph-like
+ * strokes on a light background, using only a few distinct colors.
+ */
+static uint32_t bench_text_pixel(int x, int y) {
+
+    int cell_x = x % 8;
+    int cell_y = y % 16;
+    int glyph = (x / 8) * 31 + (y / 16) * 17;
+
+    if (cell_y >= 3 && cell_y < 13 && cell_x < 6
+            && (glyph % 5 != 0) && ((cell_x + cell_y + glyph) % 3 == 0))
+        return (glyph % 7 == 0) ? 0xFF2060A0 : 0xFF202020;
+
+    return 0xFFF8F8F8;
+
+}
+
+/**
+ * Returns the color of the pixel at the given coordinates of a synthetic
+ * image resembling a photograph or desktop wallpaper: smooth gradients with
+ * mild variation, using many distinct colors.
+ */
+static uint32_t bench_gradient_pixel(int x, int y) {
+
+    int variation = ((x * 7 + y * 13) % 5) - 2;
+    int red = (x * 255 / BENCH_ENCODE_WIDTH) + variation;
+    int green = (y * 255 / BENCH_ENCODE_HEIGHT) - variation;
+    int blue = ((x + y) * 127 / BENCH_ENCODE_WIDTH) + variation;
+
+    if (red < 0) red = 0;
+    if (green < 0) green = 0;
+    if (blue < 0) blue = 0;
+
+    return 0xFF000000 | (red << 16) | (green << 8) | blue;
+
+}
+
+/**
+ * Returns the color of the pixel at the given coordinates of a synthetic
+ * image consisting of pseudo-random noise, representing the worst case for
+ * all encoders.
+ */
+static uint32_t bench_noise_pixel(int x, int y) {
+    return 0xFF000000 | ((uint32_t) (x * 2654435761U ^ y * 40503U) >> 8);
+}
+
+/**
+ * Allocates a new Cairo image surface of BENCH_ENCODE_WIDTH by
+ * BENCH_ENCODE_HEIGHT pixels, filled using the given pixel function.
+ */
+static cairo_surface_t* bench_create_image(uint32_t (*pixel)(int x, int y)) {
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+            BENCH_ENCODE_WIDTH, BENCH_ENCODE_HEIGHT);
+
+    unsigned char* data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+
+    for (int y = 0; y < BENCH_ENCODE_HEIGHT; y++) {
+        uint32_t* row = (uint32_t*) (data + y * stride);
+        for (int x = 0; x < BENCH_ENCODE_WIDTH; x++)
+            row[x] = pixel(x, y);
+    }
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+
+}
+
+/**
+ * The image encoders being benchmarked.
+ */
+typedef enum bench_encoder {
+    BENCH_ENCODER_PNG,
+    BENCH_ENCODER_JPEG,
+    BENCH_ENCODER_WEBP
+} bench_encoder;
+
+/**
+ * Encodes the given surface BENCH_ENCODE_ROUNDS times using the given
+ * encoder, printing the average time taken and the number of bytes sent per
+ * image in the tab-separated format shared by all benchmarks: one line per
+ * metric, each consisting of the benchmark name, the metric name, the value
+ * of the metric, and its unit.
+ */
+static void bench_encode(const char* name, bench_encoder encoder,
+        cairo_surface_t* surface) {
+
+    size_t bytes = 0;
+    guac_socket* socket = guac_socket_alloc();
+    socket->data = &bytes;
+    socket->write_handler = bench_count_write;
+
+    guac_stream stream = { .index = 1 };
+
+    uint64_t start = bench_now();
+    for (int i = 0; i < BENCH_ENCODE_ROUNDS; i++) {
+
+        switch (encoder) {
+
+            case BENCH_ENCODER_PNG:
+                guac_png_write(socket, &stream, surface);
+                break;
+
+            case BENCH_ENCODER_JPEG:
+                guac_jpeg_write(socket, &stream, surface,
+                        BENCH_ENCODE_QUALITY);
+                break;
+
+#ifdef ENABLE_WEBP
+            case BENCH_ENCODER_WEBP:
+                guac_webp_write(socket, &stream, surface,
+                        BENCH_ENCODE_QUALITY, 0);
+                break;
+#endif
+
+            default:
+                break;
+
+        }
+
+        guac_socket_flush(socket);
+
+    }
+    uint64_t duration = bench_now() - start;
+
+    printf("%s\ttime_per_image\t%.2f\tns\n", name,
+            (double) duration / BENCH_ENCODE_ROUNDS);
+    printf("%s\tbytes_per_image\t%.2f\tbytes\n", name,
+            (double) bytes / BENCH_ENCODE_ROUNDS);
+
+    guac_socket_free(socket);
+
+}
+
+/**
+ * Builds a palette for the given surface BENCH_ENCODE_ROUNDS times, as is
+ * done by the PNG encoder for every image, printing the average time taken
+ * in the tab-separated format shared by all benchmarks.
+ */
+static void bench_palette(const char* name, cairo_surface_t* surface) {
+
+    uint64_t start = bench_now();
+    for (int i = 0; i < BENCH_ENCODE_ROUNDS; i++) {
+        guac_palette* palette = guac_palette_alloc(surface);
+        if (palette != NULL)
+            guac_palette_free(palette);
+    }
+    uint64_t duration = bench_now() - start;
+
+    printf("%s\ttime_per_image\t%.2f\tns\n", name,
+            (double) duration / BENCH_ENCODE_ROUNDS);
+
+}
+
+int main(int argc, char** argv) {
+
+    struct {
+        const char* name;
+        uint32_t (*pixel)(int x, int y);
+    } images[] = {
+        { "text",     bench_text_pixel     },
+        { "gradient", bench_gradient_pixel },
+        { "noise",    bench_noise_pixel    }
+    };
+
+    int count = sizeof(images) / sizeof(images[0]);
+    for (int i = 0; i < count; i++) {
+
+        cairo_surface_t* surface = bench_create_image(images[i].pixel);
+        char name[64];
+
+        snprintf(name, sizeof(name), "palette_alloc_%s", images[i].name);
+        bench_palette(name, surface);
+
+        snprintf(name, sizeof(name), "png_write_%s", images[i].name);
+        bench_encode(name, BENCH_ENCODER_PNG, surface);
+
+        snprintf(name, sizeof(name), "jpeg_write_%s", images[i].name);
+        bench_encode(name, BENCH_ENCODER_JPEG, surface);
+
+#ifdef ENABLE_WEBP
+        snprintf(name, sizeof(name), "webp_write_%s", images[i].name);
+        bench_encode(name, BENCH_ENCODER_WEBP, surface);
+#endif
+
+        cairo_surface_destroy(surface);
+
+    }
+
+    return 0;
+
+}
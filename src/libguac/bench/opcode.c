@@ -0,0 +1,266 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <guacamole/error.h>
+#include <guacamole/opcode.h>
+#include <guacamole/parser.h>
+#include <guacamole/socket.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The number of times each benchmark dispatches every instruction within the
+ * instruction mix.
+ */
+#define BENCH_OPCODE_ROUNDS 200
+
+/**
+ * The maximum number of opcodes read from recordings to form the instruction
+ * mix. Only the opcodes of instructions are retained.
+ */
+#define BENCH_OPCODE_MAX_MIX 1000000
+
+/**
+ * Trivial instruction handler, counting the number of times each instruction
+ * is dispatched such that dispatch cannot be optimized away.
+ */
+typedef void bench_handler(uint64_t* counter);
+
+/**
+ * Mapping of opcode to handler, laid out identically to the instruction
+ * handler maps of libguac, guacenc, and guaclog.
+ */
+typedef struct bench_mapping {
+
+    /**
+     * The opcode associated with the handler.
+     */
+    const char* opcode;
+
+    /**
+     * The handler to invoke for the associated opcode.
+     */
+    bench_handler* handler;
+
+} bench_mapping;
+
+/**
+ * Handler for all opcodes within bench_map, incrementing the given counter.
+ */
+static void bench_handle(uint64_t* counter) {
+    (*counter)++;
+}
+
+/**
+ * The union of all opcodes handled by libguac (on behalf of users) and
+ * guacenc, in the order they are listed within their respective maps.
+ */
+static bench_mapping bench_map[] = {
+    {"sync",       bench_handle},
+    {"touch",      bench_handle},
+    {"mouse",      bench_handle},
+    {"key",        bench_handle},
+    {"clipboard",  bench_handle},
+    {"disconnect", bench_handle},
+    {"size",       bench_handle},
+    {"file",       bench_handle},
+    {"pipe",       bench_handle},
+    {"ack",        bench_handle},
+    {"blob",       bench_handle},
+    {"end",        bench_handle},
+    {"get",        bench_handle},
+    {"put",        bench_handle},
+    {"audio",      bench_handle},
+    {"argv",       bench_handle},
+    {"nop",        bench_handle},
+    {"img",        bench_handle},
+    {"cursor",     bench_handle},
+    {"copy",       bench_handle},
+    {"transfer",   bench_handle},
+    {"rect",       bench_handle},
+    {"cfill",      bench_handle},
+    {"move",       bench_handle},
+    {"shade",      bench_handle},
+    {"dispose",    bench_handle},
+    {NULL,         NULL}
+};
+
+/**
+ * Instruction mix used if no recordings are provided, approximating the
+ * input received from an active user: predominantly mouse movement and sync
+ * responses, with occasional key events and stream acknowledgements.
+ */
+static const char* bench_default_mix[] = {
+    "mouse", "mouse", "mouse", "mouse", "mouse", "mouse", "mouse", "sync",
+    "mouse", "mouse", "mouse", "mouse", "mouse", "mouse", "key",   "sync",
+    "mouse", "mouse", "mouse", "key",   "mouse", "mouse", "ack",   "sync",
+    "mouse", "mouse", "mouse", "mouse", "key",   "size",  "nop",   "sync"
+};
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Dispatches the given opcode by comparing it against every opcode in the
+ * map in order, as done by handler lookups prior to the introduction of
+ * guac_opcode_index.
+ */
+static void bench_dispatch_linear(const char* opcode, uint64_t* counter) {
+
+    for (bench_mapping* current = bench_map; current->opcode != NULL;
+            current++) {
+
+        if (strcmp(current->opcode, opcode) == 0) {
+            current->handler(counter);
+            return;
+        }
+
+    }
+
+}
+
+/**
+ * Dispatches the given opcode using the given guac_opcode_index.
+ */
+static void bench_dispatch_indexed(const guac_opcode_index* index,
+        const char* opcode, uint64_t* counter) {
+
+    const bench_mapping* mapping = guac_opcode_index_lookup(index, bench_map,
+            sizeof(bench_mapping), opcode);
+
+    if (mapping != NULL)
+        mapping->handler(counter);
+
+}
+
+/**
+ * Appends the opcodes of all instructions within the given recording to the
+ * given instruction mix.
+ *
+ * @return
+ *     Zero on success, non-zero if the recording cannot be read.
+ */
+static int bench_read_mix(const char* path, char** mix, int* length) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    guac_socket* socket = guac_socket_open(fd);
+    guac_parser* parser = guac_parser_alloc();
+
+    while (*length < BENCH_OPCODE_MAX_MIX
+            && guac_parser_read(parser, socket, -1) == 0)
+        mix[(*length)++] = strdup(parser->opcode);
+
+    guac_parser_free(parser);
+    guac_socket_free(socket);
+    return 0;
+
+}
+
+/**
+ * Prints the results of a single benchmark in the tab-separated format shared
+ * by all benchmarks: one line per metric, each consisting of the benchmark
+ * name, the metric name, the value of the metric, and its unit.
+ */
+static void bench_report(const char* name, uint64_t operations,
+        uint64_t duration) {
+    printf("%s\toperations\t%" PRIu64 "\tcount\n", name, operations);
+    printf("%s\ttime_per_operation\t%.2f\tns\n", name,
+            (double) duration / operations);
+}
+
+int main(int argc, char** argv) {
+
+    char** mix = malloc(sizeof(char*) * BENCH_OPCODE_MAX_MIX);
+    int length = 0;
+
+    /* Read instruction mix from recordings, if any */
+    for (int i = 1; i < argc; i++) {
+        if (bench_read_mix(argv[i], mix, &length))
+            return 1;
+    }
+
+    /* Fall back to synthetic user input */
+    if (length == 0) {
+        int default_length = sizeof(bench_default_mix) / sizeof(char*);
+        for (length = 0; length < default_length; length++)
+            mix[length] = strdup(bench_default_mix[length]);
+    }
+
+    guac_opcode_index index;
+    guac_opcode_index_init(&index, bench_map, sizeof(bench_mapping));
+
+    /* Repeat instruction mix such that each benchmark takes measurable time */
+    int rounds = BENCH_OPCODE_ROUNDS;
+    if (length < 1000)
+        rounds = BENCH_OPCODE_ROUNDS * 1000 / length;
+
+    uint64_t operations = (uint64_t) rounds * length;
+    uint64_t linear_count = 0;
+    uint64_t indexed_count = 0;
+
+    uint64_t start = bench_now();
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < length; i++)
+            bench_dispatch_linear(mix[i], &linear_count);
+    }
+    bench_report("opcode_dispatch_linear", operations, bench_now() - start);
+
+    start = bench_now();
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < length; i++)
+            bench_dispatch_indexed(&index, mix[i], &indexed_count);
+    }
+    bench_report("opcode_dispatch_indexed", operations, bench_now() - start);
+
+    /* Both approaches must agree on which instructions are handled */
+    if (linear_count != indexed_count) {
+        fprintf(stderr, "Dispatch mismatch: %" PRIu64 " linear vs. %" PRIu64
+                " indexed\n", linear_count, indexed_count);
+        return 1;
+    }
+
+    for (int i = 0; i < length; i++)
+        free(mix[i]);
+
+    free(mix);
+    return 0;
+
+}
+
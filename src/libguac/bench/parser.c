@@ -0,0 +1,356 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+#include <guacamole/socket.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The approximate size of each synthetic instruction stream, in bytes.
+ */
+#define BENCH_PARSER_STREAM_SIZE 4194304
+
+/**
+ * The number of times each instruction stream is parsed.
+ */
+#define BENCH_PARSER_ROUNDS 20
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Allocates a synthetic instruction stream consisting of the given
+ * instruction, repeated until the stream is roughly
+ * BENCH_PARSER_STREAM_SIZE bytes long.
+ *
+ * @param instruction
+ *     The instruction to repeat.
+ *
+ * @param length
+ *     Pointer to a size_t which will receive the length of the stream.
+ *
+ * @return
+ *     A newly-allocated buffer containing the stream.
+ */
+static char* bench_repeat(const char* instruction, size_t* length) {
+
+    size_t instruction_length = strlen(instruction);
+    size_t count = BENCH_PARSER_STREAM_SIZE / instruction_length + 1;
+
+    char* stream = malloc(count * instruction_length);
+    for (size_t i = 0; i < count; i++)
+        memcpy(stream + i * instruction_length, instruction,
+                instruction_length);
+
+    *length = count * instruction_length;
+    return stream;
+
+}
+
+/**
+ * Allocates a synthetic "blob" instruction whose payload consists of the
+ * given string repeated the given number of times.
+ *
+ * @param payload
+ *     The string to repeat within the blob payload.
+ *
+ * @param payload_chars
+ *     The number of UTF-8 characters within the given string.
+ *
+ * @param repeat
+ *     The number of times to repeat the given string.
+ *
+ * @return
+ *     A newly-allocated, NULL-terminated blob instruction.
+ */
+static char* bench_blob(const char* payload, int payload_chars, int repeat) {
+
+    size_t payload_length = strlen(payload);
+    char* instruction = malloc(payload_length * repeat + 64);
+
+    int offset = sprintf(instruction, "4.blob,1.7,%i.",
+            payload_chars * repeat);
+
+    for (int i = 0; i < repeat; i++) {
+        memcpy(instruction + offset, payload, payload_length);
+        offset += payload_length;
+    }
+
+    strcpy(instruction + offset, ";");
+    return instruction;
+
+}
+
+/**
+ * Reads the entire contents of the given file into a newly-allocated buffer.
+ *
+ * @param path
+ *     The path of the file to read.
+ *
+ * @param length
+ *     Pointer to a size_t which will receive the length of the file.
+ *
+ * @return
+ *     A newly-allocated buffer containing the file, or NULL if the file
+ *     cannot be read.
+ */
+static char* bench_read_file(const char* path, size_t* length) {
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    struct stat file_stat;
+    fstat(fileno(file), &file_stat);
+
+    char* buffer = malloc(file_stat.st_size + 1);
+    *length = fread(buffer, 1, file_stat.st_size, file);
+
+    fclose(file);
+    return buffer;
+
+}
+
+/**
+ * Prints the results of a single benchmark in the tab-separated format shared
+ * by all benchmarks: one line per metric, each consisting of the benchmark
+ * name, the metric name, the value of the metric, and its unit.
+ */
+static void bench_report(const char* name, uint64_t instructions,
+        uint64_t duration, uint64_t bytes) {
+    printf("%s\tinstructions\t%" PRIu64 "\tcount\n", name, instructions);
+    printf("%s\ttime_per_instruction\t%.2f\tns\n", name,
+            (double) duration / instructions);
+    printf("%s\tthroughput\t%.1f\tMB/s\n", name,
+            bytes * 1000.0 / duration);
+}
+
+/**
+ * Repeatedly parses every instruction within the given stream using
+ * guac_parser_read_buffer() (and thus guac_parser_append()), printing the
+ * results as a line of tab-separated values: the benchmark name, the number
+ * of instructions parsed, the average time per instruction in nanoseconds,
+ * and the overall throughput in megabytes per second.
+ *
+ * @param name
+ *     The name of the benchmark.
+ *
+ * @param stream
+ *     The instruction stream to parse. The stream is not modified.
+ *
+ * @param length
+ *     The length of the stream, in bytes.
+ */
+static void bench_parse(const char* name, const char* stream, size_t length) {
+
+    guac_parser* parser = guac_parser_alloc();
+    char* buffer = malloc(length);
+
+    uint64_t instructions = 0;
+    uint64_t bytes = 0;
+    uint64_t duration = 0;
+
+    for (int round = 0; round < BENCH_PARSER_ROUNDS; round++) {
+
+        /* The parser modifies the buffer in place, so restore it */
+        memcpy(buffer, stream, length);
+
+        char* current = buffer;
+        size_t remaining = length;
+
+        uint64_t start = bench_now();
+        while (remaining > 0) {
+
+            int parsed = guac_parser_read_buffer(parser, current,
+                    remaining > INT32_MAX ? INT32_MAX : remaining);
+            if (parsed <= 0)
+                break;
+
+            current += parsed;
+            remaining -= parsed;
+            instructions++;
+
+        }
+        duration += bench_now() - start;
+        bytes += length - remaining;
+
+    }
+
+    if (instructions > 0)
+        bench_report(name, instructions, duration, bytes);
+
+    free(buffer);
+    guac_parser_free(parser);
+
+}
+
+/**
+ * Callback for guac_parser_read_batch() which counts each instruction read.
+ *
+ * @param parser
+ *     The parser which read the instruction.
+ *
+ * @param data
+ *     Pointer to the uint64_t counting instructions read.
+ *
+ * @return
+ *     Always zero.
+ */
+static int bench_count_instruction(guac_parser* parser, void* data) {
+    (*((uint64_t*) data))++;
+    return 0;
+}
+
+/**
+ * Repeatedly reads every instruction within the given stream through a
+ * guac_socket, using either guac_parser_read() or guac_parser_read_batch(),
+ * printing the results in the same format as bench_parse(). The stream is
+ * read from a temporary file, such that the cost of each read is that of the
+ * syscall alone.
+ *
+ * @param name
+ *     The name of the benchmark.
+ *
+ * @param stream
+ *     The instruction stream to read.
+ *
+ * @param length
+ *     The length of the stream, in bytes.
+ *
+ * @param batch
+ *     Non-zero if guac_parser_read_batch() should be used, zero if
+ *     guac_parser_read() should be used.
+ */
+static void bench_read_socket(const char* name, const char* stream,
+        size_t length, int batch) {
+
+    char path[] = "/tmp/bench_parser.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, stream, length) != (ssize_t) length) {
+        perror(path);
+        return;
+    }
+
+    close(fd);
+
+    uint64_t instructions = 0;
+    uint64_t duration = 0;
+
+    for (int round = 0; round < BENCH_PARSER_ROUNDS; round++) {
+
+        guac_socket* socket = guac_socket_open(open(path, O_RDONLY));
+        guac_parser* parser = guac_parser_alloc();
+
+        uint64_t start = bench_now();
+
+        if (batch) {
+            while (guac_parser_read_batch(parser, socket, -1,
+                        bench_count_instruction, &instructions) >= 0);
+        }
+
+        else {
+            while (guac_parser_read(parser, socket, -1) == 0)
+                instructions++;
+        }
+
+        duration += bench_now() - start;
+
+        guac_parser_free(parser);
+        guac_socket_free(socket);
+
+    }
+
+    unlink(path);
+
+    if (instructions > 0)
+        bench_report(name, instructions, duration,
+                (uint64_t) length * BENCH_PARSER_ROUNDS);
+
+}
+
+int main(int argc, char** argv) {
+
+    size_t length;
+    char* stream;
+
+    /* Input received by guacd from an active user */
+    stream = bench_repeat("5.mouse,3.512,3.384,1.0,13.1718659205123;"
+            "5.mouse,3.513,3.386,1.0,13.1718659205140;"
+            "3.key,5.65507,1.1;4.sync,13.1718659205141;", &length);
+    bench_parse("parser_user_input", stream, length);
+    bench_read_socket("parser_socket_read_user_input", stream, length, 0);
+    bench_read_socket("parser_socket_read_batch_user_input", stream, length, 1);
+    free(stream);
+
+    /* Base64 image data, as found within recordings or file uploads */
+    char* blob = bench_blob("iVBORw0KGgoAAAANSUhEUgAAAEAAAABACAYAAACqaXHe", 44, 186);
+    stream = bench_repeat(blob, &length);
+    bench_parse("parser_base64_blobs", stream, length);
+    bench_read_socket("parser_socket_read_base64_blobs", stream, length, 0);
+    bench_read_socket("parser_socket_read_batch_base64_blobs", stream, length, 1);
+    free(stream);
+    free(blob);
+
+    /* Clipboard text mixing ASCII with multibyte characters */
+    blob = bench_blob("Guacamole \xc3\xa9t\xc3\xa9 \xe7\x8a\xac "
+            "clientless remote desktop gateway\n", 50, 160);
+    stream = bench_repeat(blob, &length);
+    bench_parse("parser_utf8_clipboard", stream, length);
+    free(stream);
+    free(blob);
+
+    /* Recordings, as read by guacenc and guaclog */
+    for (int i = 1; i < argc; i++) {
+
+        stream = bench_read_file(argv[i], &length);
+        if (stream == NULL)
+            return 1;
+
+        char name[256];
+        snprintf(name, sizeof(name), "parser_recording:%s", argv[i]);
+        bench_parse(name, stream, length);
+        free(stream);
+
+    }
+
+    return 0;
+
+}
+
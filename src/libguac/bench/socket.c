@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <guacamole/layer.h>
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The number of frames written for each socket output buffer size.
+ */
+#define BENCH_SOCKET_FRAMES 2000
+
+/**
+ * The number of drawing instructions within each frame, each alternating
+ * between "rect" and "cfill".
+ */
+#define BENCH_SOCKET_DRAW_INSTRUCTIONS 40
+
+/**
+ * The number of images sent within each frame.
+ */
+#define BENCH_SOCKET_IMAGES 4
+
+/**
+ * The number of bytes of (unencoded) image data sent for each image.
+ */
+#define BENCH_SOCKET_IMAGE_SIZE 16384
+
+/**
+ * The total number of bytes of (unencoded) data written when measuring the
+ * throughput of guac_socket_write_base64().
+ */
+#define BENCH_SOCKET_BASE64_SIZE 67108864
+
+/**
+ * The socket output buffer sizes to compare, in bytes.
+ */
+static const size_t bench_buffer_sizes[] = { 8192, 65536, 262144 };
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Returns the number of write-type system calls made by this process so far,
+ * as reported by /proc/self/io.
+ *
+ * @return
+ *     The number of write-type system calls made so far, or -1 if this
+ *     information is not available.
+ */
+static int64_t bench_write_syscalls() {
+
+    FILE* io = fopen("/proc/self/io", "r");
+    if (io == NULL)
+        return -1;
+
+    int64_t count = -1;
+    char line[256];
+    while (fgets(line, sizeof(line), io) != NULL) {
+        if (sscanf(line, "syscw: %" SCNd64, &count) == 1)
+            break;
+    }
+
+    fclose(io);
+    return count;
+
+}
+
+/**
+ * Writes a single frame to the given socket, approximating a busy display
+ * update: many small drawing instructions interleaved with several image
+ * streams, followed by a sync and a flush.
+ */
+static void bench_write_frame(guac_socket* socket, const unsigned char* image,
+        int frame) {
+
+    guac_layer layer = { .index = 0 };
+    guac_stream stream = { .index = 1 };
+
+    for (int i = 0; i < BENCH_SOCKET_DRAW_INSTRUCTIONS; i++) {
+        if (i % 2)
+            guac_protocol_send_cfill(socket, GUAC_COMP_OVER, &layer,
+                    i, frame & 0xFF, 0x40, 0xFF);
+        else
+            guac_protocol_send_rect(socket, &layer, i * 8, frame % 512,
+                    64, 64);
+    }
+
+    for (int i = 0; i < BENCH_SOCKET_IMAGES; i++) {
+        guac_protocol_send_img(socket, &stream, GUAC_COMP_OVER, &layer,
+                "image/png", i * 64, 0);
+        guac_protocol_send_blobs(socket, &stream, image,
+                BENCH_SOCKET_IMAGE_SIZE);
+        guac_protocol_send_end(socket, &stream);
+    }
+
+    guac_protocol_send_sync(socket, frame, 1);
+    guac_socket_flush(socket);
+
+}
+
+/**
+ * Prints the results of a single benchmark in the tab-separated format shared
+ * by all benchmarks: one line per metric, each consisting of the benchmark
+ * name, the metric name, the value of the metric, and its unit. The number of
+ * write system calls is omitted if unavailable.
+ */
+static void bench_report(const char* name, uint64_t frames, uint64_t duration,
+        int64_t syscalls) {
+    printf("%s\tframes\t%" PRIu64 "\tcount\n", name, frames);
+    printf("%s\ttime_per_frame\t%.2f\tns\n", name,
+            (double) duration / frames);
+    if (syscalls >= 0)
+        printf("%s\tsyscalls_per_frame\t%.2f\tsyscalls\n", name,
+                (double) syscalls / frames);
+}
+
+/**
+ * Measures the throughput of guac_socket_write_base64(), writing
+ * BENCH_SOCKET_BASE64_SIZE bytes of the given image data to the given socket
+ * in BENCH_SOCKET_IMAGE_SIZE chunks, as is done for each blob of an image
+ * stream.
+ */
+static void bench_write_base64(guac_socket* socket,
+        const unsigned char* image) {
+
+    uint64_t start = bench_now();
+
+    for (int written = 0; written < BENCH_SOCKET_BASE64_SIZE;
+            written += BENCH_SOCKET_IMAGE_SIZE)
+        guac_socket_write_base64(socket, image, BENCH_SOCKET_IMAGE_SIZE);
+
+    guac_socket_flush_base64(socket);
+    guac_socket_flush(socket);
+
+    uint64_t duration = bench_now() - start;
+
+    printf("socket_write_base64\tthroughput\t%.1f\tMB/s\n",
+            BENCH_SOCKET_BASE64_SIZE * 1000.0 / duration);
+
+}
+
+int main(int argc, char** argv) {
+
+    /* Arbitrary, incompressible-looking image data */
+    unsigned char* image = malloc(BENCH_SOCKET_IMAGE_SIZE);
+    for (int i = 0; i < BENCH_SOCKET_IMAGE_SIZE; i++)
+        image[i] = (i * 2654435761U) >> 24;
+
+    int sizes = sizeof(bench_buffer_sizes) / sizeof(bench_buffer_sizes[0]);
+    for (int i = 0; i < sizes; i++) {
+
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd < 0) {
+            perror("/dev/null");
+            return 1;
+        }
+
+        guac_socket* socket = guac_socket_open_buffered(fd,
+                bench_buffer_sizes[i]);
+
+        int64_t start_syscalls = bench_write_syscalls();
+        uint64_t start = bench_now();
+
+        for (int frame = 0; frame < BENCH_SOCKET_FRAMES; frame++)
+            bench_write_frame(socket, image, frame);
+
+        uint64_t duration = bench_now() - start;
+        int64_t end_syscalls = bench_write_syscalls();
+
+        char name[64];
+        snprintf(name, sizeof(name), "socket_frame_buffer_%zu",
+                bench_buffer_sizes[i]);
+
+        bench_report(name, BENCH_SOCKET_FRAMES, duration,
+                (start_syscalls < 0 || end_syscalls < 0)
+                    ? -1 : end_syscalls - start_syscalls);
+
+        /* Measure raw base64 throughput using the largest buffer */
+        if (i == sizes - 1)
+            bench_write_base64(socket, image);
+
+        guac_socket_free(socket);
+
+    }
+
+    free(image);
+    return 0;
+
+}
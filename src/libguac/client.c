@@ -25,7 +25,9 @@
 #include "guacamole/mem.h"
 #include "guacamole/client.h"
 #include "guacamole/error.h"
+#include "guacamole/flag.h"
 #include "guacamole/layer.h"
+#include "guacamole/metrics.h"
 #include "guacamole/plugin.h"
 #include "guacamole/pool.h"
 #include "guacamole/protocol.h"
@@ -48,28 +50,32 @@
 #include <string.h>
 
 /**
- * The number of milliseconds between times that the pending users list will be
- * synchronized and emptied (250 milliseconds aka 1/4 second).
+ * The maximum number of milliseconds that may elapse between users joining
+ * for those users to be considered part of the same burst of joining users.
+ * All users within a burst are synchronized together, with a single
+ * invocation of the join_pending_handler.
  */
-#define GUAC_CLIENT_PENDING_USERS_REFRESH_INTERVAL 250
+#define GUAC_CLIENT_PENDING_USERS_BATCH_INTERVAL 10
 
 /**
- * A value that indicates that the pending users timer has yet to be
- * initialized and started.
+ * The maximum number of milliseconds that synchronization of pending users
+ * may be delayed while waiting for a burst of joining users to end (250
+ * milliseconds aka 1/4 second).
  */
-#define GUAC_CLIENT_PENDING_TIMER_UNREGISTERED 0
+#define GUAC_CLIENT_PENDING_USERS_MAX_BATCH_DURATION 250
 
 /**
- * A value that indicates that the pending users timer has been initialized
- * and started, but that the timer handler is not currently running.
+ * Bitwise flag that is set on the __pending_users_flag of a guac_client when
+ * at least one user has been added to the list of pending users since the
+ * pending users thread last checked that list.
  */
-#define GUAC_CLIENT_PENDING_TIMER_REGISTERED 1
+#define GUAC_CLIENT_PENDING_USERS_WAITING 1
 
 /**
- * A value that indicates that the pending users timer has been initialized
- * and started, and that the timer handler is currently running.
+ * Bitwise flag that is set on the __pending_users_flag of a guac_client when
+ * the pending users thread should stop.
  */
-#define GUAC_CLIENT_PENDING_TIMER_TRIGGERED 2
+#define GUAC_CLIENT_PENDING_USERS_STOPPING 2
 
 /**
  * Empty NULL-terminated array of argument names.
@@ -228,9 +234,13 @@ promotion_complete:
 }
 
 /**
- * Thread that periodically checks for users that have requested to join the
- * current connection (pending users). The check is performed every
- * GUAC_CLIENT_PENDING_USERS_REFRESH_INTERVAL milliseconds.
+ * Thread that promotes users that have requested to join the current
+ * connection (pending users) as they join. The thread sleeps until
+ * guac_client_add_pending_user() signals that a user has joined, and then
+ * continues waiting for as long as further users join within
+ * GUAC_CLIENT_PENDING_USERS_BATCH_INTERVAL milliseconds of each other (up to
+ * GUAC_CLIENT_PENDING_USERS_MAX_BATCH_DURATION milliseconds), such that a
+ * burst of joining users is promoted all at once.
  *
  * @param data
  *     A pointer to the guac_client associated with the connection.
@@ -241,10 +251,41 @@ promotion_complete:
 static void* guac_client_pending_users_thread(void* data) {
 
     guac_client* client = (guac_client*) data;
+    guac_flag* pending_users_flag = &client->__pending_users_flag;
+
+    for (;;) {
+
+        /* Wait indefinitely for users to join */
+        guac_flag_wait_and_lock(pending_users_flag,
+                  GUAC_CLIENT_PENDING_USERS_WAITING
+                | GUAC_CLIENT_PENDING_USERS_STOPPING);
+
+        /* Continue waiting while further users join in quick succession */
+        guac_timestamp batch_start = guac_timestamp_current();
+        do {
+
+            /* Bail out immediately if the client is stopping */
+            if ((pending_users_flag->value & GUAC_CLIENT_PENDING_USERS_STOPPING)
+                    || client->state != GUAC_CLIENT_RUNNING) {
+                guac_flag_unlock(pending_users_flag);
+                return NULL;
+            }
+
+            guac_flag_clear(pending_users_flag, GUAC_CLIENT_PENDING_USERS_WAITING);
+            guac_flag_unlock(pending_users_flag);
+
+            /* Do not delay the first user of the burst indefinitely */
+            if (guac_timestamp_current() - batch_start
+                    >= GUAC_CLIENT_PENDING_USERS_MAX_BATCH_DURATION)
+                break;
+
+        } while (guac_flag_timedwait_and_lock(pending_users_flag,
+                      GUAC_CLIENT_PENDING_USERS_WAITING
+                    | GUAC_CLIENT_PENDING_USERS_STOPPING,
+                    GUAC_CLIENT_PENDING_USERS_BATCH_INTERVAL));
 
-    while (client->state == GUAC_CLIENT_RUNNING) {
         guac_client_promote_pending_users(client);
-        guac_timestamp_msleep(GUAC_CLIENT_PENDING_USERS_REFRESH_INTERVAL);
+
     }
 
     return NULL;
@@ -291,9 +332,13 @@ guac_client* guac_client_alloc() {
         client->__output_streams[i].index = GUAC_CLIENT_CLOSED_STREAM_INDEX;
     }
 
+    /* Allocate performance counters */
+    client->metrics = guac_metrics_alloc();
+
     /* Init locks */
     guac_rwlock_init(&(client->__users_lock));
     guac_rwlock_init(&(client->__pending_users_lock));
+    guac_flag_init(&(client->__pending_users_flag));
 
     /* Set up broadcast sockets */
     client->socket = guac_socket_broadcast(client);
@@ -308,6 +353,19 @@ void guac_client_free(guac_client* client) {
     /* Ensure that anything waiting for the client can begin shutting down */
     guac_client_stop(client);
 
+    /* Clean up the thread promoting pending users, if it's been started. This
+     * must be done before acquiring the locks below, as that thread acquires
+     * those same locks while promoting users. */
+    guac_rwlock_acquire_read_lock(&(client->__pending_users_lock));
+    int pending_users_thread_started = client->__pending_users_thread_started;
+    guac_rwlock_release_lock(&(client->__pending_users_lock));
+
+    if (pending_users_thread_started) {
+        guac_flag_set(&(client->__pending_users_flag),
+                GUAC_CLIENT_PENDING_USERS_STOPPING);
+        pthread_join(client->__pending_users_thread, NULL);
+    }
+
     /* Acquire write locks before referencing user pointers */
     guac_rwlock_acquire_write_lock(&(client->__pending_users_lock));
     guac_rwlock_acquire_write_lock(&(client->__users_lock));
@@ -320,11 +378,6 @@ void guac_client_free(guac_client* client) {
     while (client->__users != NULL)
         guac_client_remove_user(client, client->__users);
 
-    /* Clean up the thread monitoring for new pending users, if it's been
-     * started */
-    if (client->__pending_users_thread_started)
-        pthread_join(client->__pending_users_thread, NULL);
-
     /* Release the locks */
     guac_rwlock_release_lock(&(client->__users_lock));
     guac_rwlock_release_lock(&(client->__pending_users_lock));
@@ -359,7 +412,9 @@ void guac_client_free(guac_client* client) {
     /* Destroy the reentrant read-write locks */
     guac_rwlock_destroy(&(client->__users_lock));
     guac_rwlock_destroy(&(client->__pending_users_lock));
+    guac_flag_destroy(&(client->__pending_users_flag));
 
+    guac_metrics_free(client->metrics);
     guac_mem_free(client->connection_id);
     guac_mem_free(client);
 }
@@ -439,7 +494,7 @@ static void guac_client_add_pending_user(guac_client* client,
     /* Acquire the lock for modifying the list of pending users */
     guac_rwlock_acquire_write_lock(&(client->__pending_users_lock));
 
-    /* Set up the pending user promotion mutex */
+    /* Start the thread that promotes pending users, if not yet started */
     if (!client->__pending_users_thread_started) {
         pthread_create(&client->__pending_users_thread, NULL,
                 guac_client_pending_users_thread, (void*) client);
@@ -460,6 +515,10 @@ static void guac_client_add_pending_user(guac_client* client,
     /* Release the lock */
     guac_rwlock_release_lock(&(client->__pending_users_lock));
 
+    /* Wake the pending users thread to promote the new user */
+    guac_flag_set(&(client->__pending_users_flag),
+            GUAC_CLIENT_PENDING_USERS_WAITING);
+
 }
 
 int guac_client_add_user(guac_client* client, guac_user* user, int argc, char** argv) {
@@ -795,8 +854,13 @@ void guac_client_stream_png(guac_client* client, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/png", x, y);
 
-    /* Write PNG data */
-    guac_png_write(socket, stream, surface);
+    /* Write PNG data, recording the time taken and amount of data sent */
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_png_write(socket, stream, surface);
+    if (size > 0)
+        guac_metrics_add(client->metrics, GUAC_METRICS_PNG_BYTES, size);
+    guac_metrics_observe_since(client->metrics,
+            GUAC_METRICS_PNG_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -816,8 +880,13 @@ void guac_client_stream_jpeg(guac_client* client, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/jpeg", x, y);
 
-    /* Write JPEG data */
-    guac_jpeg_write(socket, stream, surface, quality);
+    /* Write JPEG data, recording the time taken and amount of data sent */
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_jpeg_write(socket, stream, surface, quality);
+    if (size > 0)
+        guac_metrics_add(client->metrics, GUAC_METRICS_JPEG_BYTES, size);
+    guac_metrics_observe_since(client->metrics,
+            GUAC_METRICS_JPEG_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -838,8 +907,13 @@ void guac_client_stream_webp(guac_client* client, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/webp", x, y);
 
-    /* Write WebP data */
-    guac_webp_write(socket, stream, surface, quality, lossless);
+    /* Write WebP data, recording the time taken and amount of data sent */
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_webp_write(socket, stream, surface, quality, lossless);
+    if (size > 0)
+        guac_metrics_add(client->metrics, GUAC_METRICS_WEBP_BYTES, size);
+    guac_metrics_observe_since(client->metrics,
+            GUAC_METRICS_WEBP_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -0,0 +1,311 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "display-priv.h"
+#include "guacamole/display.h"
+#include "guacamole/error.h"
+#include "guacamole/mem.h"
+#include "guacamole/timestamp.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/**
+ * The encoder budget shared by this process, if any. As the budget is
+ * established before any child processes are created, those processes inherit
+ * both this pointer and the shared memory that it references.
+ */
+static guac_display_encoder_budget* guac_display_budget = NULL;
+
+/**
+ * The lease of the encoder budget associated with this process, or zero if
+ * no lease has yet been associated with this process. Child processes inherit
+ * the lease of their parent unless given their own lease with
+ * guac_display_use_encoder_lease().
+ */
+static uint64_t guac_display_encoder_lease = 0;
+
+/**
+ * Restores the consistency of the given encoder budget after a process
+ * terminated while holding its lock, recalculating all counters from the
+ * slots and waiters that are recorded. Anything recorded against the lease
+ * of the terminated process remains until that lease is closed. The lock of
+ * the budget must already be held by the current thread.
+ *
+ * @param budget
+ *     The encoder budget whose consistency should be restored.
+ */
+static void guac_display_budget_restore(guac_display_encoder_budget* budget) {
+
+    budget->available = 0;
+    for (int i = 0; i < budget->size; i++) {
+        if (budget->owners[i] == 0)
+            budget->available++;
+    }
+
+    budget->interactive_waiting = 0;
+    for (int i = 0; i < GUAC_DISPLAY_BUDGET_MAX_INTERACTIVE_WAITERS; i++) {
+        if (budget->interactive_waiters[i] != 0)
+            budget->interactive_waiting++;
+    }
+
+    pthread_mutex_consistent(&budget->lock);
+    pthread_cond_broadcast(&budget->changed);
+
+}
+
+/**
+ * Acquires the lock of the given encoder budget, restoring the consistency of
+ * the budget if the previous holder of the lock terminated while holding it.
+ *
+ * @param budget
+ *     The encoder budget to lock.
+ */
+static void guac_display_budget_lock(guac_display_encoder_budget* budget) {
+    if (pthread_mutex_lock(&budget->lock) == EOWNERDEAD)
+        guac_display_budget_restore(budget);
+}
+
+/**
+ * Releases the lock of the given encoder budget, waits for the budget to
+ * change, and reacquires the lock, restoring the consistency of the budget if
+ * the previous holder of the lock terminated while holding it. The lock of
+ * the budget must already be held by the current thread.
+ *
+ * @param budget
+ *     The encoder budget to wait for.
+ */
+static void guac_display_budget_wait(guac_display_encoder_budget* budget) {
+    if (pthread_cond_wait(&budget->changed, &budget->lock) == EOWNERDEAD)
+        guac_display_budget_restore(budget);
+}
+
+/**
+ * Returns the lease associated with this process, opening a new lease if
+ * this process has not yet been associated with any lease. The lock of the
+ * given budget must already be held by the current thread.
+ *
+ * @param budget
+ *     The encoder budget shared by this process.
+ *
+ * @return
+ *     The lease associated with this process.
+ */
+static uint64_t guac_display_budget_lease(
+        guac_display_encoder_budget* budget) {
+
+    if (guac_display_encoder_lease == 0)
+        guac_display_encoder_lease = ++budget->last_lease;
+
+    return guac_display_encoder_lease;
+
+}
+
+int guac_display_set_encoder_budget(int encoders) {
+
+    /* Nothing to do if no budget is requested */
+    if (encoders <= 0)
+        return 0;
+
+    if (guac_display_budget != NULL) {
+        guac_error = GUAC_STATUS_INVALID_ARGUMENT;
+        guac_error_message = "Encoder budget has already been established";
+        return 1;
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+
+    /* The budget must be visible to all child processes, and thus cannot
+     * reside within ordinary heap memory */
+    size_t size = guac_mem_ckd_add_or_die(sizeof(guac_display_encoder_budget),
+            guac_mem_ckd_mul_or_die(encoders, sizeof(uint64_t)));
+
+    guac_display_encoder_budget* budget = mmap(NULL, size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (budget == MAP_FAILED) {
+        guac_error = GUAC_STATUS_SEE_ERRNO;
+        guac_error_message = "Shared memory for encoder budget could not be "
+            "allocated";
+        return 1;
+    }
+
+    /* All slots are initially free and no leases have been opened (anonymous
+     * mappings are zero-filled) */
+    budget->available = encoders;
+    budget->size = encoders;
+
+    /* A process killed while holding the lock must not block all others */
+    pthread_mutexattr_t lock_attributes;
+    pthread_mutexattr_init(&lock_attributes);
+    pthread_mutexattr_setpshared(&lock_attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&lock_attributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&budget->lock, &lock_attributes);
+    pthread_mutexattr_destroy(&lock_attributes);
+
+    pthread_condattr_t cond_attributes;
+    pthread_condattr_init(&cond_attributes);
+    pthread_condattr_setpshared(&cond_attributes, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&budget->changed, &cond_attributes);
+    pthread_condattr_destroy(&cond_attributes);
+
+    guac_display_budget = budget;
+    return 0;
+
+#else
+
+    guac_error = GUAC_STATUS_NOT_SUPPORTED;
+    guac_error_message = "Shared memory is not supported on this platform";
+    return 1;
+
+#endif
+
+}
+
+uint64_t guac_display_open_encoder_lease() {
+
+    guac_display_encoder_budget* budget = guac_display_budget;
+    if (budget == NULL)
+        return 0;
+
+    guac_display_budget_lock(budget);
+    uint64_t lease = ++budget->last_lease;
+    pthread_mutex_unlock(&budget->lock);
+
+    return lease;
+
+}
+
+void guac_display_use_encoder_lease(uint64_t lease) {
+    if (lease != 0)
+        guac_display_encoder_lease = lease;
+}
+
+void guac_display_close_encoder_lease(uint64_t lease) {
+
+    guac_display_encoder_budget* budget = guac_display_budget;
+    if (budget == NULL || lease == 0)
+        return;
+
+    guac_display_budget_lock(budget);
+
+    /* Free all slots held by the terminated process */
+    for (int i = 0; i < budget->size; i++) {
+        if (budget->owners[i] == lease) {
+            budget->owners[i] = 0;
+            budget->available++;
+        }
+    }
+
+    /* Stop deferring to any of its threads that were waiting for a slot */
+    for (int i = 0; i < GUAC_DISPLAY_BUDGET_MAX_INTERACTIVE_WAITERS; i++) {
+        if (budget->interactive_waiters[i] == lease) {
+            budget->interactive_waiters[i] = 0;
+            budget->interactive_waiting--;
+        }
+    }
+
+    pthread_cond_broadcast(&budget->changed);
+    pthread_mutex_unlock(&budget->lock);
+
+}
+
+int guac_display_encoder_budget_size() {
+
+    guac_display_encoder_budget* budget = guac_display_budget;
+    if (budget == NULL)
+        return 0;
+
+    return budget->size;
+
+}
+
+int guac_display_encoder_acquire(guac_display* display) {
+
+    guac_display_encoder_budget* budget = guac_display_budget;
+    if (budget == NULL)
+        return -1;
+
+    /* Displays that recently received user input may take any free slot,
+     * while all others must defer to those interactive displays */
+    guac_timestamp last_user_input = __atomic_load_n(&display->last_user_input,
+            __ATOMIC_RELAXED);
+    int interactive = guac_timestamp_current() - last_user_input
+        < GUAC_DISPLAY_INTERACTIVE_DURATION;
+
+    guac_display_budget_lock(budget);
+    uint64_t lease = guac_display_budget_lease(budget);
+
+    int waiter = -1;
+    if (interactive) {
+        for (int i = 0; i < GUAC_DISPLAY_BUDGET_MAX_INTERACTIVE_WAITERS; i++) {
+            if (budget->interactive_waiters[i] == 0) {
+                budget->interactive_waiters[i] = lease;
+                budget->interactive_waiting++;
+                waiter = i;
+                break;
+            }
+        }
+    }
+
+    while (budget->available == 0
+            || (!interactive && budget->interactive_waiting > 0))
+        guac_display_budget_wait(budget);
+
+    int slot = 0;
+    while (budget->owners[slot] != 0)
+        slot++;
+
+    budget->owners[slot] = lease;
+    budget->available--;
+
+    /* Threads of other displays may no longer need to defer to this one */
+    if (waiter >= 0) {
+        budget->interactive_waiters[waiter] = 0;
+        if (--budget->interactive_waiting == 0)
+            pthread_cond_broadcast(&budget->changed);
+    }
+
+    pthread_mutex_unlock(&budget->lock);
+    return slot;
+
+}
+
+void guac_display_encoder_release(int slot) {
+
+    guac_display_encoder_budget* budget = guac_display_budget;
+    if (budget == NULL || slot < 0)
+        return;
+
+    guac_display_budget_lock(budget);
+
+    budget->owners[slot] = 0;
+    budget->available++;
+
+    pthread_cond_broadcast(&budget->changed);
+    pthread_mutex_unlock(&budget->lock);
+
+}
@@ -22,27 +22,30 @@
 #include "guacamole/assert.h"
 #include "guacamole/client.h"
 #include "guacamole/display.h"
-#include "guacamole/fifo.h"
 #include "guacamole/flag.h"
 #include "guacamole/mem.h"
 #include "guacamole/protocol.h"
 #include "guacamole/rect.h"
 #include "guacamole/rwlock.h"
 #include "guacamole/user.h"
+#include "trace.h"
 
 #include <string.h>
 
 /**
  * Begins a section related to an optimization phase that should be tracked for
- * performance at the "trace" log level.
+ * performance at the "trace" log level (and within the in-memory trace, if
+ * libguac was built with tracing enabled).
  */
 #define GUAC_DISPLAY_PLAN_BEGIN_PHASE()                                       \
     do {                                                                      \
-        guac_timestamp phase_start = guac_timestamp_current();
+        guac_timestamp phase_start = guac_timestamp_current();                \
+        GUAC_TRACE_BEGIN(phase_span);
 
 /**
  * Ends a section related to an optimization phase that should be tracked for
- * performance at the "trace" log level.
+ * performance at the "trace" log level (and within the in-memory trace, if
+ * libguac was built with tracing enabled).
  *
  * @param display
  *     The guac_display related to the optimizations being performed.
@@ -50,6 +53,9 @@
  * @param phase
  *     A human-readable name for the optimization phase being tracked.
  *
+ * @param type
+ *     The guac_trace_type corresponding to the optimization phase.
+ *
  * @param n
  *     The ordinal number of this phase relative to other phases, where the
  *     first phase is phase 1.
@@ -57,7 +63,8 @@
  * @param total
  *     The total number of optimization phases.
  */
-#define GUAC_DISPLAY_PLAN_END_PHASE(display, phase, n, total)                 \
+#define GUAC_DISPLAY_PLAN_END_PHASE(display, phase, type, n, total)           \
+        GUAC_TRACE_END(phase_span, type, 0);                                  \
         guac_timestamp phase_end = guac_timestamp_current();                  \
         guac_client_log(display->client, GUAC_LOG_TRACE, "Render planning "   \
                 "phase %i/%i (%s): %ims", n, total, phase,                    \
@@ -293,6 +300,7 @@ void guac_display_end_mouse_frame(guac_display* display) {
 
 void guac_display_end_multiple_frames(guac_display* display, int frames) {
 
+    GUAC_TRACE_BEGIN(span);
     guac_display_plan* plan = NULL;
 
     guac_rwlock_acquire_write_lock(&display->pending_frame.lock);
@@ -302,14 +310,16 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
      * finished. Graphical changes will meanwhile continue being accumulated in
      * the pending frame. */
 
-    guac_fifo_lock(&display->ops);
-    int defer_frame = display->frame_deferred =
-        (display->ops.state.value & GUAC_FIFO_STATE_NONEMPTY) || display->active_workers;
-    guac_fifo_unlock(&display->ops);
-
-    if (defer_frame)
+    /* NOTE: The worker sending the boundary of the in-progress frame first
+     * releases its reference on pending_ops and then checks frame_deferred,
+     * while this thread does the reverse, thus at least one of the two will
+     * see the other and the deferred frame cannot be lost */
+    __atomic_store_n(&display->frame_deferred, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&display->pending_ops, __ATOMIC_SEQ_CST))
         goto finished_with_pending_frame_lock;
 
+    __atomic_store_n(&display->frame_deferred, 0, __ATOMIC_SEQ_CST);
+
     guac_rwlock_acquire_write_lock(&display->last_frame.lock);
 
     /* PASS 0: Create naive plan, identify minimal dirty rects by comparing the
@@ -322,7 +332,7 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
      * passes. */
     GUAC_DISPLAY_PLAN_BEGIN_PHASE();
     plan = PFW_LFR_guac_display_plan_create(display);
-    GUAC_DISPLAY_PLAN_END_PHASE(display, "draft", 1, 5);
+    GUAC_DISPLAY_PLAN_END_PHASE(display, "draft", GUAC_TRACE_PLAN_CREATE, 1, 5);
 
     if (plan != NULL) {
 
@@ -332,7 +342,7 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
          * replace those operations with simple rectangle draws. */
         GUAC_DISPLAY_PLAN_BEGIN_PHASE();
         PFR_guac_display_plan_rewrite_as_rects(plan);
-        GUAC_DISPLAY_PLAN_END_PHASE(display, "rects", 2, 5);
+        GUAC_DISPLAY_PLAN_END_PHASE(display, "rects", GUAC_TRACE_PLAN_RECTS, 2, 5);
 
         /* PASS 2 (and 3): Index all modified cells by their graphical contents and
          * search the previous frame for occurrences of the same content. Where any
@@ -341,7 +351,7 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
         GUAC_DISPLAY_PLAN_BEGIN_PHASE();
         PFR_guac_display_plan_index_dirty_cells(plan);
         PFR_LFR_guac_display_plan_rewrite_as_copies(plan);
-        GUAC_DISPLAY_PLAN_END_PHASE(display, "search", 3, 5);
+        GUAC_DISPLAY_PLAN_END_PHASE(display, "search", GUAC_TRACE_PLAN_COPIES, 3, 5);
 
         /* PASS 4 (and 5): Combine adjacent updates in horizontal and vertical
          * directions where doing so would be more efficient. The goal of these
@@ -351,7 +361,7 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
         GUAC_DISPLAY_PLAN_BEGIN_PHASE();
         PFW_guac_display_plan_combine_horizontally(plan);
         PFW_guac_display_plan_combine_vertically(plan);
-        GUAC_DISPLAY_PLAN_END_PHASE(display, "combine", 4, 5);
+        GUAC_DISPLAY_PLAN_END_PHASE(display, "combine", GUAC_TRACE_PLAN_COMBINE, 4, 5);
 
     }
 
@@ -366,17 +376,16 @@ void guac_display_end_multiple_frames(guac_display* display, int frames) {
 
     GUAC_DISPLAY_PLAN_BEGIN_PHASE();
     frame_nonempty = PFW_LFW_guac_display_frame_complete(display);
-    GUAC_DISPLAY_PLAN_END_PHASE(display, "commit", 5, 5);
+    GUAC_DISPLAY_PLAN_END_PHASE(display, "commit", GUAC_TRACE_FRAME_COMMIT, 5, 5);
 
     /* Not all frames are graphical. If we end up with a frame containing
      * nothing but layer property changes, then we must still send a frame
      * boundary even though there is no display plan to optimize. */
-    if (plan == NULL && frame_nonempty) {
-        guac_display_plan_operation end_frame_op = {
-            .type = GUAC_DISPLAY_PLAN_END_FRAME
-        };
-        guac_fifo_enqueue(&display->ops, &end_frame_op);
-    }
+    if (plan != NULL || frame_nonempty)
+        guac_display_frame_begin(display);
+
+    if (plan == NULL && frame_nonempty)
+        guac_display_frame_ops_queued(display);
 
     guac_rwlock_release_lock(&display->last_frame.lock);
 
@@ -388,4 +397,6 @@ finished_with_pending_frame_lock:
         guac_display_plan_free(plan);
     }
 
+    GUAC_TRACE_END(span, GUAC_TRACE_END_FRAMES, 0);
+
 }
@@ -19,7 +19,9 @@
 
 #include "display-plan.h"
 #include "display-priv.h"
+#include "guacamole/client.h"
 #include "guacamole/display.h"
+#include "guacamole/metrics.h"
 #include "guacamole/rect.h"
 
 #include <string.h>
@@ -400,6 +402,8 @@ static void PFR_LFR_guac_display_plan_find_copies(guac_display_plan* plan,
             op->src.layer_rect.layer = copy_from_layer->last_frame_buffer;
             op->src.layer_rect.rect = src_rect;
             op->dest = dst_rect;
+            guac_metrics_add(plan->display->client->metrics,
+                    GUAC_METRICS_COPIES, 1);
         }
 
     }
@@ -22,11 +22,11 @@
 #include "guacamole/assert.h"
 #include "guacamole/client.h"
 #include "guacamole/display.h"
-#include "guacamole/fifo.h"
 #include "guacamole/mem.h"
 #include "guacamole/protocol.h"
 #include "guacamole/socket.h"
 #include "guacamole/timestamp.h"
+#include "trace.h"
 
 #include <string.h>
 #include <cairo/cairo.h>
@@ -376,14 +376,12 @@ void guac_display_plan_free(guac_display_plan* plan) {
 
 void guac_display_plan_apply(guac_display_plan* plan) {
 
+    GUAC_TRACE_BEGIN(span);
+
     guac_display* display = plan->display;
     guac_client* client = display->client;
     guac_display_plan_operation* op = plan->ops;
 
-    /* Do not allow worker threads to move forward with image encoding until
-     * AFTER the non-image instructions have finished being written */
-    guac_fifo_lock(&display->ops);
-
     /* Immediately send instructions for all updates that do not involve
      * significant processing (do not involve encoding anything). This allows
      * us to use the worker threads solely for encoding, reducing contention
@@ -421,13 +419,9 @@ void guac_display_plan_apply(guac_display_plan* plan) {
 
                 break;
 
-            /* Simply ignore and drop NOP */
-            case GUAC_DISPLAY_PLAN_OPERATION_NOP:
-                break;
-
-            /* All other operations should be handled by the workers */
+            /* All other operations are either handled by the workers or
+             * simply ignored and dropped (NOP) */
             default:
-                guac_fifo_enqueue(&display->ops, op);
                 break;
 
         }
@@ -436,6 +430,22 @@ void guac_display_plan_apply(guac_display_plan* plan) {
 
     }
 
-    guac_fifo_unlock(&display->ops);
+    /* Only now allow worker threads to move forward with image encoding, as
+     * the image instructions must follow the non-image instructions */
+    op = plan->ops;
+    for (int i = 0; i < plan->length; i++) {
+
+        if (op->type == GUAC_DISPLAY_PLAN_OPERATION_IMG)
+            guac_display_frame_enqueue(display, op);
+
+        op++;
+
+    }
+
+    /* The frame boundary (END_FRAME) is sent by whichever worker completes
+     * the last operation of the frame */
+    guac_display_frame_ops_queued(display);
+
+    GUAC_TRACE_END(span, GUAC_TRACE_PLAN_APPLY, plan->length);
 
 }
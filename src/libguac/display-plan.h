@@ -385,11 +385,12 @@ void PFW_guac_display_plan_combine_horizontally(guac_display_plan* plan);
 void PFW_guac_display_plan_combine_vertically(guac_display_plan* plan);
 
 /**
- * Enqueues all operations from the given plan within the operation FIFO used
- * by the worker threads of the display associated with that plan. The
- * display's worker threads will immediately begin picking up and performing
- * these operations, with the final operation resulting in a frame boundary
- * ("sync" instruction) being sent to connected users.
+ * Sends all operations from the given plan that require no encoding, and then
+ * enqueues all remaining operations within the operation queue used by the
+ * worker threads of the display associated with that plan. The display's
+ * worker threads will immediately begin picking up and performing these
+ * operations, with the worker completing the final operation also sending the
+ * frame boundary ("sync" instruction) to connected users.
  *
  * @param plan
  *     The guac_display_plan to apply.
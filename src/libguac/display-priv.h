@@ -23,11 +23,14 @@
 #include "display-plan.h"
 #include "guacamole/client.h"
 #include "guacamole/display.h"
-#include "guacamole/fifo.h"
+#include "guacamole/flag.h"
 #include "guacamole/rect.h"
 #include "guacamole/socket.h"
+#include "guacamole/timestamp.h"
 
 #include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 /**
  * The maximum amount of time to wait after flushing a frame when compensating
@@ -90,8 +93,11 @@
  *
  * 1) pending_frame.lock
  * 2) last_frame.lock
- * 3) ops
- * 4) render_state
+ * 3) render_state
+ *
+ * The operation queue (ops) is lock-free. The lock of its internal state flag
+ * is only ever held briefly by threads about to sleep or wake other threads,
+ * and no other locks are acquired while it is held.
  *
  * Acquiring these locks in any other order risks deadlock. Don't do it.
  */
@@ -140,8 +146,8 @@
     ((pixels + GUAC_DISPLAY_CELL_SIZE - 1) / GUAC_DISPLAY_CELL_SIZE)
 
 /**
- * The size of the operation FIFO read by the display worker threads. This
- * value is the number of operation slots in the FIFO, not bytes. The amount of
+ * The size of the operation queue read by the display worker threads. This
+ * value is the number of operation slots in the queue, not bytes. The amount of
  * space currently specified here is roughly sufficient 8 worst-case frames
  * worth of outstanding operations.
  */
@@ -151,6 +157,48 @@
                 / GUAC_DISPLAY_CELL_SIZE                                      \
                 * 8)
 
+/**
+ * The assumed size of a CPU cache line, in bytes. Members of
+ * guac_display_queue that are modified by different threads are separated by
+ * at least this much space to avoid false sharing.
+ */
+#define GUAC_DISPLAY_QUEUE_CACHE_LINE_SIZE 64
+
+/**
+ * Bitwise flag set on the state flag of a guac_display_queue when the queue
+ * may contain operations. Threads waiting for operations wait for this flag.
+ */
+#define GUAC_DISPLAY_QUEUE_STATE_NONEMPTY 1
+
+/**
+ * Bitwise flag set on the state flag of a guac_display_queue when the queue
+ * may have space for further operations. Threads waiting for space wait for
+ * this flag.
+ */
+#define GUAC_DISPLAY_QUEUE_STATE_READY 2
+
+/**
+ * Bitwise flag set on the state flag of a guac_display_queue when the queue
+ * has been invalidated and must no longer be used.
+ */
+#define GUAC_DISPLAY_QUEUE_STATE_INVALID 4
+
+/**
+ * The maximum number of worker threads encoding updates for interactive
+ * connections that may be tracked as waiting for an encoder slot at any one
+ * time. Any further such threads still wait for a free slot, but do not
+ * prevent threads encoding updates for other connections from taking that
+ * slot.
+ */
+#define GUAC_DISPLAY_BUDGET_MAX_INTERACTIVE_WAITERS 256
+
+/**
+ * The amount of time after the most recent user input that a guac_display is
+ * considered interactive, in milliseconds. The updates of interactive
+ * displays are given priority when waiting for an encoder slot.
+ */
+#define GUAC_DISPLAY_INTERACTIVE_DURATION 1000
+
 /**
  * Returns the memory address of the given rectangle within the mutable image
  * buffer of the given guac_display_layer_state, where the upper-left corner of
@@ -267,6 +315,20 @@ struct guac_display_render_thread {
      */
     unsigned int frames;
 
+    /**
+     * The time that the render thread last observed a modification to the
+     * display, in microseconds, as returned by guac_metrics_current_usec().
+     * This value may be accessed only by the render thread.
+     */
+    uint64_t last_modified;
+
+    /**
+     * The exponentially-weighted moving average of the time between
+     * modifications to the display, in microseconds. This value may be
+     * accessed only by the render thread.
+     */
+    uint64_t modification_interval;
+
 };
 
 /**
@@ -643,6 +705,171 @@ typedef struct guac_display_state {
 
 } guac_display_state;
 
+/**
+ * A single slot within a guac_display_queue.
+ */
+typedef struct guac_display_queue_slot {
+
+    /**
+     * The sequence number of this slot, coordinating access to the slot by
+     * producers and consumers without locking. If equal to the position
+     * within the queue that maps to this slot, the slot is empty and may
+     * receive the operation enqueued at that position. If equal to that
+     * position plus one, the slot contains the operation enqueued at that
+     * position, which may now be dequeued.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    size_t sequence;
+
+    /**
+     * The operation stored within this slot, if any.
+     */
+    guac_display_plan_operation op;
+
+} guac_display_queue_slot;
+
+/**
+ * Bounded, lock-free queue of operations which may be safely shared by any
+ * number of producer and consumer threads. Threads only block (and only then
+ * acquire a lock) if the queue is empty (when dequeuing) or full (when
+ * enqueuing).
+ */
+typedef struct guac_display_queue {
+
+    /**
+     * The position within the queue that will receive the next operation
+     * enqueued. Positions increase without bound and are mapped to slots
+     * modulo GUAC_DISPLAY_WORKER_FIFO_SIZE.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    size_t enqueue_position;
+
+    /**
+     * Padding separating enqueue_position and dequeue_position, which are
+     * modified by different threads, into different cache lines.
+     */
+    char __enqueue_padding[GUAC_DISPLAY_QUEUE_CACHE_LINE_SIZE];
+
+    /**
+     * The position within the queue of the next operation to be dequeued.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    size_t dequeue_position;
+
+    /**
+     * Padding separating dequeue_position from the remaining members of this
+     * queue.
+     */
+    char __dequeue_padding[GUAC_DISPLAY_QUEUE_CACHE_LINE_SIZE];
+
+    /**
+     * The number of threads that are waiting (or about to wait) for
+     * operations to be enqueued.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    unsigned int waiting_consumers;
+
+    /**
+     * The number of threads that are waiting (or about to wait) for space
+     * within the queue.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    unsigned int waiting_producers;
+
+    /**
+     * Non-zero if this queue has been invalidated, zero otherwise.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    int invalid;
+
+    /**
+     * The current state of this queue, used only to allow threads to sleep
+     * while the queue is empty or full, and to signal invalidation. This may
+     * be any combination of GUAC_DISPLAY_QUEUE_STATE_NONEMPTY,
+     * GUAC_DISPLAY_QUEUE_STATE_READY, and GUAC_DISPLAY_QUEUE_STATE_INVALID.
+     */
+    guac_flag state;
+
+    /**
+     * All slots within this queue.
+     */
+    guac_display_queue_slot slots[GUAC_DISPLAY_WORKER_FIFO_SIZE];
+
+} guac_display_queue;
+
+/**
+ * The encoding budget shared by all guac_display instances of all processes
+ * that inherited that budget from the process which called
+ * guac_display_set_encoder_budget(). Each worker thread must hold one of the
+ * slots of this budget while encoding an image, limiting the total number of
+ * images being encoded at any one time regardless of the number of
+ * connections. The budget resides within shared memory and must only be
+ * modified while its lock is held.
+ *
+ * Slots and waiting threads are recorded against the lease of the process
+ * that holds or waits for them, rather than against its process ID, such that
+ * the process which established the budget can release everything held by a
+ * terminated child process (see guac_display_close_encoder_lease()) without
+ * any risk of that child's process ID having been reused.
+ */
+typedef struct guac_display_encoder_budget {
+
+    /**
+     * Process-shared, robust lock which guards all other members of this
+     * structure. If a process terminates while holding this lock, the next
+     * process to acquire the lock restores the consistency of this structure.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Process-shared condition which is signalled whenever a slot is freed
+     * or the number of interactive waiters decreases.
+     */
+    pthread_cond_t changed;
+
+    /**
+     * The number of slots that are not currently held by any worker thread.
+     */
+    int available;
+
+    /**
+     * The number of worker threads encoding updates for interactive
+     * connections that are currently waiting for a slot. This is the number
+     * of non-zero entries within interactive_waiters.
+     */
+    int interactive_waiting;
+
+    /**
+     * The lease of the process of each worker thread encoding updates for an
+     * interactive connection that is currently waiting for a slot, or zero
+     * for unused entries.
+     */
+    uint64_t interactive_waiters[GUAC_DISPLAY_BUDGET_MAX_INTERACTIVE_WAITERS];
+
+    /**
+     * The most recently opened lease. Leases are never reused.
+     */
+    uint64_t last_lease;
+
+    /**
+     * The total number of slots within the owners array.
+     */
+    int size;
+
+    /**
+     * The lease of the process holding each slot, or zero for slots that are
+     * free.
+     */
+    uint64_t owners[];
+
+} guac_display_encoder_budget;
+
 struct guac_display {
 
     /* NOTE: Any member of this structure that requires protection against
@@ -698,47 +925,88 @@ struct guac_display {
     /* ---------------- FRAME ENCODING WORKER THREADS ---------------- */
 
     /**
-     * The number of worker threads in the worker_threads array.
+     * The number of worker threads that have been started and are present
+     * in the worker_threads array. Worker threads are started only as the
+     * number of image operations within a frame demands them, and this value
+     * may be modified only by the thread rendering the current frame.
      */
     int worker_thread_count;
 
     /**
-     * Pool of worker threads that automatically pull from the ops FIFO,
+     * The maximum number of worker threads that may be started, and thus the
+     * size of the worker_threads array.
+     */
+    int worker_thread_limit;
+
+    /**
+     * The number of image operations added to the ops queue for the frame
+     * currently being rendered. This value may be accessed only by the thread
+     * rendering the current frame.
+     */
+    int frame_ops;
+
+    /**
+     * The time that input was last received from any user of this display.
+     * The display is considered interactive for
+     * GUAC_DISPLAY_INTERACTIVE_DURATION milliseconds after user input.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    guac_timestamp last_user_input;
+
+    /**
+     * Pool of worker threads that automatically pull from the ops queue,
      * sending corresponding Guacamole instructions to all connected clients.
      */
     pthread_t* worker_threads;
 
     /**
-     * FIFO of all graphical operations required to transform the remote
+     * Queue of all graphical operations required to transform the remote
      * display state from the previous frame to the next frame. Operations
-     * added to this FIFO will automatically be pulled and processed by a
+     * added to this queue will automatically be pulled and processed by a
      * worker thread.
      */
-    guac_fifo ops;
-
-    /**
-     * Storage for any items within the ops fifo.
-     */
-    guac_display_plan_operation ops_items[GUAC_DISPLAY_WORKER_FIFO_SIZE];
+    guac_display_queue ops;
 
     /**
-     * The current number of active worker threads.
+     * The number of operations of the frame currently being rendered that
+     * have not yet been completed, plus one for as long as operations of that
+     * frame are still being added to the ops queue, plus one for the frame
+     * boundary. The thread that decrements this value to one is responsible
+     * for the frame boundary, and the frame boundary decrements this value to
+     * zero once sent. A frame is thus being rendered if and only if this
+     * value is non-zero.
      *
-     * IMPORTANT: This member must only be accessed or modified while the ops
-     * FIFO is locked.
+     * IMPORTANT: This member must only be accessed using atomic operations.
      */
-    unsigned int active_workers;
+    unsigned int pending_ops;
 
     /**
      * Whether least one pending frame has been deferred due to the encoding
      * process being underway for a previous frame at the time it was
      * completed.
      *
-     * IMPORTANT: This member must only be accessed or modified while the ops
-     * FIFO is locked.
+     * IMPORTANT: This member must only be accessed using atomic operations.
      */
     int frame_deferred;
 
+    /**
+     * The time taken to encode and send the most recently rendered frame, in
+     * milliseconds, as measured by the worker thread that sent the boundary
+     * of that frame.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    int render_latency;
+
+    /**
+     * The approximate processing lag of connected users, in milliseconds, as
+     * of the boundary of the most recently rendered frame.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    int processing_lag;
+
     /**
      * The current state of the rendering process. Code that needs to be aware
      * of whether a frame is currently in the process of being rendered can
@@ -798,9 +1066,176 @@ void PFW_guac_display_layer_resize(guac_display_layer* layer,
         int width, int height);
 
 /**
- * Worker thread that continuously pulls operations from the operation FIFO of
- * the given guac_display, applying those operations by seding corresponding
- * instructions to connected clients.
+ * Initializes the given guac_display_queue, which must not already be
+ * initialized. The queue is initially empty.
+ *
+ * @param queue
+ *     The queue to initialize.
+ */
+void guac_display_queue_init(guac_display_queue* queue);
+
+/**
+ * Releases any resources associated with the given guac_display_queue. The
+ * queue must no longer be in use by any thread.
+ *
+ * @param queue
+ *     The queue to destroy.
+ */
+void guac_display_queue_destroy(guac_display_queue* queue);
+
+/**
+ * Invalidates the given guac_display_queue, causing all current and future
+ * attempts to enqueue or dequeue operations to fail. Any threads currently
+ * blocked on the queue are woken.
+ *
+ * @param queue
+ *     The queue to invalidate.
+ */
+void guac_display_queue_invalidate(guac_display_queue* queue);
+
+/**
+ * Adds a copy of the given operation to the end of the given
+ * guac_display_queue, blocking if the queue is full until space becomes
+ * available.
+ *
+ * @param queue
+ *     The queue to add the operation to.
+ *
+ * @param op
+ *     The operation to add.
+ *
+ * @return
+ *     Non-zero if the operation was added, zero if the queue has been
+ *     invalidated.
+ */
+int guac_display_queue_enqueue(guac_display_queue* queue,
+        const guac_display_plan_operation* op);
+
+/**
+ * Removes the operation at the front of the given guac_display_queue, storing
+ * a copy within the given buffer, blocking if the queue is empty until an
+ * operation is added.
+ *
+ * @param queue
+ *     The queue to remove an operation from.
+ *
+ * @param op
+ *     The buffer that should receive the removed operation.
+ *
+ * @return
+ *     Non-zero if an operation was removed, zero if the queue has been
+ *     invalidated.
+ */
+int guac_display_queue_dequeue(guac_display_queue* queue,
+        guac_display_plan_operation* op);
+
+/**
+ * Returns the approximate number of operations currently within the given
+ * guac_display_queue. As operations may be concurrently added and removed by
+ * other threads, the value returned is suitable only for statistics.
+ *
+ * @param queue
+ *     The queue to inspect.
+ *
+ * @return
+ *     The approximate number of operations within the given queue.
+ */
+size_t guac_display_queue_length(guac_display_queue* queue);
+
+/**
+ * Marks the beginning of a new frame that will be rendered by the worker
+ * threads of the given guac_display. This function must be invoked before any
+ * operations of that frame are added to the ops queue, and must be followed
+ * by a call to guac_display_frame_ops_queued() after all such operations have
+ * been added.
+ *
+ * @param display
+ *     The guac_display that is beginning to render a new frame.
+ */
+void guac_display_frame_begin(guac_display* display);
+
+/**
+ * Adds the given operation of the frame currently being rendered to the ops
+ * queue of the given guac_display, such that it will be completed by a worker
+ * thread.
+ *
+ * @param display
+ *     The guac_display that is rendering the frame.
+ *
+ * @param op
+ *     The operation to add.
+ */
+void guac_display_frame_enqueue(guac_display* display,
+        const guac_display_plan_operation* op);
+
+/**
+ * Notes that all operations of the frame currently being rendered have been
+ * added to the ops queue of the given guac_display. If the worker threads
+ * have already completed all of those operations (or there were none), the
+ * frame boundary is queued to be sent by a worker thread.
+ *
+ * @param display
+ *     The guac_display that is rendering the frame.
+ */
+void guac_display_frame_ops_queued(guac_display* display);
+
+/**
+ * Starts an additional worker thread for the given guac_display, if the
+ * maximum number of worker threads has not yet been reached. This function
+ * may be invoked only during allocation of the guac_display or by the thread
+ * rendering the current frame.
+ *
+ * @param display
+ *     The guac_display that should receive an additional worker thread.
+ *
+ * @return
+ *     Zero if a worker thread was started, non-zero if the maximum number of
+ *     worker threads has been reached or the thread could not be created.
+ */
+int guac_display_worker_start(guac_display* display);
+
+/**
+ * Returns the number of encoder slots within the encoder budget shared by
+ * this process, as established by guac_display_set_encoder_budget().
+ *
+ * @return
+ *     The number of encoder slots within the shared encoder budget, or zero
+ *     if no encoder budget has been established.
+ */
+int guac_display_encoder_budget_size();
+
+/**
+ * Acquires a slot from the encoder budget shared by this process, waiting
+ * for a slot to become free if necessary. If the given guac_display has
+ * received user input recently, the calling thread is given priority over
+ * threads encoding updates for non-interactive displays. If no encoder budget
+ * has been established, this function returns immediately. The acquired slot
+ * must eventually be released with guac_display_encoder_release().
+ *
+ * @param display
+ *     The guac_display whose updates will be encoded using the acquired slot.
+ *
+ * @return
+ *     The index of the acquired slot, or -1 if no encoder budget has been
+ *     established.
+ */
+int guac_display_encoder_acquire(guac_display* display);
+
+/**
+ * Releases a slot previously acquired with guac_display_encoder_acquire().
+ *
+ * @param slot
+ *     The index of the slot to release, as returned by
+ *     guac_display_encoder_acquire(). If negative, this function has no
+ *     effect.
+ */
+void guac_display_encoder_release(int slot);
+
+/**
+ * Worker thread that continuously pulls operations from the operation queue
+ * of the given guac_display, applying those operations by seding
+ * corresponding instructions to connected clients. The worker that completes
+ * the final operation of a frame also sends the boundary of that frame.
  *
  * @param data
  *     A pointer to the guac_display.
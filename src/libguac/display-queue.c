@@ -0,0 +1,337 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "config.h"
+#include "display-priv.h"
+#include "guacamole/flag.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The operation queue is a bounded multi-producer, multi-consumer ring in
+ * which each slot carries a sequence number (D. Vyukov's bounded MPMC queue).
+ * Producers and consumers claim positions by atomically advancing the
+ * enqueue/dequeue positions, and the sequence number of each slot indicates
+ * whether that slot is ready for the producer or consumer that claimed it.
+ * The guac_flag within the queue is used only to sleep while the queue is
+ * empty or full.
+ */
+
+void guac_display_queue_init(guac_display_queue* queue) {
+
+    /* Each slot is initially ready to receive the operation enqueued at the
+     * first position that maps to that slot */
+    for (size_t i = 0; i < GUAC_DISPLAY_WORKER_FIFO_SIZE; i++)
+        queue->slots[i].sequence = i;
+
+    queue->enqueue_position = 0;
+    queue->dequeue_position = 0;
+    queue->waiting_consumers = 0;
+    queue->waiting_producers = 0;
+    queue->invalid = 0;
+
+    guac_flag_init(&queue->state);
+    guac_flag_set(&queue->state, GUAC_DISPLAY_QUEUE_STATE_READY);
+
+}
+
+void guac_display_queue_destroy(guac_display_queue* queue) {
+    guac_flag_destroy(&queue->state);
+}
+
+void guac_display_queue_invalidate(guac_display_queue* queue) {
+    __atomic_store_n(&queue->invalid, 1, __ATOMIC_SEQ_CST);
+    guac_flag_set(&queue->state, GUAC_DISPLAY_QUEUE_STATE_INVALID);
+}
+
+/**
+ * Returns whether the given guac_display_queue is still valid (has not been
+ * invalidated with guac_display_queue_invalidate()).
+ *
+ * @param queue
+ *     The queue to test.
+ *
+ * @return
+ *     Non-zero if the queue is still valid, zero otherwise.
+ */
+static int guac_display_queue_is_valid(guac_display_queue* queue) {
+    return !__atomic_load_n(&queue->invalid, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Attempts to add a copy of the given operation to the end of the given
+ * queue without blocking.
+ *
+ * @param queue
+ *     The queue to add the operation to.
+ *
+ * @param op
+ *     The operation to add.
+ *
+ * @return
+ *     Non-zero if the operation was added, zero if the queue is full.
+ */
+static int guac_display_queue_try_enqueue(guac_display_queue* queue,
+        const guac_display_plan_operation* op) {
+
+    size_t position = __atomic_load_n(&queue->enqueue_position,
+            __ATOMIC_RELAXED);
+
+    for (;;) {
+
+        guac_display_queue_slot* slot =
+            &queue->slots[position % GUAC_DISPLAY_WORKER_FIFO_SIZE];
+
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        /* Claim the slot if it is ready for this position, storing the
+         * operation and then publishing it to consumers */
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->enqueue_position,
+                        &position, position + 1, 1,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->op = *op;
+                __atomic_store_n(&slot->sequence, position + 1,
+                        __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+
+        /* The slot still holds an operation from a full cycle ago */
+        else if (difference < 0)
+            return 0;
+
+        /* Another producer claimed this position first */
+        else
+            position = __atomic_load_n(&queue->enqueue_position,
+                    __ATOMIC_RELAXED);
+
+    }
+
+}
+
+/**
+ * Attempts to remove the operation at the front of the given queue without
+ * blocking.
+ *
+ * @param queue
+ *     The queue to remove an operation from.
+ *
+ * @param op
+ *     The buffer that should receive the removed operation.
+ *
+ * @return
+ *     Non-zero if an operation was removed, zero if the queue is empty.
+ */
+static int guac_display_queue_try_dequeue(guac_display_queue* queue,
+        guac_display_plan_operation* op) {
+
+    size_t position = __atomic_load_n(&queue->dequeue_position,
+            __ATOMIC_RELAXED);
+
+    for (;;) {
+
+        guac_display_queue_slot* slot =
+            &queue->slots[position % GUAC_DISPLAY_WORKER_FIFO_SIZE];
+
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        /* Claim the slot if it holds the operation for this position, then
+         * release the slot to the producer of the next cycle */
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->dequeue_position,
+                        &position, position + 1, 1,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *op = slot->op;
+                __atomic_store_n(&slot->sequence,
+                        position + GUAC_DISPLAY_WORKER_FIFO_SIZE,
+                        __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+
+        /* No operation has yet been enqueued at this position */
+        else if (difference < 0)
+            return 0;
+
+        /* Another consumer claimed this position first */
+        else
+            position = __atomic_load_n(&queue->dequeue_position,
+                    __ATOMIC_RELAXED);
+
+    }
+
+}
+
+/**
+ * Wakes any threads waiting on the given queue for the given state flag to be
+ * set. The lock of the queue state is acquired only if at least one thread is
+ * actually waiting.
+ *
+ * @param queue
+ *     The queue whose waiting threads should be woken.
+ *
+ * @param waiting
+ *     The count of threads waiting for the given flag.
+ *
+ * @param flag
+ *     The state flag that those threads are waiting for.
+ */
+static void guac_display_queue_wake(guac_display_queue* queue,
+        unsigned int* waiting, unsigned int flag) {
+
+    /* Pairs with the fence in guac_display_queue_wait(), guaranteeing that
+     * either the waiting thread sees the change just made to the queue or
+     * this thread sees the waiting thread */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED))
+        guac_flag_set(&queue->state, flag);
+
+}
+
+/**
+ * Announces that the current thread is about to wait for the given state
+ * flag to be set on the given queue, clearing that flag. The caller must
+ * then make one final attempt to enqueue or dequeue before calling
+ * guac_display_queue_wait(), such that any change made to the queue after
+ * that attempt fails is guaranteed to set the flag again.
+ *
+ * @param queue
+ *     The queue that will be waited on.
+ *
+ * @param waiting
+ *     The count of threads waiting for the given flag.
+ *
+ * @param flag
+ *     The state flag that will be waited for.
+ */
+static void guac_display_queue_prepare_wait(guac_display_queue* queue,
+        unsigned int* waiting, unsigned int flag) {
+
+    __atomic_add_fetch(waiting, 1, __ATOMIC_SEQ_CST);
+
+    /* Pairs with the fence in guac_display_queue_wake() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    guac_flag_clear(&queue->state, flag);
+
+}
+
+/**
+ * Completes a wait begun with guac_display_queue_prepare_wait(), blocking
+ * until the given state flag has been set on the given queue (or the queue
+ * is invalidated) unless the final attempt made by the caller succeeded.
+ *
+ * @param queue
+ *     The queue being waited on.
+ *
+ * @param waiting
+ *     The count of threads waiting for the given flag.
+ *
+ * @param flag
+ *     The state flag being waited for.
+ *
+ * @param succeeded
+ *     Non-zero if the final attempt to enqueue or dequeue succeeded, in which
+ *     case this function does not block.
+ */
+static void guac_display_queue_wait(guac_display_queue* queue,
+        unsigned int* waiting, unsigned int flag, int succeeded) {
+
+    if (!succeeded) {
+        guac_flag_wait_and_lock(&queue->state,
+                flag | GUAC_DISPLAY_QUEUE_STATE_INVALID);
+        guac_flag_unlock(&queue->state);
+    }
+
+    __atomic_sub_fetch(waiting, 1, __ATOMIC_SEQ_CST);
+
+}
+
+int guac_display_queue_enqueue(guac_display_queue* queue,
+        const guac_display_plan_operation* op) {
+
+    while (guac_display_queue_is_valid(queue)) {
+
+        /* If the queue is full, try one final time before waiting */
+        int enqueued = guac_display_queue_try_enqueue(queue, op);
+        if (!enqueued) {
+            guac_display_queue_prepare_wait(queue, &queue->waiting_producers,
+                    GUAC_DISPLAY_QUEUE_STATE_READY);
+            enqueued = guac_display_queue_try_enqueue(queue, op);
+            guac_display_queue_wait(queue, &queue->waiting_producers,
+                    GUAC_DISPLAY_QUEUE_STATE_READY, enqueued);
+        }
+
+        if (enqueued) {
+            guac_display_queue_wake(queue, &queue->waiting_consumers,
+                    GUAC_DISPLAY_QUEUE_STATE_NONEMPTY);
+            return 1;
+        }
+
+    }
+
+    return 0;
+
+}
+
+int guac_display_queue_dequeue(guac_display_queue* queue,
+        guac_display_plan_operation* op) {
+
+    while (guac_display_queue_is_valid(queue)) {
+
+        /* If the queue is empty, try one final time before waiting */
+        int dequeued = guac_display_queue_try_dequeue(queue, op);
+        if (!dequeued) {
+            guac_display_queue_prepare_wait(queue, &queue->waiting_consumers,
+                    GUAC_DISPLAY_QUEUE_STATE_NONEMPTY);
+            dequeued = guac_display_queue_try_dequeue(queue, op);
+            guac_display_queue_wait(queue, &queue->waiting_consumers,
+                    GUAC_DISPLAY_QUEUE_STATE_NONEMPTY, dequeued);
+        }
+
+        if (dequeued) {
+            guac_display_queue_wake(queue, &queue->waiting_producers,
+                    GUAC_DISPLAY_QUEUE_STATE_READY);
+            return 1;
+        }
+
+    }
+
+    return 0;
+
+}
+
+size_t guac_display_queue_length(guac_display_queue* queue) {
+
+    size_t dequeue_position = __atomic_load_n(&queue->dequeue_position,
+            __ATOMIC_RELAXED);
+    size_t enqueue_position = __atomic_load_n(&queue->enqueue_position,
+            __ATOMIC_RELAXED);
+
+    /* The positions are read separately and may briefly appear reversed */
+    if (enqueue_position < dequeue_position)
+        return 0;
+
+    return enqueue_position - dequeue_position;
+
+}
@@ -23,28 +23,161 @@
 #include "guacamole/display.h"
 #include "guacamole/flag.h"
 #include "guacamole/mem.h"
+#include "guacamole/metrics.h"
 #include "guacamole/timestamp.h"
+#include "trace.h"
+
+#include <stdint.h>
 
 /**
- * The maximum duration of a frame in milliseconds. This ensures we at least
- * meet a reasonable minimum framerate in the case that the remote desktop
- * server provides no frame boundaries and streams data continuously enough
- * that frame boundaries are not discernable through timing.
+ * The default maximum duration of a frame in milliseconds. This ensures we at
+ * least meet a reasonable minimum framerate in the case that the remote
+ * desktop server provides no frame boundaries and streams data continuously
+ * enough that frame boundaries are not discernable through timing.
  *
  * The current value of 100 is equivalent to 10 frames per second.
  */
 #define GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION 100
 
 /**
- * The minimum duration of a frame in milliseconds. This ensures we don't start
- * flushing a ton of tiny frames if a remote desktop server provides no frame
- * boundaries and streams data inconsistently enough that timing would suggest
- * frame boundaries in the middle of a frame.
+ * The minimum duration of a frame in milliseconds while modifications are
+ * arriving continuously. This ensures we don't start flushing a ton of tiny
+ * frames if a remote desktop server provides no frame boundaries and streams
+ * data inconsistently enough that timing would suggest frame boundaries in
+ * the middle of a frame. Isolated modifications are not subject to this
+ * minimum.
  *
  * The current value of 10 is equivalent to 100 frames per second.
  */
 #define GUAC_DISPLAY_RENDER_THREAD_MIN_FRAME_DURATION 10
 
+/**
+ * The average time between modifications, in milliseconds, at or above which
+ * modifications are considered sporadic rather than part of a continuous
+ * stream (such as video). Sporadic modifications are flushed immediately
+ * rather than being coalesced.
+ */
+#define GUAC_DISPLAY_RENDER_THREAD_SPORADIC_INTERVAL 20
+
+/**
+ * The weight given to the existing average time between modifications when
+ * incorporating a new measurement, as the denominator of a fraction. Each
+ * new measurement contributes 1/GUAC_DISPLAY_RENDER_THREAD_INTERVAL_WEIGHT of
+ * the new average.
+ */
+#define GUAC_DISPLAY_RENDER_THREAD_INTERVAL_WEIGHT 4
+
+/**
+ * The minimum amount of time that modifications should be coalesced into a
+ * single frame, in milliseconds, as set by
+ * guac_display_render_thread_set_frame_duration().
+ */
+static int guac_display_render_thread_min_duration = 0;
+
+/**
+ * The maximum duration of any frame, in milliseconds, as set by
+ * guac_display_render_thread_set_frame_duration().
+ */
+static int guac_display_render_thread_max_duration =
+    GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION;
+
+/**
+ * Updates the average time between modifications tracked by the given render
+ * thread to account for a modification observed at the given time. Gaps
+ * between modifications are limited to the default maximum frame duration,
+ * such that the average recovers quickly once modifications resume after the
+ * display has been idle.
+ *
+ * @param render_thread
+ *     The render thread that observed the modification.
+ *
+ * @param now
+ *     The time that the modification was observed, as returned by
+ *     guac_metrics_current_usec().
+ */
+static void guac_display_render_thread_observe(
+        guac_display_render_thread* render_thread, uint64_t now) {
+
+    uint64_t interval = now - render_thread->last_modified;
+    if (interval > GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION * 1000)
+        interval = GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION * 1000;
+
+    render_thread->modification_interval =
+        (render_thread->modification_interval
+            * (GUAC_DISPLAY_RENDER_THREAD_INTERVAL_WEIGHT - 1) + interval)
+        / GUAC_DISPLAY_RENDER_THREAD_INTERVAL_WEIGHT;
+
+    render_thread->last_modified = now;
+
+}
+
+/**
+ * Returns the amount of time that modifications should be coalesced into the
+ * frame beginning at the given time, in milliseconds. Isolated modifications,
+ * and modifications arriving only sporadically, are flushed immediately. If
+ * modifications are instead arriving as a continuous stream, they are
+ * coalesced for at least long enough to cover the typical gap between them,
+ * and for no less than the time the most recent frame took to encode or the
+ * processing lag of connected users, as frames cannot usefully be produced any
+ * faster than that. The result is always within the bounds set through
+ * guac_display_render_thread_set_frame_duration().
+ *
+ * @param render_thread
+ *     The render thread beginning the frame.
+ *
+ * @param now
+ *     The time that the frame began, as returned by
+ *     guac_metrics_current_usec().
+ *
+ * @return
+ *     The amount of time that modifications should be coalesced, in
+ *     milliseconds.
+ */
+static int guac_display_render_thread_window(
+        guac_display_render_thread* render_thread, uint64_t now) {
+
+    guac_display* display = render_thread->display;
+
+    /* Both durations are compared in microseconds, before any narrowing
+     * conversion, as the time since the last modification is unbounded */
+    uint64_t idle = now > render_thread->last_modified
+        ? now - render_thread->last_modified : 0;
+    uint64_t interval = render_thread->modification_interval;
+
+    int window = 0;
+
+    /* Coalesce only continuous streams of modifications */
+    if (idle < GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION * 1000
+            && interval < GUAC_DISPLAY_RENDER_THREAD_SPORADIC_INTERVAL * 1000) {
+
+        /* The interval is now known to be small enough to fit within an
+         * int */
+        window = (int) (interval / 1000) * 2;
+
+        int latency = __atomic_load_n(&display->render_latency, __ATOMIC_RELAXED);
+        if (latency > window)
+            window = latency;
+
+        int lag = __atomic_load_n(&display->processing_lag, __ATOMIC_RELAXED);
+        if (lag > window)
+            window = lag;
+
+        if (window < GUAC_DISPLAY_RENDER_THREAD_MIN_FRAME_DURATION)
+            window = GUAC_DISPLAY_RENDER_THREAD_MIN_FRAME_DURATION;
+
+    }
+
+    /* Apply any configured bounds */
+    if (window < guac_display_render_thread_min_duration)
+        window = guac_display_render_thread_min_duration;
+
+    if (window > guac_display_render_thread_max_duration)
+        window = guac_display_render_thread_max_duration;
+
+    return window;
+
+}
+
 /**
  * The start routine for the display render thread, consisting of a single
  * render loop. The render loop will proceed until signalled to stop,
@@ -79,18 +212,30 @@ static void* guac_display_render_loop(void* data) {
 
         int rendered_frames = 0;
 
-        /* Lacking explicit frame boundaries, handle the change in frame state,
-         * continuing to accumulate frame modifications while still within
-         * heuristically determined frame boundaries */
+        /* Lacking explicit frame boundaries, decide how long modifications
+         * should be coalesced based on how they have been arriving */
+        GUAC_TRACE_BEGIN(span);
+        int max_duration = guac_display_render_thread_max_duration;
+        int window = guac_display_render_thread_window(render_thread,
+                guac_metrics_current_usec());
+
+        /* Handle the change in frame state, continuing to accumulate frame
+         * modifications while still within heuristically determined frame
+         * boundaries */
         int allowed_wait = 0;
         guac_timestamp frame_start = guac_timestamp_current();
         do {
 
+            /* Track the rate that modifications are arriving */
+            if (render_thread->state.value & GUAC_DISPLAY_RENDER_THREAD_STATE_FRAME_MODIFIED)
+                guac_display_render_thread_observe(render_thread,
+                        guac_metrics_current_usec());
+
             /* Continue processing messages for up to a reasonable
              * minimum framerate without an explicit frame boundary
              * indicating that the frame is not yet complete */
             int frame_duration = guac_timestamp_current() - frame_start;
-            if (frame_duration > GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION) {
+            if (frame_duration > max_duration) {
                 guac_flag_unlock(&render_thread->state);
                 break;
             }
@@ -109,9 +254,10 @@ static void* guac_display_render_loop(void* data) {
 
             }
 
-            /* Do not exceed a reasonable maximum framerate without an
-             * explicit frame boundary terminating the frame early */
-            allowed_wait = GUAC_DISPLAY_RENDER_THREAD_MIN_FRAME_DURATION - frame_duration;
+            /* Do not end the frame before the coalescing window has elapsed
+             * without an explicit frame boundary terminating the frame
+             * early */
+            allowed_wait = window - frame_duration;
             if (allowed_wait < 0)
                 allowed_wait = 0;
 
@@ -125,6 +271,13 @@ static void* guac_display_render_loop(void* data) {
                     | GUAC_DISPLAY_RENDER_THREAD_STATE_FRAME_READY
                     | GUAC_DISPLAY_RENDER_THREAD_STATE_FRAME_MODIFIED, allowed_wait));
 
+        if (rendered_frames == 0) {
+            GUAC_TRACE_END(span, GUAC_TRACE_COALESCE, window);
+            guac_client_log(display->client, GUAC_LOG_TRACE, "Coalesced "
+                    "modifications for %ims (window: %ims).",
+                    (int) (guac_timestamp_current() - frame_start), window);
+        }
+
         guac_display_end_multiple_frames(display, rendered_frames);
 
     }
@@ -141,6 +294,11 @@ guac_display_render_thread* guac_display_render_thread_create(guac_display* disp
     render_thread->display = display;
     render_thread->frames = 0;
 
+    /* Consider modifications sporadic until measured otherwise */
+    render_thread->last_modified = 0;
+    render_thread->modification_interval =
+        GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION * 1000;
+
     /* Start render thread (this will immediately begin blocking until frame
      * modification or readiness is signalled) */
     pthread_create(&render_thread->thread, NULL, guac_display_render_loop, render_thread);
@@ -171,3 +329,19 @@ void guac_display_render_thread_destroy(guac_display_render_thread* render_threa
 
 }
 
+void guac_display_render_thread_set_frame_duration(int min_duration,
+        int max_duration) {
+
+    if (min_duration < 0)
+        min_duration = 0;
+
+    if (max_duration < 0)
+        max_duration = GUAC_DISPLAY_RENDER_THREAD_MAX_FRAME_DURATION;
+
+    if (max_duration < min_duration)
+        max_duration = min_duration;
+
+    guac_display_render_thread_min_duration = min_duration;
+    guac_display_render_thread_max_duration = max_duration;
+
+}
@@ -21,14 +21,16 @@
 #include "display-priv.h"
 #include "guacamole/client.h"
 #include "guacamole/display.h"
-#include "guacamole/fifo.h"
+#include "guacamole/flag.h"
 #include "guacamole/layer.h"
+#include "guacamole/metrics.h"
 #include "guacamole/protocol-types.h"
 #include "guacamole/protocol.h"
 #include "guacamole/rect.h"
 #include "guacamole/rwlock.h"
 #include "guacamole/socket.h"
 #include "guacamole/timestamp.h"
+#include "trace.h"
 
 #include <inttypes.h>
 #include <limits.h>
@@ -285,28 +287,234 @@ static int LFR_guac_display_layer_should_use_webp(guac_display_layer* layer,
 
 }
 
+/**
+ * Sends the boundary of the frame currently being rendered to connected
+ * users, along with any updates to the cursor and client-side backing
+ * buffers, waiting afterwards if necessary to compensate for client-side
+ * processing delays. This function is invoked by the worker thread that
+ * completes the final operation of the frame.
+ *
+ * @param display
+ *     The guac_display whose frame is being rendered.
+ */
+static void LFR_guac_display_worker_end_frame(guac_display* display) {
+
+    GUAC_TRACE_BEGIN(span);
+    guac_client* client = display->client;
+
+    /* Update the mouse cursor if it's been changed since the
+     * last frame */
+    guac_display_layer* cursor = display->cursor_buffer;
+    if (!guac_rect_is_empty(&cursor->last_frame.dirty)) {
+        guac_protocol_send_cursor(client->socket,
+                display->last_frame.cursor_hotspot_x,
+                display->last_frame.cursor_hotspot_y,
+                cursor->layer, 0, 0,
+                cursor->last_frame.width,
+                cursor->last_frame.height);
+    }
+
+    /* Use the amount of time that the client has been waiting
+     * for a frame vs. the amount of time that it took the
+     * client to process the most recently acknowledged frame
+     * to calculate the amount of additional delay required to
+     * allow the client to catch up. This value is used later,
+     * after everything else related to the frame has been
+     * finalized. */
+    int time_since_last_frame = guac_timestamp_current() - client->last_sent_timestamp;
+    int processing_lag = guac_client_get_processing_lag(client);
+    int required_wait = processing_lag - time_since_last_frame;
+    guac_metrics_observe(client->metrics, GUAC_METRICS_PROCESSING_LAG,
+            processing_lag);
+    __atomic_store_n(&display->processing_lag, processing_lag, __ATOMIC_RELAXED);
+
+    /* Allow connected clients to move forward with rendering */
+    guac_client_end_multiple_frames(client, display->last_frame.frames);
+
+    /* While connected clients moves forward with rendering,
+     * commit any changed contents to client-side backing buffer */
+    guac_display_layer* current = display->last_frame.layers;
+    while (current != NULL) {
+
+        /* Save a copy of the changed region if the layer has
+         * been modified since the last frame */
+        guac_rect* dirty = &current->last_frame.dirty;
+        if (!guac_rect_is_empty(dirty)) {
+
+            int x = dirty->left;
+            int y = dirty->top;
+            int width = guac_rect_width(dirty);
+            int height = guac_rect_height(dirty);
+
+            /* Ensure destination region is cleared out first if the alpha channel need be considered,
+             * as GUAC_COMP_OVER is significantly faster than GUAC_COMP_SRC on the browser side */
+            if (!current->opaque) {
+                guac_protocol_send_rect(client->socket, current->last_frame_buffer, x, y, width, height);
+                guac_protocol_send_cfill(client->socket, GUAC_COMP_RATOP, current->last_frame_buffer,
+                        0x00, 0x00, 0x00, 0x00);
+            }
+
+            guac_protocol_send_copy(client->socket,
+                    current->layer, x, y, width, height,
+                    GUAC_COMP_OVER, current->last_frame_buffer, x, y);
+
+        }
+
+        current = current->last_frame.next;
+
+    }
+
+    /* Include an additional frame boundary to allow the client to also move forward with committing
+     * changes to the backing buffer while the server is receiving and preparing the next frame */
+    guac_client_end_multiple_frames(client, 0);
+
+    /* This is now absolutely everything for the current frame,
+     * and it's safe to flush any outstanding data */
+    uint64_t flush_start = guac_metrics_current_usec();
+    guac_socket_flush(client->socket);
+    guac_metrics_observe_since(client->metrics, GUAC_METRICS_SOCKET_FLUSH_TIME,
+            flush_start);
+
+    /* Notify any watchers of render_state that a frame is no longer in progress */
+    guac_flag_set_and_lock(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_NOT_IN_PROGRESS);
+    guac_flag_clear(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_IN_PROGRESS);
+    guac_flag_unlock(&display->render_state);
+
+    /* Exclude local, server-side frame processing latency from
+     * waiting period */
+    int latency = (int) (guac_timestamp_current() - display->last_frame.timestamp);
+    if (latency >= 0) {
+        guac_client_log(display->client, GUAC_LOG_TRACE,
+                "Rendering latency: %ims (%i:1 frame)\n",
+                latency, display->last_frame.frames);
+        guac_metrics_observe(client->metrics, GUAC_METRICS_FRAME_LATENCY,
+                latency);
+        __atomic_store_n(&display->render_latency, latency, __ATOMIC_RELAXED);
+        required_wait -= latency;
+    }
+
+    /* Ensure we don't wait without bound when compensating for
+     * client-side processing delays */
+    if (required_wait > GUAC_DISPLAY_MAX_LAG_COMPENSATION)
+        required_wait = GUAC_DISPLAY_MAX_LAG_COMPENSATION;
+
+    /* Allow connected clients to catch up if they're taking
+     * longer to process frames than the server is taking to
+     * generate them */
+    if (required_wait > 0) {
+        guac_client_log(display->client, GUAC_LOG_TRACE,
+                "Waiting %ims to compensate for client-side "
+                "processing delays.\n", required_wait);
+        GUAC_TRACE_BEGIN(wait_span);
+        guac_timestamp_msleep(required_wait);
+        GUAC_TRACE_END(wait_span, GUAC_TRACE_LAG_WAIT, required_wait);
+    }
+
+    GUAC_TRACE_END(span, GUAC_TRACE_END_FRAME, 0);
+
+}
+
+void guac_display_frame_begin(guac_display* display) {
+
+    /* One reference is held by the thread adding operations to the queue,
+     * and another by the frame boundary itself */
+    __atomic_store_n(&display->pending_ops, 2, __ATOMIC_SEQ_CST);
+    display->frame_ops = 0;
+
+    /* Notify any watchers of render_state that a frame is now in progress */
+    guac_flag_set_and_lock(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_IN_PROGRESS);
+    guac_flag_clear(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_NOT_IN_PROGRESS);
+    guac_flag_unlock(&display->render_state);
+
+}
+
+/**
+ * Releases one reference on the pending operations of the frame currently
+ * being rendered, as tracked by the pending_ops member of the given
+ * guac_display.
+ *
+ * @param display
+ *     The guac_display whose frame is being rendered.
+ *
+ * @return
+ *     Non-zero if the only remaining reference is that of the frame boundary,
+ *     in which case the caller is responsible for that boundary, zero
+ *     otherwise.
+ */
+static int guac_display_frame_release(guac_display* display) {
+    return __atomic_sub_fetch(&display->pending_ops, 1, __ATOMIC_SEQ_CST) == 1;
+}
+
+void guac_display_frame_enqueue(guac_display* display,
+        const guac_display_plan_operation* op) {
+
+    /* The operation must be counted before any worker can complete it */
+    __atomic_add_fetch(&display->pending_ops, 1, __ATOMIC_SEQ_CST);
+    guac_display_queue_enqueue(&display->ops, op);
+    guac_metrics_observe(display->client->metrics,
+            GUAC_METRICS_WORKER_QUEUE_DEPTH,
+            guac_display_queue_length(&display->ops));
+
+    /* Start additional workers only once frames are large enough to keep
+     * them busy */
+    if (++display->frame_ops > display->worker_thread_count)
+        guac_display_worker_start(display);
+
+}
+
+int guac_display_worker_start(guac_display* display) {
+
+    if (display->worker_thread_count >= display->worker_thread_limit)
+        return 1;
+
+    pthread_t* thread = &(display->worker_threads[display->worker_thread_count]);
+    if (pthread_create(thread, NULL, guac_display_worker_thread, display)) {
+        guac_client_log(display->client, GUAC_LOG_WARNING, "Additional "
+                "worker thread could not be created. Graphical updates will "
+                "continue to be encoded using %i worker thread(s).",
+                display->worker_thread_count);
+        display->worker_thread_limit = display->worker_thread_count;
+        return 1;
+    }
+
+    display->worker_thread_count++;
+    return 0;
+
+}
+
+void guac_display_frame_ops_queued(guac_display* display) {
+
+    /* If the workers have already completed every operation, the boundary
+     * must still be sent by a worker, as sending the boundary may involve
+     * waiting for connected clients to catch up */
+    if (guac_display_frame_release(display)) {
+        guac_display_plan_operation end_frame_op = {
+            .type = GUAC_DISPLAY_PLAN_END_FRAME
+        };
+        guac_display_queue_enqueue(&display->ops, &end_frame_op);
+    }
+
+}
+
 void* guac_display_worker_thread(void* data) {
 
     int framerate;
-    int has_outstanding_frames = 0;
 
     guac_display* display = (guac_display*) data;
     guac_client* client = display->client;
     guac_socket* socket = client->socket;
 
     guac_display_plan_operation op;
-    while (guac_fifo_dequeue_and_lock(&display->ops, &op)) {
+    while (guac_display_queue_dequeue(&display->ops, &op)) {
 
-        /* Notify any watchers of render_state that a frame is now in progress */
-        guac_flag_set_and_lock(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_IN_PROGRESS);
-        guac_flag_clear(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_NOT_IN_PROGRESS);
-        guac_flag_unlock(&display->render_state);
+        int end_frame = 0;
 
-        /* NOTE: Any thread that locks the operation queue can know that there
-         * are no pending operations in progress if the queue is empty and
-         * there are no active workers */
-        display->active_workers++;
-        guac_fifo_unlock(&display->ops);
+        /* Encoding of images is limited by any encoder budget shared with
+         * other connections. The slot is acquired before the last_frame lock
+         * so that waiting does not block the next frame. */
+        int encoder_slot = -1;
+        if (op.type == GUAC_DISPLAY_PLAN_OPERATION_IMG)
+            encoder_slot = guac_display_encoder_acquire(display);
 
         guac_rwlock_acquire_read_lock(&display->last_frame.lock);
         guac_display_layer* display_layer = op.layer;
@@ -319,6 +527,7 @@ void* guac_display_worker_thread(void* data) {
                     framerate = 1000 / (op.current_frame - op.last_frame);
 
                 guac_rect* dirty = &op.dest;
+                GUAC_TRACE_BEGIN(span);
 
                 /* TODO: Determine whether to use PNG/WebP/JPEG purely
                  * based on whether lossless encoding is required, the
@@ -364,6 +573,14 @@ void* guac_display_worker_thread(void* data) {
                             layer, dirty->left, dirty->top, rect);
 
                 cairo_surface_destroy(rect);
+                guac_display_encoder_release(encoder_slot);
+
+                GUAC_TRACE_END(span, GUAC_TRACE_ENCODE,
+                        guac_rect_width(dirty) * guac_rect_height(dirty));
+
+                /* The worker completing the final operation of the frame also
+                 * sends the frame boundary */
+                end_frame = guac_display_frame_release(display);
                 break;
 
             case GUAC_DISPLAY_PLAN_OPERATION_COPY:
@@ -377,142 +594,29 @@ void* guac_display_worker_thread(void* data) {
                         op.type);
                 break;
 
+            /* The frame boundary is queued only if all operations of the
+             * frame were completed before the last was even queued */
             case GUAC_DISPLAY_PLAN_END_FRAME:
-
-                guac_fifo_lock(&display->ops);
-                int other_workers_busy = (display->active_workers > 1);
-                guac_fifo_unlock(&display->ops);
-
-                /* If other workers are still busy, push the frame boundary
-                 * back on the queue so that it's picked up by one of those
-                 * workers */
-                if (other_workers_busy) {
-                    guac_fifo_enqueue(&display->ops, &op);
-                }
-
-                /* Otherwise, we've reached the end of the frame, and this is
-                 * the worker that will be sending that boundary to connected
-                 * users */
-                else {
-
-                    /* Update the mouse cursor if it's been changed since the
-                     * last frame */
-                    guac_display_layer* cursor = display->cursor_buffer;
-                    if (!guac_rect_is_empty(&cursor->last_frame.dirty)) {
-                        guac_protocol_send_cursor(client->socket,
-                                display->last_frame.cursor_hotspot_x,
-                                display->last_frame.cursor_hotspot_y,
-                                cursor->layer, 0, 0,
-                                cursor->last_frame.width,
-                                cursor->last_frame.height);
-                    }
-
-                    /* Use the amount of time that the client has been waiting
-                     * for a frame vs. the amount of time that it took the
-                     * client to process the most recently acknowledged frame
-                     * to calculate the amount of additional delay required to
-                     * allow the client to catch up. This value is used later,
-                     * after everything else related to the frame has been
-                     * finalized. */
-                    int time_since_last_frame = guac_timestamp_current() - client->last_sent_timestamp;
-                    int processing_lag = guac_client_get_processing_lag(client);
-                    int required_wait = processing_lag - time_since_last_frame;
-
-                    /* Allow connected clients to move forward with rendering */
-                    guac_client_end_multiple_frames(client, display->last_frame.frames);
-
-                    /* While connected clients moves forward with rendering,
-                     * commit any changed contents to client-side backing buffer */
-                    guac_display_layer* current = display->last_frame.layers;
-                    while (current != NULL) {
-
-                        /* Save a copy of the changed region if the layer has
-                         * been modified since the last frame */
-                        guac_rect* dirty = &current->last_frame.dirty;
-                        if (!guac_rect_is_empty(dirty)) {
-
-                            int x = dirty->left;
-                            int y = dirty->top;
-                            int width = guac_rect_width(dirty);
-                            int height = guac_rect_height(dirty);
-
-                            /* Ensure destination region is cleared out first if the alpha channel need be considered,
-                             * as GUAC_COMP_OVER is significantly faster than GUAC_COMP_SRC on the browser side */
-                            if (!current->opaque) {
-                                guac_protocol_send_rect(client->socket, current->last_frame_buffer, x, y, width, height);
-                                guac_protocol_send_cfill(client->socket, GUAC_COMP_RATOP, current->last_frame_buffer,
-                                        0x00, 0x00, 0x00, 0x00);
-                            }
-
-                            guac_protocol_send_copy(client->socket,
-                                    current->layer, x, y, width, height,
-                                    GUAC_COMP_OVER, current->last_frame_buffer, x, y);
-
-                        }
-
-                        current = current->last_frame.next;
-
-                    }
-
-                    /* Include an additional frame boundary to allow the client to also move forward with committing
-                     * changes to the backing buffer while the server is receiving and preparing the next frame */
-                    guac_client_end_multiple_frames(client, 0);
-
-                    /* This is now absolutely everything for the current frame,
-                     * and it's safe to flush any outstanding data */
-                    guac_socket_flush(client->socket);
-
-                    /* Notify any watchers of render_state that a frame is no longer in progress */
-                    guac_flag_set_and_lock(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_NOT_IN_PROGRESS);
-                    guac_flag_clear(&display->render_state, GUAC_DISPLAY_RENDER_STATE_FRAME_IN_PROGRESS);
-                    guac_flag_unlock(&display->render_state);
-
-                    /* Exclude local, server-side frame processing latency from
-                     * waiting period */
-                    int latency = (int) (guac_timestamp_current() - display->last_frame.timestamp);
-                    if (latency >= 0) {
-                        guac_client_log(display->client, GUAC_LOG_TRACE,
-                                "Rendering latency: %ims (%i:1 frame)\n",
-                                latency, display->last_frame.frames);
-                        required_wait -= latency;
-                    }
-
-                    /* Ensure we don't wait without bound when compensating for
-                     * client-side processing delays */
-                    if (required_wait > GUAC_DISPLAY_MAX_LAG_COMPENSATION)
-                        required_wait = GUAC_DISPLAY_MAX_LAG_COMPENSATION;
-
-                    /* Allow connected clients to catch up if they're taking
-                     * longer to process frames than the server is taking to
-                     * generate them */
-                    if (required_wait > 0) {
-                        guac_client_log(display->client, GUAC_LOG_TRACE,
-                                "Waiting %ims to compensate for client-side "
-                                "processing delays.\n", required_wait);
-                        guac_timestamp_msleep(required_wait);
-                    }
-
-                    guac_fifo_lock(&display->ops);
-                    has_outstanding_frames = display->frame_deferred;
-                    guac_fifo_unlock(&display->ops);
-
-                }
-
+                end_frame = 1;
                 break;
 
         }
 
+        if (end_frame)
+            LFR_guac_display_worker_end_frame(display);
+
         guac_rwlock_release_lock(&display->last_frame.lock);
 
-        guac_fifo_lock(&display->ops);
-        display->active_workers--;
-        guac_fifo_unlock(&display->ops);
+        if (end_frame) {
+
+            /* The frame, including its boundary, is now completely sent */
+            __atomic_sub_fetch(&display->pending_ops, 1, __ATOMIC_SEQ_CST);
+
+            /* Trigger additional flush if frames were completed while we were
+             * still processing the previous frame */
+            if (__atomic_exchange_n(&display->frame_deferred, 0, __ATOMIC_SEQ_CST))
+                guac_display_end_multiple_frames(display, 0);
 
-        /* Trigger additional flush if frames were completed while we were
-         * still processing the previous frame */
-        if (has_outstanding_frames) {
-            guac_display_end_multiple_frames(display, 0);
-            has_outstanding_frames = 0;
         }
 
     }
@@ -22,7 +22,6 @@
 #include "display-priv.h"
 #include "guacamole/client.h"
 #include "guacamole/display.h"
-#include "guacamole/fifo.h"
 #include "guacamole/layer.h"
 #include "guacamole/mem.h"
 #include "guacamole/protocol.h"
@@ -128,9 +127,8 @@ guac_display* guac_display_alloc(guac_client* client) {
     display->default_layer = guac_display_add_layer(display, (guac_layer*) GUAC_DEFAULT_LAYER, 1);
     display->cursor_buffer = guac_display_alloc_buffer(display, 0);
 
-    /* Init operation FIFO used by worker threads */
-    guac_fifo_init(&display->ops, display->ops_items,
-            GUAC_DISPLAY_WORKER_FIFO_SIZE, sizeof(guac_display_plan_operation));
+    /* Init operation queue used by worker threads */
+    guac_display_queue_init(&display->ops);
 
     /* Init flag used to notify threads that need to monitor whether a frame is
      * currently being rendered */
@@ -148,15 +146,21 @@ guac_display* guac_display_alloc(guac_client* client) {
                 "processor(s) are available.", cpu_count);
     }
 
-    display->worker_thread_count = cpu_count * GUAC_DISPLAY_CPU_THREAD_FACTOR;
-    display->worker_threads = guac_mem_alloc(display->worker_thread_count, sizeof(pthread_t));
+    /* There is no benefit to more workers than may encode concurrently */
+    display->worker_thread_limit = cpu_count * GUAC_DISPLAY_CPU_THREAD_FACTOR;
+    int budget = guac_display_encoder_budget_size();
+    if (budget > 0 && budget < display->worker_thread_limit)
+        display->worker_thread_limit = budget;
+
+    display->worker_threads = guac_mem_alloc(display->worker_thread_limit, sizeof(pthread_t));
     guac_client_log(client, GUAC_LOG_INFO, "Graphical updates will be encoded "
-            "using %i worker thread(s).", display->worker_thread_count);
+            "using up to %i worker thread(s).", display->worker_thread_limit);
 
     /* Now that the core of the display has been fully initialized, it's safe
-     * to start the worker threads */
-    for (int i = 0; i < display->worker_thread_count; i++)
-        pthread_create(&(display->worker_threads[i]), NULL, guac_display_worker_thread, display);
+     * to start the worker threads. Additional workers beyond the first are
+     * started only once frames contain enough image operations to occupy
+     * them. */
+    guac_display_worker_start(display);
 
     return display;
 
@@ -164,17 +168,17 @@ guac_display* guac_display_alloc(guac_client* client) {
 
 void guac_display_free(guac_display* display) {
 
-    /* Stop further use of the operation FIFO */
-    guac_fifo_invalidate(&display->ops);
+    /* Stop further use of the operation queue */
+    guac_display_queue_invalidate(&display->ops);
 
     /* Wait for all worker threads to terminate (they should nearly immediately
-     * terminate following invalidation of the FIFO) */
+     * terminate following invalidation of the queue) */
     for (int i = 0; i < display->worker_thread_count; i++)
         pthread_join(display->worker_threads[i], NULL);
 
-    /* All locks, FIFOs, etc. are now unused and can be safely destroyed */
+    /* All locks, queues, etc. are now unused and can be safely destroyed */
     guac_flag_destroy(&display->render_state);
-    guac_fifo_destroy(&display->ops);
+    guac_display_queue_destroy(&display->ops);
     guac_rwlock_destroy(&display->last_frame.lock);
     guac_rwlock_destroy(&display->pending_frame.lock);
 
@@ -310,6 +314,11 @@ void guac_display_notify_user_moved_mouse(guac_display* display, guac_user* user
     display->pending_frame.cursor_mask = mask;
     guac_rwlock_release_lock(&display->pending_frame.lock);
 
+    /* Prioritize encoding of updates while the user is actively interacting
+     * with the display */
+    __atomic_store_n(&display->last_user_input, guac_timestamp_current(),
+            __ATOMIC_RELAXED);
+
     guac_display_end_mouse_frame(display);
 
 }
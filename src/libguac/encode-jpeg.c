@@ -62,6 +62,11 @@ typedef struct guac_jpeg_destination_mgr {
      */
     unsigned char buffer[GUAC_PROTOCOL_BLOB_MAX_LENGTH];
 
+    /**
+     * The total number of bytes of JPEG data written as blobs thus far.
+     */
+    int total_size;
+
 } guac_jpeg_destination_mgr;
 
 /**
@@ -99,6 +104,7 @@ static boolean guac_jpeg_empty_output_buffer(j_compress_ptr cinfo) {
     /* Write blob */
     guac_protocol_send_blob(dest->socket, dest->stream,
             dest->buffer, sizeof(dest->buffer));
+    dest->total_size += sizeof(dest->buffer);
 
     /* Update destination offset */
     dest->parent.next_output_byte = dest->buffer;
@@ -121,9 +127,12 @@ static void guac_jpeg_term_destination(j_compress_ptr cinfo) {
     guac_jpeg_destination_mgr* dest = (guac_jpeg_destination_mgr*) cinfo->dest;
 
     /* Write final blob, if any */
-    if (dest->parent.free_in_buffer != sizeof(dest->buffer))
+    int length = sizeof(dest->buffer) - dest->parent.free_in_buffer;
+    if (length > 0) {
         guac_protocol_send_blob(dest->socket, dest->stream, dest->buffer,
-                sizeof(dest->buffer) - dest->parent.free_in_buffer);
+                length);
+        dest->total_size += length;
+    }
 
 }
 
@@ -162,6 +171,7 @@ static void jpeg_guac_dest(j_compress_ptr cinfo, guac_socket* socket,
     /* Store Guacamole-specific objects */
     dest->socket = socket;
     dest->stream = stream;
+    dest->total_size = 0;
 
 }
 
@@ -258,10 +268,11 @@ int guac_jpeg_write(guac_socket* socket, guac_stream* stream,
 
     /* Finalize compression */
     jpeg_finish_compress(&cinfo);
+    int total_size = ((guac_jpeg_destination_mgr*) cinfo.dest)->total_size;
 
     /* Clean up */
     jpeg_destroy_compress(&cinfo);
-    return 0;
+    return total_size;
 
 }
 
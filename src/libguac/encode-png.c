@@ -64,6 +64,11 @@ typedef struct guac_png_write_state {
      */
     int buffer_size;
 
+    /**
+     * The total number of bytes of PNG data written as blobs thus far.
+     */
+    int total_size;
+
 } guac_png_write_state;
 
 /**
@@ -80,6 +85,7 @@ static void guac_png_flush_data(guac_png_write_state* write_state) {
             write_state->buffer, write_state->buffer_size);
 
     /* Clear buffer */
+    write_state->total_size += write_state->buffer_size;
     write_state->buffer_size = 0;
 
 }
@@ -179,7 +185,8 @@ static cairo_status_t guac_png_cairo_write_handler(void* closure,
  *     The Cairo surface to write to the given stream and socket as PNG blobs.
  *
  * @return
- *     Zero if the encoding operation is successful, non-zero otherwise.
+ *     The number of bytes of PNG data written if the encoding operation is
+ *     successful, a negative value otherwise.
  */
 static int guac_png_cairo_write(guac_socket* socket, guac_stream* stream,
         cairo_surface_t* surface) {
@@ -190,6 +197,7 @@ static int guac_png_cairo_write(guac_socket* socket, guac_stream* stream,
     write_state.socket = socket;
     write_state.stream = stream;
     write_state.buffer_size = 0;
+    write_state.total_size = 0;
 
     /* Write surface as PNG */
     if (cairo_surface_write_to_png_stream(surface,
@@ -202,7 +210,7 @@ static int guac_png_cairo_write(guac_socket* socket, guac_stream* stream,
 
     /* Flush remaining PNG data */
     guac_png_flush_data(&write_state);
-    return 0;
+    return write_state.total_size;
 
 }
 
@@ -336,6 +344,7 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     write_state.socket = socket;
     write_state.stream = stream;
     write_state.buffer_size = 0;
+    write_state.total_size = 0;
 
     /* Set up writer */
     png_set_write_fn(png, &write_state,
@@ -399,7 +408,7 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
 
     /* Ensure all data is written */
     guac_png_flush_data(&write_state);
-    return 0;
+    return write_state.total_size;
 
 }
 
@@ -41,7 +41,8 @@
  *     The Cairo surface to write to the given stream and socket as PNG blobs.
  *
  * @return
- *     Zero if the encoding operation is successful, non-zero otherwise.
+ *     The number of bytes of encoded image data written if the encoding
+ *     operation is successful, a negative value otherwise.
  */
 int guac_png_write(guac_socket* socket, guac_stream* stream,
         cairo_surface_t* surface);
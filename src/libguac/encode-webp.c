@@ -59,6 +59,11 @@ typedef struct guac_webp_stream_writer {
      */
     int buffer_size;
 
+    /**
+     * The total number of bytes of WebP data written as blobs thus far.
+     */
+    int total_size;
+
 } guac_webp_stream_writer;
 
 /**
@@ -75,6 +80,7 @@ static void guac_webp_flush_data(guac_webp_stream_writer* writer) {
             writer->buffer, writer->buffer_size);
 
     /* Clear buffer */
+    writer->total_size += writer->buffer_size;
     writer->buffer_size = 0;
 
 }
@@ -96,6 +102,7 @@ static void guac_webp_stream_writer_init(guac_webp_stream_writer* writer,
         guac_socket* socket, guac_stream* stream) {
 
     writer->buffer_size = 0;
+    writer->total_size = 0;
 
     /* Store Guacamole-specific objects */
     writer->socket = socket;
@@ -250,7 +257,7 @@ int guac_webp_write(guac_socket* socket, guac_stream* stream,
     }
 
     /* Encode image */
-    const int result = WebPEncode(&config, &picture) ? 0 : -1;
+    const int encoded = WebPEncode(&config, &picture);
 
     /* Free picture */
     WebPPictureFree(&picture);
@@ -258,7 +265,7 @@ int guac_webp_write(guac_socket* socket, guac_stream* stream,
     /* Ensure all data is written */
     guac_webp_flush_data(&writer);
 
-    return result;
+    return encoded ? writer.total_size : -1;
 
 }
 
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __GUAC_AUDIO_CONSTANTS_H
+#define __GUAC_AUDIO_CONSTANTS_H
+
+/**
+ * Constants related to simple streaming audio.
+ *
+ * @file audio-constants.h
+ */
+
+/**
+ * The recommended RMS level, scaled to the range of a signed 16-bit sample,
+ * below which PCM data may be considered silent. This is roughly -60 dBFS,
+ * well above the level of typical dither noise.
+ */
+#define GUAC_AUDIO_DEFAULT_SILENCE_THRESHOLD 32
+
+/**
+ * The recommended duration of continuous silence, in milliseconds, which
+ * must be observed before an audio stream is suppressed.
+ */
+#define GUAC_AUDIO_DEFAULT_SILENCE_HOLD 500
+
+/**
+ * The recommended duration of PCM data, in milliseconds, to accumulate before
+ * an audio stream is automatically flushed.
+ */
+#define GUAC_AUDIO_DEFAULT_PACKET_DURATION 100
+
+/**
+ * The factor by which the RMS level of PCM data must exceed the silence
+ * threshold for a suppressed audio stream to resume. Requiring a level
+ * greater than the threshold itself prevents a stream hovering near the
+ * threshold from being repeatedly suppressed and resumed.
+ */
+#define GUAC_AUDIO_SILENCE_RESUME_FACTOR 2
+
+/**
+ * The factor by which the peak level of PCM data may exceed the silence
+ * threshold while that data is still considered silent. Brief sounds with a
+ * peak above this level are never suppressed, even if their RMS level is
+ * low.
+ */
+#define GUAC_AUDIO_SILENCE_PEAK_FACTOR 8
+
+#endif
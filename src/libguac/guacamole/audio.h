@@ -26,11 +26,15 @@
  * @file audio.h
  */
 
+#include "audio-constants.h"
 #include "audio-fntypes.h"
 #include "audio-types.h"
 #include "client-types.h"
+#include "flag.h"
 #include "stream-types.h"
 
+#include <pthread.h>
+
 struct guac_audio_encoder {
 
     /**
@@ -107,6 +111,80 @@ struct guac_audio_stream {
      */
     void* data;
 
+    /**
+     * The duration of PCM data, in milliseconds, to accumulate before this
+     * audio stream is automatically flushed. If zero, the stream is flushed
+     * only when explicitly requested or when the encoder's own buffer fills.
+     */
+    int packet_duration;
+
+    /**
+     * The number of bytes of PCM data written since this audio stream was
+     * last flushed.
+     */
+    int pending_length;
+
+    /**
+     * The RMS level, scaled to the range of a signed 16-bit sample, below
+     * which PCM data is considered silent. If zero, silence is never
+     * suppressed.
+     */
+    int silence_threshold;
+
+    /**
+     * The duration of continuous silence, in milliseconds, which must be
+     * observed before this audio stream is suppressed.
+     */
+    int silence_hold;
+
+    /**
+     * The number of bytes of continuously silent PCM data written since
+     * non-silent PCM data was last written.
+     */
+    int silence_length;
+
+    /**
+     * Non-zero if PCM data is currently being discarded due to silence, zero
+     * otherwise.
+     */
+    int suppressed;
+
+    /**
+     * Recursive lock which is acquired while PCM data is being written,
+     * encoded, or flushed, such that pending PCM data may be flushed by the
+     * flush thread without disturbing the thread writing PCM data.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Flag signalling the flush thread that PCM data has been written or that
+     * the thread should stop.
+     */
+    guac_flag flush_state;
+
+    /**
+     * Thread which flushes any pending PCM data once no further PCM data has
+     * been written for packet_duration milliseconds, such that the end of a
+     * sound is not held back until the next sound begins. This thread is
+     * started only once a packet duration is set.
+     */
+    pthread_t flush_thread;
+
+    /**
+     * Non-zero if flush_thread has been started, zero otherwise.
+     */
+    int flush_thread_started;
+
+    /**
+     * Non-zero while pending PCM data is being flushed because the current
+     * sound has ended, either because no further PCM data has been written
+     * for packet_duration milliseconds or because the stream is about to be
+     * suppressed as silent, zero otherwise. Encoders which hold back
+     * incomplete blocks of PCM data until further data is written should
+     * encode and send those blocks during such a flush.
+     */
+    int sound_ended;
+
 };
 
 /**
@@ -121,13 +199,16 @@ struct guac_audio_stream {
  * If a new user joins the connection after the audio stream is created, that
  * user will not be aware of the existence of the audio stream, and
  * guac_audio_stream_add_user() will need to be invoked to recreate the stream
- * for the new user.
+ * for the new user. As the same encoded audio is sent to all users, a
+ * compressed format is selected only if all users support it, and the stream
+ * falls back to raw PCM if a user that does not support the selected
+ * compressed format later joins.
  *
  * @param client
  *     The guac_client for which this audio stream is being allocated. The
  *     connection owner is given priority when determining the level of audio
- *     support. It is currently assumed that all other joining users on the
- *     connection will have the same level of audio support.
+ *     support, while compressed formats are used only if supported by all
+ *     users of the connection.
  *
  * @param encoder
  *     The guac_audio_encoder to use when encoding audio, or NULL if libguac
@@ -185,7 +266,9 @@ void guac_audio_stream_reset(guac_audio_stream* audio,
  * Notifies the given audio stream that a user has joined the connection. The
  * audio stream itself may need to be restarted. and the audio stream will need
  * to be created for the new user to ensure they can properly handle future
- * data received along the stream.
+ * data received along the stream. If the user does not support the compressed
+ * format currently being used by the stream, the stream is restarted for all
+ * users using raw PCM.
  *
  * @param audio
  *     The guac_audio_stream associated with the Guacamole connection being
@@ -204,10 +287,56 @@ void guac_audio_stream_add_user(guac_audio_stream* audio, guac_user* user);
  */
 void guac_audio_stream_free(guac_audio_stream* stream);
 
+/**
+ * Sets the duration of PCM data to accumulate before the given audio stream
+ * is automatically flushed, allowing PCM data to be sent in fewer, larger
+ * packets without requiring callers to flush explicitly. This duration is
+ * effectively the added latency of the stream. Any PCM data still pending
+ * once no further PCM data has been written for the same duration is also
+ * flushed automatically, such that the end of each sound is not delayed
+ * until the next. By default, audio streams are not flushed automatically.
+ *
+ * @param audio
+ *     The guac_audio_stream to configure.
+ *
+ * @param duration
+ *     The duration of PCM data to accumulate, in milliseconds, or zero to
+ *     flush only when explicitly requested via guac_audio_stream_flush().
+ */
+void guac_audio_stream_set_packet_duration(guac_audio_stream* audio,
+        int duration);
+
+/**
+ * Enables or disables silence suppression for the given audio stream. Once
+ * the RMS level of written PCM data has remained below the given threshold
+ * for the given duration, any pending PCM data is flushed and further PCM data
+ * is discarded. PCM data is sent again once its RMS level exceeds the
+ * threshold by GUAC_AUDIO_SILENCE_RESUME_FACTOR, or its peak level exceeds
+ * the threshold by GUAC_AUDIO_SILENCE_PEAK_FACTOR. By default, silence is
+ * not suppressed.
+ *
+ * @param audio
+ *     The guac_audio_stream to configure.
+ *
+ * @param threshold
+ *     The RMS level, scaled to the range of a signed 16-bit sample, below
+ *     which PCM data is considered silent, or zero to disable silence
+ *     suppression.
+ *
+ * @param hold
+ *     The duration of continuous silence, in milliseconds, which must be
+ *     observed before the audio stream is suppressed.
+ */
+void guac_audio_stream_set_silence_threshold(guac_audio_stream* audio,
+        int threshold, int hold);
+
 /**
  * Writes PCM data to the given audio stream. This PCM data will be
- * automatically encoded by the audio encoder associated with this stream. The
- * PCM data must be 2-channel, 44100 Hz, with signed 16-bit samples.
+ * automatically encoded by the audio encoder associated with this stream,
+ * unless silence suppression has been enabled via
+ * guac_audio_stream_set_silence_threshold() and the stream is currently
+ * silent. The PCM data must match the format given when the stream was
+ * allocated or last reset.
  *
  * @param stream
  *     The guac_audio_stream to write PCM data through.
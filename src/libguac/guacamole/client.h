@@ -29,7 +29,9 @@
 #include "client-fntypes.h"
 #include "client-types.h"
 #include "client-constants.h"
+#include "flag.h"
 #include "layer-types.h"
+#include "metrics-types.h"
 #include "object-types.h"
 #include "pool-types.h"
 #include "rwlock.h"
@@ -188,10 +190,10 @@ struct guac_client {
     guac_rwlock __pending_users_lock;
 
     /**
-     * A timer that will periodically synchronize the list of pending users,
+     * A thread that will synchronize the list of pending users as users join,
      * emptying the list once synchronization is complete. Only for internal
-     * use within the client. This will be NULL until the first user joins
-     * the connection, as it is lazily instantiated at that time.
+     * use within the client. This thread is not started until the first user
+     * joins the connection, as it is lazily instantiated at that time.
      */
     pthread_t __pending_users_thread;
 
@@ -311,6 +313,22 @@ struct guac_client {
      */
     void* __plugin_handle;
 
+    /**
+     * Performance counters and histograms describing the operation of this
+     * client, such as the time taken to render each frame and the amount of
+     * image data sent using each image format. This is allocated
+     * automatically by guac_client_alloc() and is updated by libguac itself.
+     * The values within may be read at any time using guac_metrics_copy().
+     */
+    guac_metrics* metrics;
+
+    /**
+     * Flag which wakes the pending users thread, signalling either that
+     * users have been added to the list of pending users or that the thread
+     * should stop. Only for internal use within the client.
+     */
+    guac_flag __pending_users_flag;
+
 };
 
 /**
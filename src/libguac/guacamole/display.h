@@ -49,6 +49,7 @@
 #include "socket.h"
 
 #include <cairo/cairo.h>
+#include <stdint.h>
 #include <unistd.h>
 
 /**
@@ -220,6 +221,68 @@ guac_display* guac_display_alloc(guac_client* client);
  */
 void guac_display_free(guac_display* display);
 
+/**
+ * Establishes an encoding budget shared by this process and all child
+ * processes created after this function is called, limiting the total number
+ * of images that may be encoded at any one time by all guac_display instances
+ * of those processes. Worker threads encoding updates for displays that have
+ * recently received user input are given priority over those of other
+ * displays. This function may be invoked at most once, and must be invoked
+ * before any child processes that should share the budget are created.
+ *
+ * @param encoders
+ *     The maximum number of images that may be encoded concurrently. If zero
+ *     or negative, no budget is established and the number of concurrent
+ *     encoding operations is limited only by the number of worker threads of
+ *     each guac_display.
+ *
+ * @return
+ *     Zero if the budget was successfully established (or no budget was
+ *     requested), non-zero if the budget could not be established, in which
+ *     case guac_error and guac_error_message are set appropriately.
+ */
+int guac_display_set_encoder_budget(int encoders);
+
+/**
+ * Opens a new lease on the encoder budget established by
+ * guac_display_set_encoder_budget(), on behalf of a child process that is
+ * about to be created. The child process must call
+ * guac_display_use_encoder_lease() with the returned lease, and the process
+ * that created the child must call guac_display_close_encoder_lease() once
+ * the child (and any of its own children) has terminated, releasing any
+ * encoder slots that the child process did not release itself, such as if it
+ * was killed while encoding.
+ *
+ * @return
+ *     A new lease which is never reused, or zero if no encoder budget has
+ *     been established.
+ */
+uint64_t guac_display_open_encoder_lease();
+
+/**
+ * Associates the current process with the given lease, as returned by
+ * guac_display_open_encoder_lease() within the parent process, such that all
+ * encoder slots acquired by this process are released when that lease is
+ * closed. If a process acquires encoder slots without first calling this
+ * function, a lease is opened for that process automatically, but will never
+ * be closed.
+ *
+ * @param lease
+ *     The lease to associate with the current process. If zero, this
+ *     function has no effect.
+ */
+void guac_display_use_encoder_lease(uint64_t lease);
+
+/**
+ * Closes the given lease, as returned by guac_display_open_encoder_lease(),
+ * releasing all encoder slots still held by the process that used that lease.
+ * This function must only be called once that process has terminated.
+ *
+ * @param lease
+ *     The lease to close. If zero, this function has no effect.
+ */
+void guac_display_close_encoder_lease(uint64_t lease);
+
 /**
  * Replicates the current remote display state across the given socket. When
  * new users join a particular guac_client, this function should be used to
@@ -773,6 +836,30 @@ void guac_display_render_thread_notify_frame(guac_display_render_thread* render_
  */
 void guac_display_render_thread_destroy(guac_display_render_thread* render_thread);
 
+/**
+ * Overrides the bounds of the window during which render threads lacking
+ * explicit frame boundaries coalesce modifications into a single frame. By
+ * default, this window is chosen automatically for each frame, based on the
+ * rate that modifications are arriving, the time taken to encode recent
+ * frames, and the processing lag of connected users. Isolated modifications,
+ * such as the echo of a single keystroke, are flushed immediately, while
+ * continuous streams of modifications, such as video, are batched. The
+ * bounds apply to all render threads of the current process and any child
+ * processes created after this function is called.
+ *
+ * @param min_duration
+ *     The minimum amount of time that modifications should be coalesced,
+ *     in milliseconds, even if the modification is isolated. If negative,
+ *     the default minimum of zero is used.
+ *
+ * @param max_duration
+ *     The maximum duration of any frame, in milliseconds. If negative, the
+ *     default maximum of 100 milliseconds is used. If less than the minimum,
+ *     the minimum is used, and the window thus does not adapt.
+ */
+void guac_display_render_thread_set_frame_duration(int min_duration,
+        int max_duration);
+
 /**
  * @}
  */
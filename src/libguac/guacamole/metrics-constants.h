@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_METRICS_CONSTANTS_H
+#define GUAC_METRICS_CONSTANTS_H
+
+/**
+ * Constants related to the performance counters and histograms maintained for
+ * each guac_client.
+ *
+ * @file metrics-constants.h
+ */
+
+/**
+ * The number of buckets within each histogram of a guac_metrics. Each bucket
+ * other than the last counts the observed values less than or equal to the
+ * power of two matching that bucket's index (1, 2, 4, 8, ...). The last
+ * bucket counts all remaining values.
+ */
+#define GUAC_METRICS_BUCKETS 24
+
+#endif
+
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_METRICS_TYPES_H
+#define GUAC_METRICS_TYPES_H
+
+/**
+ * Type definitions related to the performance counters and histograms
+ * maintained for each guac_client.
+ *
+ * @file metrics-types.h
+ */
+
+/**
+ * All counters maintained by a guac_metrics. Each counter only ever
+ * increases.
+ */
+typedef enum guac_metrics_counter {
+
+    /**
+     * The number of bytes of PNG image data sent.
+     */
+    GUAC_METRICS_PNG_BYTES,
+
+    /**
+     * The number of bytes of JPEG image data sent.
+     */
+    GUAC_METRICS_JPEG_BYTES,
+
+    /**
+     * The number of bytes of WebP image data sent.
+     */
+    GUAC_METRICS_WEBP_BYTES,
+
+    /**
+     * The number of display updates that were sent as copies of previously
+     * sent image data (including scrolling) rather than as new images.
+     */
+    GUAC_METRICS_COPIES,
+
+    /**
+     * The number of counters. This is not a valid counter.
+     */
+    GUAC_METRICS_COUNTERS
+
+} guac_metrics_counter;
+
+/**
+ * All histograms maintained by a guac_metrics. The number of values observed
+ * by each histogram is tracked along with the distribution of those values,
+ * and thus the histograms related to encoding also count the number of images
+ * encoded.
+ */
+typedef enum guac_metrics_histogram {
+
+    /**
+     * The time taken to render each frame of the guac_display, from the
+     * start of the frame until the frame has been flushed, in milliseconds.
+     */
+    GUAC_METRICS_FRAME_LATENCY,
+
+    /**
+     * The processing lag of connected users at the end of each frame of the
+     * guac_display, in milliseconds.
+     */
+    GUAC_METRICS_PROCESSING_LAG,
+
+    /**
+     * The time taken to encode and send each PNG image, in microseconds.
+     */
+    GUAC_METRICS_PNG_ENCODE_TIME,
+
+    /**
+     * The time taken to encode and send each JPEG image, in microseconds.
+     */
+    GUAC_METRICS_JPEG_ENCODE_TIME,
+
+    /**
+     * The time taken to encode and send each WebP image, in microseconds.
+     */
+    GUAC_METRICS_WEBP_ENCODE_TIME,
+
+    /**
+     * The number of operations waiting in the queue of the guac_display
+     * worker threads each time an operation is added to that queue.
+     */
+    GUAC_METRICS_WORKER_QUEUE_DEPTH,
+
+    /**
+     * The time taken to flush the broadcast socket at the end of each frame
+     * of the guac_display, in microseconds.
+     */
+    GUAC_METRICS_SOCKET_FLUSH_TIME,
+
+    /**
+     * The number of histograms. This is not a valid histogram.
+     */
+    GUAC_METRICS_HISTOGRAMS
+
+} guac_metrics_histogram;
+
+/**
+ * The distribution of values observed by a single histogram of a
+ * guac_metrics.
+ */
+typedef struct guac_metrics_distribution guac_metrics_distribution;
+
+/**
+ * The performance counters and histograms of a single guac_client. A
+ * guac_metrics contains no pointers and may be safely copied between
+ * processes.
+ */
+typedef struct guac_metrics guac_metrics;
+
+#endif
+
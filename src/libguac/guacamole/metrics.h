@@ -0,0 +1,256 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_METRICS_H
+#define GUAC_METRICS_H
+
+/**
+ * Performance counters and histograms maintained for each guac_client,
+ * suitable for aggregation across connections and export to monitoring
+ * systems.
+ *
+ * @file metrics.h
+ */
+
+#include "metrics-constants.h"
+#include "metrics-types.h"
+
+#include <stdint.h>
+
+struct guac_metrics_distribution {
+
+    /**
+     * The number of observed values within each bucket. The value at index N
+     * is the number of observed values greater than 2^(N-1) but less than or
+     * equal to 2^N, except for the first bucket (which also counts zero) and
+     * the last bucket (which has no upper bound).
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    uint64_t buckets[GUAC_METRICS_BUCKETS];
+
+    /**
+     * The sum of all observed values.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    uint64_t sum;
+
+    /**
+     * The total number of observed values.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    uint64_t count;
+
+};
+
+struct guac_metrics {
+
+    /**
+     * The current value of each counter, indexed by guac_metrics_counter.
+     *
+     * IMPORTANT: This member must only be accessed using atomic operations.
+     */
+    uint64_t counters[GUAC_METRICS_COUNTERS];
+
+    /**
+     * The distribution of values observed by each histogram, indexed by
+     * guac_metrics_histogram.
+     */
+    guac_metrics_distribution histograms[GUAC_METRICS_HISTOGRAMS];
+
+};
+
+/**
+ * Allocates a new guac_metrics having all counters and histograms set to
+ * zero.
+ *
+ * @return
+ *     A newly-allocated guac_metrics, or NULL if allocation fails. The
+ *     guac_metrics must eventually be freed with guac_metrics_free().
+ */
+guac_metrics* guac_metrics_alloc();
+
+/**
+ * Frees the given guac_metrics. If NULL is provided, this function has no
+ * effect.
+ *
+ * @param metrics
+ *     The guac_metrics to free.
+ */
+void guac_metrics_free(guac_metrics* metrics);
+
+/**
+ * Adds the given value to the given counter. This function is threadsafe. If
+ * NULL is provided for the guac_metrics, this function has no effect.
+ *
+ * @param metrics
+ *     The guac_metrics containing the counter to update.
+ *
+ * @param counter
+ *     The counter to update.
+ *
+ * @param value
+ *     The value to add to the counter.
+ */
+void guac_metrics_add(guac_metrics* metrics, guac_metrics_counter counter,
+        uint64_t value);
+
+/**
+ * Records the given value within the given histogram. This function is
+ * threadsafe. If NULL is provided for the guac_metrics, this function has no
+ * effect.
+ *
+ * @param metrics
+ *     The guac_metrics containing the histogram to update.
+ *
+ * @param histogram
+ *     The histogram to update.
+ *
+ * @param value
+ *     The value to record.
+ */
+void guac_metrics_observe(guac_metrics* metrics,
+        guac_metrics_histogram histogram, uint64_t value);
+
+/**
+ * Returns the current value of a monotonic clock in microseconds, for use in
+ * measuring the durations recorded with guac_metrics_observe_since().
+ *
+ * @return
+ *     The current value of a monotonic clock, in microseconds.
+ */
+uint64_t guac_metrics_current_usec();
+
+/**
+ * Records the number of microseconds elapsed since the given time within the
+ * given histogram. This function is threadsafe. If NULL is provided for the
+ * guac_metrics, this function has no effect.
+ *
+ * @param metrics
+ *     The guac_metrics containing the histogram to update.
+ *
+ * @param histogram
+ *     The histogram to update.
+ *
+ * @param start
+ *     The start of the duration to record, as returned by
+ *     guac_metrics_current_usec().
+ */
+void guac_metrics_observe_since(guac_metrics* metrics,
+        guac_metrics_histogram histogram, uint64_t start);
+
+/**
+ * Copies the current values of all counters and histograms of the given
+ * guac_metrics into another guac_metrics. Each value is copied atomically,
+ * but the copy as a whole is not atomic, and values may continue to change
+ * while the copy is in progress. This function is threadsafe with respect to
+ * concurrent updates of either guac_metrics.
+ *
+ * @param dst
+ *     The guac_metrics to copy values into.
+ *
+ * @param src
+ *     The guac_metrics to copy values from.
+ */
+void guac_metrics_copy(guac_metrics* dst, const guac_metrics* src);
+
+/**
+ * Adds the current values of all counters and histograms of the given
+ * guac_metrics to the corresponding counters and histograms of another
+ * guac_metrics, as when aggregating the metrics of several connections. This
+ * function is threadsafe with respect to concurrent updates of either
+ * guac_metrics.
+ *
+ * @param dst
+ *     The guac_metrics to add values to.
+ *
+ * @param src
+ *     The guac_metrics whose values should be added.
+ */
+void guac_metrics_merge(guac_metrics* dst, const guac_metrics* src);
+
+/**
+ * Returns the inclusive upper bound of the values counted by the given bucket
+ * of any histogram.
+ *
+ * @param bucket
+ *     The index of the bucket, which must be less than GUAC_METRICS_BUCKETS.
+ *
+ * @return
+ *     The inclusive upper bound of the values counted by the given bucket, or
+ *     UINT64_MAX if the bucket is the last bucket and thus has no upper bound.
+ */
+uint64_t guac_metrics_bucket_bound(int bucket);
+
+/**
+ * Returns a short, unique name for the given counter consisting only of
+ * lowercase letters and underscores, suitable for use within the names of
+ * metrics exported to monitoring systems.
+ *
+ * @param counter
+ *     The counter to return the name of.
+ *
+ * @return
+ *     The name of the given counter, or NULL if the counter is invalid.
+ */
+const char* guac_metrics_counter_name(guac_metrics_counter counter);
+
+/**
+ * Returns a human-readable description of the given counter.
+ *
+ * @param counter
+ *     The counter to describe.
+ *
+ * @return
+ *     A human-readable description of the given counter, or NULL if the
+ *     counter is invalid.
+ */
+const char* guac_metrics_counter_description(guac_metrics_counter counter);
+
+/**
+ * Returns a short, unique name for the given histogram consisting only of
+ * lowercase letters and underscores, suitable for use within the names of
+ * metrics exported to monitoring systems. The name includes the unit of the
+ * values observed, if any.
+ *
+ * @param histogram
+ *     The histogram to return the name of.
+ *
+ * @return
+ *     The name of the given histogram, or NULL if the histogram is invalid.
+ */
+const char* guac_metrics_histogram_name(guac_metrics_histogram histogram);
+
+/**
+ * Returns a human-readable description of the given histogram.
+ *
+ * @param histogram
+ *     The histogram to describe.
+ *
+ * @return
+ *     A human-readable description of the given histogram, or NULL if the
+ *     histogram is invalid.
+ */
+const char* guac_metrics_histogram_description(
+        guac_metrics_histogram histogram);
+
+#endif
+
@@ -0,0 +1,38 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_OPCODE_CONSTANTS_H
+#define GUAC_OPCODE_CONSTANTS_H
+
+/**
+ * Constants related to the constant-time lookup of instruction handlers by
+ * opcode.
+ *
+ * @file opcode-constants.h
+ */
+
+/**
+ * The number of slots within each guac_opcode_index. This value MUST be a
+ * power of two. At most half of these slots may be occupied, such that
+ * lookups for unknown opcodes quickly encounter an empty slot.
+ */
+#define GUAC_OPCODE_INDEX_SIZE 64
+
+#endif
+
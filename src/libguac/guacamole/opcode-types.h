@@ -0,0 +1,38 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_OPCODE_TYPES_H
+#define GUAC_OPCODE_TYPES_H
+
+/**
+ * Type definitions related to the constant-time lookup of instruction
+ * handlers by opcode.
+ *
+ * @file opcode-types.h
+ */
+
+/**
+ * Hash index over an existing, NULL-terminated array of opcode/handler
+ * mappings, allowing the mapping for any particular opcode to be located
+ * without comparing that opcode against every defined opcode.
+ */
+typedef struct guac_opcode_index guac_opcode_index;
+
+#endif
+
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_OPCODE_H
+#define GUAC_OPCODE_H
+
+/**
+ * Provides functions for locating the handler associated with an instruction
+ * opcode in constant time. Any NULL-terminated array of structures whose
+ * first member is the opcode string (a "char*" or "const char*") may be
+ * indexed, such as the handler maps used by libguac, guacenc, and guaclog.
+ *
+ * @file opcode.h
+ */
+
+#include "opcode-constants.h"
+#include "opcode-types.h"
+
+#include <stddef.h>
+
+struct guac_opcode_index {
+
+    /**
+     * The entries of the indexed map, stored by hash value. Each slot
+     * contains one more than the index of the corresponding entry within the
+     * indexed map, or zero if the slot is unused. Slots which collide are
+     * resolved by linear probing.
+     */
+    unsigned char slots[GUAC_OPCODE_INDEX_SIZE];
+
+};
+
+/**
+ * Returns a hash of the given opcode which is suitable for indexing within a
+ * guac_opcode_index. The hash is derived from the length and the first and
+ * last characters of the opcode only, and is collision-free across each of
+ * the handler maps defined by libguac, guacenc, and guaclog.
+ *
+ * @param opcode
+ *     The opcode to hash. This MUST be a non-empty string.
+ *
+ * @param length
+ *     The length of the opcode, in bytes.
+ *
+ * @return
+ *     A hash of the given opcode, in the range 0 through
+ *     GUAC_OPCODE_INDEX_SIZE - 1 inclusive.
+ */
+unsigned int guac_opcode_hash(const char* opcode, size_t length);
+
+/**
+ * Initializes the given guac_opcode_index such that it indexes the opcodes
+ * of all entries within the given map. The map must remain unchanged for as
+ * long as the index is in use. If the map contains more than
+ * GUAC_OPCODE_INDEX_SIZE / 2 entries, execution is aborted.
+ *
+ * @param index
+ *     The guac_opcode_index to initialize.
+ *
+ * @param map
+ *     An array of structures, each beginning with a pointer to a
+ *     non-empty opcode string, and terminated by a structure whose opcode is
+ *     NULL.
+ *
+ * @param mapping_size
+ *     The size of each structure within the map, in bytes.
+ */
+void guac_opcode_index_init(guac_opcode_index* index, const void* map,
+        size_t mapping_size);
+
+/**
+ * Returns the entry within the given map having the given opcode, using the
+ * given guac_opcode_index, which must have been initialized with that same
+ * map. Only a single string comparison is required unless opcodes within the
+ * map have colliding hashes.
+ *
+ * @param index
+ *     The guac_opcode_index that was initialized with the given map.
+ *
+ * @param map
+ *     The map to search.
+ *
+ * @param mapping_size
+ *     The size of each structure within the map, in bytes.
+ *
+ * @param opcode
+ *     The opcode to search for.
+ *
+ * @return
+ *     A pointer to the entry within the given map having the given opcode, or
+ *     NULL if there is no such entry.
+ */
+const void* guac_opcode_index_lookup(const guac_opcode_index* index,
+        const void* map, size_t mapping_size, const char* opcode);
+
+#endif
+
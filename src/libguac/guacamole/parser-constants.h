@@ -41,5 +41,22 @@
  */
 #define GUAC_INSTRUCTION_MAX_ELEMENTS 128
 
+/**
+ * The initial size of the buffer used by guac_parser to store received
+ * instruction data, in bytes. The buffer grows automatically if a single
+ * instruction does not fit, up to GUAC_PARSER_MAX_BUFFER_SIZE.
+ */
+#define GUAC_PARSER_INITIAL_BUFFER_SIZE 65536
+
+/**
+ * The maximum size of the buffer used by guac_parser to store received
+ * instruction data, in bytes. This is sufficient to store any instruction
+ * permitted by GUAC_INSTRUCTION_MAX_ELEMENTS, GUAC_INSTRUCTION_MAX_DIGITS, and
+ * GUAC_INSTRUCTION_MAX_LENGTH, even if every character requires the maximum
+ * of four bytes in UTF-8.
+ */
+#define GUAC_PARSER_MAX_BUFFER_SIZE (GUAC_INSTRUCTION_MAX_ELEMENTS    \
+        * (GUAC_INSTRUCTION_MAX_DIGITS + GUAC_INSTRUCTION_MAX_LENGTH * 4 + 2))
+
 #endif
 
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _GUAC_PARSER_FNTYPES_H
+#define _GUAC_PARSER_FNTYPES_H
+
+/**
+ * Function type definitions related to parsing the Guacamole protocol.
+ *
+ * @file parser-fntypes.h
+ */
+
+#include "parser-types.h"
+
+/**
+ * Callback which is invoked by guac_parser_read_batch() for each complete
+ * instruction read. The instruction is available through the opcode, argc,
+ * and argv of the given parser only for the duration of the call.
+ *
+ * @param parser
+ *     The guac_parser which has just read a complete instruction.
+ *
+ * @param data
+ *     The arbitrary data passed to guac_parser_read_batch().
+ *
+ * @return
+ *     Zero if handling of further instructions should continue, non-zero if
+ *     guac_parser_read_batch() should stop and return immediately.
+ */
+typedef int guac_parser_callback(guac_parser* parser, void* data);
+
+#endif
+
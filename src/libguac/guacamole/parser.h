@@ -28,8 +28,11 @@
 
 #include "parser-types.h"
 #include "parser-constants.h"
+#include "parser-fntypes.h"
 #include "socket-types.h"
 
+#include <stddef.h>
+
 struct guac_parser {
 
     /**
@@ -71,6 +74,12 @@ struct guac_parser {
      * Pointer to the first character of the current in-progress instruction
      * within the buffer.
      */
+    char* __instructionbuf_instruction_start;
+
+    /**
+     * Pointer to the first character within the buffer which has not yet
+     * been parsed.
+     */
     char* __instructionbuf_unparsed_start;
 
     /**
@@ -81,9 +90,16 @@ struct guac_parser {
     /**
      * The instruction buffer. This is essentially the input buffer,
      * provided as a convenience to be used to buffer instructions until
-     * those instructions are complete and ready to be parsed.
+     * those instructions are complete and ready to be parsed. The buffer
+     * starts at GUAC_PARSER_INITIAL_BUFFER_SIZE bytes and grows as needed to
+     * hold a single instruction, up to GUAC_PARSER_MAX_BUFFER_SIZE bytes.
+     */
+    char* __instructionbuf;
+
+    /**
+     * The current size of the instruction buffer, in bytes.
      */
-    char __instructionbuf[32768];
+    size_t __instructionbuf_size;
 
 };
 
@@ -161,6 +177,78 @@ void guac_parser_free(guac_parser* parser);
  */
 int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout);
 
+/**
+ * Reads and handles all instructions available from the given guac_socket,
+ * invoking the given callback for each complete instruction in the order
+ * received. Any complete instructions already buffered within the parser are
+ * handled first without reading from the guac_socket. Otherwise, this
+ * function waits up to the given timeout for data to become available,
+ * performs a single read filling as much of the parser's internal buffer as
+ * possible, and handles every complete instruction within that data. Any
+ * trailing partial instruction remains buffered until a future call.
+ *
+ * Each instruction is available through the opcode, argc, and argv of the
+ * parser only for the duration of the callback invoked for that
+ * instruction.
+ *
+ * If an error occurs reading or parsing instructions, -1 is returned, and
+ * guac_error is set appropriately. If the callback returns non-zero, no
+ * further instructions are handled, and -1 is returned without modifying
+ * guac_error.
+ *
+ * @param parser
+ *     The guac_parser to read instruction data from.
+ *
+ * @param socket
+ *     The guac_socket connection to use.
+ *
+ * @param usec_timeout
+ *     The maximum number of microseconds to wait for data before giving up,
+ *     or -1 to wait indefinitely.
+ *
+ * @param callback
+ *     The callback to invoke for each complete instruction.
+ *
+ * @param data
+ *     Arbitrary data to pass to the given callback.
+ *
+ * @return
+ *     The number of instructions handled, which may be zero if only part of
+ *     an instruction has been received so far, or -1 if an error occurs or
+ *     the callback requested that handling stop.
+ */
+int guac_parser_read_batch(guac_parser* parser, guac_socket* socket,
+        int usec_timeout, guac_parser_callback* callback, void* data);
+
+/**
+ * Reads a single instruction directly from the given buffer, which must
+ * contain all data remaining to be parsed, such as a memory-mapped file. Any
+ * previously-read instruction is discarded. The instruction is parsed in
+ * place: the opcode and argv of the parser will point directly into the given
+ * buffer, which will be modified to NULL-terminate each element, and which
+ * must remain valid for as long as the parsed instruction is in use.
+ *
+ * If an error occurs reading the instruction, -1 is returned, and guac_error
+ * is set appropriately. If the end of the buffer is reached before a complete
+ * instruction could be read, guac_error is set to GUAC_STATUS_CLOSED, just as
+ * guac_parser_read() would upon reaching the end of a stream.
+ *
+ * @param parser
+ *     The guac_parser to read instruction data into.
+ *
+ * @param buffer
+ *     The buffer containing the instruction to read, followed by any number
+ *     of additional instructions.
+ *
+ * @param length
+ *     The number of bytes available within the buffer.
+ *
+ * @return
+ *     The number of bytes of the buffer occupied by the instruction read, or
+ *     -1 if no instruction could be read.
+ */
+int guac_parser_read_buffer(guac_parser* parser, void* buffer, int length);
+
 /**
  * Reads a single instruction from the given guac_socket. This operates
  * identically to guac_parser_read(), except that an error is returned if
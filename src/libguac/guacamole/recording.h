@@ -95,6 +95,11 @@ typedef struct guac_recording {
      */
     int include_keys;
 
+    /**
+     * The client whose session is being recorded.
+     */
+    guac_client* client;
+
 } guac_recording;
 
 /**
@@ -27,9 +27,11 @@
  */
 
 /**
- * The number of bytes to buffer within each socket before flushing.
+ * The default number of bytes to buffer within each socket before flushing.
+ * Sockets are always flushed at the end of each frame, so this need only be
+ * large enough that typical frames can be written with few system calls.
  */
-#define GUAC_SOCKET_OUTPUT_BUFFER_SIZE 8192
+#define GUAC_SOCKET_OUTPUT_BUFFER_SIZE 65536
 
 /**
  * The number of milliseconds to wait between keep-alive pings on a socket
@@ -177,6 +177,32 @@ void guac_socket_instruction_end(guac_socket* socket);
  */
 guac_socket* guac_socket_open(int fd);
 
+/**
+ * Allocates and initializes a new guac_socket object with the given open
+ * file descriptor, buffering up to the given number of bytes of output before
+ * writing to that file descriptor. The file descriptor will be automatically
+ * closed when the allocated guac_socket is freed. Output which does not fit
+ * within the remaining buffer space is written together with the buffered
+ * output using a single system call, without first being copied, except for
+ * a short tail which is retained in the buffer until the next flush.
+ *
+ * If an error occurs while allocating the guac_socket object, NULL is returned,
+ * and guac_error is set appropriately.
+ *
+ * @param fd
+ *     An open file descriptor that this guac_socket object should manage.
+ *
+ * @param buffer_size
+ *     The number of bytes of output to buffer before writing to the file
+ *     descriptor. guac_socket_open() uses GUAC_SOCKET_OUTPUT_BUFFER_SIZE.
+ *
+ * @return
+ *     A newly allocated guac_socket object associated with the given file
+ *     descriptor, or NULL if an error occurs while allocating the guac_socket
+ *     object.
+ */
+guac_socket* guac_socket_open_buffered(int fd, size_t buffer_size);
+
 /**
  * Allocates and initializes a new guac_socket which writes all data via
  * nest instructions to the given existing, open guac_socket. Freeing the
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TRACE_H
+#define GUAC_TRACE_H
+
+/**
+ * Provides access to the timing of each stage of the render pipeline, as
+ * recorded in memory if libguac was built with tracing enabled (the
+ * "--enable-trace" option of the configure script).
+ *
+ * Traces are dumped in a simple binary format consisting of a
+ * guac_trace_header, followed by the name of each type of event as a
+ * NULL-padded string of GUAC_TRACE_NAME_LENGTH bytes, followed by each
+ * guac_trace_event in the order recorded. All values are in the native byte
+ * order of the system that produced the trace. The "guac-trace-to-json.pl"
+ * script within the "util/" directory of the source tree converts traces to
+ * the JSON format understood by Chrome's trace viewer and Perfetto.
+ *
+ * @file trace.h
+ */
+
+#include <stdint.h>
+
+/**
+ * The value of the magic member of every guac_trace_header.
+ */
+#define GUAC_TRACE_MAGIC "GUACTRC1"
+
+/**
+ * The number of bytes occupied by the name of each type of event within a
+ * dumped trace, including NULL padding.
+ */
+#define GUAC_TRACE_NAME_LENGTH 32
+
+/**
+ * The header at the beginning of every dumped trace.
+ */
+typedef struct guac_trace_header {
+
+    /**
+     * The characters of GUAC_TRACE_MAGIC, without NULL terminator.
+     */
+    char magic[8];
+
+    /**
+     * The number of types of events, and thus the number of names following
+     * this header.
+     */
+    uint32_t types;
+
+    /**
+     * The number of events following the names of all types of events.
+     */
+    uint32_t events;
+
+} guac_trace_header;
+
+/**
+ * A single, completed stage of the render pipeline.
+ */
+typedef struct guac_trace_event {
+
+    /**
+     * The time that the stage began, in microseconds, relative to an
+     * arbitrary point in time that is consistent across all events of the
+     * same trace.
+     */
+    uint64_t start;
+
+    /**
+     * An opaque value uniquely identifying the thread that performed the
+     * stage.
+     */
+    uint64_t thread;
+
+    /**
+     * The time taken by the stage, in microseconds.
+     */
+    uint32_t duration;
+
+    /**
+     * The type of the event, as an index into the names of all types of
+     * events.
+     */
+    uint32_t type;
+
+    /**
+     * An additional value whose meaning depends on the type of the event,
+     * such as the number of pixels encoded.
+     */
+    uint32_t arg;
+
+    /**
+     * Reserved for future use. This will currently always be zero.
+     */
+    uint32_t reserved;
+
+} guac_trace_event;
+
+/**
+ * Writes the most recent events recorded for the current process to the
+ * given file descriptor, in the binary format described by this header. Older
+ * events are discarded as new events are recorded, and events recorded while
+ * the dump is in progress may appear partially written. This function is
+ * async-signal-safe and may be invoked from within a signal handler.
+ *
+ * @param fd
+ *     The file descriptor to write the trace to.
+ *
+ * @return
+ *     Zero if the trace was written successfully, non-zero otherwise. If
+ *     libguac was built without tracing, this function always fails, setting
+ *     errno to ENOSYS.
+ */
+int guac_trace_dump(int fd);
+
+#endif
+
@@ -46,6 +46,20 @@ size_t guac_utf8_charsize(unsigned char c);
  */
 size_t guac_utf8_strlen(const char* str);
 
+/**
+ * Returns the number of bytes at the beginning of the given buffer which are
+ * ASCII (have their high bit clear), and are thus each a complete UTF-8
+ * character. Where supported by the CPU, bytes are tested 16 at a time using
+ * SIMD instructions, such that long runs of ASCII (like base64 data) can be
+ * skipped quickly.
+ *
+ * @param buffer The buffer to test.
+ * @param length The number of bytes within the buffer.
+ * @return The number of bytes at the beginning of the buffer which are ASCII,
+ *         which will equal the given length if all bytes are ASCII.
+ */
+size_t guac_utf8_ascii_length(const char* buffer, size_t length);
+
 /**
  * Given destination buffer and its length, writes the given codepoint as UTF-8
  * to the buffer, returning the number of bytes written. If there is not enough
@@ -0,0 +1,410 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/mem.h"
+#include "guacamole/audio.h"
+#include "guacamole/client.h"
+#include "guacamole/protocol.h"
+#include "guacamole/socket.h"
+#include "guacamole/user.h"
+#include "ima_adpcm_encoder.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * The amount to adjust the step index by for each possible 4-bit code.
+ */
+static const int8_t guac_ima_adpcm_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * The quantizer step size associated with each possible step index.
+ */
+static const int16_t guac_ima_adpcm_step_table[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/**
+ * Encodes a single sample as a 4-bit IMA ADPCM code, updating the adaptive
+ * state of its channel to match the state that a decoder will have after
+ * decoding that code.
+ *
+ * @param channel
+ *     The adaptive state of the channel containing the sample.
+ *
+ * @param sample
+ *     The signed 16-bit sample to encode.
+ *
+ * @return
+ *     The 4-bit code representing the given sample.
+ */
+static unsigned char guac_ima_adpcm_encode_sample(
+        guac_ima_adpcm_channel* channel, int sample) {
+
+    int step = guac_ima_adpcm_step_table[channel->step_index];
+    int diff = sample - channel->predictor;
+
+    /* Sign is stored within the highest-order bit of the code */
+    unsigned char code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    /* Quantize the difference, tracking the difference that the decoder will
+     * reconstruct from the resulting code */
+    int reconstructed = step >> 3;
+
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        reconstructed += step;
+    }
+
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        reconstructed += step;
+    }
+
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        reconstructed += step;
+    }
+
+    /* Update prediction exactly as the decoder will */
+    if (code & 8)
+        channel->predictor -= reconstructed;
+    else
+        channel->predictor += reconstructed;
+
+    if (channel->predictor > INT16_MAX)
+        channel->predictor = INT16_MAX;
+    else if (channel->predictor < INT16_MIN)
+        channel->predictor = INT16_MIN;
+
+    /* Adapt step size to the magnitude of the code */
+    channel->step_index += guac_ima_adpcm_index_table[code];
+
+    if (channel->step_index < 0)
+        channel->step_index = 0;
+    else if (channel->step_index > 88)
+        channel->step_index = 88;
+
+    return code;
+
+}
+
+size_t guac_ima_adpcm_block_size(int channels) {
+    return (size_t) GUAC_IMA_ADPCM_BLOCK_CHANNEL_SIZE * channels;
+}
+
+void guac_ima_adpcm_encode_block(guac_ima_adpcm_channel* channel,
+        int channels, const int16_t* pcm, unsigned char* output) {
+
+    /* Each channel begins with a header containing its first sample
+     * (uncompressed) and current step index */
+    for (int c = 0; c < channels; c++) {
+
+        int sample = pcm[c];
+        channel[c].predictor = sample;
+
+        *(output++) = sample & 0xFF;
+        *(output++) = (sample >> 8) & 0xFF;
+        *(output++) = channel[c].step_index;
+        *(output++) = 0;
+
+    }
+
+    pcm += channels;
+
+    /* Remaining samples are encoded in groups of eight per channel */
+    for (int group = 0; group < (GUAC_IMA_ADPCM_BLOCK_FRAMES - 1) / 8; group++) {
+
+        for (int c = 0; c < channels; c++) {
+
+            const int16_t* current = pcm + c;
+
+            /* Pack two samples per byte, earlier sample first */
+            for (int i = 0; i < 4; i++) {
+
+                unsigned char low = guac_ima_adpcm_encode_sample(&channel[c],
+                        current[0]);
+
+                unsigned char high = guac_ima_adpcm_encode_sample(&channel[c],
+                        current[channels]);
+
+                *(output++) = low | (high << 4);
+                current += channels * 2;
+
+            }
+
+        }
+
+        pcm += channels * 8;
+
+    }
+
+}
+
+static void ima_adpcm_encoder_send_audio(guac_audio_stream* audio,
+        guac_socket* socket) {
+
+    char mimetype[256];
+
+    /* Produce mimetype string from format info */
+    snprintf(mimetype, sizeof(mimetype), GUAC_IMA_ADPCM_MIMETYPE
+            ";rate=%i,channels=%i", audio->rate, audio->channels);
+
+    /* Associate stream */
+    guac_protocol_send_audio(socket, audio->stream, mimetype);
+
+}
+
+static void ima_adpcm_encoder_begin_handler(guac_audio_stream* audio) {
+
+    ima_adpcm_encoder_state* state;
+
+    /* Broadcast existence of stream */
+    ima_adpcm_encoder_send_audio(audio, audio->client->socket);
+
+    /* Allocate and init encoder state */
+    audio->data = state = guac_mem_zalloc(sizeof(ima_adpcm_encoder_state));
+    state->length = guac_mem_ckd_mul_or_die(GUAC_IMA_ADPCM_BUFFER_BLOCKS,
+            guac_ima_adpcm_block_size(audio->channels));
+
+    state->buffer = guac_mem_alloc(state->length);
+
+}
+
+static void ima_adpcm_encoder_join_handler(guac_audio_stream* audio,
+        guac_user* user) {
+
+    /* Notify user of existence of stream */
+    ima_adpcm_encoder_send_audio(audio, user->socket);
+
+}
+
+/**
+ * Encodes the sample frames currently buffered within the given encoder state
+ * as a single block, appending that block to the buffer of encoded data. The
+ * buffered PCM must contain exactly GUAC_IMA_ADPCM_BLOCK_FRAMES frames. If
+ * there is insufficient space for the encoded block, the audio stream is
+ * first flushed.
+ *
+ * @param audio
+ *     The audio stream being encoded.
+ *
+ * @param state
+ *     The IMA ADPCM encoder state of the given audio stream.
+ */
+static void ima_adpcm_encoder_encode_block(guac_audio_stream* audio,
+        ima_adpcm_encoder_state* state) {
+
+    size_t block_size = guac_ima_adpcm_block_size(audio->channels);
+
+    /* Flush existing blocks if no space remains */
+    if (state->written + block_size > state->length)
+        guac_audio_stream_flush(audio);
+
+    guac_ima_adpcm_encode_block(state->channel, audio->channels,
+            state->pcm, state->buffer + state->written);
+
+    state->written += block_size;
+    state->pcm_frames = 0;
+
+}
+
+/**
+ * Appends a single sample frame of signed, 16-bit, little-endian PCM to the
+ * PCM buffer of the given encoder state, encoding a block if that buffer is
+ * now full.
+ *
+ * @param audio
+ *     The audio stream being encoded.
+ *
+ * @param state
+ *     The IMA ADPCM encoder state of the given audio stream.
+ *
+ * @param frame
+ *     The bytes of the sample frame to append.
+ */
+static void ima_adpcm_encoder_append_frame(guac_audio_stream* audio,
+        ima_adpcm_encoder_state* state, const unsigned char* frame) {
+
+    int16_t* pcm = state->pcm + state->pcm_frames * audio->channels;
+    for (int c = 0; c < audio->channels; c++) {
+        *(pcm++) = (int16_t) (frame[0] | (frame[1] << 8));
+        frame += 2;
+    }
+
+    if (++state->pcm_frames == GUAC_IMA_ADPCM_BLOCK_FRAMES)
+        ima_adpcm_encoder_encode_block(audio, state);
+
+}
+
+/**
+ * Pads the incomplete block of sample frames currently buffered within the
+ * given encoder state by repeating its final frame, and encodes the result,
+ * such that trailing audio is not lost or held back. If no sample frames are
+ * buffered, this function has no effect.
+ *
+ * @param audio
+ *     The audio stream being encoded.
+ *
+ * @param state
+ *     The IMA ADPCM encoder state of the given audio stream.
+ */
+static void ima_adpcm_encoder_encode_partial_block(guac_audio_stream* audio,
+        ima_adpcm_encoder_state* state) {
+
+    if (state->pcm_frames == 0)
+        return;
+
+    const int16_t* last = state->pcm
+        + (state->pcm_frames - 1) * audio->channels;
+
+    while (state->pcm_frames < GUAC_IMA_ADPCM_BLOCK_FRAMES) {
+        memcpy(state->pcm + state->pcm_frames * audio->channels, last,
+                sizeof(int16_t) * audio->channels);
+        state->pcm_frames++;
+    }
+
+    ima_adpcm_encoder_encode_block(audio, state);
+
+}
+
+static void ima_adpcm_encoder_end_handler(guac_audio_stream* audio) {
+
+    ima_adpcm_encoder_state* state = (ima_adpcm_encoder_state*) audio->data;
+
+    /* Encode any incomplete block, such that trailing audio is not lost */
+    ima_adpcm_encoder_encode_partial_block(audio, state);
+
+    /* Send any remaining encoded audio */
+    guac_protocol_send_blobs(audio->client->socket, audio->stream,
+            state->buffer, state->written);
+
+    /* Send end of stream */
+    guac_protocol_send_end(audio->client->socket, audio->stream);
+
+    /* Free state information */
+    guac_mem_free(state->buffer);
+    guac_mem_free(state);
+
+}
+
+static void ima_adpcm_encoder_write_handler(guac_audio_stream* audio,
+        const unsigned char* pcm_data, int length) {
+
+    ima_adpcm_encoder_state* state = (ima_adpcm_encoder_state*) audio->data;
+    int frame_size = audio->channels * 2;
+
+    while (length > 0) {
+
+        /* Reassemble any sample frame split across writes */
+        if (state->frame_length > 0 || length < frame_size) {
+
+            int chunk_size = frame_size - state->frame_length;
+            if (chunk_size > length)
+                chunk_size = length;
+
+            memcpy(state->frame + state->frame_length, pcm_data, chunk_size);
+            state->frame_length += chunk_size;
+            pcm_data += chunk_size;
+            length -= chunk_size;
+
+            if (state->frame_length == frame_size) {
+                ima_adpcm_encoder_append_frame(audio, state, state->frame);
+                state->frame_length = 0;
+            }
+
+            continue;
+
+        }
+
+        /* Otherwise, read complete frames directly from source PCM */
+        ima_adpcm_encoder_append_frame(audio, state, pcm_data);
+        pcm_data += frame_size;
+        length -= frame_size;
+
+    }
+
+}
+
+static void ima_adpcm_encoder_flush_handler(guac_audio_stream* audio) {
+
+    ima_adpcm_encoder_state* state = (ima_adpcm_encoder_state*) audio->data;
+    guac_socket* socket = audio->client->socket;
+    guac_stream* stream = audio->stream;
+
+    /* Once the sound has ended, also encode any incomplete block rather than
+     * holding it back until further PCM data is written. Blocks already
+     * encoded are sent first if necessary to make room, as encoding must not
+     * itself trigger a flush. */
+    if (audio->sound_ended && state->pcm_frames > 0) {
+
+        if (state->written + guac_ima_adpcm_block_size(audio->channels)
+                > state->length) {
+            guac_protocol_send_blobs(socket, stream, state->buffer,
+                    state->written);
+            state->written = 0;
+        }
+
+        ima_adpcm_encoder_encode_partial_block(audio, state);
+
+    }
+
+    /* Flush all complete blocks as blobs. Any other incomplete block remains
+     * buffered as PCM until enough further data has been written. */
+    guac_protocol_send_blobs(socket, stream, state->buffer, state->written);
+
+    /* All encoded data has been flushed */
+    state->written = 0;
+
+}
+
+/* IMA ADPCM encoder handlers */
+guac_audio_encoder _ima_adpcm_encoder = {
+    .mimetype      = GUAC_IMA_ADPCM_MIMETYPE,
+    .begin_handler = ima_adpcm_encoder_begin_handler,
+    .write_handler = ima_adpcm_encoder_write_handler,
+    .flush_handler = ima_adpcm_encoder_flush_handler,
+    .join_handler  = ima_adpcm_encoder_join_handler,
+    .end_handler   = ima_adpcm_encoder_end_handler
+};
+
+/* Actual encoder definition */
+guac_audio_encoder* ima_adpcm_encoder = &_ima_adpcm_encoder;
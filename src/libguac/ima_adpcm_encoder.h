@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_IMA_ADPCM_ENCODER_H
+#define GUAC_IMA_ADPCM_ENCODER_H
+
+#include "config.h"
+
+#include "guacamole/audio.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The base mimetype of audio encoded by the IMA ADPCM encoder. The mimetype
+ * sent to users additionally describes the rate and number of channels, in
+ * the same manner as the raw PCM encoders.
+ */
+#define GUAC_IMA_ADPCM_MIMETYPE "audio/x-ima-adpcm"
+
+/**
+ * The number of sample frames encoded within each IMA ADPCM block. The first
+ * frame of each block is stored uncompressed within the block header, while
+ * the remaining frames are stored as 4-bit codes in groups of eight samples
+ * per channel. This is the block layout used by IMA ADPCM within WAV files,
+ * with 256 bytes per channel per block.
+ */
+#define GUAC_IMA_ADPCM_BLOCK_FRAMES 505
+
+/**
+ * The number of bytes occupied by each channel within a single IMA ADPCM
+ * block, including its 4-byte header.
+ */
+#define GUAC_IMA_ADPCM_BLOCK_CHANNEL_SIZE 256
+
+/**
+ * The maximum number of channels supported by the IMA ADPCM encoder.
+ */
+#define GUAC_IMA_ADPCM_MAX_CHANNELS 2
+
+/**
+ * The number of blocks to accumulate before sending encoded audio, unless
+ * the stream is flushed sooner. At 44.1 kHz, this is roughly 115 ms of
+ * audio. This is chosen such that the encoded buffer always fits within a
+ * single blob, and thus each blob contains only whole blocks.
+ */
+#define GUAC_IMA_ADPCM_BUFFER_BLOCKS 10
+
+/**
+ * The adaptive state of a single channel of IMA ADPCM encoded audio. This
+ * state carries over from block to block, with each block header recording
+ * the state at the beginning of that block such that decoding can begin at
+ * any block.
+ */
+typedef struct guac_ima_adpcm_channel {
+
+    /**
+     * The most recent sample value predicted by the encoder (and, therefore,
+     * by any decoder).
+     */
+    int predictor;
+
+    /**
+     * The current index into the IMA ADPCM step size table.
+     */
+    int step_index;
+
+} guac_ima_adpcm_channel;
+
+/**
+ * The current state of the IMA ADPCM encoder. PCM data is buffered only until
+ * a complete block is available, with encoded blocks buffered until the
+ * stream is flushed or the output buffer is full.
+ */
+typedef struct ima_adpcm_encoder_state {
+
+    /**
+     * The adaptive state of each channel.
+     */
+    guac_ima_adpcm_channel channel[GUAC_IMA_ADPCM_MAX_CHANNELS];
+
+    /**
+     * Buffer of 16-bit PCM sample frames which do not yet form a complete
+     * block.
+     */
+    int16_t pcm[GUAC_IMA_ADPCM_BLOCK_FRAMES * GUAC_IMA_ADPCM_MAX_CHANNELS];
+
+    /**
+     * The number of complete sample frames currently stored within the PCM
+     * buffer.
+     */
+    int pcm_frames;
+
+    /**
+     * The bytes of an incomplete sample frame which was split across
+     * separate writes.
+     */
+    unsigned char frame[GUAC_IMA_ADPCM_MAX_CHANNELS * 2];
+
+    /**
+     * The number of bytes currently stored within the frame buffer.
+     */
+    int frame_length;
+
+    /**
+     * Buffer of encoded blocks which have not yet been sent.
+     */
+    unsigned char* buffer;
+
+    /**
+     * Size of the encoded buffer, in bytes.
+     */
+    size_t length;
+
+    /**
+     * The current number of bytes stored within the encoded buffer.
+     */
+    size_t written;
+
+} ima_adpcm_encoder_state;
+
+/**
+ * Returns the size of a single IMA ADPCM block containing the given number of
+ * channels, in bytes.
+ *
+ * @param channels
+ *     The number of channels within the block.
+ *
+ * @return
+ *     The size of a single block, in bytes.
+ */
+size_t guac_ima_adpcm_block_size(int channels);
+
+/**
+ * Encodes exactly GUAC_IMA_ADPCM_BLOCK_FRAMES frames of interleaved, signed
+ * 16-bit PCM as a single IMA ADPCM block, updating the adaptive state of each
+ * channel accordingly. The block begins with a 4-byte header for each
+ * channel, containing the first sample (16-bit, little-endian) and current
+ * step index, followed by the 4-bit codes of the remaining samples, which are
+ * interleaved in groups of eight samples (four bytes) per channel, with the
+ * earlier sample of each byte in the low-order nibble.
+ *
+ * @param channel
+ *     The adaptive state of each channel, which will be updated to reflect
+ *     the encoded block.
+ *
+ * @param channels
+ *     The number of channels, which may not exceed
+ *     GUAC_IMA_ADPCM_MAX_CHANNELS.
+ *
+ * @param pcm
+ *     The interleaved PCM sample frames to encode.
+ *
+ * @param output
+ *     The buffer that should receive the encoded block. This buffer must be
+ *     at least guac_ima_adpcm_block_size() bytes.
+ */
+void guac_ima_adpcm_encode_block(guac_ima_adpcm_channel* channel,
+        int channels, const int16_t* pcm, unsigned char* output);
+
+/**
+ * Audio encoder which writes IMA ADPCM, compressing 16-bit PCM roughly 4:1.
+ */
+extern guac_audio_encoder* ima_adpcm_encoder;
+
+#endif
@@ -0,0 +1,278 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/mem.h"
+#include "guacamole/metrics.h"
+
+#include <stdint.h>
+
+#if defined(HAVE_CLOCK_GETTIME)
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+/**
+ * The names of all counters, indexed by guac_metrics_counter.
+ */
+static const char* GUAC_METRICS_COUNTER_NAMES[GUAC_METRICS_COUNTERS] = {
+    [GUAC_METRICS_PNG_BYTES]  = "png_bytes",
+    [GUAC_METRICS_JPEG_BYTES] = "jpeg_bytes",
+    [GUAC_METRICS_WEBP_BYTES] = "webp_bytes",
+    [GUAC_METRICS_COPIES]     = "copies"
+};
+
+/**
+ * The descriptions of all counters, indexed by guac_metrics_counter.
+ */
+static const char* GUAC_METRICS_COUNTER_DESCRIPTIONS[GUAC_METRICS_COUNTERS] = {
+    [GUAC_METRICS_PNG_BYTES]  = "Bytes of PNG image data sent.",
+    [GUAC_METRICS_JPEG_BYTES] = "Bytes of JPEG image data sent.",
+    [GUAC_METRICS_WEBP_BYTES] = "Bytes of WebP image data sent.",
+    [GUAC_METRICS_COPIES]     = "Display updates sent as copies of "
+                                "previously-sent image data."
+};
+
+/**
+ * The names of all histograms, indexed by guac_metrics_histogram.
+ */
+static const char* GUAC_METRICS_HISTOGRAM_NAMES[GUAC_METRICS_HISTOGRAMS] = {
+    [GUAC_METRICS_FRAME_LATENCY]      = "frame_latency_milliseconds",
+    [GUAC_METRICS_PROCESSING_LAG]     = "processing_lag_milliseconds",
+    [GUAC_METRICS_PNG_ENCODE_TIME]    = "png_encode_microseconds",
+    [GUAC_METRICS_JPEG_ENCODE_TIME]   = "jpeg_encode_microseconds",
+    [GUAC_METRICS_WEBP_ENCODE_TIME]   = "webp_encode_microseconds",
+    [GUAC_METRICS_WORKER_QUEUE_DEPTH] = "worker_queue_depth",
+    [GUAC_METRICS_SOCKET_FLUSH_TIME]  = "socket_flush_microseconds"
+};
+
+/**
+ * The descriptions of all histograms, indexed by guac_metrics_histogram.
+ */
+static const char* GUAC_METRICS_HISTOGRAM_DESCRIPTIONS[GUAC_METRICS_HISTOGRAMS] = {
+    [GUAC_METRICS_FRAME_LATENCY]      = "Time taken to render each frame.",
+    [GUAC_METRICS_PROCESSING_LAG]     = "Processing lag of connected users at "
+                                        "the end of each frame.",
+    [GUAC_METRICS_PNG_ENCODE_TIME]    = "Time taken to encode and send each "
+                                        "PNG image.",
+    [GUAC_METRICS_JPEG_ENCODE_TIME]   = "Time taken to encode and send each "
+                                        "JPEG image.",
+    [GUAC_METRICS_WEBP_ENCODE_TIME]   = "Time taken to encode and send each "
+                                        "WebP image.",
+    [GUAC_METRICS_WORKER_QUEUE_DEPTH] = "Operations waiting for display "
+                                        "worker threads as each operation is "
+                                        "queued.",
+    [GUAC_METRICS_SOCKET_FLUSH_TIME]  = "Time taken to flush output at the "
+                                        "end of each frame."
+};
+
+guac_metrics* guac_metrics_alloc() {
+    return guac_mem_zalloc(sizeof(guac_metrics));
+}
+
+void guac_metrics_free(guac_metrics* metrics) {
+    guac_mem_free(metrics);
+}
+
+void guac_metrics_add(guac_metrics* metrics, guac_metrics_counter counter,
+        uint64_t value) {
+
+    if (metrics == NULL)
+        return;
+
+    __atomic_add_fetch(&metrics->counters[counter], value, __ATOMIC_RELAXED);
+
+}
+
+/**
+ * Returns the index of the histogram bucket that counts the given value.
+ *
+ * @param value
+ *     The value to locate the bucket of.
+ *
+ * @return
+ *     The index of the bucket counting the given value.
+ */
+static int guac_metrics_bucket(uint64_t value) {
+
+    /* Zero and one both fall within the first bucket */
+    if (value <= 1)
+        return 0;
+
+    /* Otherwise, the bucket is the base-2 logarithm, rounded up */
+    int bucket = 64 - __builtin_clzll(value - 1);
+    if (bucket >= GUAC_METRICS_BUCKETS)
+        return GUAC_METRICS_BUCKETS - 1;
+
+    return bucket;
+
+}
+
+void guac_metrics_observe(guac_metrics* metrics,
+        guac_metrics_histogram histogram, uint64_t value) {
+
+    if (metrics == NULL)
+        return;
+
+    guac_metrics_distribution* distribution = &metrics->histograms[histogram];
+
+    __atomic_add_fetch(&distribution->buckets[guac_metrics_bucket(value)], 1,
+            __ATOMIC_RELAXED);
+    __atomic_add_fetch(&distribution->sum, value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&distribution->count, 1, __ATOMIC_RELAXED);
+
+}
+
+uint64_t guac_metrics_current_usec() {
+
+#ifdef HAVE_CLOCK_GETTIME
+
+    struct timespec current;
+
+    /* Get current time, monotonically increasing */
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &current);
+#else
+    clock_gettime(CLOCK_REALTIME, &current);
+#endif
+
+    return (uint64_t) current.tv_sec * 1000000 + current.tv_nsec / 1000;
+
+#else
+
+    struct timeval current;
+    gettimeofday(&current, NULL);
+
+    return (uint64_t) current.tv_sec * 1000000 + current.tv_usec;
+
+#endif
+
+}
+
+void guac_metrics_observe_since(guac_metrics* metrics,
+        guac_metrics_histogram histogram, uint64_t start) {
+
+    if (metrics == NULL)
+        return;
+
+    /* Clamp durations which appear negative due to clock changes */
+    uint64_t current = guac_metrics_current_usec();
+    guac_metrics_observe(metrics, histogram,
+            current > start ? current - start : 0);
+
+}
+
+/**
+ * Atomically copies or adds each of the given number of 64-bit values from
+ * one array to another.
+ *
+ * @param dst
+ *     The array to copy or add values into.
+ *
+ * @param src
+ *     The array to copy or add values from.
+ *
+ * @param length
+ *     The number of values within each array.
+ *
+ * @param add
+ *     Non-zero if values should be added to the existing values within the
+ *     destination array, zero if those values should be replaced.
+ */
+static void guac_metrics_transfer(uint64_t* dst, const uint64_t* src,
+        int length, int add) {
+
+    for (int i = 0; i < length; i++) {
+
+        uint64_t value = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+
+        if (add)
+            __atomic_add_fetch(&dst[i], value, __ATOMIC_RELAXED);
+        else
+            __atomic_store_n(&dst[i], value, __ATOMIC_RELAXED);
+
+    }
+
+}
+
+void guac_metrics_copy(guac_metrics* dst, const guac_metrics* src) {
+
+    /* guac_metrics consists entirely of 64-bit values */
+    guac_metrics_transfer((uint64_t*) dst, (const uint64_t*) src,
+            sizeof(guac_metrics) / sizeof(uint64_t), 0);
+
+}
+
+void guac_metrics_merge(guac_metrics* dst, const guac_metrics* src) {
+
+    /* guac_metrics consists entirely of 64-bit values */
+    guac_metrics_transfer((uint64_t*) dst, (const uint64_t*) src,
+            sizeof(guac_metrics) / sizeof(uint64_t), 1);
+
+}
+
+uint64_t guac_metrics_bucket_bound(int bucket) {
+
+    /* The last bucket has no upper bound */
+    if (bucket >= GUAC_METRICS_BUCKETS - 1)
+        return UINT64_MAX;
+
+    return (uint64_t) 1 << bucket;
+
+}
+
+const char* guac_metrics_counter_name(guac_metrics_counter counter) {
+
+    if (counter < 0 || counter >= GUAC_METRICS_COUNTERS)
+        return NULL;
+
+    return GUAC_METRICS_COUNTER_NAMES[counter];
+
+}
+
+const char* guac_metrics_counter_description(guac_metrics_counter counter) {
+
+    if (counter < 0 || counter >= GUAC_METRICS_COUNTERS)
+        return NULL;
+
+    return GUAC_METRICS_COUNTER_DESCRIPTIONS[counter];
+
+}
+
+const char* guac_metrics_histogram_name(guac_metrics_histogram histogram) {
+
+    if (histogram < 0 || histogram >= GUAC_METRICS_HISTOGRAMS)
+        return NULL;
+
+    return GUAC_METRICS_HISTOGRAM_NAMES[histogram];
+
+}
+
+const char* guac_metrics_histogram_description(
+        guac_metrics_histogram histogram) {
+
+    if (histogram < 0 || histogram >= GUAC_METRICS_HISTOGRAMS)
+        return NULL;
+
+    return GUAC_METRICS_HISTOGRAM_DESCRIPTIONS[histogram];
+
+}
+
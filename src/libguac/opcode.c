@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/assert.h"
+#include "guacamole/opcode.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Returns the opcode of the entry at the given index within the given map.
+ *
+ * @param map
+ *     An array of structures, each beginning with a pointer to an opcode
+ *     string.
+ *
+ * @param mapping_size
+ *     The size of each structure within the map, in bytes.
+ *
+ * @param entry
+ *     The index of the entry within the map.
+ *
+ * @return
+ *     The opcode of the requested entry, or NULL if the entry is the
+ *     terminating entry of the map.
+ */
+static const char* guac_opcode_map_get(const void* map, size_t mapping_size,
+        size_t entry) {
+
+    const char* const* opcode = (const char* const*)
+        ((const unsigned char*) map + entry * mapping_size);
+
+    return *opcode;
+
+}
+
+unsigned int guac_opcode_hash(const char* opcode, size_t length) {
+
+    unsigned char first = opcode[0];
+    unsigned char last = opcode[length - 1];
+
+    return (length + first * 4 + last) & (GUAC_OPCODE_INDEX_SIZE - 1);
+
+}
+
+void guac_opcode_index_init(guac_opcode_index* index, const void* map,
+        size_t mapping_size) {
+
+    memset(index->slots, 0, sizeof(index->slots));
+
+    const char* opcode;
+    for (size_t entry = 0;
+            (opcode = guac_opcode_map_get(map, mapping_size, entry)) != NULL;
+            entry++) {
+
+        /* Keep at least half of all slots free such that probing is short */
+        GUAC_ASSERT(entry < GUAC_OPCODE_INDEX_SIZE / 2);
+
+        /* Store within first free slot at or after the hashed slot */
+        unsigned int slot = guac_opcode_hash(opcode, strlen(opcode));
+        while (index->slots[slot] != 0)
+            slot = (slot + 1) & (GUAC_OPCODE_INDEX_SIZE - 1);
+
+        index->slots[slot] = entry + 1;
+
+    }
+
+}
+
+const void* guac_opcode_index_lookup(const guac_opcode_index* index,
+        const void* map, size_t mapping_size, const char* opcode) {
+
+    /* The empty opcode is never defined */
+    size_t length = strlen(opcode);
+    if (length == 0)
+        return NULL;
+
+    /* Probe from the hashed slot until a match or an empty slot is found */
+    unsigned int slot = guac_opcode_hash(opcode, length);
+    while (index->slots[slot] != 0) {
+
+        size_t entry = index->slots[slot] - 1;
+        if (strcmp(guac_opcode_map_get(map, mapping_size, entry), opcode) == 0)
+            return (const unsigned char*) map + entry * mapping_size;
+
+        slot = (slot + 1) & (GUAC_OPCODE_INDEX_SIZE - 1);
+
+    }
+
+    return NULL;
+
+}
+
@@ -0,0 +1,276 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/mem.h"
+#include "guacamole/audio.h"
+#include "guacamole/client.h"
+#include "guacamole/protocol.h"
+#include "guacamole/socket.h"
+#include "guacamole/user.h"
+#include "opus_audio_encoder.h"
+
+#include <opus/opus.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+int guac_opus_rate_supported(int rate) {
+    return rate == 8000
+        || rate == 12000
+        || rate == 16000
+        || rate == 24000
+        || rate == 48000;
+}
+
+static void opus_audio_encoder_send_audio(guac_audio_stream* audio,
+        guac_socket* socket) {
+
+    char mimetype[256];
+
+    /* Produce mimetype string from format info */
+    snprintf(mimetype, sizeof(mimetype), GUAC_OPUS_MIMETYPE
+            ";rate=%i,channels=%i", audio->rate, audio->channels);
+
+    /* Associate stream */
+    guac_protocol_send_audio(socket, audio->stream, mimetype);
+
+}
+
+static void opus_audio_encoder_begin_handler(guac_audio_stream* audio) {
+
+    opus_audio_encoder_state* state;
+
+    /* Broadcast existence of stream */
+    opus_audio_encoder_send_audio(audio, audio->client->socket);
+
+    /* Allocate and init encoder state */
+    audio->data = state = guac_mem_zalloc(sizeof(opus_audio_encoder_state));
+    state->frame_size = audio->rate * GUAC_OPUS_FRAME_DURATION / 1000;
+
+    state->pcm_length = guac_mem_ckd_mul_or_die(state->frame_size,
+            audio->channels, sizeof(opus_int16));
+    state->pcm = guac_mem_alloc(state->pcm_length);
+    state->samples = guac_mem_alloc(state->pcm_length);
+
+    state->length = guac_mem_ckd_mul_or_die(GUAC_OPUS_BUFFER_PACKETS,
+            GUAC_OPUS_MAX_PACKET_SIZE + 2);
+    state->buffer = guac_mem_alloc(state->length);
+
+    /* Create underlying encoder */
+    int error;
+    state->encoder = opus_encoder_create(audio->rate, audio->channels,
+            OPUS_APPLICATION_AUDIO, &error);
+
+    if (state->encoder == NULL) {
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to create "
+                "Opus encoder: %s. Audio will be dropped.",
+                opus_strerror(error));
+        return;
+    }
+
+    opus_encoder_ctl(state->encoder, OPUS_SET_BITRATE(
+                GUAC_OPUS_BITRATE_PER_CHANNEL * audio->channels));
+
+}
+
+static void opus_audio_encoder_join_handler(guac_audio_stream* audio,
+        guac_user* user) {
+
+    /* Notify user of existence of stream */
+    opus_audio_encoder_send_audio(audio, user->socket);
+
+}
+
+/**
+ * Encodes the complete Opus frame of PCM data currently buffered within the
+ * given encoder state as a single length-prefixed packet, appending that
+ * packet to the buffer of encoded data. If there may be insufficient space
+ * for the encoded packet, the audio stream is first flushed.
+ *
+ * @param audio
+ *     The audio stream being encoded.
+ *
+ * @param state
+ *     The Opus encoder state of the given audio stream.
+ */
+static void opus_audio_encoder_encode_frame(guac_audio_stream* audio,
+        opus_audio_encoder_state* state) {
+
+    /* Flush existing packets if no space remains */
+    if (state->written + GUAC_OPUS_MAX_PACKET_SIZE + 2 > state->length)
+        guac_audio_stream_flush(audio);
+
+    /* Convert little-endian PCM to native samples */
+    const unsigned char* current = state->pcm;
+    for (int i = 0; i < state->frame_size * audio->channels; i++) {
+        state->samples[i] = (opus_int16) (current[0] | (current[1] << 8));
+        current += 2;
+    }
+
+    unsigned char* packet = state->buffer + state->written;
+    opus_int32 size = opus_encode(state->encoder, state->samples,
+            state->frame_size,
+            packet + 2, GUAC_OPUS_MAX_PACKET_SIZE);
+
+    /* Drop frames which fail to encode */
+    if (size < 0) {
+        guac_client_log(audio->client, GUAC_LOG_DEBUG, "Opus frame could "
+                "not be encoded: %s", opus_strerror(size));
+    }
+
+    /* Prefix packet with its length */
+    else {
+        packet[0] = (size >> 8) & 0xFF;
+        packet[1] = size & 0xFF;
+        state->written += size + 2;
+    }
+
+    state->pcm_written = 0;
+
+}
+
+/**
+ * Pads the incomplete frame of PCM data currently buffered within the given
+ * encoder state with silence, and encodes the result, such that trailing
+ * audio is not lost or held back. If no PCM data is buffered, or no Opus
+ * encoder is available, this function has no effect.
+ *
+ * @param audio
+ *     The audio stream being encoded.
+ *
+ * @param state
+ *     The Opus encoder state of the given audio stream.
+ */
+static void opus_audio_encoder_encode_partial_frame(guac_audio_stream* audio,
+        opus_audio_encoder_state* state) {
+
+    if (state->encoder == NULL || state->pcm_written == 0)
+        return;
+
+    memset(state->pcm + state->pcm_written, 0,
+            state->pcm_length - state->pcm_written);
+    opus_audio_encoder_encode_frame(audio, state);
+
+}
+
+static void opus_audio_encoder_end_handler(guac_audio_stream* audio) {
+
+    opus_audio_encoder_state* state = (opus_audio_encoder_state*) audio->data;
+
+    /* Encode any incomplete frame, such that trailing audio is not lost */
+    opus_audio_encoder_encode_partial_frame(audio, state);
+
+    /* Send any remaining encoded audio */
+    guac_protocol_send_blobs(audio->client->socket, audio->stream,
+            state->buffer, state->written);
+
+    /* Send end of stream */
+    guac_protocol_send_end(audio->client->socket, audio->stream);
+
+    /* Free state information */
+    if (state->encoder != NULL)
+        opus_encoder_destroy(state->encoder);
+
+    guac_mem_free(state->buffer);
+    guac_mem_free(state->samples);
+    guac_mem_free(state->pcm);
+    guac_mem_free(state);
+
+}
+
+static void opus_audio_encoder_write_handler(guac_audio_stream* audio,
+        const unsigned char* pcm_data, int length) {
+
+    opus_audio_encoder_state* state = (opus_audio_encoder_state*) audio->data;
+
+    /* Drop all audio if no encoder is available */
+    if (state->encoder == NULL)
+        return;
+
+    while (length > 0) {
+
+        /* Prefer to copy a chunk of equal size to available buffer space */
+        size_t chunk_size = state->pcm_length - state->pcm_written;
+
+        /* Do not copy more data than is available in source PCM */
+        if (chunk_size > (size_t) length)
+            chunk_size = length;
+
+        /* Copy block of PCM data into buffer */
+        memcpy(state->pcm + state->pcm_written, pcm_data, chunk_size);
+
+        /* Advance to next block */
+        state->pcm_written += chunk_size;
+        pcm_data += chunk_size;
+        length -= chunk_size;
+
+        /* Encode each complete frame */
+        if (state->pcm_written == state->pcm_length)
+            opus_audio_encoder_encode_frame(audio, state);
+
+    }
+
+}
+
+static void opus_audio_encoder_flush_handler(guac_audio_stream* audio) {
+
+    opus_audio_encoder_state* state = (opus_audio_encoder_state*) audio->data;
+    guac_socket* socket = audio->client->socket;
+    guac_stream* stream = audio->stream;
+
+    /* Once the sound has ended, also encode any incomplete frame rather than
+     * holding it back until further PCM data is written. Packets already
+     * encoded are sent first if necessary to make room, as encoding must not
+     * itself trigger a flush. */
+    if (audio->sound_ended && state->pcm_written > 0) {
+
+        if (state->written + GUAC_OPUS_MAX_PACKET_SIZE + 2 > state->length) {
+            guac_protocol_send_blobs(socket, stream, state->buffer,
+                    state->written);
+            state->written = 0;
+        }
+
+        opus_audio_encoder_encode_partial_frame(audio, state);
+
+    }
+
+    /* Flush all complete packets as blobs. Any other incomplete frame remains
+     * buffered as PCM until enough further data has been written. */
+    guac_protocol_send_blobs(socket, stream, state->buffer, state->written);
+
+    /* All encoded data has been flushed */
+    state->written = 0;
+
+}
+
+/* Opus encoder handlers */
+guac_audio_encoder _opus_audio_encoder = {
+    .mimetype      = GUAC_OPUS_MIMETYPE,
+    .begin_handler = opus_audio_encoder_begin_handler,
+    .write_handler = opus_audio_encoder_write_handler,
+    .flush_handler = opus_audio_encoder_flush_handler,
+    .join_handler  = opus_audio_encoder_join_handler,
+    .end_handler   = opus_audio_encoder_end_handler
+};
+
+/* Actual encoder definition */
+guac_audio_encoder* opus_audio_encoder = &_opus_audio_encoder;
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_OPUS_AUDIO_ENCODER_H
+#define GUAC_OPUS_AUDIO_ENCODER_H
+
+#include "config.h"
+
+#include "guacamole/audio.h"
+
+#include <opus/opus.h>
+
+#include <stddef.h>
+
+/**
+ * The base mimetype of audio encoded by the Opus encoder. Each encoded Opus
+ * packet is preceded by its length in bytes, as a 16-bit big-endian integer,
+ * such that packets can be recovered from the concatenated contents of each
+ * blob. The mimetype sent to users additionally describes the rate and number
+ * of channels, in the same manner as the raw PCM encoders.
+ */
+#define GUAC_OPUS_MIMETYPE "audio/x-opus-framed"
+
+/**
+ * The duration of the audio encoded within each Opus packet, in
+ * milliseconds.
+ */
+#define GUAC_OPUS_FRAME_DURATION 20
+
+/**
+ * The maximum size of a single Opus packet, in bytes.
+ */
+#define GUAC_OPUS_MAX_PACKET_SIZE 1275
+
+/**
+ * The number of packets to accumulate before sending encoded audio, unless
+ * the stream is flushed sooner. This is chosen such that the encoded buffer
+ * always fits within a single blob, and thus each blob contains only whole
+ * packets.
+ */
+#define GUAC_OPUS_BUFFER_PACKETS 4
+
+/**
+ * The target bitrate of each encoded channel, in bits per second.
+ */
+#define GUAC_OPUS_BITRATE_PER_CHANNEL 48000
+
+/**
+ * The current state of the Opus encoder. PCM data is buffered only until a
+ * complete Opus frame is available, with encoded packets buffered until the
+ * stream is flushed or the output buffer is full.
+ */
+typedef struct opus_audio_encoder_state {
+
+    /**
+     * The underlying libopus encoder, or NULL if the encoder could not be
+     * created (in which case all audio is dropped).
+     */
+    OpusEncoder* encoder;
+
+    /**
+     * The number of sample frames within each Opus frame.
+     */
+    int frame_size;
+
+    /**
+     * Buffer of signed, 16-bit, little-endian PCM data which does not yet
+     * form a complete Opus frame.
+     */
+    unsigned char* pcm;
+
+    /**
+     * The size of a complete Opus frame of PCM data, in bytes.
+     */
+    size_t pcm_length;
+
+    /**
+     * The current number of bytes stored within the PCM buffer.
+     */
+    size_t pcm_written;
+
+    /**
+     * The samples of the Opus frame currently being encoded, converted from
+     * the PCM buffer to native byte order.
+     */
+    opus_int16* samples;
+
+    /**
+     * Buffer of encoded, length-prefixed packets which have not yet been
+     * sent.
+     */
+    unsigned char* buffer;
+
+    /**
+     * Size of the encoded buffer, in bytes.
+     */
+    size_t length;
+
+    /**
+     * The current number of bytes stored within the encoded buffer.
+     */
+    size_t written;
+
+} opus_audio_encoder_state;
+
+/**
+ * Returns whether the given sample rate can be encoded by Opus. Opus
+ * supports only a fixed set of sample rates and does not resample audio
+ * itself.
+ *
+ * @param rate
+ *     The sample rate to test, in samples per second.
+ *
+ * @return
+ *     Non-zero if the given rate is supported by Opus, zero otherwise.
+ */
+int guac_opus_rate_supported(int rate);
+
+/**
+ * Audio encoder which writes Opus packets, encoding 16-bit PCM at any of the
+ * sample rates supported by Opus.
+ */
+extern guac_audio_encoder* opus_audio_encoder;
+
+#endif
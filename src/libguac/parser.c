@@ -35,6 +35,8 @@ static void guac_parser_reset(guac_parser* parser) {
     parser->state = GUAC_PARSE_LENGTH;
     parser->__elementc = 0;
     parser->__element_length = 0;
+    parser->__instructionbuf_instruction_start =
+        parser->__instructionbuf_unparsed_start;
 }
 
 guac_parser* guac_parser_alloc() {
@@ -47,6 +49,16 @@ guac_parser* guac_parser_alloc() {
         return NULL;
     }
 
+    /* Allocate initial instruction buffer */
+    parser->__instructionbuf_size = GUAC_PARSER_INITIAL_BUFFER_SIZE;
+    parser->__instructionbuf = guac_mem_alloc(parser->__instructionbuf_size);
+    if (parser->__instructionbuf == NULL) {
+        guac_error = GUAC_STATUS_NO_MEMORY;
+        guac_error_message = "Insufficient memory to allocate parser";
+        guac_mem_free(parser);
+        return NULL;
+    }
+
     /* Init parse start/end markers */
     parser->__instructionbuf_unparsed_start = parser->__instructionbuf;
     parser->__instructionbuf_unparsed_end = parser->__instructionbuf;
@@ -113,6 +125,27 @@ int guac_parser_append(guac_parser* parser, void* buffer, int length) {
 
         while (bytes_parsed < length && parser->__element_length >= 0) {
 
+            /* Skip any run of ASCII characters within the element in bulk.
+             * Only multibyte characters and the terminator need to be handled
+             * one character at a time. */
+            if (parser->__element_length > 0) {
+
+                int available = length - bytes_parsed;
+                if (available > parser->__element_length)
+                    available = parser->__element_length;
+
+                int ascii_length = guac_utf8_ascii_length(char_buffer,
+                        available);
+
+                if (ascii_length > 0) {
+                    bytes_parsed += ascii_length;
+                    char_buffer += ascii_length;
+                    parser->__element_length -= ascii_length;
+                    continue;
+                }
+
+            }
+
             /* Get length of current character */
             char c = *char_buffer;
             int char_length = guac_utf8_charsize((unsigned char) c);
@@ -164,95 +197,302 @@ int guac_parser_append(guac_parser* parser, void* buffer, int length) {
 
 }
 
-int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout) {
+/**
+ * Parses as much of the current instruction as possible from the data
+ * already stored within the parser's internal buffer, stopping once the
+ * instruction is complete or more data is needed.
+ *
+ * @param parser
+ *     The guac_parser to parse buffered data within.
+ *
+ * @return
+ *     Zero if parsing succeeded (though the instruction may still be
+ *     incomplete), non-zero if the buffered data cannot be parsed, in which
+ *     case guac_error is set appropriately.
+ */
+static int guac_parser_parse_buffered(guac_parser* parser) {
 
-    char* unparsed_end   = parser->__instructionbuf_unparsed_end;
     char* unparsed_start = parser->__instructionbuf_unparsed_start;
-    char* instr_start    = parser->__instructionbuf_unparsed_start;
-    char* buffer_end     = parser->__instructionbuf + sizeof(parser->__instructionbuf);
+    char* unparsed_end = parser->__instructionbuf_unparsed_end;
+
+    while (parser->state != GUAC_PARSE_COMPLETE
+        && parser->state != GUAC_PARSE_ERROR) {
+
+        /* Stop if more data is needed */
+        int parsed = guac_parser_append(parser, unparsed_start,
+                unparsed_end - unparsed_start);
+        if (parsed == 0)
+            break;
+
+        unparsed_start += parsed;
+
+    }
+
+    parser->__instructionbuf_unparsed_start = unparsed_start;
+
+    /* Fail on error */
+    if (parser->state == GUAC_PARSE_ERROR) {
+        guac_error = GUAC_STATUS_PROTOCOL_ERROR;
+        guac_error_message = "Instruction parse error";
+        return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Ensures space is available at the end of the parser's internal buffer for
+ * reading more data. If the buffer contains no data which is still needed, it
+ * is simply rewound. If the buffer is full, the in-progress instruction is
+ * moved to the beginning of the buffer, or, if the in-progress instruction
+ * already occupies the entire buffer, the buffer is grown.
+ *
+ * @param parser
+ *     The guac_parser whose buffer should have space available.
+ *
+ * @return
+ *     Zero if space is available, non-zero if the buffer would need to grow
+ *     beyond GUAC_PARSER_MAX_BUFFER_SIZE or cannot be grown, in which case
+ *     guac_error is set appropriately.
+ */
+static int guac_parser_make_room(guac_parser* parser) {
+
+    char* buffer = parser->__instructionbuf;
+    char* instr_start = parser->__instructionbuf_instruction_start;
+    char* unparsed_end = parser->__instructionbuf_unparsed_end;
+
+    /* If no part of an instruction is buffered, simply start over at the
+     * beginning of the buffer */
+    if (instr_start == unparsed_end) {
+        parser->__instructionbuf_instruction_start = buffer;
+        parser->__instructionbuf_unparsed_start = buffer;
+        parser->__instructionbuf_unparsed_end = buffer;
+        return 0;
+    }
+
+    /* Nothing to do if space remains */
+    if (unparsed_end != buffer + parser->__instructionbuf_size)
+        return 0;
+
+    /* Grow the buffer only if the instruction cannot be shifted backward */
+    char* new_buffer = buffer;
+    if (instr_start == buffer) {
+
+        if (parser->__instructionbuf_size >= GUAC_PARSER_MAX_BUFFER_SIZE) {
+            guac_error = GUAC_STATUS_NO_MEMORY;
+            guac_error_message = "Instruction too long";
+            return 1;
+        }
+
+        size_t new_size = parser->__instructionbuf_size * 2;
+        if (new_size > GUAC_PARSER_MAX_BUFFER_SIZE)
+            new_size = GUAC_PARSER_MAX_BUFFER_SIZE;
+
+        new_buffer = guac_mem_alloc(new_size);
+        if (new_buffer == NULL) {
+            guac_error = GUAC_STATUS_NO_MEMORY;
+            guac_error_message = "Insufficient memory to grow instruction "
+                                 "buffer";
+            return 1;
+        }
+
+        memcpy(new_buffer, instr_start, unparsed_end - instr_start);
+        parser->__instructionbuf_size = new_size;
+
+    }
+
+    /* Otherwise, shift the in-progress instruction to the beginning */
+    else
+        memmove(new_buffer, instr_start, unparsed_end - instr_start);
+
+    /* Update parsed elements, if any */
+    for (int i = 0; i < parser->__elementc; i++)
+        parser->__elementv[i] = new_buffer
+            + (parser->__elementv[i] - instr_start);
+
+    /* Update tracking pointers */
+    parser->__instructionbuf_unparsed_start = new_buffer
+        + (parser->__instructionbuf_unparsed_start - instr_start);
+    parser->__instructionbuf_unparsed_end = new_buffer
+        + (unparsed_end - instr_start);
+    parser->__instructionbuf_instruction_start = new_buffer;
+
+    if (new_buffer != buffer) {
+        guac_mem_free(buffer);
+        parser->__instructionbuf = new_buffer;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Waits for data to become available on the given guac_socket and reads as
+ * much of that data as will fit into the parser's internal buffer using a
+ * single read, making room within the buffer as necessary.
+ *
+ * @param parser
+ *     The guac_parser whose buffer should receive the data read.
+ *
+ * @param socket
+ *     The guac_socket to read data from.
+ *
+ * @param usec_timeout
+ *     The maximum number of microseconds to wait for data, or -1 to wait
+ *     indefinitely.
+ *
+ * @return
+ *     Zero if data was read, non-zero if no data could be read, in which
+ *     case guac_error is set appropriately.
+ */
+static int guac_parser_fill(guac_parser* parser, guac_socket* socket,
+        int usec_timeout) {
+
+    if (guac_parser_make_room(parser))
+        return 1;
+
+    char* unparsed_end = parser->__instructionbuf_unparsed_end;
+    char* buffer_end = parser->__instructionbuf + parser->__instructionbuf_size;
+
+    /* No instruction yet? Get more data ... */
+    int retval = guac_socket_select(socket, usec_timeout);
+    if (retval <= 0)
+        return 1;
+
+    /* Attempt to fill buffer */
+    retval = guac_socket_read(socket, unparsed_end, buffer_end - unparsed_end);
+
+    /* Set guac_error if read unsuccessful */
+    if (retval < 0) {
+        guac_error = GUAC_STATUS_SEE_ERRNO;
+        guac_error_message = "Error filling instruction buffer";
+        return 1;
+    }
+
+    /* EOF */
+    if (retval == 0) {
+        guac_error = GUAC_STATUS_CLOSED;
+        guac_error_message = "End of stream reached while "
+                             "reading instruction";
+        return 1;
+    }
+
+    /* Update internal buffer */
+    parser->__instructionbuf_unparsed_end = unparsed_end + retval;
+    return 0;
+
+}
+
+int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout) {
 
     /* Begin next instruction if previous was ended */
     if (parser->state == GUAC_PARSE_COMPLETE)
         guac_parser_reset(parser);
 
-    while (parser->state != GUAC_PARSE_COMPLETE
-        && parser->state != GUAC_PARSE_ERROR) {
+    for (;;) {
+
+        /* Parse any buffered data, stopping once the instruction is read */
+        if (guac_parser_parse_buffered(parser))
+            return -1;
 
-        /* Add any available data to buffer */
-        int parsed = guac_parser_append(parser, unparsed_start, unparsed_end - unparsed_start);
+        if (parser->state == GUAC_PARSE_COMPLETE)
+            return 0;
 
         /* Read more data if not enough data to parse */
-        if (parsed == 0 && parser->state != GUAC_PARSE_ERROR) {
+        if (guac_parser_fill(parser, socket, usec_timeout))
+            return -1;
+
+    }
+
+}
 
-            int retval;
+/**
+ * Parses and handles every complete instruction already stored within the
+ * parser's internal buffer, invoking the given callback for each.
+ *
+ * @param parser
+ *     The guac_parser to parse buffered data within.
+ *
+ * @param callback
+ *     The callback to invoke for each complete instruction.
+ *
+ * @param data
+ *     Arbitrary data to pass to the given callback.
+ *
+ * @return
+ *     The number of instructions handled, or -1 if a parse error occurs or
+ *     the callback returns non-zero.
+ */
+static int guac_parser_dispatch_buffered(guac_parser* parser,
+        guac_parser_callback* callback, void* data) {
 
-            /* If no space left to read, fail */
-            if (unparsed_end == buffer_end) {
+    int handled = 0;
 
-                /* Shift backward if possible */
-                if (instr_start != parser->__instructionbuf) {
+    for (;;) {
 
-                    int i;
+        /* Begin next instruction if previous was ended */
+        if (parser->state == GUAC_PARSE_COMPLETE)
+            guac_parser_reset(parser);
 
-                    /* Shift buffer */
-                    int offset = instr_start - parser->__instructionbuf;
-                    memmove(parser->__instructionbuf, instr_start,
-                            unparsed_end - instr_start);
+        if (guac_parser_parse_buffered(parser))
+            return -1;
 
-                    /* Update tracking pointers */
-                    unparsed_end -= offset;
-                    unparsed_start -= offset;
-                    instr_start = parser->__instructionbuf;
+        /* Stop once only a partial instruction remains */
+        if (parser->state != GUAC_PARSE_COMPLETE)
+            return handled;
 
-                    /* Update parsed elements, if any */
-                    for (i=0; i < parser->__elementc; i++)
-                        parser->__elementv[i] -= offset;
+        handled++;
+        if (callback(parser, data))
+            return -1;
 
-                }
+    }
 
-                /* Otherwise, no memory to read */
-                else {
-                    guac_error = GUAC_STATUS_NO_MEMORY;
-                    guac_error_message = "Instruction too long";
-                    return -1;
-                }
+}
 
-            }
+int guac_parser_read_batch(guac_parser* parser, guac_socket* socket,
+        int usec_timeout, guac_parser_callback* callback, void* data) {
 
-            /* No instruction yet? Get more data ... */
-            retval = guac_socket_select(socket, usec_timeout);
-            if (retval <= 0)
-                return -1;
-           
-            /* Attempt to fill buffer */
-            retval = guac_socket_read(socket, unparsed_end,
-                    buffer_end - unparsed_end);
-
-            /* Set guac_error if read unsuccessful */
-            if (retval < 0) {
-                guac_error = GUAC_STATUS_SEE_ERRNO;
-                guac_error_message = "Error filling instruction buffer";
-                return -1;
-            }
+    /* Handle any instructions which have already been received */
+    int handled = guac_parser_dispatch_buffered(parser, callback, data);
+    if (handled != 0)
+        return handled;
 
-            /* EOF */
-            if (retval == 0) {
-                guac_error = GUAC_STATUS_CLOSED;
-                guac_error_message = "End of stream reached while "
-                                     "reading instruction";
-                return -1;
-            }
+    /* Read once, handling everything that read produced */
+    if (guac_parser_fill(parser, socket, usec_timeout))
+        return -1;
 
-            /* Update internal buffer */
-            unparsed_end += retval;
+    return guac_parser_dispatch_buffered(parser, callback, data);
 
+}
+
+int guac_parser_read_buffer(guac_parser* parser, void* buffer, int length) {
+
+    char* current = (char*) buffer;
+    int remaining = length;
+
+    /* Discard any previously-read instruction */
+    guac_parser_reset(parser);
+
+    while (parser->state != GUAC_PARSE_COMPLETE
+        && parser->state != GUAC_PARSE_ERROR) {
+
+        /* Parse as much of the instruction as possible */
+        int parsed = guac_parser_append(parser, current, remaining);
+
+        /* The buffer is the entirety of the available data, thus failing to
+         * parse anything further means the data has run out */
+        if (parsed == 0 && parser->state != GUAC_PARSE_ERROR) {
+            guac_error = GUAC_STATUS_CLOSED;
+            guac_error_message = "End of buffer reached while "
+                                 "reading instruction";
+            return -1;
         }
 
-        /* If data was parsed, advance buffer */
-        else
-            unparsed_start += parsed;
+        current += parsed;
+        remaining -= parsed;
 
-    } /* end while parsing data */
+    }
 
     /* Fail on error */
     if (parser->state == GUAC_PARSE_ERROR) {
@@ -261,9 +501,7 @@ int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout)
         return -1;
     }
 
-    parser->__instructionbuf_unparsed_start = unparsed_start;
-    parser->__instructionbuf_unparsed_end = unparsed_end;
-    return 0;
+    return length - remaining;
 
 }
 
@@ -314,6 +552,7 @@ int guac_parser_shift(guac_parser* parser, void* buffer, int length) {
 }
 
 void guac_parser_free(guac_parser* parser) {
+    guac_mem_free(parser->__instructionbuf);
     guac_mem_free(parser);
 }
 
@@ -19,10 +19,12 @@
 
 #include "guacamole/mem.h"
 #include "guacamole/client.h"
+#include "guacamole/error.h"
 #include "guacamole/protocol.h"
 #include "guacamole/recording.h"
 #include "guacamole/socket.h"
 #include "guacamole/timestamp.h"
+#include "socket-async.h"
 
 #ifdef __MINGW32__
 #include <direct.h>
@@ -32,6 +34,7 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -141,6 +144,29 @@ static int guac_recording_open(const char* path,
 
 }
 
+/**
+ * Logs how much has been recorded and the cost of writing it. This function
+ * is invoked once the socket of the recording has been freed and all data has
+ * been written, and thus may outlive the guac_recording itself.
+ *
+ * @param stats
+ *     The final statistics of the socket of the recording.
+ *
+ * @param data
+ *     The guac_client associated with the recording.
+ */
+static void guac_recording_log_stats(const guac_socket_async_stats* stats,
+        void* data) {
+
+    guac_client* client = (guac_client*) data;
+
+    guac_client_log(client, GUAC_LOG_DEBUG, "Recording wrote "
+            "%" PRIu64 " bytes in %" PRIu64 " writes (%" PRIi64 "ms spent "
+            "writing, output blocked %" PRIu64 " times).", stats->bytes_written,
+            stats->writes, stats->write_duration, stats->stalls);
+
+}
+
 guac_recording* guac_recording_create(guac_client* client,
         const char* path, const char* name, int create_path,
         int include_output, int include_mouse, int include_touch,
@@ -169,9 +195,22 @@ guac_recording* guac_recording_create(guac_client* client,
         return NULL;
     }
 
+    /* Write recording from a dedicated thread such that slow storage does not
+     * block the threads producing output */
+    guac_socket* socket = guac_socket_open_async(fd,
+            GUAC_SOCKET_ASYNC_DEFAULT_BUFFER_SIZE,
+            guac_recording_log_stats, client);
+    if (socket == NULL) {
+        guac_client_log(client, GUAC_LOG_ERROR,
+                "Creation of recording failed: %s", guac_status_string(guac_error));
+        close(fd);
+        return NULL;
+    }
+
     /* Create recording structure with reference to underlying socket */
     guac_recording* recording = guac_mem_alloc(sizeof(guac_recording));
-    recording->socket = guac_socket_open(fd);
+    recording->client = client;
+    recording->socket = socket;
     recording->include_output = include_output;
     recording->include_mouse = include_mouse;
     recording->include_touch = include_touch;
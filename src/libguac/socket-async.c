@@ -0,0 +1,455 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/error.h"
+#include "guacamole/flag.h"
+#include "guacamole/mem.h"
+#include "guacamole/socket.h"
+#include "guacamole/timestamp.h"
+#include "socket-async.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Data associated with an open socket which writes to a file descriptor from
+ * a dedicated background thread.
+ */
+typedef struct guac_socket_async_data {
+
+    /**
+     * The associated file descriptor.
+     */
+    int fd;
+
+    /**
+     * Circular buffer containing all data written to the socket that has not
+     * yet been written to the file descriptor.
+     */
+    char* buffer;
+
+    /**
+     * The total size of the circular buffer, in bytes.
+     */
+    size_t buffer_size;
+
+    /**
+     * The offset within the circular buffer of the first pending byte.
+     */
+    size_t start;
+
+    /**
+     * The number of bytes currently pending within the circular buffer.
+     */
+    size_t length;
+
+    /**
+     * Non-zero if a write to the underlying file descriptor has failed, in
+     * which case all further writes to this socket will fail.
+     */
+    int failed;
+
+    /**
+     * The current state of the circular buffer and background writer thread.
+     * Locking this flag guards access to all other members of this structure
+     * except fd, socket_lock, and writer_thread. Valid flags are
+     * GUAC_SOCKET_ASYNC_STATE_PENDING, GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE,
+     * and GUAC_SOCKET_ASYNC_STATE_STOPPING.
+     */
+    guac_flag state;
+
+    /**
+     * Statistics describing the data written thus far.
+     */
+    guac_socket_async_stats stats;
+
+    /**
+     * The handler to invoke with the final statistics once the socket is
+     * freed, or NULL if there is no such handler.
+     */
+    guac_socket_async_stats_handler* stats_handler;
+
+    /**
+     * Arbitrary data to pass to stats_handler.
+     */
+    void* stats_handler_data;
+
+    /**
+     * The background thread that writes pending data to the file descriptor.
+     */
+    pthread_t writer_thread;
+
+    /**
+     * Lock which is acquired when an instruction is being written, and
+     * released when the instruction is finished being written.
+     */
+    pthread_mutex_t socket_lock;
+
+} guac_socket_async_data;
+
+/**
+ * Writes the entire contents of the given buffer to the given file
+ * descriptor, retrying as necessary until the whole buffer is written.
+ *
+ * @param fd
+ *     The file descriptor to write to.
+ *
+ * @param buffer
+ *     The buffer of data to write.
+ *
+ * @param count
+ *     The number of bytes within the given buffer.
+ *
+ * @param stats
+ *     The statistics to update with the number of write() calls made.
+ *
+ * @return
+ *     Zero if the entire buffer was written, non-zero if an error occurs.
+ */
+static int guac_socket_async_write_fully(int fd, const char* buffer,
+        size_t count, guac_socket_async_stats* stats) {
+
+    while (count > 0) {
+
+        ssize_t retval = write(fd, buffer, count);
+        stats->writes++;
+
+        if (retval < 0) {
+
+            /* Retry if interrupted before anything was written */
+            if (errno == EINTR)
+                continue;
+
+            return 1;
+
+        }
+
+        buffer += retval;
+        count  -= retval;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Background thread which continuously writes pending data from the circular
+ * buffer of an asynchronous guac_socket to its file descriptor. The circular
+ * buffer is NOT locked while data is being written, and the data being
+ * written remains reserved within the buffer until the write completes. This
+ * thread terminates once GUAC_SOCKET_ASYNC_STATE_STOPPING has been set and no
+ * data remains pending.
+ *
+ * @param data
+ *     The guac_socket_async_data of the socket being written.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_socket_async_writer_thread(void* data) {
+
+    guac_socket_async_data* async_data = (guac_socket_async_data*) data;
+
+    for (;;) {
+
+        guac_flag_wait_and_lock(&async_data->state,
+                GUAC_SOCKET_ASYNC_STATE_PENDING
+                | GUAC_SOCKET_ASYNC_STATE_STOPPING);
+
+        /* Wait for further data if everything has been written, unless the
+         * socket is being freed */
+        if (async_data->length == 0) {
+
+            if (async_data->state.value & GUAC_SOCKET_ASYNC_STATE_STOPPING) {
+                guac_flag_unlock(&async_data->state);
+                break;
+            }
+
+            guac_flag_clear(&async_data->state,
+                    GUAC_SOCKET_ASYNC_STATE_PENDING);
+            guac_flag_unlock(&async_data->state);
+            continue;
+
+        }
+
+        /* Write as much contiguous pending data as possible in one batch,
+         * without holding the lock (other threads may continue appending to
+         * the unreserved portion of the buffer) */
+        size_t start = async_data->start;
+        size_t length = async_data->length;
+        if (length > async_data->buffer_size - start)
+            length = async_data->buffer_size - start;
+
+        guac_flag_unlock(&async_data->state);
+
+        guac_socket_async_stats stats = { 0 };
+        guac_timestamp write_started = guac_timestamp_current();
+        int failed = guac_socket_async_write_fully(async_data->fd,
+                async_data->buffer + start, length, &stats);
+        guac_timestamp write_ended = guac_timestamp_current();
+
+        guac_flag_lock(&async_data->state);
+
+        /* Discard everything pending if the file descriptor can no longer be
+         * written, such that no thread ever blocks waiting for space */
+        if (failed) {
+            async_data->failed = 1;
+            length = async_data->length;
+        }
+        else
+            async_data->stats.bytes_written += length;
+
+        async_data->stats.writes += stats.writes;
+        async_data->stats.write_duration += write_ended - write_started;
+
+        /* Release the written region for reuse */
+        async_data->start = (start + length) % async_data->buffer_size;
+        async_data->length -= length;
+
+        guac_flag_set(&async_data->state,
+                GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE);
+        guac_flag_unlock(&async_data->state);
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Appends the provided data to the circular buffer of the given asynchronous
+ * socket, waiting for space to become available if the buffer is full. The
+ * background writer thread is woken if enough data is pending to fill an
+ * entire batch.
+ *
+ * @param socket
+ *     The guac_socket being written to.
+ *
+ * @param buf
+ *     The arbitrary buffer containing the data to be written.
+ *
+ * @param count
+ *     The number of bytes contained within the buffer.
+ *
+ * @return
+ *     The number of bytes written, or -1 if an error occurs.
+ */
+static ssize_t guac_socket_async_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    guac_socket_async_data* data = (guac_socket_async_data*) socket->data;
+    const char* current = buf;
+    size_t original_count = count;
+
+    guac_flag_lock(&data->state);
+
+    while (count > 0) {
+
+        if (data->failed) {
+            guac_flag_unlock(&data->state);
+            guac_error = GUAC_STATUS_IO_ERROR;
+            guac_error_message = "Error writing data to file";
+            return -1;
+        }
+
+        /* Wait for the background writer thread to free some space if the
+         * buffer is full */
+        size_t remaining = data->buffer_size - data->length;
+        if (remaining == 0) {
+
+            data->stats.stalls++;
+            guac_flag_clear(&data->state,
+                    GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE);
+            guac_flag_set(&data->state, GUAC_SOCKET_ASYNC_STATE_PENDING);
+            guac_flag_unlock(&data->state);
+
+            guac_flag_wait_and_lock(&data->state,
+                    GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE);
+            continue;
+
+        }
+
+        /* Copy only as much as fits contiguously after the current end of
+         * the pending data, wrapping around on the next iteration */
+        size_t end = (data->start + data->length) % data->buffer_size;
+        size_t chunk_size = count;
+
+        if (chunk_size > remaining)
+            chunk_size = remaining;
+
+        if (chunk_size > data->buffer_size - end)
+            chunk_size = data->buffer_size - end;
+
+        memcpy(data->buffer + end, current, chunk_size);
+        data->length += chunk_size;
+
+        current += chunk_size;
+        count   -= chunk_size;
+
+    }
+
+    /* Wake the background writer thread once a full batch is pending */
+    if (data->length >= GUAC_SOCKET_ASYNC_BATCH_SIZE)
+        guac_flag_set(&data->state, GUAC_SOCKET_ASYNC_STATE_PENDING);
+
+    guac_flag_unlock(&data->state);
+    return original_count;
+
+}
+
+/**
+ * Requests that the background writer thread write all data currently
+ * pending within the circular buffer of the given socket. This function does
+ * not wait for that data to actually be written.
+ *
+ * @param socket
+ *     The guac_socket to flush.
+ *
+ * @return
+ *     Zero if the flush operation was successful, non-zero if a previous
+ *     write to the underlying file descriptor has failed.
+ */
+static ssize_t guac_socket_async_flush_handler(guac_socket* socket) {
+
+    guac_socket_async_data* data = (guac_socket_async_data*) socket->data;
+
+    guac_flag_lock(&data->state);
+
+    int failed = data->failed;
+    if (!failed && data->length > 0)
+        guac_flag_set(&data->state, GUAC_SOCKET_ASYNC_STATE_PENDING);
+
+    guac_flag_unlock(&data->state);
+    return failed;
+
+}
+
+/**
+ * Acquires exclusive access to the given socket.
+ *
+ * @param socket
+ *     The guac_socket to which exclusive access is required.
+ */
+static void guac_socket_async_lock_handler(guac_socket* socket) {
+
+    guac_socket_async_data* data = (guac_socket_async_data*) socket->data;
+
+    /* Acquire exclusive access to socket */
+    pthread_mutex_lock(&(data->socket_lock));
+
+}
+
+/**
+ * Relinquishes exclusive access to the given socket.
+ *
+ * @param socket
+ *     The guac_socket to which exclusive access is no longer required.
+ */
+static void guac_socket_async_unlock_handler(guac_socket* socket) {
+
+    guac_socket_async_data* data = (guac_socket_async_data*) socket->data;
+
+    /* Relinquish exclusive access to socket */
+    pthread_mutex_unlock(&(data->socket_lock));
+
+}
+
+/**
+ * Waits for all pending data to be written by the background writer thread,
+ * invokes the stats_handler (if any) with the final statistics, then frees
+ * all implementation-specific data associated with the given socket, but not
+ * the socket object itself.
+ *
+ * @param socket
+ *     The guac_socket whose associated data should be freed.
+ *
+ * @return
+ *     Always zero.
+ */
+static int guac_socket_async_free_handler(guac_socket* socket) {
+
+    guac_socket_async_data* data = (guac_socket_async_data*) socket->data;
+
+    /* Write any remaining data and stop the writer thread */
+    guac_flag_set(&data->state, GUAC_SOCKET_ASYNC_STATE_STOPPING);
+    pthread_join(data->writer_thread, NULL);
+
+    /* Report statistics only now that they include the final writes */
+    if (data->stats_handler != NULL)
+        data->stats_handler(&data->stats, data->stats_handler_data);
+
+    guac_flag_destroy(&data->state);
+    pthread_mutex_destroy(&(data->socket_lock));
+
+    /* Close file descriptor */
+    close(data->fd);
+
+    guac_mem_free(data->buffer);
+    guac_mem_free(data);
+    return 0;
+
+}
+
+guac_socket* guac_socket_open_async(int fd, size_t buffer_size,
+        guac_socket_async_stats_handler* stats_handler, void* stats_data) {
+
+    guac_socket_async_data* data = guac_mem_zalloc(sizeof(guac_socket_async_data));
+    data->fd = fd;
+    data->buffer = guac_mem_alloc(buffer_size);
+    data->buffer_size = buffer_size;
+    data->stats_handler = stats_handler;
+    data->stats_handler_data = stats_data;
+
+    guac_flag_init(&data->state);
+    guac_flag_set(&data->state, GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE);
+    pthread_mutex_init(&(data->socket_lock), NULL);
+
+    /* Start background writer thread */
+    if (pthread_create(&data->writer_thread, NULL,
+                guac_socket_async_writer_thread, data)) {
+        guac_flag_destroy(&data->state);
+        pthread_mutex_destroy(&(data->socket_lock));
+        guac_mem_free(data->buffer);
+        guac_mem_free(data);
+        guac_error = GUAC_STATUS_SEE_ERRNO;
+        guac_error_message = "Unable to start background writer thread";
+        return NULL;
+    }
+
+    guac_socket* socket = guac_socket_alloc();
+    socket->data = data;
+
+    /* Set write handlers (reads are not supported) */
+    socket->write_handler  = guac_socket_async_write_handler;
+    socket->lock_handler   = guac_socket_async_lock_handler;
+    socket->unlock_handler = guac_socket_async_unlock_handler;
+    socket->flush_handler  = guac_socket_async_flush_handler;
+    socket->free_handler   = guac_socket_async_free_handler;
+
+    return socket;
+
+}
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_SOCKET_ASYNC_H
+#define GUAC_SOCKET_ASYNC_H
+
+/**
+ * Provides an implementation of guac_socket which writes to a file descriptor
+ * from a dedicated background thread, such that slow storage never blocks the
+ * threads producing output.
+ *
+ * @file socket-async.h
+ */
+
+#include "guacamole/socket-types.h"
+#include "guacamole/timestamp-types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The default size of the buffer that data written to an asynchronous
+ * guac_socket is copied into prior to being written by the background writer
+ * thread, in bytes. Threads writing to the socket will block only if this
+ * buffer is completely full.
+ */
+#define GUAC_SOCKET_ASYNC_DEFAULT_BUFFER_SIZE 4194304
+
+/**
+ * The number of bytes that must be pending within the buffer of an
+ * asynchronous guac_socket before the background writer thread is woken to
+ * write that data, even if the socket has not been explicitly flushed.
+ */
+#define GUAC_SOCKET_ASYNC_BATCH_SIZE 262144
+
+/**
+ * The bitwise flag used by the "state" member of guac_socket_async_data to
+ * represent that the background writer thread should write all data
+ * currently pending within the buffer.
+ */
+#define GUAC_SOCKET_ASYNC_STATE_PENDING 1
+
+/**
+ * The bitwise flag used by the "state" member of guac_socket_async_data to
+ * represent that the buffer has space for at least one more byte.
+ */
+#define GUAC_SOCKET_ASYNC_STATE_SPACE_AVAILABLE 2
+
+/**
+ * The bitwise flag used by the "state" member of guac_socket_async_data to
+ * represent that the socket is being freed and the background writer thread
+ * should terminate once all pending data has been written.
+ */
+#define GUAC_SOCKET_ASYNC_STATE_STOPPING 4
+
+/**
+ * Statistics describing the data written by an asynchronous guac_socket and
+ * the amount of time spent writing that data.
+ */
+typedef struct guac_socket_async_stats {
+
+    /**
+     * The total number of bytes written to the underlying file descriptor.
+     */
+    uint64_t bytes_written;
+
+    /**
+     * The total number of write() calls made against the underlying file
+     * descriptor.
+     */
+    uint64_t writes;
+
+    /**
+     * The total amount of time the background writer thread has spent
+     * within write(), in milliseconds.
+     */
+    guac_timestamp write_duration;
+
+    /**
+     * The number of times a thread writing to the socket had to wait for
+     * space within the buffer because the background writer thread could not
+     * keep up.
+     */
+    uint64_t stalls;
+
+} guac_socket_async_stats;
+
+/**
+ * Handler which is invoked when an asynchronous guac_socket is freed, after
+ * all pending data has been written and the background writer thread has
+ * stopped, such that the given statistics are final.
+ *
+ * @param stats
+ *     The final statistics of the asynchronous guac_socket being freed.
+ *
+ * @param data
+ *     The arbitrary data provided when the asynchronous guac_socket was
+ *     created.
+ */
+typedef void guac_socket_async_stats_handler(
+        const guac_socket_async_stats* stats, void* data);
+
+/**
+ * Allocates and initializes a new guac_socket which writes all data to the
+ * given open file descriptor from a dedicated background thread. Data written
+ * to the returned guac_socket is copied into an internal buffer of the given
+ * size and is written to the file descriptor in large batches, either when a
+ * flush is requested or when GUAC_SOCKET_ASYNC_BATCH_SIZE bytes are pending.
+ * Flushing the returned guac_socket does not wait for data to be written.
+ *
+ * Threads writing to the returned guac_socket will block only if the internal
+ * buffer is full. Freeing the returned guac_socket waits for all pending data
+ * to be written before the file descriptor is closed. The returned socket
+ * cannot be read from.
+ *
+ * @param fd
+ *     An open file descriptor that the returned guac_socket should manage.
+ *     The file descriptor will be automatically closed when the guac_socket
+ *     is freed.
+ *
+ * @param buffer_size
+ *     The size of the internal buffer, in bytes.
+ *
+ * @param stats_handler
+ *     The handler to invoke with the final statistics of the returned
+ *     guac_socket when it is freed, or NULL if no such handler is needed.
+ *
+ * @param stats_data
+ *     Arbitrary data to pass to the given stats_handler.
+ *
+ * @return
+ *     A newly allocated guac_socket associated with the given file
+ *     descriptor, or NULL if the background writer thread could not be
+ *     started.
+ */
+guac_socket* guac_socket_open_async(int fd, size_t buffer_size,
+        guac_socket_async_stats_handler* stats_handler, void* stats_data);
+
+#endif
+
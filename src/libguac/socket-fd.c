@@ -34,8 +34,21 @@
 
 #ifdef ENABLE_WINSOCK
 #include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
+/**
+ * The maximum number of trailing bytes of a write that overflows the output
+ * buffer which are retained within the buffer rather than sent immediately.
+ * Data sent when the buffer overflows is sent with MSG_MORE, and may be held
+ * back by the kernel until something is sent without MSG_MORE. Retaining a
+ * small tail guarantees that the flush at the end of each frame has data to
+ * send, and thus pushes out everything sent before it.
+ */
+#define GUAC_SOCKET_FD_RETAINED_TAIL 256
+
 /**
  * Data associated with an open socket which writes to a file descriptor.
  */
@@ -46,16 +59,27 @@ typedef struct guac_socket_fd_data {
      */
     int fd;
 
+    /**
+     * Non-zero if the associated file descriptor is a stream socket, and
+     * thus may be written with sendmsg() and MSG_MORE, zero otherwise.
+     */
+    int is_socket;
+
     /**
      * The number of bytes currently in the main write buffer.
      */
-    int written;
+    size_t written;
+
+    /**
+     * The size of the main write buffer, in bytes.
+     */
+    size_t buffer_size;
 
     /**
      * The main write buffer. Bytes written go here before being flushed
      * to the open file descriptor.
      */
-    char out_buf[GUAC_SOCKET_OUTPUT_BUFFER_SIZE];
+    char* out_buf;
 
     /**
      * Lock which is acquired when an instruction is being written, and
@@ -71,42 +95,81 @@ typedef struct guac_socket_fd_data {
 
 } guac_socket_fd_data;
 
+#ifdef ENABLE_WINSOCK
 /**
- * Writes the entire contents of the given buffer to the file descriptor
- * associated with the given socket, retrying as necessary until the whole
- * buffer is written, and aborting if an error occurs.
+ * Minimal stand-in for the POSIX iovec structure, which is not provided by
+ * Winsock. Each buffer is simply written with its own call to send().
+ */
+struct iovec {
+
+    /**
+     * The start of the buffer.
+     */
+    void* iov_base;
+
+    /**
+     * The number of bytes within the buffer.
+     */
+    size_t iov_len;
+
+};
+#endif
+
+/**
+ * Writes the entire contents of the given buffers, in order, to the file
+ * descriptor associated with the given socket, retrying as necessary until
+ * all buffers are written, and aborting if an error occurs. Where possible,
+ * all buffers are written with a single system call. The given array of
+ * buffers is modified to track progress.
  *
  * @param socket
  *     The guac_socket associated with the file descriptor to which the given
- *     buffer should be written.
+ *     buffers should be written.
  *
- * @param buf
- *     The buffer of data to write to the given guac_socket.
+ * @param iov
+ *     The buffers to write.
  *
- * @param count
- *     The number of bytes within the given buffer.
+ * @param iovcnt
+ *     The number of buffers within the given array.
+ *
+ * @param more
+ *     Non-zero if further data is expected to be written imminently, such
+ *     that the underlying stream socket (if any) may defer transmission of
+ *     a partial packet, zero otherwise.
  *
  * @return
- *     The number of bytes written, which will be exactly the size of the given
- *     buffer, or a negative value if an error occurs.
+ *     Zero on success, or a negative value if an error occurs.
  */
-ssize_t guac_socket_fd_write(guac_socket* socket,
-        const void* buf, size_t count) {
+static ssize_t guac_socket_fd_writev(guac_socket* socket,
+        struct iovec* iov, int iovcnt, int more) {
 
     guac_socket_fd_data* data = (guac_socket_fd_data*) socket->data;
-    const char* buffer = buf;
 
     /* Write until completely written */
-    while (count > 0) {
+    while (iovcnt > 0) {
 
-        int retval;
+        ssize_t retval;
 
 #ifdef ENABLE_WINSOCK
         /* WSA only works with send() */
-        retval = send(data->fd, buffer, count, 0);
+        retval = send(data->fd, iov->iov_base, iov->iov_len, 0);
 #else
-        /* Use write() for all other platforms */
-        retval = write(data->fd, buffer, count);
+        /* Hint at frame boundaries for stream sockets */
+        if (data->is_socket) {
+            struct msghdr message = {
+                .msg_iov    = iov,
+                .msg_iovlen = iovcnt
+            };
+#ifdef MSG_MORE
+            retval = sendmsg(data->fd, &message, more ? MSG_MORE : 0);
+#else
+            retval = sendmsg(data->fd, &message, 0);
+#endif
+        }
+
+        /* Use writev() for all other file descriptors */
+        else
+            retval = writev(data->fd, iov, iovcnt);
 #endif
 
         /* Record errors in guac_error */
@@ -116,9 +179,18 @@ ssize_t guac_socket_fd_write(guac_socket* socket,
             return retval;
         }
 
-        /* Advance buffer to next chunk */
-        buffer += retval;
-        count  -= retval;
+        /* Skip past all completely-written buffers */
+        while (iovcnt > 0 && (size_t) retval >= iov->iov_len) {
+            retval -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        /* Advance partially-written buffer to next chunk */
+        if (iovcnt > 0) {
+            iov->iov_base = (char*) iov->iov_base + retval;
+            iov->iov_len -= retval;
+        }
 
     }
 
@@ -126,6 +198,36 @@ ssize_t guac_socket_fd_write(guac_socket* socket,
 
 }
 
+/**
+ * Writes the entire contents of the given buffer to the file descriptor
+ * associated with the given socket, retrying as necessary until the whole
+ * buffer is written, and aborting if an error occurs.
+ *
+ * @param socket
+ *     The guac_socket associated with the file descriptor to which the given
+ *     buffer should be written.
+ *
+ * @param buf
+ *     The buffer of data to write to the given guac_socket.
+ *
+ * @param count
+ *     The number of bytes within the given buffer.
+ *
+ * @return
+ *     Zero on success, or a negative value if an error occurs.
+ */
+ssize_t guac_socket_fd_write(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    struct iovec iov = {
+        .iov_base = (void*) buf,
+        .iov_len  = count
+    };
+
+    return guac_socket_fd_writev(socket, &iov, 1, 0);
+
+}
+
 /**
  * Attempts to read from the underlying file descriptor of the given
  * guac_socket, populating the given buffer.
@@ -246,45 +348,38 @@ static ssize_t guac_socket_fd_flush_handler(guac_socket* socket) {
 static ssize_t guac_socket_fd_write_buffered(guac_socket* socket,
         const void* buf, size_t count) {
 
-    size_t original_count = count;
-    const char* current = buf;
     guac_socket_fd_data* data = (guac_socket_fd_data*) socket->data;
 
-    /* Append to buffer, flush if necessary */
-    while (count > 0) {
-
-        int chunk_size;
-        int remaining = sizeof(data->out_buf) - data->written;
-
-        /* If no space left in buffer, flush and retry */
-        if (remaining == 0) {
-
-            /* Abort if error occurs during flush */
-            if (guac_socket_fd_flush(socket))
-                return -1;
-
-            /* Retry buffer append */
-            continue;
-
-        }
-
-        /* Calculate size of chunk to be written to buffer */
-        chunk_size = count;
-        if (chunk_size > remaining)
-            chunk_size = remaining;
-
-        /* Update output buffer */
-        memcpy(data->out_buf + data->written, current, chunk_size);
-        data->written += chunk_size;
-
-        /* Update provided buffer */
-        current += chunk_size;
-        count   -= chunk_size;
-
+    /* Simply append to buffer if sufficient space remains */
+    if (count <= data->buffer_size - data->written) {
+        memcpy(data->out_buf + data->written, buf, count);
+        data->written += count;
+        return count;
     }
 
-    /* All bytes have been written, possibly some to the internal buffer */
-    return original_count;
+    /* Retain the end of the provided data within the buffer, such that the
+     * data sent below is not held back beyond the next flush */
+    size_t tail = count;
+    if (tail > GUAC_SOCKET_FD_RETAINED_TAIL)
+        tail = GUAC_SOCKET_FD_RETAINED_TAIL;
+    if (tail > data->buffer_size)
+        tail = data->buffer_size;
+
+    /* Otherwise, write buffered and provided data together, without copying
+     * the provided data. As the buffer has filled mid-frame, more data is
+     * likely to follow, and will be followed by a flush of the retained tail
+     * (if any) without MSG_MORE. */
+    struct iovec iov[2] = {
+        { .iov_base = data->out_buf,  .iov_len = data->written },
+        { .iov_base = (void*) buf,    .iov_len = count - tail  }
+    };
+
+    if (guac_socket_fd_writev(socket, iov, 2, tail > 0))
+        return -1;
+
+    memcpy(data->out_buf, (const char*) buf + count - tail, tail);
+    data->written = tail;
+    return count;
 
 }
 
@@ -383,6 +478,7 @@ static int guac_socket_fd_free_handler(guac_socket* socket) {
     /* Close file descriptor */
     close(data->fd);
 
+    guac_mem_free(data->out_buf);
     guac_mem_free(data);
     return 0;
 
@@ -419,6 +515,10 @@ static void guac_socket_fd_unlock_handler(guac_socket* socket) {
 }
 
 guac_socket* guac_socket_open(int fd) {
+    return guac_socket_open_buffered(fd, GUAC_SOCKET_OUTPUT_BUFFER_SIZE);
+}
+
+guac_socket* guac_socket_open_buffered(int fd, size_t buffer_size) {
 
     pthread_mutexattr_t lock_attributes;
 
@@ -429,8 +529,20 @@ guac_socket* guac_socket_open(int fd) {
     /* Store file descriptor as socket data */
     data->fd = fd;
     data->written = 0;
+    data->buffer_size = buffer_size;
+    data->out_buf = guac_mem_alloc(buffer_size);
     socket->data = data;
 
+    /* Only stream sockets benefit from hinting at frame boundaries */
+    data->is_socket = 0;
+#ifndef ENABLE_WINSOCK
+    int type;
+    socklen_t type_length = sizeof(type);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_length) == 0
+            && type == SOCK_STREAM)
+        data->is_socket = 1;
+#endif
+
     pthread_mutexattr_init(&lock_attributes);
     pthread_mutexattr_setpshared(&lock_attributes, PTHREAD_PROCESS_SHARED);
 
@@ -24,6 +24,7 @@
 #include "guacamole/protocol.h"
 #include "guacamole/socket.h"
 #include "guacamole/timestamp.h"
+#include "trace.h"
 
 #include <inttypes.h>
 #include <pthread.h>
@@ -382,8 +383,12 @@ ssize_t guac_socket_write_base64(guac_socket* socket, const void* buf, size_t co
 ssize_t guac_socket_flush(guac_socket* socket) {
 
     /* If handler defined, call it. */
-    if (socket->flush_handler)
-        return socket->flush_handler(socket);
+    if (socket->flush_handler) {
+        GUAC_TRACE_BEGIN(span);
+        ssize_t retval = socket->flush_handler(socket);
+        GUAC_TRACE_END(span, GUAC_TRACE_SOCKET_FLUSH, 0);
+        return retval;
+    }
 
     /* Otherwise, do nothing */
     return 0;
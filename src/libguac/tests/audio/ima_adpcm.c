@@ -0,0 +1,280 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "ima_adpcm_encoder.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/audio.h>
+#include <guacamole/client.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The step size table defined by the IMA ADPCM specification.
+ */
+static const int step_table[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/**
+ * The step index adjustment table defined by the IMA ADPCM specification.
+ */
+static const int index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * Decodes a single IMA ADPCM block produced by guac_ima_adpcm_encode_block(),
+ * independently of the encoder implementation, as a client would.
+ *
+ * @param block
+ *     The encoded block.
+ *
+ * @param channels
+ *     The number of channels within the block.
+ *
+ * @param pcm
+ *     Buffer that should receive GUAC_IMA_ADPCM_BLOCK_FRAMES frames of
+ *     decoded, interleaved PCM.
+ */
+static void decode_block(const unsigned char* block, int channels,
+        int16_t* pcm) {
+
+    int predictor[GUAC_IMA_ADPCM_MAX_CHANNELS];
+    int step_index[GUAC_IMA_ADPCM_MAX_CHANNELS];
+
+    /* Read per-channel headers */
+    for (int c = 0; c < channels; c++) {
+        predictor[c] = (int16_t) (block[0] | (block[1] << 8));
+        step_index[c] = block[2];
+        pcm[c] = predictor[c];
+        block += 4;
+    }
+
+    /* Decode groups of eight samples per channel */
+    for (int group = 0; group < (GUAC_IMA_ADPCM_BLOCK_FRAMES - 1) / 8; group++) {
+        for (int c = 0; c < channels; c++) {
+            for (int i = 0; i < 8; i++) {
+
+                int code = (block[i / 2] >> ((i % 2) * 4)) & 0xF;
+                int step = step_table[step_index[c]];
+
+                int diff = step >> 3;
+                if (code & 4) diff += step;
+                if (code & 2) diff += step >> 1;
+                if (code & 1) diff += step >> 2;
+
+                predictor[c] += (code & 8) ? -diff : diff;
+                if (predictor[c] > INT16_MAX) predictor[c] = INT16_MAX;
+                if (predictor[c] < INT16_MIN) predictor[c] = INT16_MIN;
+
+                step_index[c] += index_table[code];
+                if (step_index[c] < 0) step_index[c] = 0;
+                if (step_index[c] > 88) step_index[c] = 88;
+
+                pcm[(1 + group * 8 + i) * channels + c] = predictor[c];
+
+            }
+            block += 4;
+        }
+    }
+
+}
+
+/**
+ * Test which verifies that guac_ima_adpcm_encode_block() produces blocks of
+ * the expected size which, when decoded, closely reproduce the original
+ * audio, including across consecutive blocks.
+ */
+void test_audio__ima_adpcm_roundtrip() {
+
+    guac_ima_adpcm_channel state[GUAC_IMA_ADPCM_MAX_CHANNELS] = { { 0 } };
+
+    int16_t pcm[GUAC_IMA_ADPCM_BLOCK_FRAMES * 2];
+    int16_t decoded[GUAC_IMA_ADPCM_BLOCK_FRAMES * 2];
+    unsigned char block[GUAC_IMA_ADPCM_BLOCK_CHANNEL_SIZE * 2];
+
+    CU_ASSERT_EQUAL(guac_ima_adpcm_block_size(1), 256);
+    CU_ASSERT_EQUAL(guac_ima_adpcm_block_size(2), 512);
+
+    for (int n = 0; n < 4; n++) {
+
+        /* Left channel is a 440 Hz tone, right is a quieter 1 kHz tone */
+        for (int i = 0; i < GUAC_IMA_ADPCM_BLOCK_FRAMES; i++) {
+            double t = (n * GUAC_IMA_ADPCM_BLOCK_FRAMES + i) / 44100.0;
+            pcm[i * 2]     = (int16_t) (12000 * sin(2 * M_PI * 440 * t));
+            pcm[i * 2 + 1] = (int16_t) (3000 * sin(2 * M_PI * 1000 * t));
+        }
+
+        guac_ima_adpcm_encode_block(state, 2, pcm, block);
+        decode_block(block, 2, decoded);
+
+        /* First frame is stored exactly */
+        CU_ASSERT_EQUAL(decoded[0], pcm[0]);
+        CU_ASSERT_EQUAL(decoded[1], pcm[1]);
+
+        /* Remaining frames need only be close (ADPCM is lossy), and the
+         * channels must not bleed into each other */
+        int max_error = 0;
+        for (int i = 2; i < GUAC_IMA_ADPCM_BLOCK_FRAMES * 2; i++) {
+            int error = abs(decoded[i] - pcm[i]);
+            if (error > max_error)
+                max_error = error;
+        }
+
+        /* Step size adapts from the initial minimum during the first block */
+        CU_ASSERT(max_error < (n == 0 ? 4000 : 600));
+
+    }
+
+}
+
+/**
+ * Test which verifies that silence encodes as silence, with the step index
+ * settling at its minimum.
+ */
+void test_audio__ima_adpcm_silence() {
+
+    guac_ima_adpcm_channel state[1] = { { 0 } };
+    state[0].step_index = 40;
+
+    int16_t pcm[GUAC_IMA_ADPCM_BLOCK_FRAMES] = { 0 };
+    int16_t decoded[GUAC_IMA_ADPCM_BLOCK_FRAMES];
+    unsigned char block[GUAC_IMA_ADPCM_BLOCK_CHANNEL_SIZE];
+
+    guac_ima_adpcm_encode_block(state, 1, pcm, block);
+    CU_ASSERT_EQUAL(block[2], 40);
+
+    decode_block(block, 1, decoded);
+    for (int i = 0; i < GUAC_IMA_ADPCM_BLOCK_FRAMES; i++) {
+        if (abs(decoded[i]) > 400) {
+            CU_FAIL("Decoded silence is audible");
+            break;
+        }
+    }
+
+    CU_ASSERT_EQUAL(state[0].step_index, 0);
+
+    /* The next block decodes to exact silence */
+    guac_ima_adpcm_encode_block(state, 1, pcm, block);
+    decode_block(block, 1, decoded);
+    for (int i = 0; i < GUAC_IMA_ADPCM_BLOCK_FRAMES; i++)
+        CU_ASSERT_EQUAL_FATAL(abs(decoded[i]) <= 1, 1);
+
+}
+
+/**
+ * The total number of bytes written to the socket of the audio stream within
+ * test_audio__ima_adpcm_flush_partial().
+ */
+static size_t test_bytes_written = 0;
+
+/**
+ * Write handler for the socket of the audio stream within
+ * test_audio__ima_adpcm_flush_partial(), which discards all data while
+ * counting the number of bytes written.
+ *
+ * @param socket
+ *     The socket being written to.
+ *
+ * @param buf
+ *     The data being written.
+ *
+ * @param count
+ *     The number of bytes being written.
+ *
+ * @return
+ *     The number of bytes written, which is always the number of bytes
+ *     provided.
+ */
+static ssize_t test_count_bytes(guac_socket* socket, const void* buf,
+        size_t count) {
+    test_bytes_written += count;
+    return count;
+}
+
+/**
+ * Test which verifies that flushing an IMA ADPCM audio stream sends any
+ * incomplete block of buffered PCM data only once the current sound has
+ * ended, rather than holding that data back until further PCM data is
+ * written.
+ */
+void test_audio__ima_adpcm_flush_partial() {
+
+    guac_socket* socket = guac_socket_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+    socket->write_handler = test_count_bytes;
+
+    guac_client client = { .socket = socket };
+    guac_stream stream = { .index = 1 };
+    guac_audio_stream audio = {
+        .encoder  = ima_adpcm_encoder,
+        .client   = &client,
+        .stream   = &stream,
+        .rate     = 44100,
+        .channels = 1,
+        .bps      = 16
+    };
+
+    ima_adpcm_encoder->begin_handler(&audio);
+
+    /* Buffer less than one block of a tone */
+    unsigned char pcm[200];
+    for (int i = 0; i < sizeof(pcm); i += 2) {
+        pcm[i]     = 0x00;
+        pcm[i + 1] = (i % 8 < 4) ? 0x10 : 0xF0;
+    }
+
+    ima_adpcm_encoder->write_handler(&audio, pcm, sizeof(pcm));
+
+    /* An incomplete block is held back while the sound continues */
+    test_bytes_written = 0;
+    ima_adpcm_encoder->flush_handler(&audio);
+    guac_socket_flush(socket);
+    CU_ASSERT_EQUAL(test_bytes_written, 0);
+
+    /* An incomplete block is sent once the sound has ended */
+    audio.sound_ended = 1;
+    ima_adpcm_encoder->flush_handler(&audio);
+    guac_socket_flush(socket);
+    CU_ASSERT(test_bytes_written > guac_ima_adpcm_block_size(1));
+
+    /* Nothing further remains to be sent */
+    test_bytes_written = 0;
+    ima_adpcm_encoder->flush_handler(&audio);
+    guac_socket_flush(socket);
+    CU_ASSERT_EQUAL(test_bytes_written, 0);
+
+    ima_adpcm_encoder->end_handler(&audio);
+    guac_socket_free(socket);
+
+}
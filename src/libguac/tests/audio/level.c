@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "audio-level.h"
+
+#include <CUnit/CUnit.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Writes the given signed 16-bit sample to the given buffer in little-endian
+ * byte order.
+ *
+ * @param buffer
+ *     The buffer to write the sample to.
+ *
+ * @param sample
+ *     The sample to write.
+ */
+static void write_sample16(unsigned char* buffer, int16_t sample) {
+    buffer[0] = (uint16_t) sample & 0xFF;
+    buffer[1] = (uint16_t) sample >> 8;
+}
+
+/**
+ * Test which verifies that buffers containing only zero-valued samples, as
+ * well as empty buffers, are measured as entirely silent. Zero-valued 8-bit
+ * samples are unsigned and thus have the value 128.
+ */
+void test_audio__level_zero() {
+
+    unsigned char buffer[64] = { 0 };
+    guac_audio_level level;
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 16, &level);
+    CU_ASSERT_EQUAL(level.rms, 0);
+    CU_ASSERT_EQUAL(level.peak, 0);
+
+    guac_audio_level_measure(buffer, 0, 16, &level);
+    CU_ASSERT_EQUAL(level.rms, 0);
+    CU_ASSERT_EQUAL(level.peak, 0);
+
+    memset(buffer, 128, sizeof(buffer));
+    guac_audio_level_measure(buffer, sizeof(buffer), 8, &level);
+    CU_ASSERT_EQUAL(level.rms, 0);
+    CU_ASSERT_EQUAL(level.peak, 0);
+
+}
+
+/**
+ * Test which verifies that the RMS and peak levels of 16-bit PCM data are
+ * measured correctly, including for buffers whose length is not a multiple
+ * of any vectorized block size.
+ */
+void test_audio__level_16bit() {
+
+    unsigned char buffer[2 * 37];
+    guac_audio_level level;
+
+    /* A square wave has equal RMS and peak levels */
+    for (int i = 0; i < 37; i++)
+        write_sample16(buffer + i * 2, (i % 2) ? -1000 : 1000);
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 16, &level);
+    CU_ASSERT_EQUAL(level.rms, 1000);
+    CU_ASSERT_EQUAL(level.peak, 1000);
+
+    /* A single loud sample is reflected in the peak but barely in the RMS */
+    for (int i = 0; i < 37; i++)
+        write_sample16(buffer + i * 2, (i == 30) ? -20000 : 10);
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 16, &level);
+    CU_ASSERT_EQUAL(level.peak, 20000);
+    CU_ASSERT(level.rms > 3000 && level.rms < 3500);
+
+    /* Full-scale samples must not overflow */
+    for (int i = 0; i < 37; i++)
+        write_sample16(buffer + i * 2, INT16_MIN);
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 16, &level);
+    CU_ASSERT_EQUAL(level.rms, 32768);
+    CU_ASSERT_EQUAL(level.peak, 32768);
+
+    /* Trailing partial samples are ignored */
+    guac_audio_level_measure(buffer, 3, 16, &level);
+    CU_ASSERT_EQUAL(level.rms, 32768);
+    CU_ASSERT_EQUAL(level.peak, 32768);
+
+}
+
+/**
+ * Test which verifies that the levels of unsigned 8-bit PCM data are measured
+ * relative to 128 and scaled to the range of a signed 16-bit sample.
+ */
+void test_audio__level_8bit() {
+
+    unsigned char buffer[25];
+    guac_audio_level level;
+
+    for (int i = 0; i < sizeof(buffer); i++)
+        buffer[i] = (i % 2) ? 124 : 132;
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 8, &level);
+    CU_ASSERT_EQUAL(level.rms, 1024);
+    CU_ASSERT_EQUAL(level.peak, 1024);
+
+    /* The lowest sample value is the greatest negative magnitude */
+    for (int i = 0; i < sizeof(buffer); i++)
+        buffer[i] = 0;
+
+    guac_audio_level_measure(buffer, sizeof(buffer), 8, &level);
+    CU_ASSERT_EQUAL(level.rms, 32768);
+    CU_ASSERT_EQUAL(level.peak, 32768);
+
+}
@@ -0,0 +1,376 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/flag.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * The number of users that join at once within
+ * test_client__pending_users_burst().
+ */
+#define TEST_PENDING_USERS_BURST_SIZE 8
+
+/**
+ * The number of users that join one after another within
+ * test_client__pending_users_latency().
+ */
+#define TEST_PENDING_USERS_SEQUENCE_LENGTH 3
+
+/**
+ * The maximum number of milliseconds that may elapse between a user joining
+ * and that user being promoted. This is comfortably below the interval at
+ * which pending users were previously checked (250 milliseconds), such that
+ * promotion must be triggered by the user joining.
+ */
+#define TEST_PENDING_USERS_MAX_LATENCY 100
+
+/**
+ * The maximum number of milliseconds to wait for users to be promoted, or for
+ * the pending users thread to become idle, before the test is considered to
+ * have failed. This bounds the duration of a failing test only, and is far
+ * longer than either should ever take.
+ */
+#define TEST_PENDING_USERS_TIMEOUT 10000
+
+/**
+ * The number of milliseconds between checks of whether the pending users
+ * thread has become idle.
+ */
+#define TEST_PENDING_USERS_SETTLE_INTERVAL 50
+
+/**
+ * The number of milliseconds that test_client__pending_users_idle() waits
+ * while no users are joining. This is long enough for the pending users
+ * thread to have woken at least twice if it were to poll at the interval
+ * previously used (250 milliseconds).
+ */
+#define TEST_PENDING_USERS_IDLE_DURATION 600
+
+/**
+ * Bitwise flag set by test_join_pending_handler() each time it is invoked.
+ */
+#define TEST_PENDING_USERS_PROMOTED 1
+
+/**
+ * The state of each test, stored within the data member of the guac_client.
+ */
+typedef struct test_pending_users_state {
+
+    /**
+     * Flag set to TEST_PENDING_USERS_PROMOTED whenever the
+     * join_pending_handler is invoked.
+     */
+    guac_flag promoted;
+
+    /**
+     * The number of times the join_pending_handler has been invoked. The
+     * promoted flag must be locked while accessing this value.
+     */
+    int promotions;
+
+    /**
+     * The total number of users that have been promoted. The promoted flag
+     * must be locked while accessing this value.
+     */
+    int promoted_users;
+
+    /**
+     * The time at which the join_pending_handler was most recently invoked.
+     * The promoted flag must be locked while accessing this value.
+     */
+    guac_timestamp last_promotion;
+
+} test_pending_users_state;
+
+/**
+ * Callback for guac_client_foreach_pending_user() which counts each pending
+ * user.
+ *
+ * @param user
+ *     The pending user.
+ *
+ * @param data
+ *     A pointer to the int counting pending users.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* test_count_pending_user(guac_user* user, void* data) {
+    (*((int*) data))++;
+    return NULL;
+}
+
+/**
+ * Handler invoked by the guac_client when promoting pending users, recording
+ * when that promotion occurred, and the number of users promoted, within the
+ * test state.
+ *
+ * @param client
+ *     The client promoting its pending users.
+ *
+ * @return
+ *     Always zero.
+ */
+static int test_join_pending_handler(guac_client* client) {
+
+    test_pending_users_state* state = (test_pending_users_state*) client->data;
+
+    int users = 0;
+    guac_client_foreach_pending_user(client, test_count_pending_user, &users);
+
+    guac_flag_set_and_lock(&state->promoted, TEST_PENDING_USERS_PROMOTED);
+    state->promotions++;
+    state->promoted_users += users;
+    state->last_promotion = guac_timestamp_current();
+    guac_flag_unlock(&state->promoted);
+
+    return 0;
+
+}
+
+/**
+ * Allocates a new guac_client which records each promotion of pending users
+ * within the given test state.
+ *
+ * @param state
+ *     The test state to initialize and associate with the new client.
+ *
+ * @return
+ *     The newly-allocated guac_client.
+ */
+static guac_client* test_pending_users_client_alloc(
+        test_pending_users_state* state) {
+
+    guac_flag_init(&state->promoted);
+    state->promotions = 0;
+    state->promoted_users = 0;
+    state->last_promotion = 0;
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    client->data = state;
+    client->join_pending_handler = test_join_pending_handler;
+
+    return client;
+
+}
+
+/**
+ * Adds a new user to the given client. Each user is an owner, such that no
+ * notifications are sent to other users when users join or leave.
+ *
+ * @param client
+ *     The client to add a new user to.
+ *
+ * @return
+ *     The newly-allocated user, which must be freed with guac_user_free()
+ *     after the client has been freed.
+ */
+static guac_user* test_pending_users_join(guac_client* client) {
+
+    guac_user* user = guac_user_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(user);
+
+    user->client = client;
+    user->owner = 1;
+
+    CU_ASSERT_EQUAL_FATAL(guac_client_add_user(client, user, 0, NULL), 0);
+    return user;
+
+}
+
+/**
+ * Waits for the given total number of users to have been promoted by the
+ * client associated with the given test state, failing the test if this
+ * does not happen within TEST_PENDING_USERS_TIMEOUT milliseconds.
+ *
+ * @param state
+ *     The test state associated with the client.
+ *
+ * @param users
+ *     The total number of users that must have been promoted.
+ */
+static void test_pending_users_wait(test_pending_users_state* state,
+        int users) {
+
+    guac_timestamp deadline = guac_timestamp_current() + TEST_PENDING_USERS_TIMEOUT;
+
+    guac_flag_lock(&state->promoted);
+    while (state->promoted_users < users) {
+
+        guac_flag_clear(&state->promoted, TEST_PENDING_USERS_PROMOTED);
+        guac_flag_unlock(&state->promoted);
+
+        int remaining = deadline - guac_timestamp_current();
+        CU_ASSERT_TRUE_FATAL(remaining > 0 && guac_flag_timedwait_and_lock(
+                    &state->promoted, TEST_PENDING_USERS_PROMOTED, remaining));
+
+    }
+    guac_flag_unlock(&state->promoted);
+
+}
+
+/**
+ * Returns the CPU time consumed thus far by the thread that promotes the
+ * pending users of the given client. This time does not change while that
+ * thread is blocked.
+ *
+ * @param client
+ *     The client whose pending users thread should be checked. That thread
+ *     must already have been started.
+ *
+ * @return
+ *     The CPU time consumed by the pending users thread, in nanoseconds.
+ */
+static uint64_t test_pending_users_thread_time(guac_client* client) {
+
+    clockid_t clock;
+    CU_ASSERT_EQUAL_FATAL(pthread_getcpuclockid(
+                client->__pending_users_thread, &clock), 0);
+
+    struct timespec current;
+    CU_ASSERT_EQUAL_FATAL(clock_gettime(clock, &current), 0);
+
+    return (uint64_t) current.tv_sec * 1000000000 + current.tv_nsec;
+
+}
+
+/**
+ * Waits for the thread that promotes the pending users of the given client to
+ * block, failing the test if this does not happen within
+ * TEST_PENDING_USERS_TIMEOUT milliseconds.
+ *
+ * @param client
+ *     The client whose pending users thread should be waited on. That thread
+ *     must already have been started.
+ *
+ * @return
+ *     The CPU time consumed by the pending users thread before it blocked, in
+ *     nanoseconds.
+ */
+static uint64_t test_pending_users_settle(guac_client* client) {
+
+    guac_timestamp deadline = guac_timestamp_current() + TEST_PENDING_USERS_TIMEOUT;
+
+    uint64_t previous;
+    uint64_t current = test_pending_users_thread_time(client);
+    do {
+        CU_ASSERT_TRUE_FATAL(guac_timestamp_current() < deadline);
+        guac_timestamp_msleep(TEST_PENDING_USERS_SETTLE_INTERVAL);
+        previous = current;
+        current = test_pending_users_thread_time(client);
+    } while (current != previous);
+
+    return current;
+
+}
+
+/**
+ * Verifies that each user joining a connection is promoted from a pending
+ * user promptly, because that user joined, rather than when a periodic check
+ * next occurs. Users join one after another, each only once the previous user
+ * was promoted, such that each user is promoted separately.
+ */
+void test_client__pending_users_latency() {
+
+    test_pending_users_state state;
+    guac_client* client = test_pending_users_client_alloc(&state);
+
+    guac_user* users[TEST_PENDING_USERS_SEQUENCE_LENGTH];
+    for (int i = 0; i < TEST_PENDING_USERS_SEQUENCE_LENGTH; i++) {
+
+        guac_timestamp joined = guac_timestamp_current();
+        users[i] = test_pending_users_join(client);
+        test_pending_users_wait(&state, i + 1);
+
+        guac_flag_lock(&state.promoted);
+        CU_ASSERT(state.last_promotion - joined < TEST_PENDING_USERS_MAX_LATENCY);
+        guac_flag_unlock(&state.promoted);
+
+    }
+
+    guac_client_free(client);
+    for (int i = 0; i < TEST_PENDING_USERS_SEQUENCE_LENGTH; i++)
+        guac_user_free(users[i]);
+
+    CU_ASSERT_EQUAL(state.promotions, TEST_PENDING_USERS_SEQUENCE_LENGTH);
+    guac_flag_destroy(&state.promoted);
+
+}
+
+/**
+ * Verifies that a burst of users joining a connection at the same time are
+ * all promoted, with the join_pending_handler invoked no more than once for
+ * each user.
+ */
+void test_client__pending_users_burst() {
+
+    test_pending_users_state state;
+    guac_client* client = test_pending_users_client_alloc(&state);
+
+    guac_user* users[TEST_PENDING_USERS_BURST_SIZE];
+    for (int i = 0; i < TEST_PENDING_USERS_BURST_SIZE; i++)
+        users[i] = test_pending_users_join(client);
+
+    test_pending_users_wait(&state, TEST_PENDING_USERS_BURST_SIZE);
+
+    guac_client_free(client);
+    for (int i = 0; i < TEST_PENDING_USERS_BURST_SIZE; i++)
+        guac_user_free(users[i]);
+
+    CU_ASSERT(state.promotions >= 1);
+    CU_ASSERT(state.promotions <= TEST_PENDING_USERS_BURST_SIZE);
+    CU_ASSERT_EQUAL(state.promoted_users, TEST_PENDING_USERS_BURST_SIZE);
+
+    guac_flag_destroy(&state.promoted);
+
+}
+
+/**
+ * Verifies that the thread promoting pending users does not run at all while
+ * no users are joining, as observed through the CPU time consumed by that
+ * thread.
+ */
+void test_client__pending_users_idle() {
+
+    test_pending_users_state state;
+    guac_client* client = test_pending_users_client_alloc(&state);
+
+    guac_user* user = test_pending_users_join(client);
+    test_pending_users_wait(&state, 1);
+
+    uint64_t idle_time = test_pending_users_settle(client);
+    guac_timestamp_msleep(TEST_PENDING_USERS_IDLE_DURATION);
+    CU_ASSERT_EQUAL(test_pending_users_thread_time(client), idle_time);
+
+    guac_client_free(client);
+    guac_user_free(user);
+
+    CU_ASSERT_EQUAL(state.promotions, 1);
+    guac_flag_destroy(&state.promoted);
+
+}
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "display-priv.h"
+#include "guacamole/mem.h"
+#include "guacamole/timestamp.h"
+
+#include <CUnit/CUnit.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Establishes an encoder budget of a single slot, acquires that slot within a
+ * child process that then terminates without releasing it, and verifies that
+ * the slot is released once the lease of that child is closed. A further
+ * child process is then killed while waiting for the slot on behalf of an
+ * interactive display, and the slot must remain available to non-interactive
+ * displays once the lease of that child is closed. As the encoder budget may
+ * be established only once per process, the entire test runs within its own
+ * child process.
+ *
+ * @return
+ *     Zero if the test succeeded, non-zero otherwise.
+ */
+static int test_budget_lease() {
+
+    /* Only the time of the last user input is relevant to the budget, and
+     * the display structure is too large to reside on the stack */
+    guac_display* display = guac_mem_zalloc(sizeof(guac_display));
+
+    if (guac_display_set_encoder_budget(1))
+        return 1;
+
+    if (guac_display_encoder_budget_size() != 1)
+        return 1;
+
+    /* The budget may not be established twice */
+    if (!guac_display_set_encoder_budget(1))
+        return 1;
+
+    /* Abandon the only slot within a separate process */
+    uint64_t lease = guac_display_open_encoder_lease();
+    if (lease == 0)
+        return 1;
+
+    pid_t childpid = fork();
+    if (childpid == -1)
+        return 1;
+
+    if (childpid == 0) {
+        guac_display_use_encoder_lease(lease);
+        _exit(guac_display_encoder_acquire(display) == 0 ? 0 : 1);
+    }
+
+    int status;
+    if (waitpid(childpid, &status, 0) != childpid
+            || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return 1;
+
+    /* The abandoned slot must be released with the lease rather than waited
+     * for forever */
+    guac_display_close_encoder_lease(lease);
+
+    int slot = guac_display_encoder_acquire(display);
+    if (slot != 0)
+        return 1;
+
+    /* Kill a process while it waits for the slot on behalf of an interactive
+     * display, which non-interactive displays would otherwise defer to */
+    lease = guac_display_open_encoder_lease();
+    if (lease == 0)
+        return 1;
+
+    childpid = fork();
+    if (childpid == -1)
+        return 1;
+
+    if (childpid == 0) {
+        guac_display_use_encoder_lease(lease);
+        display->last_user_input = guac_timestamp_current();
+        guac_display_encoder_acquire(display);
+        _exit(1);
+    }
+
+    /* Give the child a chance to begin waiting (the test passes regardless
+     * of whether it has) */
+    guac_timestamp_msleep(100);
+
+    if (kill(childpid, SIGKILL) || waitpid(childpid, &status, 0) != childpid)
+        return 1;
+
+    guac_display_close_encoder_lease(lease);
+    guac_display_encoder_release(slot);
+
+    slot = guac_display_encoder_acquire(display);
+    if (slot != 0)
+        return 1;
+
+    guac_display_encoder_release(slot);
+    guac_mem_free(display);
+    return 0;
+
+}
+
+/**
+ * Verifies that a slot of an encoder budget established prior to creating a
+ * child process is shared with that process, and that slots and waiters of
+ * terminated processes are released when their leases are closed.
+ */
+void test_display__encoder_budget() {
+
+    pid_t childpid;
+    CU_ASSERT_NOT_EQUAL_FATAL((childpid = fork()), -1);
+
+    if (childpid == 0)
+        _exit(test_budget_lease());
+
+    int status;
+    CU_ASSERT_EQUAL_FATAL(waitpid(childpid, &status, 0), childpid);
+    CU_ASSERT_TRUE(WIFEXITED(status));
+    CU_ASSERT_EQUAL(WEXITSTATUS(status), 0);
+
+}
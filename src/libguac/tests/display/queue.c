@@ -0,0 +1,270 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "display-priv.h"
+
+#include <CUnit/CUnit.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The number of threads adding operations to the queue under test.
+ */
+#define TEST_PRODUCERS 4
+
+/**
+ * The number of threads removing operations from the queue under test.
+ */
+#define TEST_CONSUMERS 4
+
+/**
+ * The number of operations added to the queue by each producer. This is
+ * deliberately larger than the queue itself, such that producers must wait
+ * for space.
+ */
+#define TEST_OPS_PER_PRODUCER (GUAC_DISPLAY_WORKER_FIFO_SIZE / 2 + 1000)
+
+/**
+ * The state shared by all producer and consumer threads.
+ */
+typedef struct test_queue_state {
+
+    /**
+     * The queue under test.
+     */
+    guac_display_queue* queue;
+
+    /**
+     * The number of operations received from each producer, indexed by
+     * producer. Each consumer maintains its own copy, combined only after all
+     * threads have finished.
+     */
+    size_t received[TEST_CONSUMERS][TEST_PRODUCERS];
+
+    /**
+     * The number of operations received by each consumer that arrived out of
+     * order relative to other operations from the same producer.
+     */
+    size_t out_of_order[TEST_CONSUMERS];
+
+} test_queue_state;
+
+/**
+ * The arguments passed to each producer or consumer thread.
+ */
+typedef struct test_queue_thread {
+
+    /**
+     * The state shared by all threads.
+     */
+    test_queue_state* state;
+
+    /**
+     * The index of this thread among the other producers or consumers.
+     */
+    int index;
+
+} test_queue_thread;
+
+/**
+ * Producer thread which adds TEST_OPS_PER_PRODUCER operations to the queue,
+ * each identifying the producer (within dest.left) and sequence number of the
+ * operation (within dest.top).
+ *
+ * @param data
+ *     The test_queue_thread describing this producer.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* test_queue_producer(void* data) {
+
+    test_queue_thread* thread = (test_queue_thread*) data;
+
+    guac_display_plan_operation op = {
+        .type = GUAC_DISPLAY_PLAN_OPERATION_IMG
+    };
+
+    for (int i = 0; i < TEST_OPS_PER_PRODUCER; i++) {
+        op.dest.left = thread->index;
+        op.dest.top = i;
+        guac_display_queue_enqueue(thread->state->queue, &op);
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Consumer thread which removes operations from the queue until an END_FRAME
+ * operation is received, recording the number of operations received from each
+ * producer and verifying that each producer's operations are received in
+ * order.
+ *
+ * @param data
+ *     The test_queue_thread describing this consumer.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* test_queue_consumer(void* data) {
+
+    test_queue_thread* thread = (test_queue_thread*) data;
+    test_queue_state* state = thread->state;
+
+    int last_seen[TEST_PRODUCERS];
+    for (int i = 0; i < TEST_PRODUCERS; i++)
+        last_seen[i] = -1;
+
+    guac_display_plan_operation op;
+    while (guac_display_queue_dequeue(state->queue, &op)) {
+
+        /* Stop once requested */
+        if (op.type == GUAC_DISPLAY_PLAN_END_FRAME)
+            break;
+
+        int producer = op.dest.left;
+
+        /* The operations of any one producer must be dequeued in the order
+         * they were enqueued */
+        if (op.dest.top <= last_seen[producer])
+            state->out_of_order[thread->index]++;
+
+        last_seen[producer] = op.dest.top;
+        state->received[thread->index][producer]++;
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Verifies that every operation added to a guac_display_queue by multiple
+ * concurrent producers is removed exactly once by multiple concurrent
+ * consumers, in order relative to each producer.
+ */
+void test_display__queue_mpmc() {
+
+    guac_display_queue* queue = malloc(sizeof(guac_display_queue));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    guac_display_queue_init(queue);
+
+    test_queue_state* state = calloc(1, sizeof(test_queue_state));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(state);
+    state->queue = queue;
+
+    pthread_t producers[TEST_PRODUCERS];
+    pthread_t consumers[TEST_CONSUMERS];
+    test_queue_thread producer_args[TEST_PRODUCERS];
+    test_queue_thread consumer_args[TEST_CONSUMERS];
+
+    for (int i = 0; i < TEST_CONSUMERS; i++) {
+        consumer_args[i].state = state;
+        consumer_args[i].index = i;
+        CU_ASSERT_EQUAL_FATAL(pthread_create(&consumers[i], NULL,
+                    test_queue_consumer, &consumer_args[i]), 0);
+    }
+
+    for (int i = 0; i < TEST_PRODUCERS; i++) {
+        producer_args[i].state = state;
+        producer_args[i].index = i;
+        CU_ASSERT_EQUAL_FATAL(pthread_create(&producers[i], NULL,
+                    test_queue_producer, &producer_args[i]), 0);
+    }
+
+    for (int i = 0; i < TEST_PRODUCERS; i++)
+        pthread_join(producers[i], NULL);
+
+    /* Stop each consumer once all operations have been dequeued */
+    guac_display_plan_operation stop = {
+        .type = GUAC_DISPLAY_PLAN_END_FRAME
+    };
+
+    for (int i = 0; i < TEST_CONSUMERS; i++)
+        guac_display_queue_enqueue(queue, &stop);
+
+    for (int i = 0; i < TEST_CONSUMERS; i++)
+        pthread_join(consumers[i], NULL);
+
+    /* Every operation must have been received exactly once, in order */
+    for (int producer = 0; producer < TEST_PRODUCERS; producer++) {
+
+        size_t received = 0;
+        for (int consumer = 0; consumer < TEST_CONSUMERS; consumer++)
+            received += state->received[consumer][producer];
+
+        CU_ASSERT_EQUAL(received, TEST_OPS_PER_PRODUCER);
+
+    }
+
+    for (int consumer = 0; consumer < TEST_CONSUMERS; consumer++)
+        CU_ASSERT_EQUAL(state->out_of_order[consumer], 0);
+
+    guac_display_queue_destroy(queue);
+    free(state);
+    free(queue);
+
+}
+
+/**
+ * Thread which attempts to remove a single operation from an empty queue,
+ * returning the result of that attempt.
+ *
+ * @param data
+ *     Pointer to the guac_display_queue to dequeue from.
+ *
+ * @return
+ *     The value returned by guac_display_queue_dequeue(), cast to a pointer.
+ */
+static void* test_queue_blocked_consumer(void* data) {
+    guac_display_plan_operation op;
+    return (void*) (intptr_t) guac_display_queue_dequeue(
+            (guac_display_queue*) data, &op);
+}
+
+/**
+ * Verifies that invalidating a guac_display_queue wakes any consumers blocked
+ * on the empty queue, and that those consumers report failure.
+ */
+void test_display__queue_invalidate() {
+
+    guac_display_queue* queue = malloc(sizeof(guac_display_queue));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(queue);
+    guac_display_queue_init(queue);
+
+    pthread_t consumer;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&consumer, NULL,
+                test_queue_blocked_consumer, queue), 0);
+
+    guac_display_queue_invalidate(queue);
+
+    void* result;
+    pthread_join(consumer, &result);
+    CU_ASSERT_EQUAL((intptr_t) result, 0);
+
+    guac_display_plan_operation op = {
+        .type = GUAC_DISPLAY_PLAN_OPERATION_IMG
+    };
+    CU_ASSERT_EQUAL(guac_display_queue_enqueue(queue, &op), 0);
+
+    guac_display_queue_destroy(queue);
+    free(queue);
+
+}
@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/metrics.h>
+
+#include <stdint.h>
+
+/**
+ * Test which verifies that guac_metrics_observe() records each value within
+ * the histogram bucket whose bounds include that value, while also tracking
+ * the number and sum of all values observed.
+ */
+void test_metrics__observe() {
+
+    guac_metrics* metrics = guac_metrics_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(metrics);
+
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 0);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 1);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 2);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 3);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 1024);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, 1025);
+    guac_metrics_observe(metrics, GUAC_METRICS_FRAME_LATENCY, UINT32_MAX);
+
+    guac_metrics_distribution* latency =
+        &metrics->histograms[GUAC_METRICS_FRAME_LATENCY];
+
+    /* Each value must be counted by the first bucket that bounds it */
+    CU_ASSERT_EQUAL(2, latency->buckets[0]);
+    CU_ASSERT_EQUAL(1, latency->buckets[1]);
+    CU_ASSERT_EQUAL(1, latency->buckets[2]);
+    CU_ASSERT_EQUAL(1, latency->buckets[10]);
+    CU_ASSERT_EQUAL(1, latency->buckets[11]);
+    CU_ASSERT_EQUAL(1, latency->buckets[GUAC_METRICS_BUCKETS - 1]);
+
+    CU_ASSERT_EQUAL(7, latency->count);
+    CU_ASSERT_EQUAL(0 + 1 + 2 + 3 + 1024 + 1025 + (uint64_t) UINT32_MAX,
+            latency->sum);
+
+    /* Bucket bounds must match the buckets values are counted in */
+    CU_ASSERT_EQUAL(1, guac_metrics_bucket_bound(0));
+    CU_ASSERT_EQUAL(1024, guac_metrics_bucket_bound(10));
+    CU_ASSERT_EQUAL(UINT64_MAX,
+            guac_metrics_bucket_bound(GUAC_METRICS_BUCKETS - 1));
+
+    /* Other histograms must not be affected */
+    CU_ASSERT_EQUAL(0, metrics->histograms[GUAC_METRICS_PROCESSING_LAG].count);
+
+    guac_metrics_free(metrics);
+
+}
+
+/**
+ * Test which verifies that guac_metrics_merge() adds the values of all
+ * counters and histograms, and that guac_metrics_copy() replaces them.
+ */
+void test_metrics__merge() {
+
+    guac_metrics* a = guac_metrics_alloc();
+    guac_metrics* b = guac_metrics_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(a);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+
+    guac_metrics_add(a, GUAC_METRICS_PNG_BYTES, 100);
+    guac_metrics_add(b, GUAC_METRICS_PNG_BYTES, 50);
+    guac_metrics_add(b, GUAC_METRICS_COPIES, 3);
+    guac_metrics_observe(a, GUAC_METRICS_PNG_ENCODE_TIME, 8);
+    guac_metrics_observe(b, GUAC_METRICS_PNG_ENCODE_TIME, 8);
+
+    /* Merged values are the sums of both */
+    guac_metrics_merge(a, b);
+    CU_ASSERT_EQUAL(150, a->counters[GUAC_METRICS_PNG_BYTES]);
+    CU_ASSERT_EQUAL(3, a->counters[GUAC_METRICS_COPIES]);
+    CU_ASSERT_EQUAL(2, a->histograms[GUAC_METRICS_PNG_ENCODE_TIME].buckets[3]);
+    CU_ASSERT_EQUAL(2, a->histograms[GUAC_METRICS_PNG_ENCODE_TIME].count);
+    CU_ASSERT_EQUAL(16, a->histograms[GUAC_METRICS_PNG_ENCODE_TIME].sum);
+
+    /* The source of a merge is unchanged */
+    CU_ASSERT_EQUAL(50, b->counters[GUAC_METRICS_PNG_BYTES]);
+
+    /* Copied values replace existing values */
+    guac_metrics_copy(a, b);
+    CU_ASSERT_EQUAL(50, a->counters[GUAC_METRICS_PNG_BYTES]);
+    CU_ASSERT_EQUAL(1, a->histograms[GUAC_METRICS_PNG_ENCODE_TIME].count);
+
+    /* Updates to a NULL guac_metrics are ignored */
+    guac_metrics_add(NULL, GUAC_METRICS_COPIES, 1);
+    guac_metrics_observe(NULL, GUAC_METRICS_FRAME_LATENCY, 1);
+
+    guac_metrics_free(a);
+    guac_metrics_free(b);
+
+}
+
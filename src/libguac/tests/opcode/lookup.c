@@ -0,0 +1,158 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/opcode.h>
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Arbitrary mapping of opcode to value, matching the layout of the handler
+ * maps used by libguac, guacenc, and guaclog.
+ */
+typedef struct test_opcode_mapping {
+
+    /**
+     * The opcode of this mapping.
+     */
+    const char* opcode;
+
+    /**
+     * Arbitrary value associated with the opcode.
+     */
+    int value;
+
+} test_opcode_mapping;
+
+/**
+ * Map containing the opcodes of all instructions handled by libguac on behalf
+ * of connected users.
+ */
+static test_opcode_mapping test_map[] = {
+    {"sync",        1},
+    {"touch",       2},
+    {"mouse",       3},
+    {"key",         4},
+    {"clipboard",   5},
+    {"disconnect",  6},
+    {"size",        7},
+    {"file",        8},
+    {"pipe",        9},
+    {"ack",        10},
+    {"blob",       11},
+    {"end",        12},
+    {"get",        13},
+    {"put",        14},
+    {"audio",      15},
+    {"argv",       16},
+    {"nop",        17},
+    {NULL,          0}
+};
+
+/**
+ * Map containing opcodes whose hashes are known to collide, having identical
+ * lengths and identical first and last characters.
+ */
+static test_opcode_mapping test_colliding_map[] = {
+    {"sync", 1},
+    {"snyc", 2},
+    {"sxxc", 3},
+    {NULL,   0}
+};
+
+/**
+ * Verifies that each opcode within the given map can be located using a
+ * guac_opcode_index initialized with that map, and that opcodes which are
+ * not within the map cannot be located.
+ *
+ * @param map
+ *     The map to test.
+ */
+static void verify_lookup(test_opcode_mapping* map) {
+
+    guac_opcode_index index;
+    guac_opcode_index_init(&index, map, sizeof(test_opcode_mapping));
+
+    /* Every defined opcode must map to its own entry */
+    for (test_opcode_mapping* current = map; current->opcode != NULL;
+            current++) {
+
+        /* Use a copy such that pointer equality alone cannot succeed */
+        char opcode[32];
+        strcpy(opcode, current->opcode);
+
+        const test_opcode_mapping* found = guac_opcode_index_lookup(&index,
+                map, sizeof(test_opcode_mapping), opcode);
+
+        CU_ASSERT_PTR_EQUAL(found, current);
+
+    }
+
+    /* Undefined opcodes must not be found */
+    CU_ASSERT_PTR_NULL(guac_opcode_index_lookup(&index, map,
+                sizeof(test_opcode_mapping), ""));
+    CU_ASSERT_PTR_NULL(guac_opcode_index_lookup(&index, map,
+                sizeof(test_opcode_mapping), "img"));
+    CU_ASSERT_PTR_NULL(guac_opcode_index_lookup(&index, map,
+                sizeof(test_opcode_mapping), "sxnc"));
+    CU_ASSERT_PTR_NULL(guac_opcode_index_lookup(&index, map,
+                sizeof(test_opcode_mapping), "synchronize"));
+
+}
+
+/**
+ * Test which verifies that guac_opcode_index_lookup() locates the entry for
+ * each opcode handled by libguac on behalf of users.
+ */
+void test_opcode__lookup() {
+    verify_lookup(test_map);
+}
+
+/**
+ * Test which verifies that guac_opcode_index_lookup() correctly locates
+ * entries whose opcodes have colliding hashes.
+ */
+void test_opcode__lookup_colliding() {
+    verify_lookup(test_colliding_map);
+}
+
+/**
+ * Test which verifies that guac_opcode_hash() produces distinct values for
+ * each opcode handled by libguac on behalf of users, such that no lookup of
+ * those opcodes requires more than one string comparison.
+ */
+void test_opcode__hash_distinct() {
+
+    int used[GUAC_OPCODE_INDEX_SIZE] = { 0 };
+
+    for (test_opcode_mapping* current = test_map; current->opcode != NULL;
+            current++) {
+
+        unsigned int hash = guac_opcode_hash(current->opcode,
+                strlen(current->opcode));
+
+        CU_ASSERT_FATAL(hash < GUAC_OPCODE_INDEX_SIZE);
+        CU_ASSERT_EQUAL(used[hash], 0);
+        used[hash] = 1;
+
+    }
+
+}
+
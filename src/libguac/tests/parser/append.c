@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 /**
@@ -75,3 +76,67 @@ void test_parser__append() {
 
 }
 
+
+/**
+ * Test string which contains exactly four Unicode characters encoded in UTF-8,
+ * several of which encode to multiple bytes.
+ */
+#define UTF8_4 "\xe7\x8a\xac\xf0\x90\xac\x80z\xc3\xa1"
+
+/**
+ * Test which verifies that guac_parser correctly parses Guacamole instructions
+ * containing long runs of ASCII interrupted by multibyte characters, regardless
+ * of how the instruction is split across calls to guac_parser_append().
+ */
+void test_parser__append_split() {
+
+    const char instruction[] =
+        "4.blob,1.5,44.ABCDEFGHIJKLMNOPQRSTUVWXYZ" UTF8_4 "abcdefghijklmn;";
+
+    /* Parse instruction using every possible chunk size */
+    int instruction_length = sizeof(instruction) - 1;
+    for (int chunk = 1; chunk <= instruction_length; chunk++) {
+
+        guac_parser* parser = guac_parser_alloc();
+        CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+        char buffer[sizeof(instruction)];
+        memcpy(buffer, instruction, sizeof(instruction));
+
+        /* Provide at most "chunk" more bytes with each call */
+        char* current = buffer;
+        int available = 0;
+        int remaining = instruction_length;
+        while (parser->state != GUAC_PARSE_COMPLETE
+                && parser->state != GUAC_PARSE_ERROR) {
+
+            int new_data = remaining - available;
+            available += (new_data < chunk) ? new_data : chunk;
+
+            int parsed = guac_parser_append(parser, current, available);
+            current += parsed;
+            available -= parsed;
+            remaining -= parsed;
+
+            /* Stop if no progress is possible */
+            if (parsed == 0 && available == remaining)
+                break;
+
+        }
+
+        /* Entire instruction must be parsed */
+        CU_ASSERT_EQUAL(remaining, 0);
+        CU_ASSERT_EQUAL_FATAL(parser->state, GUAC_PARSE_COMPLETE);
+
+        /* Validate resulting content */
+        CU_ASSERT_EQUAL_FATAL(parser->argc, 2);
+        CU_ASSERT_STRING_EQUAL(parser->opcode, "blob");
+        CU_ASSERT_STRING_EQUAL(parser->argv[0], "5");
+        CU_ASSERT_STRING_EQUAL(parser->argv[1],
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZ" UTF8_4 "abcdefghijklmn");
+
+        guac_parser_free(parser);
+
+    }
+
+}
@@ -0,0 +1,287 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <CUnit/CUnit.h>
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+#include <guacamole/socket.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Test string which contains exactly four Unicode characters encoded in UTF-8,
+ * each of which encodes to four bytes.
+ */
+#define UTF8_4x4 "\xf0\x90\xac\x80\xf0\x90\xac\x81\xf0\x90\xac\x82\xf0\x90\xac\x83"
+
+/**
+ * The number of four-byte characters within each element of the large
+ * instruction written by write_large_instruction(). Each element is thus the
+ * maximum permitted length, and the overall instruction is larger than
+ * GUAC_PARSER_INITIAL_BUFFER_SIZE.
+ */
+#define LARGE_ELEMENT_LENGTH GUAC_INSTRUCTION_MAX_LENGTH
+
+/**
+ * The number of large elements within the large instruction written by
+ * write_large_instruction(), not including the opcode.
+ */
+#define LARGE_ELEMENT_COUNT 3
+
+/**
+ * The number of small instructions written by write_small_instructions().
+ */
+#define SMALL_INSTRUCTION_COUNT 100
+
+/**
+ * Writes the given buffer in its entirety to the given file descriptor.
+ *
+ * @param fd
+ *     The file descriptor to write to.
+ *
+ * @param buffer
+ *     The data to write.
+ *
+ * @param length
+ *     The number of bytes to write.
+ */
+static void write_all(int fd, const char* buffer, int length) {
+
+    while (length > 0) {
+
+        /* Bail out immediately if write fails (test will fail in parent
+         * process due to failure to read) */
+        int written = write(fd, buffer, length);
+        if (written <= 0)
+            break;
+
+        buffer += written;
+        length -= written;
+
+    }
+
+}
+
+/**
+ * Writes SMALL_INSTRUCTION_COUNT "mouse" instructions, followed by the first
+ * half of one further instruction, to the given file descriptor as a single
+ * write. The given file descriptor is automatically closed as a result of
+ * calling this function.
+ *
+ * @param fd
+ *     The file descriptor to write instructions to.
+ */
+static void write_small_instructions(int fd) {
+
+    char buffer[SMALL_INSTRUCTION_COUNT * 32 + 32];
+    int length = 0;
+
+    for (int i = 0; i < SMALL_INSTRUCTION_COUNT; i++)
+        length += sprintf(buffer + length, "5.mouse,3.%03i,1.0,1.0;", i);
+
+    length += sprintf(buffer + length, "4.sync,");
+
+    write_all(fd, buffer, length);
+    close(fd);
+
+}
+
+/**
+ * Writes a single instruction having LARGE_ELEMENT_COUNT arguments, each
+ * consisting of LARGE_ELEMENT_LENGTH four-byte UTF-8 characters, to the given
+ * file descriptor. The given file descriptor is automatically closed as a
+ * result of calling this function.
+ *
+ * @param fd
+ *     The file descriptor to write the instruction to.
+ */
+static void write_large_instruction(int fd) {
+
+    int element_size = LARGE_ELEMENT_LENGTH * 4;
+    char* element = malloc(element_size);
+    for (int i = 0; i < element_size; i += sizeof(UTF8_4x4) - 1)
+        memcpy(element + i, UTF8_4x4, sizeof(UTF8_4x4) - 1);
+
+    char prefix[32];
+    write_all(fd, "5.large", 7);
+
+    for (int i = 0; i < LARGE_ELEMENT_COUNT; i++) {
+        write_all(fd, prefix, sprintf(prefix, ",%i.", LARGE_ELEMENT_LENGTH));
+        write_all(fd, element, element_size);
+    }
+
+    write_all(fd, ";", 1);
+
+    free(element);
+    close(fd);
+
+}
+
+/**
+ * Forks a child process which writes data using the given function to a new
+ * pipe, returning the read end of that pipe.
+ *
+ * @param writer
+ *     The function which should write data to the given file descriptor
+ *     within the child process.
+ *
+ * @return
+ *     The file descriptor of the read end of the pipe.
+ */
+static int fork_writer(void (*writer)(int fd)) {
+
+    int fd[2];
+
+    /* Create pipe */
+    CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+
+    int read_fd = fd[0];
+    int write_fd = fd[1];
+
+    /* Fork into writer process (child) and reader process (parent) */
+    int childpid;
+    CU_ASSERT_NOT_EQUAL_FATAL((childpid = fork()), -1);
+
+    /* Write within the child process */
+    if (childpid == 0) {
+        close(read_fd);
+        writer(write_fd);
+        exit(0);
+    }
+
+    close(write_fd);
+    return read_fd;
+
+}
+
+/**
+ * Callback for guac_parser_read_batch() which verifies that each instruction
+ * is the next expected "mouse" instruction.
+ *
+ * @param parser
+ *     The parser which read the instruction.
+ *
+ * @param data
+ *     Pointer to an int containing the number of instructions handled so far.
+ *
+ * @return
+ *     Always zero.
+ */
+static int verify_mouse_instruction(guac_parser* parser, void* data) {
+
+    int* handled = (int*) data;
+
+    char expected[8];
+    sprintf(expected, "%03i", *handled);
+
+    CU_ASSERT_STRING_EQUAL(parser->opcode, "mouse");
+    CU_ASSERT_EQUAL_FATAL(parser->argc, 3);
+    CU_ASSERT_STRING_EQUAL(parser->argv[0], expected);
+
+    (*handled)++;
+    return 0;
+
+}
+
+/**
+ * Callback for guac_parser_read_batch() which requests that handling stop
+ * immediately.
+ *
+ * @param parser
+ *     The parser which read the instruction.
+ *
+ * @param data
+ *     Pointer to an int containing the number of instructions handled so far.
+ *
+ * @return
+ *     Always non-zero.
+ */
+static int stop_handling(guac_parser* parser, void* data) {
+    (*((int*) data))++;
+    return 1;
+}
+
+/**
+ * Tests that guac_parser_read_batch() handles every complete instruction
+ * received, leaving any trailing partial instruction buffered, and stops
+ * handling instructions if requested by the callback.
+ */
+void test_parser__read_batch() {
+
+    int handled = 0;
+    int fd = fork_writer(write_small_instructions);
+
+    guac_socket* socket = guac_socket_open(fd);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+
+    guac_parser* parser = guac_parser_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+    /* All complete instructions must be handled, regardless of how many
+     * reads are required */
+    while (handled < SMALL_INSTRUCTION_COUNT) {
+        int retval = guac_parser_read_batch(parser, socket, 1000000,
+                verify_mouse_instruction, &handled);
+        CU_ASSERT_FATAL(retval >= 0);
+    }
+
+    CU_ASSERT_EQUAL(handled, SMALL_INSTRUCTION_COUNT);
+
+    /* The trailing partial instruction must never be handled */
+    CU_ASSERT_EQUAL(guac_parser_read_batch(parser, socket, 1000000,
+                stop_handling, &handled), -1);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_CLOSED);
+    CU_ASSERT_EQUAL(handled, SMALL_INSTRUCTION_COUNT);
+
+    guac_parser_free(parser);
+    guac_socket_free(socket);
+
+}
+
+/**
+ * Tests that guac_parser_read() grows its internal buffer to read an
+ * instruction larger than GUAC_PARSER_INITIAL_BUFFER_SIZE.
+ */
+void test_parser__read_large() {
+
+    int fd = fork_writer(write_large_instruction);
+
+    guac_socket* socket = guac_socket_open(fd);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+
+    guac_parser* parser = guac_parser_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+    CU_ASSERT_EQUAL_FATAL(guac_parser_read(parser, socket, 1000000), 0);
+    CU_ASSERT_STRING_EQUAL(parser->opcode, "large");
+    CU_ASSERT_EQUAL_FATAL(parser->argc, LARGE_ELEMENT_COUNT);
+
+    for (int i = 0; i < LARGE_ELEMENT_COUNT; i++) {
+        CU_ASSERT_EQUAL(strlen(parser->argv[i]), LARGE_ELEMENT_LENGTH * 4);
+        CU_ASSERT_EQUAL(memcmp(parser->argv[i], UTF8_4x4,
+                    sizeof(UTF8_4x4) - 1), 0);
+    }
+
+    guac_parser_free(parser);
+    guac_socket_free(socket);
+
+}
+
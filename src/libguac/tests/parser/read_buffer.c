@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+
+#include <stdlib.h>
+
+/**
+ * Test string which contains exactly four Unicode characters encoded in UTF-8.
+ * This particular test string uses several characters which encode to multiple
+ * bytes in UTF-8.
+ */
+#define UTF8_4 "\xe7\x8a\xac\xf0\x90\xac\x80z\xc3\xa1"
+
+/**
+ * Test which verifies that guac_parser_read_buffer() correctly parses each
+ * Guacamole instruction in place from a buffer containing several complete
+ * instructions followed by a truncated instruction.
+ */
+void test_parser__read_buffer() {
+
+    /* Allocate parser */
+    guac_parser* parser = guac_parser_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+    /* Instruction input */
+    char buffer[] = "4.test,6.a" UTF8_4 "b,"
+                    "5.12345,10.a" UTF8_4 UTF8_4 "c;"
+                    "5.test2,10.hellohello,15.worldworldworld;"
+                    "5.test3,4.trun";
+
+    char* current = buffer;
+    int remaining = sizeof(buffer) - 1;
+
+    /* Read first instruction */
+    int length = guac_parser_read_buffer(parser, current, remaining);
+    CU_ASSERT_EQUAL_FATAL(length, 56);
+    CU_ASSERT_EQUAL(parser->state, GUAC_PARSE_COMPLETE);
+
+    /* Validate first instruction, which must point into the buffer */
+    CU_ASSERT_EQUAL_FATAL(parser->argc, 3);
+    CU_ASSERT_PTR_EQUAL(parser->opcode, current + 2);
+    CU_ASSERT_STRING_EQUAL(parser->opcode, "test");
+    CU_ASSERT_STRING_EQUAL(parser->argv[0], "a" UTF8_4 "b");
+    CU_ASSERT_STRING_EQUAL(parser->argv[1], "12345");
+    CU_ASSERT_STRING_EQUAL(parser->argv[2], "a" UTF8_4 UTF8_4 "c");
+
+    current += length;
+    remaining -= length;
+
+    /* Read and validate second instruction */
+    length = guac_parser_read_buffer(parser, current, remaining);
+    CU_ASSERT_EQUAL_FATAL(length, 41);
+    CU_ASSERT_EQUAL_FATAL(parser->argc, 2);
+    CU_ASSERT_STRING_EQUAL(parser->opcode, "test2");
+    CU_ASSERT_STRING_EQUAL(parser->argv[0], "hellohello");
+    CU_ASSERT_STRING_EQUAL(parser->argv[1], "worldworldworld");
+
+    current += length;
+    remaining -= length;
+
+    /* Truncated final instruction must be reported as end of data */
+    CU_ASSERT_EQUAL(guac_parser_read_buffer(parser, current, remaining), -1);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_CLOSED);
+
+    /* Nothing at all remaining is also end of data */
+    CU_ASSERT_EQUAL(guac_parser_read_buffer(parser, current, 0), -1);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_CLOSED);
+
+    guac_parser_free(parser);
+
+}
+
+/**
+ * Test which verifies that guac_parser_read_buffer() reports malformed
+ * instruction data as a protocol error.
+ */
+void test_parser__read_buffer_invalid() {
+
+    /* Allocate parser */
+    guac_parser* parser = guac_parser_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+    char buffer[] = "4.test,x.invalid;";
+    CU_ASSERT_EQUAL(guac_parser_read_buffer(parser, buffer,
+                sizeof(buffer) - 1), -1);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_PROTOCOL_ERROR);
+
+    guac_parser_free(parser);
+
+}
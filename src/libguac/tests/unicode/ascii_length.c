@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/unicode.h>
+
+/**
+ * A single Unicode character encoded as two bytes with UTF-8.
+ */
+#define UTF8_2b "\xc4\xa3"
+
+/**
+ * Forty bytes of ASCII, spanning more than one 16-byte block.
+ */
+#define ASCII_40 "0123456789abcdefghijklmnopqrstuvwxyzABCD"
+
+/**
+ * Test which verifies that guac_utf8_ascii_length() properly locates the end
+ * of the run of ASCII at the beginning of a buffer, regardless of where the
+ * first non-ASCII byte falls relative to any block boundary.
+ */
+void test_unicode__utf8_ascii_length() {
+
+    const char ascii[] = ASCII_40;
+    const char mixed[] = ASCII_40 UTF8_2b ASCII_40;
+
+    /* Buffers which are entirely ASCII */
+    CU_ASSERT_EQUAL(0, guac_utf8_ascii_length(ascii, 0));
+    CU_ASSERT_EQUAL(1, guac_utf8_ascii_length(ascii, 1));
+    CU_ASSERT_EQUAL(40, guac_utf8_ascii_length(ascii, 40));
+
+    /* Buffers beginning with a multibyte character */
+    CU_ASSERT_EQUAL(0, guac_utf8_ascii_length(UTF8_2b, 2));
+    CU_ASSERT_EQUAL(0, guac_utf8_ascii_length(mixed + 40, 42));
+
+    /* Non-ASCII byte at every possible offset */
+    for (int offset = 0; offset <= 40; offset++) {
+        CU_ASSERT_EQUAL(40 - offset,
+                guac_utf8_ascii_length(mixed + offset, sizeof(mixed) - 1 - offset));
+    }
+
+    /* Length must be respected even if followed by ASCII */
+    CU_ASSERT_EQUAL(17, guac_utf8_ascii_length(mixed, 17));
+
+}
+
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "guacamole/trace.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef ENABLE_TRACE
+
+/**
+ * The names of all types of events, indexed by guac_trace_type.
+ */
+static const char GUAC_TRACE_NAMES[GUAC_TRACE_TYPES][GUAC_TRACE_NAME_LENGTH] = {
+    [GUAC_TRACE_END_FRAMES]    = "end_frames",
+    [GUAC_TRACE_PLAN_CREATE]   = "plan_create",
+    [GUAC_TRACE_PLAN_RECTS]    = "plan_rects",
+    [GUAC_TRACE_PLAN_COPIES]   = "plan_copies",
+    [GUAC_TRACE_PLAN_COMBINE]  = "plan_combine",
+    [GUAC_TRACE_FRAME_COMMIT]  = "frame_commit",
+    [GUAC_TRACE_PLAN_APPLY]    = "plan_apply",
+    [GUAC_TRACE_ENCODE]        = "encode",
+    [GUAC_TRACE_END_FRAME]     = "end_frame",
+    [GUAC_TRACE_LAG_WAIT]      = "lag_wait",
+    [GUAC_TRACE_SOCKET_FLUSH]  = "socket_flush",
+    [GUAC_TRACE_COALESCE]      = "coalesce"
+};
+
+/**
+ * The most recent GUAC_TRACE_RING_SIZE events recorded by the current
+ * process. The event at index N % GUAC_TRACE_RING_SIZE is the Nth event
+ * recorded.
+ */
+static guac_trace_event guac_trace_ring[GUAC_TRACE_RING_SIZE];
+
+/**
+ * The total number of events recorded by the current process.
+ *
+ * IMPORTANT: This value must only be accessed using atomic operations.
+ */
+static uint64_t guac_trace_recorded = 0;
+
+void guac_trace_record(guac_trace_type type, uint64_t start, uint32_t arg) {
+
+    uint64_t end = guac_metrics_current_usec();
+    uint64_t duration = end > start ? end - start : 0;
+
+    /* Claim the slot of the oldest event */
+    uint64_t index = __atomic_fetch_add(&guac_trace_recorded, 1,
+            __ATOMIC_RELAXED);
+
+    guac_trace_event* event = &guac_trace_ring[index % GUAC_TRACE_RING_SIZE];
+    event->start = start;
+    event->thread = (uint64_t) pthread_self();
+    event->duration = duration > UINT32_MAX ? UINT32_MAX : duration;
+    event->type = type;
+    event->arg = arg;
+    event->reserved = 0;
+
+}
+
+/**
+ * Writes the entire contents of the given buffer to the given file
+ * descriptor, retrying as necessary. This function is async-signal-safe.
+ *
+ * @param fd
+ *     The file descriptor to write to.
+ *
+ * @param buffer
+ *     The buffer to write.
+ *
+ * @param length
+ *     The number of bytes within the buffer.
+ *
+ * @return
+ *     Zero if the entire buffer was written, non-zero otherwise.
+ */
+static int guac_trace_write_all(int fd, const void* buffer, size_t length) {
+
+    const char* current = buffer;
+    while (length > 0) {
+
+        ssize_t written = write(fd, current, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+
+        current += written;
+        length -= written;
+
+    }
+
+    return 0;
+
+}
+
+int guac_trace_dump(int fd) {
+
+    uint64_t recorded = __atomic_load_n(&guac_trace_recorded, __ATOMIC_RELAXED);
+
+    /* Only the most recent events are retained */
+    uint64_t count = recorded;
+    if (count > GUAC_TRACE_RING_SIZE)
+        count = GUAC_TRACE_RING_SIZE;
+
+    guac_trace_header header = {
+        .types = GUAC_TRACE_TYPES,
+        .events = count
+    };
+    memcpy(header.magic, GUAC_TRACE_MAGIC, sizeof(header.magic));
+
+    if (guac_trace_write_all(fd, &header, sizeof(header))
+            || guac_trace_write_all(fd, GUAC_TRACE_NAMES,
+                sizeof(GUAC_TRACE_NAMES)))
+        return 1;
+
+    /* Write events from oldest to newest, wrapping around the end of the
+     * ring as necessary */
+    size_t first = (recorded - count) % GUAC_TRACE_RING_SIZE;
+    size_t before_wrap = GUAC_TRACE_RING_SIZE - first;
+    if (before_wrap > count)
+        before_wrap = count;
+
+    if (guac_trace_write_all(fd, &guac_trace_ring[first],
+                before_wrap * sizeof(guac_trace_event))
+            || guac_trace_write_all(fd, guac_trace_ring,
+                (count - before_wrap) * sizeof(guac_trace_event)))
+        return 1;
+
+    return 0;
+
+}
+
+#else
+
+int guac_trace_dump(int fd) {
+    errno = ENOSYS;
+    return 1;
+}
+
+#endif
+
@@ -0,0 +1,172 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TRACE_PRIV_H
+#define GUAC_TRACE_PRIV_H
+
+#include "config.h"
+#include "guacamole/metrics.h"
+
+#include <stdint.h>
+
+/**
+ * The number of events retained in memory for the current process. Once this
+ * many events have been recorded, each new event replaces the oldest. This
+ * MUST be a power of two.
+ */
+#define GUAC_TRACE_RING_SIZE 65536
+
+/**
+ * All stages of the render pipeline that may be traced.
+ */
+typedef enum guac_trace_type {
+
+    /**
+     * A call to guac_display_end_multiple_frames(), including all planning
+     * stages and the application of the resulting plan.
+     */
+    GUAC_TRACE_END_FRAMES,
+
+    /**
+     * Creation of the naive display plan covering all changed cells.
+     */
+    GUAC_TRACE_PLAN_CREATE,
+
+    /**
+     * Rewriting of operations that draw a single color as rectangles.
+     */
+    GUAC_TRACE_PLAN_RECTS,
+
+    /**
+     * Indexing of changed cells and rewriting of operations as copies of
+     * previously-sent image data.
+     */
+    GUAC_TRACE_PLAN_COPIES,
+
+    /**
+     * Combining of adjacent operations.
+     */
+    GUAC_TRACE_PLAN_COMBINE,
+
+    /**
+     * Commit of the pending frame, handing its operations to the worker
+     * threads.
+     */
+    GUAC_TRACE_FRAME_COMMIT,
+
+    /**
+     * Sending of all operations of the display plan that do not require
+     * encoding.
+     */
+    GUAC_TRACE_PLAN_APPLY,
+
+    /**
+     * Encoding and sending of a single image by a worker thread. The
+     * argument is the number of pixels encoded.
+     */
+    GUAC_TRACE_ENCODE,
+
+    /**
+     * Sending of a frame boundary by a worker thread, including any wait for
+     * connected users to catch up.
+     */
+    GUAC_TRACE_END_FRAME,
+
+    /**
+     * Waiting for connected users to catch up before rendering further
+     * frames. The argument is the intended wait, in milliseconds.
+     */
+    GUAC_TRACE_LAG_WAIT,
+
+    /**
+     * A call to guac_socket_flush().
+     */
+    GUAC_TRACE_SOCKET_FLUSH,
+
+    /**
+     * Coalescing of modifications into a single frame by a render thread
+     * lacking explicit frame boundaries. The argument is the chosen
+     * coalescing window, in milliseconds.
+     */
+    GUAC_TRACE_COALESCE,
+
+    /**
+     * The number of types of events. This is not a valid type.
+     */
+    GUAC_TRACE_TYPES
+
+} guac_trace_type;
+
+#ifdef ENABLE_TRACE
+
+/**
+ * Begins a traced stage of the render pipeline, declaring a variable with the
+ * given name that stores the start time of that stage. If libguac is built
+ * without tracing, this has no effect.
+ *
+ * @param span
+ *     The name of the variable to declare.
+ */
+#define GUAC_TRACE_BEGIN(span)                                                \
+    uint64_t span = guac_metrics_current_usec()
+
+/**
+ * Ends a traced stage of the render pipeline, recording an event describing
+ * that stage. If libguac is built without tracing, this has no effect.
+ *
+ * @param span
+ *     The name of the variable declared by the GUAC_TRACE_BEGIN() that began
+ *     the stage.
+ *
+ * @param type
+ *     The guac_trace_type of the stage.
+ *
+ * @param arg
+ *     An additional value whose meaning depends on the type of the stage.
+ */
+#define GUAC_TRACE_END(span, type, arg)                                       \
+    guac_trace_record(type, span, arg)
+
+/**
+ * Records a completed stage of the render pipeline within the in-memory trace
+ * of the current process, replacing the oldest event if necessary. This
+ * function is threadsafe and lock-free. This function should not be invoked
+ * directly. Use GUAC_TRACE_BEGIN() and GUAC_TRACE_END() instead.
+ *
+ * @param type
+ *     The type of the stage.
+ *
+ * @param start
+ *     The time that the stage began, as returned by
+ *     guac_metrics_current_usec().
+ *
+ * @param arg
+ *     An additional value whose meaning depends on the type of the stage.
+ */
+void guac_trace_record(guac_trace_type type, uint64_t start, uint32_t arg);
+
+#else
+
+#define GUAC_TRACE_BEGIN(span) do {} while (0)
+#define GUAC_TRACE_END(span, type, arg) do {} while (0)
+
+#endif
+
+#endif
+
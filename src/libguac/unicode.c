@@ -22,6 +22,12 @@
 #include "guacamole/unicode.h"
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 size_t guac_utf8_charsize(unsigned char c) {
 
@@ -68,6 +74,45 @@ size_t guac_utf8_strlen(const char* str) {
 
 }
 
+size_t guac_utf8_ascii_length(const char* buffer, size_t length) {
+
+    size_t offset = 0;
+
+#ifdef __SSE2__
+    /* Test 16 bytes at a time, stopping at the first block containing a byte
+     * with its high bit set */
+    while (length - offset >= sizeof(__m128i)) {
+
+        __m128i block = _mm_loadu_si128((const __m128i*) (buffer + offset));
+        if (_mm_movemask_epi8(block) != 0)
+            break;
+
+        offset += sizeof(__m128i);
+
+    }
+#endif
+
+    /* Test 8 bytes at a time, stopping at the first block containing a byte
+     * with its high bit set */
+    while (length - offset >= sizeof(uint64_t)) {
+
+        uint64_t block;
+        memcpy(&block, buffer + offset, sizeof(block));
+        if (block & 0x8080808080808080ULL)
+            break;
+
+        offset += sizeof(uint64_t);
+
+    }
+
+    /* Locate the exact end of the ASCII run within any remaining bytes */
+    while (offset < length && ((unsigned char) buffer[offset] & 0x80) == 0)
+        offset++;
+
+    return offset;
+
+}
+
 int guac_utf8_write(int codepoint, char* utf8, int length) {
 
     int i;
@@ -22,6 +22,7 @@
 #include "guacamole/mem.h"
 #include "guacamole/client.h"
 #include "guacamole/object.h"
+#include "guacamole/opcode.h"
 #include "guacamole/protocol.h"
 #include "guacamole/stream.h"
 #include "guacamole/string.h"
@@ -29,7 +30,9 @@
 #include "guacamole/user.h"
 #include "user-handlers.h"
 
+#include <assert.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -70,6 +73,39 @@ __guac_instruction_handler_mapping __guac_handshake_handler_map[] = {
     {NULL,       NULL}
 };
 
+/**
+ * Index of all opcodes within __guac_instruction_handler_map.
+ */
+static guac_opcode_index __guac_instruction_handler_index;
+
+/**
+ * Index of all opcodes within __guac_handshake_handler_map.
+ */
+static guac_opcode_index __guac_handshake_handler_index;
+
+/**
+ * Control object which ensures the opcode indexes of the instruction and
+ * handshake handler maps are built exactly once.
+ */
+static pthread_once_t __guac_handler_index_init = PTHREAD_ONCE_INIT;
+
+/**
+ * Builds the opcode indexes for the instruction and handshake handler maps.
+ * This function is invoked once, via pthread_once(), prior to the first
+ * lookup of any handler.
+ */
+static void __guac_build_handler_indexes(void) {
+
+    guac_opcode_index_init(&__guac_instruction_handler_index,
+            __guac_instruction_handler_map,
+            sizeof(__guac_instruction_handler_mapping));
+
+    guac_opcode_index_init(&__guac_handshake_handler_index,
+            __guac_handshake_handler_map,
+            sizeof(__guac_instruction_handler_mapping));
+
+}
+
 /**
  * Parses a 64-bit integer from the given string. It is assumed that the string
  * will contain only decimal digits, with an optional leading minus sign.
@@ -760,16 +796,26 @@ void guac_free_mimetypes(char** mimetypes) {
 int __guac_user_call_opcode_handler(__guac_instruction_handler_mapping* map,
         guac_user* user, const char* opcode, int argc, char** argv) {
 
-    /* For each defined instruction */
-    __guac_instruction_handler_mapping* current = map;
-    while (current->opcode != NULL) {
+    pthread_once(&__guac_handler_index_init, __guac_build_handler_indexes);
+
+    /* Use the index built for the given map. Indexes exist only for the
+     * instruction and handshake handler maps, and an index cannot be used
+     * with any map other than the map it was built from. */
+    const guac_opcode_index* index;
+    if (map == __guac_instruction_handler_map)
+        index = &__guac_instruction_handler_index;
+    else {
+        assert(map == __guac_handshake_handler_map);
+        index = &__guac_handshake_handler_index;
+    }
 
-        /* If recognized, call handler */
-        if (strcmp(opcode, current->opcode) == 0)
-            return current->handler(user, argc, argv);
+    /* If recognized, call handler */
+    const __guac_instruction_handler_mapping* mapping =
+        guac_opcode_index_lookup(index, map,
+                sizeof(__guac_instruction_handler_mapping), opcode);
 
-        current++;
-    }
+    if (mapping != NULL)
+        return mapping->handler(user, argc, argv);
 
     /* If unrecognized, log and ignore */
     guac_user_log(user, GUAC_LOG_DEBUG, "Handler not found for \"%s\"",
@@ -284,10 +284,14 @@ char** guac_copy_mimetypes(char** mimetypes, int count);
  * initial handler lookup table defined in the map that is provided to this
  * function. If an entry for the instruction is found in the provided map,
  * the handler defined in that map will be called and the value returned.  If
- * no match is found, it is silently ignored.
+ * no match is found, it is silently ignored. Entries are located through a
+ * guac_opcode_index built once for each map, such that the cost of this
+ * lookup does not depend on the number or order of mappings.
  *
  * @param map
- *     The array that holds the opcode to handler mappings.
+ *     The array that holds the opcode to handler mappings. This MUST be
+ *     either __guac_instruction_handler_map or __guac_handshake_handler_map,
+ *     as no index exists for any other map. This is checked with assert().
  * 
  * @param user
  *     The user whose handlers should be called.
@@ -115,9 +115,60 @@ static void guac_user_log_handshake_failure(guac_user* user) {
 
 }
 
+/**
+ * Handles a single instruction received from a user by invoking the
+ * corresponding instruction handler. This function is invoked by
+ * guac_parser_read_batch() for each instruction received. If the instruction
+ * handler fails, the failure is logged and the user is stopped.
+ *
+ * @param parser
+ *     The guac_parser which has just read the instruction to be handled.
+ *
+ * @param data
+ *     The guac_user that sent the instruction.
+ *
+ * @return
+ *     Zero if the instruction was handled successfully, non-zero if no
+ *     further instructions should be handled.
+ */
+static int guac_user_input_handle_instruction(guac_parser* parser,
+        void* data) {
+
+    guac_user* user = (guac_user*) data;
+    guac_client* client = user->client;
+
+    /* Stop handling instructions once the user is leaving */
+    if (client->state != GUAC_CLIENT_RUNNING || !user->active)
+        return 1;
+
+    /* Reset guac_error and guac_error_message (user/client handlers are not
+     * guaranteed to set these) */
+    guac_error = GUAC_STATUS_SUCCESS;
+    guac_error_message = NULL;
+
+    /* Call handler, stop on error */
+    if (__guac_user_call_opcode_handler(__guac_instruction_handler_map, 
+            user, parser->opcode, parser->argc, parser->argv)) {
+
+        /* Log error */
+        guac_user_log_guac_error(user, GUAC_LOG_WARNING,
+                "User connection aborted");
+
+        /* Log handler details */
+        guac_user_log(user, GUAC_LOG_DEBUG, "Failing instruction handler in user was \"%s\"", parser->opcode);
+
+        guac_user_stop(user);
+        return 1;
+    }
+
+    return 0;
+
+}
+
 /**
  * The thread which handles all user input, calling event handlers for received
- * instructions.
+ * instructions. All instructions received by each read from the user's socket
+ * are handled together before the socket is read again.
  *
  * @param data
  *     A pointer to a guac_user_input_thread_params structure describing the
@@ -141,8 +192,14 @@ static void* guac_user_input_thread(void* data) {
     /* Guacamole user input loop */
     while (client->state == GUAC_CLIENT_RUNNING && user->active) {
 
-        /* Read instruction, stop on error */
-        if (guac_parser_read(parser, socket, usec_timeout)) {
+        /* Read and handle instructions, stop on error */
+        if (guac_parser_read_batch(parser, socket, usec_timeout,
+                    guac_user_input_handle_instruction, user) < 0) {
+
+            /* Failures of instruction handlers have already been dealt
+             * with */
+            if (client->state != GUAC_CLIENT_RUNNING || !user->active)
+                return NULL;
 
             if (guac_error == GUAC_STATUS_TIMEOUT)
                 guac_user_abort(user, GUAC_PROTOCOL_STATUS_CLIENT_TIMEOUT, "User is not responding.");
@@ -157,26 +214,6 @@ static void* guac_user_input_thread(void* data) {
             return NULL;
         }
 
-        /* Reset guac_error and guac_error_message (user/client handlers are not
-         * guaranteed to set these) */
-        guac_error = GUAC_STATUS_SUCCESS;
-        guac_error_message = NULL;
-
-        /* Call handler, stop on error */
-        if (__guac_user_call_opcode_handler(__guac_instruction_handler_map, 
-                user, parser->opcode, parser->argc, parser->argv)) {
-
-            /* Log error */
-            guac_user_log_guac_error(user, GUAC_LOG_WARNING,
-                    "User connection aborted");
-
-            /* Log handler details */
-            guac_user_log(user, GUAC_LOG_DEBUG, "Failing instruction handler in user was \"%s\"", parser->opcode);
-
-            guac_user_stop(user);
-            return NULL;
-        }
-
     }
 
     return NULL;
@@ -24,6 +24,7 @@
 #include "encode-webp.h"
 #include "guacamole/mem.h"
 #include "guacamole/client.h"
+#include "guacamole/metrics.h"
 #include "guacamole/object.h"
 #include "guacamole/pool.h"
 #include "guacamole/protocol.h"
@@ -259,8 +260,13 @@ void guac_user_stream_png(guac_user* user, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/png", x, y);
 
-    /* Write PNG data */
-    guac_png_write(socket, stream, surface);
+    /* Write PNG data, recording the time taken and amount of data sent */
+    guac_metrics* metrics = user->client->metrics;
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_png_write(socket, stream, surface);
+    if (size > 0)
+        guac_metrics_add(metrics, GUAC_METRICS_PNG_BYTES, size);
+    guac_metrics_observe_since(metrics, GUAC_METRICS_PNG_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -280,8 +286,13 @@ void guac_user_stream_jpeg(guac_user* user, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/jpeg", x, y);
 
-    /* Write JPEG data */
-    guac_jpeg_write(socket, stream, surface, quality);
+    /* Write JPEG data, recording the time taken and amount of data sent */
+    guac_metrics* metrics = user->client->metrics;
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_jpeg_write(socket, stream, surface, quality);
+    if (size > 0)
+        guac_metrics_add(metrics, GUAC_METRICS_JPEG_BYTES, size);
+    guac_metrics_observe_since(metrics, GUAC_METRICS_JPEG_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -302,8 +313,13 @@ void guac_user_stream_webp(guac_user* user, guac_socket* socket,
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/webp", x, y);
 
-    /* Write WebP data */
-    guac_webp_write(socket, stream, surface, quality, lossless);
+    /* Write WebP data, recording the time taken and amount of data sent */
+    guac_metrics* metrics = user->client->metrics;
+    uint64_t start = guac_metrics_current_usec();
+    int size = guac_webp_write(socket, stream, surface, quality, lossless);
+    if (size > 0)
+        guac_metrics_add(metrics, GUAC_METRICS_WEBP_BYTES, size);
+    guac_metrics_observe_since(metrics, GUAC_METRICS_WEBP_ENCODE_TIME, start);
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
@@ -21,9 +21,10 @@
 #include "terminal/terminal.h"
 
 #include <guacamole/client.h>
+#include <guacamole/flag.h>
+#include <guacamole/mem.h>
 #include <libwebsockets.h>
 
-#include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -54,49 +55,139 @@ void guac_kubernetes_receive_data(guac_client* client,
 
 }
 
+/**
+ * Allocates a new, empty frame having the given capacity and appends that
+ * frame to the end of the outbound queue. The lock of the outbound_state flag
+ * of the given Kubernetes client MUST already be held.
+ *
+ * @param kubernetes_client
+ *     The Kubernetes client whose outbound queue should receive the new
+ *     frame.
+ *
+ * @param channel
+ *     The Kubernetes channel on which the frame will be sent, such as
+ *     GUAC_KUBERNETES_CHANNEL_STDIN.
+ *
+ * @param capacity
+ *     The maximum number of bytes of data that the frame may contain,
+ *     excluding the channel index.
+ *
+ * @return
+ *     The newly-allocated frame, which is now the last frame within the
+ *     outbound queue.
+ */
+static guac_kubernetes_frame* guac_kubernetes_enqueue_frame(
+        guac_kubernetes_client* kubernetes_client, int channel,
+        int capacity) {
+
+    guac_kubernetes_frame* frame = guac_mem_alloc(
+            guac_mem_ckd_add_or_die(sizeof(guac_kubernetes_frame), capacity));
+
+    frame->next = NULL;
+    frame->length = 0;
+    frame->capacity = capacity;
+    frame->channel = channel;
+
+    /* Append to end of queue */
+    if (kubernetes_client->outbound_tail != NULL)
+        kubernetes_client->outbound_tail->next = frame;
+    else
+        kubernetes_client->outbound_head = frame;
+
+    kubernetes_client->outbound_tail = frame;
+    return frame;
+
+}
+
+/**
+ * Notifies libwebsockets that a callback is needed to send pending frames.
+ * The lock of the outbound_state flag of the given Kubernetes client MUST
+ * already be held.
+ *
+ * @param kubernetes_client
+ *     The Kubernetes client having pending frames.
+ */
+static void guac_kubernetes_request_write(
+        guac_kubernetes_client* kubernetes_client) {
+    lws_callback_on_writable(kubernetes_client->wsi);
+    lws_cancel_service(kubernetes_client->context);
+}
+
 void guac_kubernetes_send_message(guac_client* client,
         int channel, const char* data, int length) {
 
     guac_kubernetes_client* kubernetes_client =
         (guac_kubernetes_client*) client->data;
 
-    pthread_mutex_lock(&(kubernetes_client->outbound_message_lock));
-
-    /* Add message to buffer if space is available */
-    if (kubernetes_client->outbound_messages_waiting
-            < GUAC_KUBERNETES_MAX_OUTBOUND_MESSAGES) {
+    guac_flag* outbound_state = &(kubernetes_client->outbound_state);
 
-        /* Calculate storage position of next message */
-        int index = (kubernetes_client->outbound_messages_top
-                  + kubernetes_client->outbound_messages_waiting)
-                  % GUAC_KUBERNETES_MAX_OUTBOUND_MESSAGES;
+    /* Messages along channels other than STDIN (such as terminal resize
+     * requests) are small, are not coalesced, and are never delayed */
+    if (channel != GUAC_KUBERNETES_CHANNEL_STDIN) {
 
-        /* Obtain pointer to message slot at calculated position */
-        guac_kubernetes_message* message =
-            &(kubernetes_client->outbound_messages[index]);
+        guac_flag_lock(outbound_state);
 
-        /* Copy details of message into buffer */
-        message->channel = channel;
-        memcpy(message->data, data, length);
-        message->length = length;
+        guac_kubernetes_frame* frame = guac_kubernetes_enqueue_frame(
+                kubernetes_client, channel, length);
 
-        /* One more message is now waiting */
-        kubernetes_client->outbound_messages_waiting++;
+        memcpy(frame->data, data, length);
+        frame->length = length;
+        kubernetes_client->outbound_length += length;
 
-        /* Notify libwebsockets that we need a callback to send pending
-         * messages */
-        lws_callback_on_writable(kubernetes_client->wsi);
-        lws_cancel_service(kubernetes_client->context);
+        guac_kubernetes_request_write(kubernetes_client);
+        guac_flag_unlock(outbound_state);
+        return;
 
     }
 
-    /* Warn if data has to be dropped */
-    else
-        guac_client_log(client, GUAC_LOG_WARNING, "Send buffer could not be "
-                "flushed in time to handle additional data. Outbound "
-                "message dropped.");
+    while (length > 0) {
+
+        /* Wait for space within the outbound queue, dropping the data only if
+         * the connection is closing (the queue will never drain) */
+        if (!guac_flag_timedwait_and_lock(outbound_state,
+                    GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE,
+                    GUAC_KUBERNETES_SERVICE_INTERVAL)) {
+
+            if (client->state != GUAC_CLIENT_RUNNING) {
+                guac_client_log(client, GUAC_LOG_DEBUG, "Connection closed "
+                        "before %i bytes of pending data could be sent.",
+                        length);
+                return;
+            }
+
+            continue;
+
+        }
 
-    pthread_mutex_unlock(&(kubernetes_client->outbound_message_lock));
+        /* Append to the most recent frame if it is an incomplete STDIN
+         * frame, starting a new frame otherwise */
+        guac_kubernetes_frame* frame = kubernetes_client->outbound_tail;
+        if (frame == NULL || frame->channel != channel
+                || frame->length == frame->capacity)
+            frame = guac_kubernetes_enqueue_frame(kubernetes_client, channel,
+                    GUAC_KUBERNETES_MAX_FRAME_SIZE);
+
+        int chunk_length = frame->capacity - frame->length;
+        if (chunk_length > length)
+            chunk_length = length;
+
+        memcpy(frame->data + frame->length, data, chunk_length);
+        frame->length += chunk_length;
+        kubernetes_client->outbound_length += chunk_length;
+
+        data += chunk_length;
+        length -= chunk_length;
+
+        /* Block further STDIN data once the queue is full */
+        if (kubernetes_client->outbound_length
+                >= GUAC_KUBERNETES_MAX_OUTBOUND_SIZE)
+            guac_flag_clear(outbound_state,
+                    GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE);
+
+        guac_kubernetes_request_write(kubernetes_client);
+        guac_flag_unlock(outbound_state);
+
+    }
 
 }
 
@@ -106,37 +197,66 @@ bool guac_kubernetes_write_pending_message(guac_client* client) {
     guac_kubernetes_client* kubernetes_client =
         (guac_kubernetes_client*) client->data;
 
-    pthread_mutex_lock(&(kubernetes_client->outbound_message_lock));
+    guac_flag* outbound_state = &(kubernetes_client->outbound_state);
 
-    /* Send one message from top of buffer */
-    if (kubernetes_client->outbound_messages_waiting > 0) {
+    /* Send frames from top of queue until the connection would block */
+    do {
 
-        /* Obtain pointer to message at top */
-        int top = kubernetes_client->outbound_messages_top;
-        guac_kubernetes_message* message =
-            &(kubernetes_client->outbound_messages[top]);
+        guac_flag_lock(outbound_state);
 
-        /* Write message including channel index */
-        lws_write(kubernetes_client->wsi,
-                ((unsigned char*) message) + LWS_PRE,
-                message->length + 1, LWS_WRITE_BINARY);
+        /* Remove the oldest frame from the queue, such that further STDIN
+         * data will not be appended to a frame that is being written */
+        guac_kubernetes_frame* frame = kubernetes_client->outbound_head;
+        if (frame == NULL) {
+            guac_flag_unlock(outbound_state);
+            break;
+        }
 
-        /* Advance top to next message */
-        kubernetes_client->outbound_messages_top++;
-        kubernetes_client->outbound_messages_top %=
-            GUAC_KUBERNETES_MAX_OUTBOUND_MESSAGES;
+        kubernetes_client->outbound_head = frame->next;
+        if (kubernetes_client->outbound_head == NULL)
+            kubernetes_client->outbound_tail = NULL;
 
-        /* One less message is waiting */
-        kubernetes_client->outbound_messages_waiting--;
+        /* Allow STDIN to resume once the queue is no longer full */
+        kubernetes_client->outbound_length -= frame->length;
+        if (kubernetes_client->outbound_length
+                < GUAC_KUBERNETES_MAX_OUTBOUND_SIZE)
+            guac_flag_set(outbound_state,
+                    GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE);
 
-    }
+        guac_flag_unlock(outbound_state);
 
-    /* Record whether messages remained at time of completion */
-    messages_remain = (kubernetes_client->outbound_messages_waiting > 0);
+        /* Write frame including channel index */
+        lws_write(kubernetes_client->wsi,
+                ((unsigned char*) frame->_padding) + LWS_PRE,
+                frame->length + 1, LWS_WRITE_BINARY);
 
-    pthread_mutex_unlock(&(kubernetes_client->outbound_message_lock));
+        guac_mem_free(frame);
+
+    } while (!lws_send_pipe_choked(kubernetes_client->wsi));
+
+    /* Record whether messages remained at time of completion */
+    guac_flag_lock(outbound_state);
+    messages_remain = (kubernetes_client->outbound_head != NULL);
+    guac_flag_unlock(outbound_state);
 
     return messages_remain;
 
 }
 
+void guac_kubernetes_free_pending_messages(guac_client* client) {
+
+    guac_kubernetes_client* kubernetes_client =
+        (guac_kubernetes_client*) client->data;
+
+    guac_kubernetes_frame* frame = kubernetes_client->outbound_head;
+    while (frame != NULL) {
+        guac_kubernetes_frame* next = frame->next;
+        guac_mem_free(frame);
+        frame = next;
+    }
+
+    kubernetes_client->outbound_head = NULL;
+    kubernetes_client->outbound_tail = NULL;
+    kubernetes_client->outbound_length = 0;
+
+}
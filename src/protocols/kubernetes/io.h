@@ -27,12 +27,19 @@
 #include <stdint.h>
 
 /**
- * The maximum amount of data to include in any particular WebSocket message
- * to Kubernetes. This excludes the storage space required for the channel
- * index.
+ * The maximum amount of data to read from the terminal's STDIN at any one
+ * time. Consecutive reads are coalesced into larger WebSocket frames prior to
+ * being sent to Kubernetes.
  */
 #define GUAC_KUBERNETES_MAX_MESSAGE_SIZE 1024
 
+/**
+ * The maximum amount of data to include in any particular WebSocket frame
+ * sent to Kubernetes. This excludes the storage space required for the
+ * channel index.
+ */
+#define GUAC_KUBERNETES_MAX_FRAME_SIZE 16384
+
 /**
  * The index of the Kubernetes channel used for STDIN.
  */
@@ -54,9 +61,29 @@
 #define GUAC_KUBERNETES_CHANNEL_RESIZE 4
 
 /**
- * An outbound message to be received by Kubernetes over WebSocket.
+ * An outbound WebSocket frame to be received by Kubernetes. Frames are queued
+ * in order of creation, and consecutive writes to the STDIN channel are
+ * appended to the most recently queued frame until that frame is full.
  */
-typedef struct guac_kubernetes_message {
+typedef struct guac_kubernetes_frame {
+
+    /**
+     * The next frame in the outbound queue, or NULL if this is the most
+     * recently queued frame.
+     */
+    struct guac_kubernetes_frame* next;
+
+    /**
+     * The number of bytes of data currently stored within this frame,
+     * excluding the channel index.
+     */
+    int length;
+
+    /**
+     * The maximum number of bytes of data that may be stored within this
+     * frame, excluding the channel index.
+     */
+    int capacity;
 
     /**
      * lws_write() requires leading padding of LWS_PRE bytes to provide
@@ -72,16 +99,11 @@ typedef struct guac_kubernetes_message {
 
     /**
      * The data that should be sent to Kubernetes (along with the channel
-     * index).
-     */
-    char data[GUAC_KUBERNETES_MAX_MESSAGE_SIZE];
-
-    /**
-     * The length of the data to be sent, excluding the channel index.
+     * index). This buffer is exactly "capacity" bytes long.
      */
-    int length;
+    char data[];
 
-} guac_kubernetes_message;
+} guac_kubernetes_frame;
 
 /**
  * Handles data received from Kubernetes over WebSocket, decoding the channel
@@ -102,9 +124,12 @@ void guac_kubernetes_receive_data(guac_client* client,
 /**
  * Requests that the given data be sent along the given channel to the
  * Kubernetes server when the WebSocket connection is next available for
- * writing. If the WebSocket connection has not been available for writing for
- * long enough that the outbound message buffer is full, the request to send
- * this particular message will be dropped.
+ * writing. Data sent along the STDIN channel is coalesced with any STDIN data
+ * that is still pending. If the WebSocket connection has not been available
+ * for writing for long enough that the outbound buffer is full, STDIN data
+ * blocks until space becomes available or the connection is closing, in which
+ * case that data is dropped. Data along all other channels is queued
+ * regardless of the size of the outbound buffer.
  *
  * @param client
  *     The guac_client associated with the Kubernetes connection.
@@ -123,21 +148,33 @@ void guac_kubernetes_send_message(guac_client* client,
         int channel, const char* data, int length);
 
 /**
- * Writes the oldest pending message within the outbound message queue,
- * as scheduled with guac_kubernetes_send_message(), removing that message
- * from the queue. This function MAY NOT be invoked outside the libwebsockets
- * event callback and MUST only be invoked in the context of a
- * LWS_CALLBACK_CLIENT_WRITEABLE event. If no messages are pending, this
+ * Writes pending frames within the outbound queue, as scheduled with
+ * guac_kubernetes_send_message(), removing those frames from the queue.
+ * Frames are written in order until the queue is empty or libwebsockets
+ * reports that the underlying connection cannot accept further data without
+ * blocking. This function MAY NOT be invoked outside the libwebsockets event
+ * callback and MUST only be invoked in the context of a
+ * LWS_CALLBACK_CLIENT_WRITEABLE event. If no frames are pending, this
  * function has no effect.
  *
  * @param client
  *     The guac_client associated with the Kubernetes connection.
  *
  * @return
- *     true if messages still remain to be written within the outbound message
- *     queue, false otherwise.
+ *     true if frames still remain to be written within the outbound queue,
+ *     false otherwise.
  */
 bool guac_kubernetes_write_pending_message(guac_client* client);
 
+/**
+ * Frees all frames remaining within the outbound queue without sending them.
+ * This function should be invoked only after all threads which may send or
+ * write data via the outbound queue have terminated.
+ *
+ * @param client
+ *     The guac_client associated with the Kubernetes connection.
+ */
+void guac_kubernetes_free_pending_messages(guac_client* client);
+
 #endif
 
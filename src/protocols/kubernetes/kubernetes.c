@@ -116,8 +116,8 @@ static int guac_kubernetes_lws_callback(struct lws* wsi,
         /* WebSocket is ready for writing */
         case LWS_CALLBACK_CLIENT_WRITEABLE:
 
-            /* Send any pending messages, requesting another callback if
-             * yet more messages remain */
+            /* Send as many pending messages as possible, requesting another
+             * callback if yet more messages remain */
             if (guac_kubernetes_write_pending_message(client))
                 lws_callback_on_writable(wsi);
             break;
@@ -335,8 +335,10 @@ void* guac_kubernetes_client_thread(void* data) {
         goto fail;
     }
 
-    /* Init outbound message buffer */
-    pthread_mutex_init(&(kubernetes_client->outbound_message_lock), NULL);
+    /* Init outbound message queue, initially empty */
+    guac_flag_init(&(kubernetes_client->outbound_state));
+    guac_flag_set(&(kubernetes_client->outbound_state),
+            GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE);
 
     /* Start input thread */
     if (pthread_create(&(input_thread), NULL, guac_kubernetes_input_thread, (void*) client)) {
@@ -364,6 +366,10 @@ void* guac_kubernetes_client_thread(void* data) {
     guac_client_stop(client);
     pthread_join(input_thread, NULL);
 
+    /* Discard any data which could not be sent */
+    guac_kubernetes_free_pending_messages(client);
+    guac_flag_destroy(&(kubernetes_client->outbound_state));
+
 fail:
 
     /* Kill and free terminal, if allocated */
@@ -26,6 +26,7 @@
 #include "terminal/terminal.h"
 
 #include <guacamole/client.h>
+#include <guacamole/flag.h>
 #include <guacamole/recording.h>
 #include <libwebsockets.h>
 
@@ -38,11 +39,15 @@
 #define GUAC_KUBERNETES_LWS_PROTOCOL "v4.channel.k8s.io"
 
 /**
- * The maximum number of messages to allow within the outbound message buffer.
- * If messages are sent despite the buffer being full, those messages will be
- * dropped.
+ * The number of bytes of pending data beyond which further writes to STDIN
+ * will block until the outbound queue has been partially drained.
  */
-#define GUAC_KUBERNETES_MAX_OUTBOUND_MESSAGES 8
+#define GUAC_KUBERNETES_MAX_OUTBOUND_SIZE 262144
+
+/**
+ * Flag which is set when the outbound queue has room for further STDIN data.
+ */
+#define GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE 1
 
 /**
  * The maximum number of milliseconds to wait for a libwebsockets event to
@@ -71,31 +76,34 @@ typedef struct guac_kubernetes_client {
     struct lws* wsi;
 
     /**
-     * Outbound message ring buffer for outbound WebSocket messages. As
-     * libwebsockets uses an event loop for all operations, outbound messages
-     * may be sent only in context of a particular event received via a
-     * callback. Until that event is received, pending data must accumulate in
-     * a buffer.
+     * The oldest frame within the outbound queue of WebSocket frames, or NULL
+     * if no frames are pending. As libwebsockets uses an event loop for all
+     * operations, outbound frames may be sent only in context of a particular
+     * event received via a callback. Until that event is received, pending
+     * data must accumulate in this queue.
      */
-    guac_kubernetes_message outbound_messages[GUAC_KUBERNETES_MAX_OUTBOUND_MESSAGES];
+    guac_kubernetes_frame* outbound_head;
 
     /**
-     * The number of messages currently waiting in the outbound message
-     * buffer.
+     * The most recently queued frame within the outbound queue, or NULL if no
+     * frames are pending.
      */
-    int outbound_messages_waiting;
+    guac_kubernetes_frame* outbound_tail;
 
     /**
-     * The index of the oldest entry in the outbound message buffer. Newer
-     * messages follow this entry.
+     * The total number of bytes of data currently pending within the
+     * outbound queue.
      */
-    int outbound_messages_top;
+    int outbound_length;
 
     /**
-     * Lock which is acquired when the outbound message buffer is being read
-     * or manipulated.
+     * The current state of the outbound queue. The
+     * GUAC_KUBERNETES_OUTBOUND_SPACE_AVAILABLE flag is set whenever fewer
+     * than GUAC_KUBERNETES_MAX_OUTBOUND_SIZE bytes are pending. The lock of
+     * this flag must be held while the outbound queue is being read or
+     * manipulated.
      */
-    pthread_mutex_t outbound_message_lock;
+    guac_flag outbound_state;
 
     /**
      * The Kubernetes client thread.
@@ -337,12 +337,11 @@ void guac_rdpsnd_wave_handler(guac_rdp_common_svc* svc,
     /* Copy over first four bytes */
     memcpy(buffer, rdpsnd->initial_wave_data, 4);
 
-    /* Write rest of audio packet */
-    if (audio != NULL) {
+    /* Write rest of audio packet, leaving the audio stream to flush once a
+     * full packet has been accumulated or once no further PCM arrives */
+    if (audio != NULL)
         guac_audio_stream_write_pcm(audio, buffer,
                 rdpsnd->incoming_wave_size + 4);
-        guac_audio_stream_flush(audio);
-    }
 
     /* Write Wave Confirmation PDU */
     Stream_Write_UINT8(output_stream, SNDC_WAVECONFIRM);
@@ -363,6 +362,11 @@ void guac_rdpsnd_wave_handler(guac_rdp_common_svc* svc,
 void guac_rdpsnd_close_handler(guac_rdp_common_svc* svc,
         wStream* input_stream, guac_rdpsnd_pdu_header* header) {
 
-    /* Do nothing */
+    guac_rdp_client* rdp_client = (guac_rdp_client*) svc->client->data;
+    guac_audio_stream* audio = rdp_client->audio;
+
+    /* Send any audio still pending, as no further audio will follow */
+    if (audio != NULL)
+        guac_audio_stream_flush(audio);
 
 }
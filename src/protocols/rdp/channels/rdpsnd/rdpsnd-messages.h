@@ -125,7 +125,7 @@ void guac_rdpsnd_wave_handler(guac_rdp_common_svc* svc,
 
 /**
  * Handler for the SNDC_CLOSE (Close) PDU. This PDU is sent when audio
- * streaming has stopped. This PDU is currently ignored by Guacamole. See:
+ * streaming has stopped, and results in any pending audio being flushed. See:
  *
  * https://msdn.microsoft.com/en-us/library/cc240970.aspx
  *
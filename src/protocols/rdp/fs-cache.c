@@ -0,0 +1,462 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "fs.h"
+#include "fs-cache.h"
+
+#include <guacamole/mem.h>
+#include <guacamole/string.h>
+#include <guacamole/timestamp.h>
+#include <winpr/file.h>
+#include <winpr/nt.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+/**
+ * The inotify events which indicate that the listing of a watched directory
+ * may have changed. Writes to files within the directory are observed only
+ * once the file is closed (IN_CLOSE_WRITE) rather than for each write
+ * (IN_MODIFY), such that listings are not repeatedly discarded while a large
+ * file is being written.
+ */
+#define GUAC_RDP_FS_CACHE_EVENTS ( IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE \
+        | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVED_FROM       \
+        | IN_MOVED_TO | IN_ONLYDIR )
+
+/**
+ * Frees the given directory listing and all of its entries.
+ *
+ * @param listing
+ *     The listing to free.
+ */
+static void guac_rdp_fs_dir_listing_free(guac_rdp_fs_dir_listing* listing) {
+
+    for (int i = 0; i < listing->entry_count; i++)
+        guac_mem_free(listing->entries[i].name);
+
+    guac_mem_free(listing->entries);
+    guac_mem_free(listing->path);
+    guac_mem_free(listing);
+
+}
+
+/**
+ * Reads the complete listing of the directory open as the given file
+ * descriptor, retrieving the metadata of each entry. Entries which could not
+ * be opened for reading are omitted, as they could not be opened by the
+ * remote desktop server either. The returned listing has a reference count of
+ * one and is not monitored for changes.
+ *
+ * @param path
+ *     The normalized absolute path of the directory within the virtual
+ *     filesystem.
+ *
+ * @param fd
+ *     A file descriptor for the open directory. This file descriptor is not
+ *     closed or otherwise modified.
+ *
+ * @return
+ *     A newly-allocated listing of the given directory, or NULL if the
+ *     directory cannot be read.
+ */
+static guac_rdp_fs_dir_listing* guac_rdp_fs_dir_listing_read(
+        const char* path, int fd) {
+
+    /* Read using a separate descriptor so that the position of the original
+     * descriptor is not affected */
+    int dir_fd = openat(fd, ".", O_RDONLY | O_DIRECTORY);
+    if (dir_fd == -1)
+        return NULL;
+
+    DIR* dir = fdopendir(dir_fd);
+    if (dir == NULL) {
+        close(dir_fd);
+        return NULL;
+    }
+
+    /* The parent of the root directory is the root directory itself */
+    int is_root = (strcmp(path, "\\") == 0);
+
+    guac_rdp_fs_dir_listing* listing =
+        guac_mem_zalloc(sizeof(guac_rdp_fs_dir_listing));
+
+    listing->path = guac_strdup(path);
+    listing->refcount = 1;
+    listing->watch = -1;
+    listing->loaded = guac_timestamp_current();
+    listing->last_used = listing->loaded;
+
+    int available = 0;
+    struct dirent* current;
+    while ((current = readdir(dir)) != NULL) {
+
+        const char* name = current->d_name;
+        const char* stat_name = name;
+        if (is_root && strcmp(name, "..") == 0)
+            stat_name = ".";
+
+        /* Skip entries which cannot be opened for reading */
+        struct stat entry_stat;
+        if (fstatat(dir_fd, stat_name, &entry_stat, 0)
+                || faccessat(dir_fd, stat_name, R_OK, 0))
+            continue;
+
+        /* Grow entry array as necessary */
+        if (listing->entry_count == available) {
+            available = available ? available * 2 : 64;
+            listing->entries = guac_mem_realloc_or_die(listing->entries,
+                    sizeof(guac_rdp_fs_dir_entry), available);
+        }
+
+        guac_rdp_fs_dir_entry* entry =
+            &listing->entries[listing->entry_count++];
+
+        entry->name  = guac_strdup(name);
+        entry->size  = entry_stat.st_size;
+        entry->ctime = WINDOWS_TIME(entry_stat.st_ctime);
+        entry->mtime = WINDOWS_TIME(entry_stat.st_mtime);
+        entry->atime = WINDOWS_TIME(entry_stat.st_atime);
+
+        if (S_ISDIR(entry_stat.st_mode))
+            entry->attributes = FILE_ATTRIBUTE_DIRECTORY;
+        else
+            entry->attributes = FILE_ATTRIBUTE_NORMAL;
+
+    }
+
+    /* Also closes dir_fd */
+    closedir(dir);
+    return listing;
+
+}
+
+/**
+ * Begins monitoring the directory at the given path for changes, returning
+ * the inotify watch descriptor of that directory. If the directory is already
+ * being monitored, the existing watch descriptor is returned. The cache lock
+ * must already be held.
+ *
+ * @param cache
+ *     The cache which should monitor the directory.
+ *
+ * @param real_path
+ *     The path of the directory on the local filesystem.
+ *
+ * @return
+ *     The inotify watch descriptor of the directory, or -1 if the directory
+ *     cannot be monitored.
+ */
+static int guac_rdp_fs_cache_watch(guac_rdp_fs_cache* cache,
+        const char* real_path) {
+
+#ifdef HAVE_SYS_INOTIFY_H
+    if (cache->inotify_fd != -1)
+        return inotify_add_watch(cache->inotify_fd, real_path,
+                GUAC_RDP_FS_CACHE_EVENTS);
+#endif
+
+    return -1;
+
+}
+
+/**
+ * Stops monitoring the directory having the given inotify watch descriptor,
+ * unless that directory is still cached under some path. The cache lock must
+ * already be held.
+ *
+ * @param cache
+ *     The cache that added the watch.
+ *
+ * @param watch
+ *     The inotify watch descriptor to remove, or -1 if there is no such
+ *     watch.
+ */
+static void guac_rdp_fs_cache_unwatch(guac_rdp_fs_cache* cache, int watch) {
+
+#ifdef HAVE_SYS_INOTIFY_H
+    if (watch == -1)
+        return;
+
+    for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+        if (cache->listings[i] != NULL && cache->listings[i]->watch == watch)
+            return;
+    }
+
+    inotify_rm_watch(cache->inotify_fd, watch);
+#endif
+
+}
+
+/**
+ * Removes the listing at the given index from the cache, releasing the
+ * reference held by the cache. The cache lock must already be held.
+ *
+ * @param cache
+ *     The cache to remove the listing from.
+ *
+ * @param index
+ *     The index of the listing to remove. The slot at this index must not be
+ *     empty.
+ */
+static void guac_rdp_fs_cache_remove(guac_rdp_fs_cache* cache, int index) {
+
+    guac_rdp_fs_dir_listing* listing = cache->listings[index];
+    cache->listings[index] = NULL;
+
+    guac_rdp_fs_cache_unwatch(cache, listing->watch);
+
+    if (--listing->refcount == 0)
+        guac_rdp_fs_dir_listing_free(listing);
+
+}
+
+/**
+ * Removes all cached listings of directories which inotify has reported as
+ * changed. The cache lock must already be held.
+ *
+ * @param cache
+ *     The cache to update.
+ *
+ * @param watch
+ *     The inotify watch descriptor of a directory which is being read but is
+ *     not yet cached, or -1 if there is no such directory.
+ *
+ * @return
+ *     Non-zero if inotify reported that the directory having the given watch
+ *     descriptor may have changed, zero otherwise.
+ */
+static int guac_rdp_fs_cache_process_events(guac_rdp_fs_cache* cache,
+        int watch) {
+
+    int changed = 0;
+
+#ifdef HAVE_SYS_INOTIFY_H
+    if (cache->inotify_fd == -1)
+        return 0;
+
+    char buffer[4096]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    /* Read all pending events without blocking */
+    ssize_t length;
+    while ((length = read(cache->inotify_fd, buffer, sizeof(buffer))) > 0) {
+
+        const char* current = buffer;
+        while (current < buffer + length) {
+
+            const struct inotify_event* event =
+                (const struct inotify_event*) current;
+
+            if ((event->mask & IN_Q_OVERFLOW)
+                    || (watch != -1 && event->wd == watch))
+                changed = 1;
+
+            /* Invalidate affected listings, or all listings if events were
+             * lost */
+            for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+                guac_rdp_fs_dir_listing* listing = cache->listings[i];
+                if (listing != NULL && ((event->mask & IN_Q_OVERFLOW)
+                            || listing->watch == event->wd))
+                    guac_rdp_fs_cache_remove(cache, i);
+            }
+
+            current += sizeof(struct inotify_event) + event->len;
+
+        }
+
+    }
+#endif
+
+    return changed;
+
+}
+
+guac_rdp_fs_cache* guac_rdp_fs_cache_alloc() {
+
+    guac_rdp_fs_cache* cache = guac_mem_zalloc(sizeof(guac_rdp_fs_cache));
+    pthread_mutex_init(&cache->lock, NULL);
+
+#ifdef HAVE_SYS_INOTIFY_H
+    /* Cached listings simply expire if inotify cannot be used */
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+    cache->inotify_fd = -1;
+#endif
+
+    return cache;
+
+}
+
+void guac_rdp_fs_cache_free(guac_rdp_fs_cache* cache) {
+
+    for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+        if (cache->listings[i] != NULL)
+            guac_rdp_fs_cache_remove(cache, i);
+    }
+
+    if (cache->inotify_fd != -1)
+        close(cache->inotify_fd);
+
+    pthread_mutex_destroy(&cache->lock);
+    guac_mem_free(cache);
+
+}
+
+guac_rdp_fs_dir_listing* guac_rdp_fs_cache_get_listing(
+        guac_rdp_fs_cache* cache, const char* path, const char* real_path,
+        int fd) {
+
+    guac_timestamp now = guac_timestamp_current();
+
+    pthread_mutex_lock(&cache->lock);
+    guac_rdp_fs_cache_process_events(cache, -1);
+
+    /* Use cached listing if still valid */
+    for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+
+        guac_rdp_fs_dir_listing* listing = cache->listings[i];
+        if (listing == NULL || strcmp(listing->path, path) != 0)
+            continue;
+
+        /* Listings which are not monitored expire */
+        if (listing->watch == -1
+                && now - listing->loaded > GUAC_RDP_FS_CACHE_TTL) {
+            guac_rdp_fs_cache_remove(cache, i);
+            break;
+        }
+
+        listing->refcount++;
+        listing->last_used = now;
+        pthread_mutex_unlock(&cache->lock);
+        return listing;
+
+    }
+
+    /* Begin monitoring before reading, such that any change made while the
+     * directory is being read is reported */
+    int watch = guac_rdp_fs_cache_watch(cache, real_path);
+
+    unsigned int generation = cache->generation;
+    pthread_mutex_unlock(&cache->lock);
+
+    /* Read listing without blocking other users of the cache */
+    guac_rdp_fs_dir_listing* listing = guac_rdp_fs_dir_listing_read(path, fd);
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* Do not cache the listing if the directory may have changed while it
+     * was being read, including if the watch was removed in the meantime
+     * (re-adding a watch that still exists returns the same descriptor) */
+    int changed = guac_rdp_fs_cache_process_events(cache, watch);
+    if (listing == NULL
+            || listing->entry_count > GUAC_RDP_FS_CACHE_MAX_ENTRIES
+            || changed || cache->generation != generation
+            || guac_rdp_fs_cache_watch(cache, real_path) != watch) {
+        guac_rdp_fs_cache_unwatch(cache, watch);
+        pthread_mutex_unlock(&cache->lock);
+        return listing;
+    }
+
+    /* Replace any listing of the same directory cached in the meantime,
+     * otherwise use an empty slot or evict the least-recently used listing */
+    int index = 0;
+    for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+
+        guac_rdp_fs_dir_listing* current = cache->listings[i];
+        if (current == NULL || strcmp(current->path, path) == 0) {
+            index = i;
+            break;
+        }
+
+        if (current->last_used < cache->listings[index]->last_used)
+            index = i;
+
+    }
+
+    /* The cache holds its own reference */
+    guac_rdp_fs_dir_listing* evicted = cache->listings[index];
+    listing->watch = watch;
+    listing->refcount++;
+    cache->listings[index] = listing;
+
+    /* Release any evicted listing only once the new listing is cached, such
+     * that a watch shared by both remains in place */
+    if (evicted != NULL) {
+        guac_rdp_fs_cache_unwatch(cache, evicted->watch);
+        if (--evicted->refcount == 0)
+            guac_rdp_fs_dir_listing_free(evicted);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return listing;
+
+}
+
+void guac_rdp_fs_cache_release(guac_rdp_fs_cache* cache,
+        guac_rdp_fs_dir_listing* listing) {
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (--listing->refcount == 0)
+        guac_rdp_fs_dir_listing_free(listing);
+
+    pthread_mutex_unlock(&cache->lock);
+
+}
+
+void guac_rdp_fs_cache_invalidate(guac_rdp_fs_cache* cache, const char* path) {
+
+    /* Determine path of parent directory, which is the root directory for
+     * both the root directory itself and its immediate children */
+    char parent[GUAC_RDP_FS_MAX_PATH];
+    guac_strlcpy(parent, path, sizeof(parent));
+
+    char* last_separator = strrchr(parent, '\\');
+    if (last_separator == NULL || last_separator == parent)
+        guac_strlcpy(parent, "\\", sizeof(parent));
+    else
+        *last_separator = '\0';
+
+    pthread_mutex_lock(&cache->lock);
+    cache->generation++;
+
+    for (int i = 0; i < GUAC_RDP_FS_CACHE_SIZE; i++) {
+
+        guac_rdp_fs_dir_listing* listing = cache->listings[i];
+        if (listing != NULL && (strcmp(listing->path, path) == 0
+                    || strcmp(listing->path, parent) == 0))
+            guac_rdp_fs_cache_remove(cache, i);
+
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+}
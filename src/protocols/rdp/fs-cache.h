@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_RDP_FS_CACHE_H
+#define GUAC_RDP_FS_CACHE_H
+
+/**
+ * A bounded cache of directory listings, including the metadata of each
+ * entry, for the virtual filesystem of the Guacamole drive. Listings are
+ * invalidated when modified through guac_rdp_fs, when changes are reported
+ * by inotify (if available), and otherwise after a fixed duration.
+ *
+ * @file fs-cache.h
+ */
+
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * The maximum number of directory listings to retain within the cache.
+ */
+#define GUAC_RDP_FS_CACHE_SIZE 32
+
+/**
+ * The maximum number of entries a directory may contain for its listing to
+ * be retained within the cache. Listings of larger directories are still
+ * loaded in their entirety for the file reading them, but are never shared.
+ */
+#define GUAC_RDP_FS_CACHE_MAX_ENTRIES 8192
+
+/**
+ * The number of milliseconds that a cached directory listing remains valid if
+ * changes to that directory cannot be monitored with inotify.
+ */
+#define GUAC_RDP_FS_CACHE_TTL 5000
+
+/**
+ * A single entry within a directory listing, including the metadata that
+ * would otherwise be retrieved by opening the entry.
+ */
+typedef struct guac_rdp_fs_dir_entry {
+
+    /**
+     * The name of the entry, relative to its containing directory.
+     */
+    char* name;
+
+    /**
+     * The Windows file attributes of the entry, such as
+     * FILE_ATTRIBUTE_DIRECTORY.
+     */
+    int attributes;
+
+    /**
+     * The size of the entry, in bytes.
+     */
+    uint64_t size;
+
+    /**
+     * The time the entry was created, as a Windows timestamp.
+     */
+    uint64_t ctime;
+
+    /**
+     * The time the entry was last modified, as a Windows timestamp.
+     */
+    uint64_t mtime;
+
+    /**
+     * The time the entry was last accessed, as a Windows timestamp.
+     */
+    uint64_t atime;
+
+} guac_rdp_fs_dir_entry;
+
+/**
+ * The complete listing of a single directory.
+ */
+typedef struct guac_rdp_fs_dir_listing {
+
+    /**
+     * The normalized absolute path of the directory within the virtual
+     * filesystem.
+     */
+    char* path;
+
+    /**
+     * All entries within the directory, including the "." and ".." entries,
+     * in the order they were read.
+     */
+    guac_rdp_fs_dir_entry* entries;
+
+    /**
+     * The number of entries within the entries array.
+     */
+    int entry_count;
+
+    /**
+     * The number of references to this listing, including the reference
+     * held by the cache itself while the listing is cached. The listing is
+     * freed once this reaches zero.
+     */
+    int refcount;
+
+    /**
+     * The inotify watch descriptor monitoring the directory for changes, or
+     * -1 if the directory is not being monitored.
+     */
+    int watch;
+
+    /**
+     * The time this listing was read from the directory.
+     */
+    guac_timestamp loaded;
+
+    /**
+     * The time this listing was last retrieved from the cache.
+     */
+    guac_timestamp last_used;
+
+} guac_rdp_fs_dir_listing;
+
+/**
+ * A cache of directory listings shared by all files of a single guac_rdp_fs.
+ */
+typedef struct guac_rdp_fs_cache {
+
+    /**
+     * Lock which is acquired whenever the cache or the reference count of any
+     * listing is accessed, as the filesystem is used both by the RDPDR
+     * channel and by users uploading or downloading files.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * All currently-cached listings, with unused slots set to NULL.
+     */
+    guac_rdp_fs_dir_listing* listings[GUAC_RDP_FS_CACHE_SIZE];
+
+    /**
+     * Non-blocking inotify file descriptor used to monitor cached directories
+     * for changes made outside guac_rdp_fs, or -1 if inotify is unavailable.
+     */
+    int inotify_fd;
+
+    /**
+     * Counter which is incremented each time any listing is invalidated,
+     * allowing a listing read without holding the lock to be discarded
+     * rather than cached if the directory may have changed while it was
+     * being read.
+     */
+    unsigned int generation;
+
+} guac_rdp_fs_cache;
+
+/**
+ * Allocates a new, empty directory listing cache.
+ *
+ * @return
+ *     A newly-allocated directory listing cache, which must eventually be
+ *     freed with guac_rdp_fs_cache_free().
+ */
+guac_rdp_fs_cache* guac_rdp_fs_cache_alloc();
+
+/**
+ * Frees the given directory listing cache, releasing its references to all
+ * cached listings. Listings still referenced elsewhere remain valid until
+ * released.
+ *
+ * @param cache
+ *     The cache to free.
+ */
+void guac_rdp_fs_cache_free(guac_rdp_fs_cache* cache);
+
+/**
+ * Returns a listing of the directory open as the given file descriptor,
+ * retrieving that listing from the cache if a valid listing is cached, and
+ * reading (and caching) the listing otherwise. The returned listing is
+ * unaffected by later invalidation and must be released with
+ * guac_rdp_fs_cache_release() when no longer needed.
+ *
+ * @param cache
+ *     The cache to retrieve the listing from.
+ *
+ * @param path
+ *     The normalized absolute path of the directory within the virtual
+ *     filesystem.
+ *
+ * @param real_path
+ *     The path of the directory on the local filesystem.
+ *
+ * @param fd
+ *     A file descriptor for the open directory. This file descriptor is not
+ *     closed or otherwise modified.
+ *
+ * @return
+ *     A listing of the given directory, or NULL if the directory cannot be
+ *     read.
+ */
+guac_rdp_fs_dir_listing* guac_rdp_fs_cache_get_listing(
+        guac_rdp_fs_cache* cache, const char* path, const char* real_path,
+        int fd);
+
+/**
+ * Releases a reference to the given listing, as previously returned by
+ * guac_rdp_fs_cache_get_listing(), freeing the listing if no references
+ * remain.
+ *
+ * @param cache
+ *     The cache from which the listing was retrieved.
+ *
+ * @param listing
+ *     The listing to release.
+ */
+void guac_rdp_fs_cache_release(guac_rdp_fs_cache* cache,
+        guac_rdp_fs_dir_listing* listing);
+
+/**
+ * Invalidates any cached listing of the directory containing the given path,
+ * as well as any cached listing of the path itself. This must be invoked
+ * whenever the given path is created, deleted, or renamed, and whenever a
+ * file which has been written is closed.
+ *
+ * @param cache
+ *     The cache to invalidate listings within.
+ *
+ * @param path
+ *     The normalized absolute path within the virtual filesystem that has
+ *     been modified.
+ */
+void guac_rdp_fs_cache_invalidate(guac_rdp_fs_cache* cache, const char* path);
+
+#endif
@@ -64,6 +64,7 @@ guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
 
     fs->client = client;
     fs->drive_path = guac_strdup(drive_path);
+    fs->cache = guac_rdp_fs_cache_alloc();
     fs->file_id_pool = guac_pool_alloc(0);
     fs->open_files = 0;
     fs->disable_download = disable_download;
@@ -74,6 +75,7 @@ guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
 }
 
 void guac_rdp_fs_free(guac_rdp_fs* fs) {
+    guac_rdp_fs_cache_free(fs->cache);
     guac_pool_free(fs->file_id_pool);
     guac_mem_free(fs->drive_path);
     guac_mem_free(fs);
@@ -335,6 +337,10 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
             }
         }
 
+        /* Cached listing of parent directory is now out of date */
+        else
+            guac_rdp_fs_cache_invalidate(fs->cache, normalized_path);
+
         /* Unset O_CREAT and O_EXCL as directory must exist before open() */
         flags &= ~(O_CREAT | O_EXCL);
 
@@ -360,16 +366,24 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    /* Cached listing of parent directory may now be out of date */
+    if (flags & (O_CREAT | O_TRUNC))
+        guac_rdp_fs_cache_invalidate(fs->cache, normalized_path);
+
     /* Get file ID, init file */
     file_id = guac_pool_next_int_below_or_die(fs->file_id_pool, GUAC_RDP_FS_MAX_FILES);
     file = &(fs->files[file_id]);
     file->id = file_id;
     file->fd  = fd;
-    file->dir = NULL;
+    file->dir_listing = NULL;
+    file->dir_index = 0;
     file->dir_pattern[0] = '\0';
     file->absolute_path = guac_strdup(normalized_path);
     file->real_path = guac_strdup(real_path);
     file->bytes_written = 0;
+    file->next_read_offset = 0;
+    file->sequential_reads = 0;
+    file->read_ahead_offset = 0;
 
     guac_client_log(fs->client, GUAC_LOG_DEBUG,
             "%s: Opened \"%s\" as file_id=%i",
@@ -410,6 +424,39 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
 
 }
 
+/**
+ * Advises the kernel that the given file is being read sequentially, and that
+ * the GUAC_RDP_FS_READ_AHEAD_SIZE bytes following the given offset will be
+ * needed soon, such that those bytes are read into the page cache before the
+ * RDP server requests them. Only the page cache is involved, thus data read
+ * ahead can never become stale with respect to writes made through other
+ * open files or by other processes.
+ *
+ * @param file
+ *     The file being read sequentially.
+ *
+ * @param offset
+ *     The byte offset within the file of the data about to be read.
+ */
+static void guac_rdp_fs_read_ahead(guac_rdp_fs_file* file, uint64_t offset) {
+
+#ifdef HAVE_POSIX_FADVISE
+    /* Nothing to do if the kernel has already been advised of this range */
+    if (offset + GUAC_RDP_FS_READ_AHEAD_SIZE / 2 < file->read_ahead_offset)
+        return;
+
+    /* Hints only - failure does not affect correctness */
+    if (file->read_ahead_offset == 0)
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    posix_fadvise(file->fd, offset, GUAC_RDP_FS_READ_AHEAD_SIZE,
+            POSIX_FADV_WILLNEED);
+
+    file->read_ahead_offset = offset + GUAC_RDP_FS_READ_AHEAD_SIZE;
+#endif
+
+}
+
 int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
         void* buffer, int length) {
 
@@ -422,14 +469,24 @@ int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
         return GUAC_RDP_FS_EINVAL;
     }
 
+    /* Track whether the file is being read sequentially */
+    if (offset == file->next_read_offset)
+        file->sequential_reads++;
+    else
+        file->sequential_reads = 0;
+
+    /* Read ahead if the file is being read sequentially */
+    if (file->sequential_reads >= GUAC_RDP_FS_SEQUENTIAL_READS)
+        guac_rdp_fs_read_ahead(file, offset);
+
     /* Attempt read */
-    lseek(file->fd, offset, SEEK_SET);
-    bytes_read = read(file->fd, buffer, length);
+    bytes_read = pread(file->fd, buffer, length, offset);
 
     /* Translate errno on error */
     if (bytes_read < 0)
         return guac_rdp_fs_get_errorcode(errno);
 
+    file->next_read_offset = offset + bytes_read;
     return bytes_read;
 
 }
@@ -447,13 +504,15 @@ int guac_rdp_fs_write(guac_rdp_fs* fs, int file_id, uint64_t offset,
     }
 
     /* Attempt write */
-    lseek(file->fd, offset, SEEK_SET);
-    bytes_written = write(file->fd, buffer, length);
+    bytes_written = pwrite(file->fd, buffer, length, offset);
 
     /* Translate errno on error */
     if (bytes_written < 0)
         return guac_rdp_fs_get_errorcode(errno);
 
+    /* The cached listing of the parent directory is invalidated only once
+     * the file is closed, such that the cache remains useful while large
+     * files are being written */
     file->bytes_written += bytes_written;
     return bytes_written;
 
@@ -495,6 +554,10 @@ int guac_rdp_fs_rename(guac_rdp_fs* fs, int file_id,
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    /* Both old and new parent directories have changed */
+    guac_rdp_fs_cache_invalidate(fs->cache, file->absolute_path);
+    guac_rdp_fs_cache_invalidate(fs->cache, normalized_path);
+
     return 0;
 
 }
@@ -525,6 +588,7 @@ int guac_rdp_fs_delete(guac_rdp_fs* fs, int file_id) {
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    guac_rdp_fs_cache_invalidate(fs->cache, file->absolute_path);
     return 0;
 
 }
@@ -547,6 +611,7 @@ int guac_rdp_fs_truncate(guac_rdp_fs* fs, int file_id, int length) {
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    guac_rdp_fs_cache_invalidate(fs->cache, file->absolute_path);
     return 0;
 
 }
@@ -567,9 +632,14 @@ void guac_rdp_fs_close(guac_rdp_fs* fs, int file_id) {
             "%s: Closed \"%s\" (file_id=%i)",
             __func__, file->absolute_path, file_id);
 
-    /* Close directory, if open */
-    if (file->dir != NULL)
-        closedir(file->dir);
+    /* Release directory listing, if read */
+    if (file->dir_listing != NULL)
+        guac_rdp_fs_cache_release(fs->cache, file->dir_listing);
+
+    /* Cached listing of parent directory has outdated size and time if the
+     * file was written */
+    if (file->bytes_written > 0)
+        guac_rdp_fs_cache_invalidate(fs->cache, file->absolute_path);
 
     /* Close file */
     close(file->fd);
@@ -584,31 +654,31 @@ void guac_rdp_fs_close(guac_rdp_fs* fs, int file_id) {
 
 }
 
-const char* guac_rdp_fs_read_dir(guac_rdp_fs* fs, int file_id) {
+const guac_rdp_fs_dir_entry* guac_rdp_fs_read_dir(guac_rdp_fs* fs,
+        int file_id) {
 
     guac_rdp_fs_file* file;
 
-    struct dirent* result;
-
     /* Only read if file ID is valid */
     if (file_id < 0 || file_id >= GUAC_RDP_FS_MAX_FILES)
         return NULL;
 
     file = &(fs->files[file_id]);
 
-    /* Open directory if not yet open, stop if error */
-    if (file->dir == NULL) {
-        file->dir = fdopendir(file->fd);
-        if (file->dir == NULL)
+    /* Read directory listing if not yet read, stop if error */
+    if (file->dir_listing == NULL) {
+        file->dir_listing = guac_rdp_fs_cache_get_listing(fs->cache,
+                file->absolute_path, file->real_path, file->fd);
+        if (file->dir_listing == NULL)
             return NULL;
     }
 
-    /* Read next entry, stop if error or no more entries */
-    if ((result = readdir(file->dir)) == NULL)
+    /* Stop if no more entries */
+    if (file->dir_index >= file->dir_listing->entry_count)
         return NULL;
 
-    /* Return filename */
-    return result->d_name;
+    /* Return next entry */
+    return &file->dir_listing->entries[file->dir_index++];
 
 }
 
@@ -31,6 +31,8 @@
  * @file fs.h 
  */
 
+#include "fs-cache.h"
+
 #include <guacamole/client.h>
 #include <guacamole/object.h>
 #include <guacamole/pool.h>
@@ -54,6 +56,18 @@
  */
 #define GUAC_RDP_MAX_PATH_DEPTH 64
 
+/**
+ * The number of bytes that the kernel is advised to read ahead of the current
+ * offset of each file being read sequentially.
+ */
+#define GUAC_RDP_FS_READ_AHEAD_SIZE 262144
+
+/**
+ * The number of consecutive sequential reads which must be observed before
+ * the kernel is advised to read ahead of the current offset of a file.
+ */
+#define GUAC_RDP_FS_SEQUENTIAL_READS 2
+
 /**
  * Error code returned when no more file IDs can be allocated.
  */
@@ -140,10 +154,17 @@ typedef struct guac_rdp_fs_file {
     int fd;
 
     /**
-     * Associated directory stream, if any. This field only applies
-     * if the file is being used as a directory.
+     * The listing of this directory being read via guac_rdp_fs_read_dir(),
+     * if any. This field only applies if the file is being used as a
+     * directory.
      */
-    DIR* dir;
+    guac_rdp_fs_dir_listing* dir_listing;
+
+    /**
+     * The index of the next entry within dir_listing to be returned by
+     * guac_rdp_fs_read_dir().
+     */
+    int dir_index;
 
     /**
      * The pattern the check directory contents against, if any.
@@ -176,10 +197,32 @@ typedef struct guac_rdp_fs_file {
     uint64_t atime;
 
     /**
-     * The number of bytes written to the file.
+     * The number of bytes written to the file through this handle. If
+     * non-zero when the file is closed, any cached listing of the parent
+     * directory is invalidated.
      */
     uint64_t bytes_written;
 
+    /**
+     * The offset immediately following the data returned by the most recent
+     * read, which will be the offset of the next read if the file is being
+     * read sequentially.
+     */
+    uint64_t next_read_offset;
+
+    /**
+     * The number of consecutive reads which began exactly where the previous
+     * read ended.
+     */
+    int sequential_reads;
+
+    /**
+     * The offset within the file of the first byte beyond the range that the
+     * kernel has most recently been advised will be needed soon, or zero if
+     * the file has not yet been detected as being read sequentially.
+     */
+    uint64_t read_ahead_offset;
+
 } guac_rdp_fs_file;
 
 /**
@@ -197,6 +240,11 @@ typedef struct guac_rdp_fs {
      */
     char* drive_path;
 
+    /**
+     * Cache of directory listings read from this filesystem.
+     */
+    guac_rdp_fs_cache* cache;
+
     /**
      * The number of currently open files.
      */
@@ -412,7 +460,10 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
 /**
  * Reads up to the given length of bytes from the given offset within the
  * file having the given ID. Returns the number of bytes read, zero on EOF,
- * and an error code if an error occurs.
+ * and an error code if an error occurs. Once a file is detected as being read
+ * sequentially, the kernel is advised to read data ahead of the requested
+ * offset in large blocks, such that subsequent reads are served from the page
+ * cache.
  *
  * @param fs
  *     The filesystem containing the file from which data is to be read.
@@ -587,8 +638,10 @@ int guac_rdp_fs_convert_path(const char* parent, const char* rel_path,
         char* abs_path);
 
 /**
- * Returns the next filename within the directory having the given file ID,
- * or NULL if no more files.
+ * Returns the next entry within the directory having the given file ID,
+ * or NULL if no more files. The directory listing, including the metadata of
+ * each entry, is read in its entirety on the first call, and may be served
+ * from the directory listing cache of the filesystem.
  *
  * @param fs
  *     The filesystem containing the file to read directory entries from.
@@ -598,10 +651,12 @@ int guac_rdp_fs_convert_path(const char* parent, const char* rel_path,
  *     guac_rdp_fs_open().
  *
  * @return
- *     The name of the next filename within the directory, or NULL if the last
- *     file in the directory has already been returned by a previous call.
+ *     The next entry within the directory, or NULL if the last entry in the
+ *     directory has already been returned by a previous call. The returned
+ *     entry remains valid until the file is closed.
  */
-const char* guac_rdp_fs_read_dir(guac_rdp_fs* fs, int file_id);
+const guac_rdp_fs_dir_entry* guac_rdp_fs_read_dir(guac_rdp_fs* fs,
+        int file_id);
 
 /**
  * Returns the file having the given ID, or NULL if no such file exists.
@@ -37,7 +37,7 @@ int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
         char* message, guac_protocol_status status) {
 
     int blob_written = 0;
-    const char* filename;
+    const guac_rdp_fs_dir_entry* entry;
 
     guac_rdp_ls_status* ls_status = (guac_rdp_ls_status*) stream->data;
 
@@ -50,11 +50,12 @@ int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
     }
 
     /* While directory entries remain */
-    while ((filename = guac_rdp_fs_read_dir(ls_status->fs,
+    while ((entry = guac_rdp_fs_read_dir(ls_status->fs,
                     ls_status->file_id)) != NULL
             && !blob_written) {
 
         char absolute_path[GUAC_RDP_FS_MAX_PATH];
+        const char* filename = entry->name;
 
         /* Skip current and parent directory entries */
         if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0)
@@ -71,23 +72,9 @@ int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
             continue;
         }
 
-        /* Attempt to open file to determine type */
-        int file_id = guac_rdp_fs_open(ls_status->fs, absolute_path,
-                GENERIC_READ, 0, FILE_OPEN, 0);
-        if (file_id < 0)
-            continue;
-
-        /* Get opened file */
-        guac_rdp_fs_file* file = guac_rdp_fs_get_file(ls_status->fs, file_id);
-        if (file == NULL) {
-            guac_user_log(user, GUAC_LOG_DEBUG, "%s: Successful open produced "
-                    "bad file_id: %i", __func__, file_id);
-            return 0;
-        }
-
         /* Determine mimetype */
         const char* mimetype;
-        if (file->attributes & FILE_ATTRIBUTE_DIRECTORY)
+        if (entry->attributes & FILE_ATTRIBUTE_DIRECTORY)
             mimetype = GUAC_USER_STREAM_INDEX_MIMETYPE;
         else
             mimetype = "application/octet-stream";
@@ -96,12 +83,10 @@ int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
         blob_written |= guac_common_json_write_property(user, stream,
                 &ls_status->json_state, absolute_path, mimetype);
 
-        guac_rdp_fs_close(ls_status->fs, file_id);
-
     }
 
     /* Complete JSON and cleanup at end of directory */
-    if (filename == NULL) {
+    if (entry == NULL) {
 
         /* Complete JSON object */
         guac_common_json_end_object(user, stream, &ls_status->json_state);
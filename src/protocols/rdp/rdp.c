@@ -762,6 +762,16 @@ void* guac_rdp_client_thread(void* data) {
             guac_client_log(client, GUAC_LOG_INFO,
                     "No available audio encoding. Sound disabled.");
 
+        /* Send PCM in packets of the requested duration, omitting silence
+         * if requested */
+        else {
+            guac_audio_stream_set_packet_duration(rdp_client->audio,
+                    settings->audio_packet_duration);
+            guac_audio_stream_set_silence_threshold(rdp_client->audio,
+                    settings->audio_silence_threshold,
+                    settings->audio_silence_hold);
+        }
+
     } /* end if audio enabled */
 
     /* Load filesystem if drive enabled */
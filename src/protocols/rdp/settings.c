@@ -28,6 +28,7 @@
 #include <freerdp/constants.h>
 #include <freerdp/settings.h>
 #include <freerdp/freerdp.h>
+#include <guacamole/audio-constants.h>
 #include <guacamole/client.h>
 #include <guacamole/mem.h>
 #include <guacamole/fips.h>
@@ -66,6 +67,9 @@ const char* GUAC_RDP_CLIENT_ARGS[] = {
     "initial-program",
     "color-depth",
     "disable-audio",
+    "audio-packet-duration",
+    "audio-silence-threshold",
+    "audio-silence-hold",
     "enable-printing",
     "printer-name",
     "enable-drive",
@@ -224,6 +228,30 @@ enum RDP_ARGS_IDX {
      */
     IDX_DISABLE_AUDIO,
 
+    /**
+     * The duration of audio, in milliseconds, to accumulate before each audio
+     * packet is sent. Longer durations reduce the number of packets sent at
+     * the cost of added latency. If zero, audio is sent as soon as each
+     * complete wave is received from the RDP server. If omitted,
+     * GUAC_AUDIO_DEFAULT_PACKET_DURATION is used.
+     */
+    IDX_AUDIO_PACKET_DURATION,
+
+    /**
+     * The RMS level, scaled to the range of a signed 16-bit sample, below
+     * which audio is considered silent and is not sent. If zero, silence is
+     * sent like any other audio. If omitted,
+     * GUAC_AUDIO_DEFAULT_SILENCE_THRESHOLD is used.
+     */
+    IDX_AUDIO_SILENCE_THRESHOLD,
+
+    /**
+     * The duration of continuous silence, in milliseconds, after which
+     * silence is no longer sent. If omitted, GUAC_AUDIO_DEFAULT_SILENCE_HOLD
+     * is used.
+     */
+    IDX_AUDIO_SILENCE_HOLD,
+
     /**
      * "true" if printing should be enabled, "false" or blank otherwise.
      */
@@ -1036,6 +1064,22 @@ guac_rdp_settings* guac_rdp_parse_args(guac_user* user,
         !guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
                 IDX_DISABLE_AUDIO, 0);
 
+    /* Audio packet duration */
+    settings->audio_packet_duration =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_AUDIO_PACKET_DURATION, GUAC_AUDIO_DEFAULT_PACKET_DURATION);
+
+    /* Audio silence suppression threshold */
+    settings->audio_silence_threshold =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_AUDIO_SILENCE_THRESHOLD,
+                GUAC_AUDIO_DEFAULT_SILENCE_THRESHOLD);
+
+    /* Duration of silence before suppression */
+    settings->audio_silence_hold =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_AUDIO_SILENCE_HOLD, GUAC_AUDIO_DEFAULT_SILENCE_HOLD);
+
     /* Printing enable/disable */
     settings->printing_enabled =
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
@@ -223,6 +223,26 @@ typedef struct guac_rdp_settings {
      */
     int audio_enabled;
 
+    /**
+     * The duration of audio, in milliseconds, to accumulate before each audio
+     * packet is sent, or zero to send audio as soon as each complete wave is
+     * received from the RDP server.
+     */
+    int audio_packet_duration;
+
+    /**
+     * The RMS level, scaled to the range of a signed 16-bit sample, below
+     * which audio is considered silent, or zero to send silence like any
+     * other audio.
+     */
+    int audio_silence_threshold;
+
+    /**
+     * The duration of continuous silence, in milliseconds, after which
+     * silence is no longer sent.
+     */
+    int audio_silence_hold;
+
     /**
      * Whether printing is enabled.
      */
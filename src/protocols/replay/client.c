@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "client.h"
+#include "image.h"
+#include "replay.h"
+#include "settings.h"
+#include "user.h"
+
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/mem.h>
+#include <guacamole/socket.h>
+
+#include <pthread.h>
+
+/**
+ * A pending join handler implementation that will synchronize the connection
+ * state for all pending users prior to them being promoted to full user.
+ *
+ * @param client
+ *     The client whose pending users are about to be promoted.
+ *
+ * @return
+ *     Always zero.
+ */
+static int guac_replay_join_pending_handler(guac_client* client) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    /* Synchronize the current display state to all pending users */
+    guac_socket* broadcast_socket = client->pending_socket;
+    guac_display_dup(replay_client->display, broadcast_socket);
+    guac_socket_flush(broadcast_socket);
+
+    return 0;
+
+}
+
+int guac_client_init(guac_client* client) {
+
+    /* Set client args */
+    client->args = GUAC_REPLAY_CLIENT_ARGS;
+
+    /* Allocate client instance data */
+    guac_replay_client* replay_client = guac_mem_zalloc(sizeof(guac_replay_client));
+    client->data = replay_client;
+
+    /* All replayed drawing operations are applied to this display */
+    replay_client->display = guac_display_alloc(client);
+
+    /* Set handlers */
+    client->join_handler = guac_replay_user_join_handler;
+    client->join_pending_handler = guac_replay_join_pending_handler;
+    client->free_handler = guac_replay_client_free_handler;
+    client->leave_handler = guac_replay_user_leave_handler;
+
+    /* Success */
+    return 0;
+
+}
+
+int guac_replay_client_free_handler(guac_client* client) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    /* Wait for replay to stop, if started */
+    if (replay_client->settings != NULL)
+        pthread_join(replay_client->client_thread, NULL);
+
+    /* Free any partially-received images */
+    for (int i = 0; i < GUAC_CLIENT_MAX_STREAMS; i++)
+        guac_replay_image_stream_free(&(replay_client->streams[i]));
+
+    /* Free display (along with all layers and buffers) */
+    guac_display_free(replay_client->display);
+
+    /* Free settings */
+    if (replay_client->settings != NULL)
+        guac_replay_settings_free(replay_client->settings);
+
+    guac_mem_free(replay_client);
+    return 0;
+
+}
@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "image.h"
+
+/* libjpeg requires stdio.h to be included first */
+#include <stdio.h>
+
+#include <cairo/cairo.h>
+#include <guacamole/mem.h>
+#include <jpeglib.h>
+
+#ifdef ENABLE_WEBP
+#include <webp/decode.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The current state of the PNG decoder.
+ */
+typedef struct guac_replay_png_read_state {
+
+    /**
+     * The buffer of unread image data. This pointer will be updated to point
+     * to the next unread byte when data is read.
+     */
+    unsigned char* data;
+
+    /**
+     * The number of bytes remaining to be read within the buffer.
+     */
+    unsigned int length;
+
+} guac_replay_png_read_state;
+
+/**
+ * Attempts to fill the given buffer with read image data. The behavior of
+ * this function is dictated by cairo_read_t.
+ *
+ * @param closure
+ *     The current state of the PNG decoding process (an instance of
+ *     guac_replay_png_read_state).
+ *
+ * @param data
+ *     The data buffer to fill.
+ *
+ * @param length
+ *     The number of bytes to fill within the data buffer.
+ *
+ * @return
+ *     CAIRO_STATUS_SUCCESS if all data was read successfully (the entire
+ *     buffer was filled), CAIRO_STATUS_READ_ERROR otherwise.
+ */
+static cairo_status_t guac_replay_png_read(void* closure, unsigned char* data,
+        unsigned int length) {
+
+    guac_replay_png_read_state* state = (guac_replay_png_read_state*) closure;
+
+    /* If more data is requested than is available in buffer, fail */
+    if (length > state->length)
+        return CAIRO_STATUS_READ_ERROR;
+
+    /* Read chunk into buffer */
+    memcpy(data, state->data, length);
+
+    /* Advance to next chunk */
+    state->length -= length;
+    state->data += length;
+
+    return CAIRO_STATUS_SUCCESS;
+
+}
+
+/**
+ * Decodes the given PNG image data. This function is a guac_replay_decoder.
+ */
+static cairo_surface_t* guac_replay_png_decoder(unsigned char* data,
+        int length) {
+
+    guac_replay_png_read_state state = {
+        .data = data,
+        .length = length
+    };
+
+    /* Read PNG from data */
+    cairo_surface_t* surface =
+        cairo_image_surface_create_from_png_stream(guac_replay_png_read, &state);
+
+    /* If surface returned with an error, just return NULL */
+    if (surface != NULL &&
+            cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return NULL;
+    }
+
+    return surface;
+
+}
+
+/**
+ * Decodes the given JPEG image data. This function is a guac_replay_decoder.
+ */
+static cairo_surface_t* guac_replay_jpeg_decoder(unsigned char* data,
+        int length) {
+
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    /* Create decompressor with standard error handling */
+    jpeg_create_decompress(&cinfo);
+    cinfo.err = jpeg_std_error(&jerr);
+
+    /* Read JPEG directly from memory buffer */
+    jpeg_mem_src(&cinfo, data, length);
+
+    /* Read and validate JPEG header */
+    if (!jpeg_read_header(&cinfo, TRUE)) {
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+
+    /* Decompress directly to 24-bit RGB */
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    int width = cinfo.output_width;
+    int height = cinfo.output_height;
+
+    unsigned char* scanline = guac_mem_alloc(width, 3);
+
+    /* Create blank Cairo surface (no transparency in JPEG) */
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+            width, height);
+
+    int stride = cairo_image_surface_get_stride(surface);
+    unsigned char* row = cairo_image_surface_get_data(surface);
+
+    /* Read JPEG into surface, translating each pixel for Cairo */
+    while (cinfo.output_scanline < height) {
+
+        unsigned char* buffers[1] = { scanline };
+        jpeg_read_scanlines(&cinfo, buffers, 1);
+
+        uint32_t* current = (uint32_t*) row;
+        const unsigned char* src = scanline;
+        for (int x = 0; x < width; x++, src += 3)
+            *(current++) = 0xFF000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+
+        row += stride;
+
+    }
+
+    cairo_surface_mark_dirty(surface);
+    guac_mem_free(scanline);
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    return surface;
+
+}
+
+#ifdef ENABLE_WEBP
+/**
+ * Decodes the given WebP image data. This function is a guac_replay_decoder.
+ */
+static cairo_surface_t* guac_replay_webp_decoder(unsigned char* data,
+        int length) {
+
+    int width, height;
+
+    /* Validate WebP and pull dimensions */
+    if (!WebPGetInfo((uint8_t*) data, length, &width, &height))
+        return NULL;
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+            width, height);
+
+    int stride = cairo_image_surface_get_stride(surface);
+    unsigned char* image = cairo_image_surface_get_data(surface);
+
+    /* Read WebP into surface */
+    if (WebPDecodeBGRAInto((uint8_t*) data, length, (uint8_t*) image,
+                stride * height, stride) == NULL) {
+        cairo_surface_destroy(surface);
+        return NULL;
+    }
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+
+}
+#endif
+
+guac_replay_decoder* guac_replay_get_decoder(const char* mimetype) {
+
+    if (strcmp(mimetype, "image/png") == 0)
+        return guac_replay_png_decoder;
+
+    if (strcmp(mimetype, "image/jpeg") == 0)
+        return guac_replay_jpeg_decoder;
+
+#ifdef ENABLE_WEBP
+    if (strcmp(mimetype, "image/webp") == 0)
+        return guac_replay_webp_decoder;
+#endif
+
+    /* No decoder found */
+    return NULL;
+
+}
+
+void guac_replay_image_stream_begin(guac_replay_image_stream* stream,
+        int mask, int index, const char* mimetype, int x, int y) {
+
+    stream->active = true;
+    stream->mask = mask;
+    stream->index = index;
+    stream->x = x;
+    stream->y = y;
+    stream->length = 0;
+    stream->decoder = guac_replay_get_decoder(mimetype);
+
+    /* Allocate buffer only once, retaining it for future streams */
+    if (stream->buffer == NULL) {
+        stream->max_length = GUAC_REPLAY_IMAGE_BUFFER_INITIAL_SIZE;
+        stream->buffer = guac_mem_alloc(stream->max_length);
+    }
+
+}
+
+void guac_replay_image_stream_receive(guac_replay_image_stream* stream,
+        const unsigned char* data, int length) {
+
+    /* Ignore data for unsupported formats */
+    if (!stream->active || stream->decoder == NULL)
+        return;
+
+    /* Grow buffer as necessary to contain received data */
+    if (stream->length + length > stream->max_length) {
+
+        while (stream->length + length > stream->max_length)
+            stream->max_length = guac_mem_ckd_mul_or_die(stream->max_length, 2);
+
+        stream->buffer = guac_mem_realloc(stream->buffer, stream->max_length);
+
+    }
+
+    memcpy(stream->buffer + stream->length, data, length);
+    stream->length += length;
+
+}
+
+cairo_surface_t* guac_replay_image_stream_end(guac_replay_image_stream* stream) {
+
+    if (!stream->active)
+        return NULL;
+
+    stream->active = false;
+
+    if (stream->decoder == NULL || stream->length == 0)
+        return NULL;
+
+    return stream->decoder(stream->buffer, stream->length);
+
+}
+
+void guac_replay_image_stream_free(guac_replay_image_stream* stream) {
+    guac_mem_free(stream->buffer);
+    stream->active = false;
+}
@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_REPLAY_IMAGE_H
+#define GUAC_REPLAY_IMAGE_H
+
+#include "config.h"
+
+#include <cairo/cairo.h>
+
+#include <stdbool.h>
+
+/**
+ * The initial number of bytes to allocate for the image buffer of an image
+ * stream. This buffer will grow as necessary to hold the received image.
+ */
+#define GUAC_REPLAY_IMAGE_BUFFER_INITIAL_SIZE 4096
+
+/**
+ * Callback function which is provided raw, encoded image data of the given
+ * length. The function is expected to return a new Cairo surface which will
+ * later (by replay) be freed via cairo_surface_destroy().
+ *
+ * @param data
+ *     The raw encoded image data that this function must decode.
+ *
+ * @param length
+ *     The length of the image data, in bytes.
+ *
+ * @return
+ *     A newly-allocated Cairo surface containing the decoded image, or NULL
+ *     if decoding fails.
+ */
+typedef cairo_surface_t* guac_replay_decoder(unsigned char* data, int length);
+
+/**
+ * The current state of an allocated Guacamole image stream.
+ */
+typedef struct guac_replay_image_stream {
+
+    /**
+     * Whether this image stream is currently in use.
+     */
+    bool active;
+
+    /**
+     * The index of the layer or buffer that the image should be drawn to.
+     */
+    int index;
+
+    /**
+     * The Guacamole protocol compositing operation (channel mask) to apply
+     * when drawing the image.
+     */
+    int mask;
+
+    /**
+     * The X coordinate of the upper-left corner of the rectangle within the
+     * destination layer or buffer that the decoded image should be drawn to.
+     */
+    int x;
+
+    /**
+     * The Y coordinate of the upper-left corner of the rectangle within the
+     * destination layer or buffer that the decoded image should be drawn to.
+     */
+    int y;
+
+    /**
+     * Buffer of image data which will be built up over time as chunks are
+     * received via "blob" instructions. This will ultimately be passed in its
+     * entirety to the decoder function. The buffer is retained between
+     * streams to avoid repeated allocation.
+     */
+    unsigned char* buffer;
+
+    /**
+     * The number of bytes currently stored in the buffer.
+     */
+    int length;
+
+    /**
+     * The maximum number of bytes that can be stored in the current buffer
+     * before it must be reallocated.
+     */
+    int max_length;
+
+    /**
+     * The decoder to use when decoding the raw data received along this
+     * stream, or NULL if the image format is not supported (in which case
+     * all received data is ignored).
+     */
+    guac_replay_decoder* decoder;
+
+} guac_replay_image_stream;
+
+/**
+ * Returns the decoder associated with the given mimetype. If no such decoder
+ * exists, NULL is returned.
+ *
+ * @param mimetype
+ *     The image mimetype to return the associated decoder of.
+ *
+ * @return
+ *     The decoder associated with the given mimetype, or NULL if no such
+ *     decoder exists.
+ */
+guac_replay_decoder* guac_replay_get_decoder(const char* mimetype);
+
+/**
+ * Begins receiving a new image along the given image stream, discarding any
+ * data received along a previous image.
+ *
+ * @param stream
+ *     The image stream to begin.
+ *
+ * @param mask
+ *     The Guacamole protocol compositing operation (channel mask) to apply
+ *     when drawing the image.
+ *
+ * @param index
+ *     The index of the layer or buffer that the image should be drawn to.
+ *
+ * @param mimetype
+ *     The mimetype of the image data that will be received along the
+ *     stream.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle within the
+ *     destination layer or buffer that the image should be drawn to.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle within the
+ *     destination layer or buffer that the image should be drawn to.
+ */
+void guac_replay_image_stream_begin(guac_replay_image_stream* stream,
+        int mask, int index, const char* mimetype, int x, int y);
+
+/**
+ * Appends the given chunk of (already base64-decoded) image data to the
+ * image being received along the given stream.
+ *
+ * @param stream
+ *     The image stream receiving the data.
+ *
+ * @param data
+ *     The chunk of data received.
+ *
+ * @param length
+ *     The size of the chunk of data received, in bytes.
+ */
+void guac_replay_image_stream_receive(guac_replay_image_stream* stream,
+        const unsigned char* data, int length);
+
+/**
+ * Decodes the image received along the given image stream, ending the
+ * stream.
+ *
+ * @param stream
+ *     The image stream to end.
+ *
+ * @return
+ *     A newly-allocated Cairo surface containing the decoded image, or NULL
+ *     if the image format is not supported or the image could not be
+ *     decoded. The surface must eventually be freed with
+ *     cairo_surface_destroy().
+ */
+cairo_surface_t* guac_replay_image_stream_end(guac_replay_image_stream* stream);
+
+/**
+ * Frees all memory associated with the given image stream. The stream must
+ * not be used again after this function is invoked.
+ *
+ * @param stream
+ *     The image stream to free.
+ */
+void guac_replay_image_stream_free(guac_replay_image_stream* stream);
+
+#endif
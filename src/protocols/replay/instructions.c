@@ -0,0 +1,469 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "image.h"
+#include "instructions.h"
+#include "replay.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/mem.h>
+#include <guacamole/opcode.h>
+#include <guacamole/protocol.h>
+#include <guacamole/protocol-types.h>
+#include <guacamole/rect.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns the image stream having the given index, or NULL if the index is
+ * out of range.
+ *
+ * @param replay_client
+ *     The replay client whose recording references the stream.
+ *
+ * @param index
+ *     The index of the stream.
+ *
+ * @return
+ *     The image stream having the given index, or NULL if the index is out
+ *     of range.
+ */
+static guac_replay_image_stream* guac_replay_get_stream(
+        guac_replay_client* replay_client, int index) {
+
+    if (index < 0 || index >= GUAC_CLIENT_MAX_STREAMS)
+        return NULL;
+
+    return &(replay_client->streams[index]);
+
+}
+
+/**
+ * Handles a "blob" instruction, appending the received data to the image
+ * being received along the associated image stream.
+ */
+static int guac_replay_handle_blob(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 2)
+        return 1;
+
+    guac_replay_image_stream* stream =
+        guac_replay_get_stream(replay_client, atoi(argv[0]));
+    if (stream == NULL)
+        return 1;
+
+    /* Decode base64 in place */
+    int length = guac_protocol_decode_base64(argv[1]);
+    guac_replay_image_stream_receive(stream, (unsigned char*) argv[1], length);
+
+    return 0;
+
+}
+
+/**
+ * Handles a "cfill" instruction, filling the rectangle most recently added
+ * to the path of the given layer with a single color.
+ */
+static int guac_replay_handle_cfill(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 6)
+        return 1;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, atoi(argv[1]));
+    if (layer == NULL || guac_rect_is_empty(&layer->path))
+        return 1;
+
+    /* Layer buffers use premultiplied alpha */
+    unsigned int a = atoi(argv[5]) & 0xFF;
+    unsigned int r = (atoi(argv[2]) & 0xFF) * a / 0xFF;
+    unsigned int g = (atoi(argv[3]) & 0xFF) * a / 0xFF;
+    unsigned int b = (atoi(argv[4]) & 0xFF) * a / 0xFF;
+
+    guac_replay_fit_layer(layer, &layer->path);
+
+    guac_display_layer_raw_context* context = guac_display_layer_open_raw(layer->layer);
+
+    guac_rect dst = layer->path;
+    guac_rect_constrain(&dst, &context->bounds);
+
+    guac_display_layer_raw_context_set(context, &dst,
+            (a << 24) | (r << 16) | (g << 8) | b);
+    guac_rect_extend(&context->dirty, &dst);
+
+    guac_display_layer_close_raw(layer->layer, context);
+
+    layer->path = (guac_rect) { 0 };
+    return 0;
+
+}
+
+/**
+ * Handles a "copy" instruction, copying a rectangle of image data from one
+ * layer or buffer to another (or to a different location within the same
+ * layer or buffer).
+ */
+static int guac_replay_handle_copy(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 9)
+        return 1;
+
+    int sx = atoi(argv[1]);
+    int sy = atoi(argv[2]);
+    int width = atoi(argv[3]);
+    int height = atoi(argv[4]);
+    int dx = atoi(argv[7]);
+    int dy = atoi(argv[8]);
+
+    guac_replay_layer* src = guac_replay_get_layer(replay_client, atoi(argv[0]));
+    guac_replay_layer* dst = guac_replay_get_layer(replay_client, atoi(argv[6]));
+    if (src == NULL || dst == NULL)
+        return 1;
+
+    guac_rect dst_rect;
+    guac_rect_init(&dst_rect, dx, dy, width, height);
+    guac_replay_fit_layer(dst, &dst_rect);
+
+    guac_display_layer_raw_context* src_context = guac_display_layer_open_raw(src->layer);
+    guac_display_layer_raw_context* dst_context = (src == dst) ? src_context
+        : guac_display_layer_open_raw(dst->layer);
+
+    /* Limit copy to the portion of the source that actually exists ... */
+    guac_rect src_rect;
+    guac_rect_init(&src_rect, sx, sy, width, height);
+    guac_rect_constrain(&src_rect, &src_context->bounds);
+
+    /* ... and to the portion of the destination that can receive it */
+    guac_rect_init(&dst_rect, dx + src_rect.left - sx, dy + src_rect.top - sy,
+            guac_rect_width(&src_rect), guac_rect_height(&src_rect));
+    guac_rect_constrain(&dst_rect, &dst_context->bounds);
+
+    if (!guac_rect_is_empty(&dst_rect)) {
+
+        guac_rect_init(&src_rect, sx + dst_rect.left - dx,
+                sy + dst_rect.top - dy, guac_rect_width(&dst_rect),
+                guac_rect_height(&dst_rect));
+
+        const void* src_buffer = GUAC_RECT_CONST_BUFFER(src_rect,
+                src_context->buffer, src_context->stride, 4);
+
+        /* Regions within the same layer may overlap, and so must first be
+         * copied elsewhere */
+        if (src == dst) {
+
+            size_t stride = guac_mem_ckd_mul_or_die(guac_rect_width(&src_rect), 4);
+            unsigned char* copy = guac_mem_alloc(stride, guac_rect_height(&src_rect));
+
+            for (int y = 0; y < guac_rect_height(&src_rect); y++)
+                memcpy(copy + y * stride, ((const unsigned char*) src_buffer)
+                        + y * src_context->stride, stride);
+
+            guac_display_layer_raw_context_put(dst_context, &dst_rect, copy, stride);
+            guac_mem_free(copy);
+
+        }
+
+        else
+            guac_display_layer_raw_context_put(dst_context, &dst_rect,
+                    src_buffer, src_context->stride);
+
+        guac_rect_extend(&dst_context->dirty, &dst_rect);
+        dst_context->hint_from = src->layer;
+
+    }
+
+    if (src != dst)
+        guac_display_layer_close_raw(dst->layer, dst_context);
+
+    guac_display_layer_close_raw(src->layer, src_context);
+
+    return 0;
+
+}
+
+/**
+ * Handles a "dispose" instruction, freeing the given layer or buffer.
+ */
+static int guac_replay_handle_dispose(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 1)
+        return 1;
+
+    guac_replay_free_layer(replay_client, atoi(argv[0]));
+    return 0;
+
+}
+
+/**
+ * Handles an "end" instruction, decoding the image received along the
+ * associated image stream and drawing that image to its destination layer
+ * or buffer.
+ */
+static int guac_replay_handle_end(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 1)
+        return 1;
+
+    guac_replay_image_stream* stream =
+        guac_replay_get_stream(replay_client, atoi(argv[0]));
+    if (stream == NULL)
+        return 1;
+
+    cairo_surface_t* surface = guac_replay_image_stream_end(stream);
+    if (surface == NULL)
+        return 0;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, stream->index);
+    if (layer == NULL) {
+        cairo_surface_destroy(surface);
+        return 1;
+    }
+
+    guac_rect dst;
+    guac_rect_init(&dst, stream->x, stream->y,
+            cairo_image_surface_get_width(surface),
+            cairo_image_surface_get_height(surface));
+
+    guac_replay_fit_layer(layer, &dst);
+
+    guac_display_layer_cairo_context* context = guac_display_layer_open_cairo(layer->layer);
+    cairo_t* cairo = context->cairo;
+
+    cairo_set_operator(cairo, stream->mask == GUAC_COMP_SRC
+            ? CAIRO_OPERATOR_SOURCE : CAIRO_OPERATOR_OVER);
+    cairo_set_source_surface(cairo, surface, dst.left, dst.top);
+    cairo_rectangle(cairo, dst.left, dst.top,
+            guac_rect_width(&dst), guac_rect_height(&dst));
+    cairo_fill(cairo);
+
+    guac_rect_constrain(&dst, &context->bounds);
+    guac_rect_extend(&context->dirty, &dst);
+
+    guac_display_layer_close_cairo(layer->layer, context);
+
+    cairo_surface_destroy(surface);
+    return 0;
+
+}
+
+/**
+ * Handles an "img" instruction, beginning a new image stream.
+ */
+static int guac_replay_handle_img(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 6)
+        return 1;
+
+    guac_replay_image_stream* stream =
+        guac_replay_get_stream(replay_client, atoi(argv[0]));
+    if (stream == NULL)
+        return 1;
+
+    guac_replay_image_stream_begin(stream, atoi(argv[1]), atoi(argv[2]),
+            argv[3], atoi(argv[4]), atoi(argv[5]));
+
+    return 0;
+
+}
+
+/**
+ * Handles a "move" instruction, changing the parent, position, and stacking
+ * order of a visible layer.
+ */
+static int guac_replay_handle_move(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 5)
+        return 1;
+
+    /* Only layers other than the default layer may be moved */
+    int index = atoi(argv[0]);
+    if (index <= 0)
+        return 1;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, index);
+    guac_replay_layer* parent = guac_replay_get_layer(replay_client, atoi(argv[1]));
+    if (layer == NULL || parent == NULL)
+        return 1;
+
+    guac_display_layer_set_parent(layer->layer, parent->layer);
+    guac_display_layer_move(layer->layer, atoi(argv[2]), atoi(argv[3]));
+    guac_display_layer_stack(layer->layer, atoi(argv[4]));
+
+    return 0;
+
+}
+
+/**
+ * Handles a "rect" instruction, replacing the path of the given layer or
+ * buffer with the given rectangle.
+ */
+static int guac_replay_handle_rect(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 5)
+        return 1;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, atoi(argv[0]));
+    if (layer == NULL)
+        return 1;
+
+    guac_rect_init(&layer->path, atoi(argv[1]), atoi(argv[2]),
+            atoi(argv[3]), atoi(argv[4]));
+
+    return 0;
+
+}
+
+/**
+ * Handles a "shade" instruction, changing the opacity of a visible layer.
+ */
+static int guac_replay_handle_shade(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 2)
+        return 1;
+
+    int index = atoi(argv[0]);
+    if (index < 0)
+        return 1;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, index);
+    if (layer == NULL)
+        return 1;
+
+    guac_display_layer_set_opacity(layer->layer, atoi(argv[1]));
+    return 0;
+
+}
+
+/**
+ * Handles a "size" instruction, resizing the given layer or buffer.
+ */
+static int guac_replay_handle_size(guac_client* client, int argc, char** argv) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    if (argc < 3)
+        return 1;
+
+    guac_replay_layer* layer = guac_replay_get_layer(replay_client, atoi(argv[0]));
+    if (layer == NULL)
+        return 1;
+
+    guac_display_layer_resize(layer->layer, atoi(argv[1]), atoi(argv[2]));
+    return 0;
+
+}
+
+/**
+ * Handles a "sync" instruction, ending the current frame once the time that
+ * the frame would have been rendered during the original session has been
+ * reached.
+ */
+static int guac_replay_handle_sync(guac_client* client, int argc, char** argv) {
+
+    if (argc < 1)
+        return 1;
+
+    guac_replay_end_frame(client, strtoll(argv[0], NULL, 10));
+    return 0;
+
+}
+
+guac_replay_instruction_handler_mapping guac_replay_instruction_handler_map[] = {
+    {"blob",    guac_replay_handle_blob},
+    {"img",     guac_replay_handle_img},
+    {"end",     guac_replay_handle_end},
+    {"sync",    guac_replay_handle_sync},
+    {"copy",    guac_replay_handle_copy},
+    {"size",    guac_replay_handle_size},
+    {"rect",    guac_replay_handle_rect},
+    {"cfill",   guac_replay_handle_cfill},
+    {"move",    guac_replay_handle_move},
+    {"shade",   guac_replay_handle_shade},
+    {"dispose", guac_replay_handle_dispose},
+    {NULL,      NULL}
+};
+
+/**
+ * Index of all opcodes within guac_replay_instruction_handler_map.
+ */
+static guac_opcode_index guac_replay_instruction_handler_index;
+
+/**
+ * Control object which ensures guac_replay_instruction_handler_index is built
+ * exactly once.
+ */
+static pthread_once_t guac_replay_instruction_handler_index_init = PTHREAD_ONCE_INIT;
+
+/**
+ * Builds guac_replay_instruction_handler_index. This function is invoked
+ * once, via pthread_once(), prior to the first lookup of any handler.
+ */
+static void guac_replay_build_instruction_handler_index(void) {
+    guac_opcode_index_init(&guac_replay_instruction_handler_index,
+            guac_replay_instruction_handler_map,
+            sizeof(guac_replay_instruction_handler_mapping));
+}
+
+int guac_replay_handle_instruction(guac_client* client, const char* opcode,
+        int argc, char** argv) {
+
+    pthread_once(&guac_replay_instruction_handler_index_init,
+            guac_replay_build_instruction_handler_index);
+
+    /* Look up instruction handler having given opcode */
+    const guac_replay_instruction_handler_mapping* mapping =
+        guac_opcode_index_lookup(&guac_replay_instruction_handler_index,
+                guac_replay_instruction_handler_map,
+                sizeof(guac_replay_instruction_handler_mapping), opcode);
+
+    /* Ignore all instructions which do not affect the display */
+    if (mapping == NULL)
+        return 0;
+
+    int result = mapping->handler(client, argc, argv);
+    if (result)
+        guac_client_log(client, GUAC_LOG_DEBUG, "Ignoring malformed \"%s\" "
+                "instruction within recording.", opcode);
+
+    return result;
+
+}
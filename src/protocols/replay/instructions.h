@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_REPLAY_INSTRUCTIONS_H
+#define GUAC_REPLAY_INSTRUCTIONS_H
+
+#include "config.h"
+
+#include <guacamole/client.h>
+
+/**
+ * A callback function which, when invoked, handles a particular Guacamole
+ * instruction read from the recording being replayed. The opcode of the
+ * instruction is implied (as it is expected that there will be a 1:1 mapping
+ * of opcode to callback function), while the arguments for that instruction
+ * are included in the parameters given to the callback.
+ *
+ * @param client
+ *     The guac_client associated with the replay connection.
+ *
+ * @param argc
+ *     The number of arguments (excluding opcode) passed to the instruction
+ *     being handled by the callback.
+ *
+ * @param argv
+ *     All arguments (excluding opcode) associated with the instruction being
+ *     handled by the callback.
+ *
+ * @return
+ *     Zero if the instruction was handled successfully, non-zero if an error
+ *     occurs.
+ */
+typedef int guac_replay_instruction_handler(guac_client* client,
+        int argc, char** argv);
+
+/**
+ * Mapping of instruction opcode to corresponding handler function.
+ */
+typedef struct guac_replay_instruction_handler_mapping {
+
+    /**
+     * The opcode of the instruction that the associated handler function
+     * should be invoked for.
+     */
+    const char* opcode;
+
+    /**
+     * The handler function to invoke whenever an instruction having the
+     * associated opcode is parsed.
+     */
+    guac_replay_instruction_handler* handler;
+
+} guac_replay_instruction_handler_mapping;
+
+/**
+ * Array of all opcode/handler mappings for all supported opcodes, terminated
+ * by an entry with a NULL opcode. All opcodes not listed here are ignored,
+ * as they do not affect the contents of the display.
+ */
+extern guac_replay_instruction_handler_mapping guac_replay_instruction_handler_map[];
+
+/**
+ * Handles the instruction having the given opcode and arguments, replaying
+ * its effect on the display of the given client.
+ *
+ * @param client
+ *     The guac_client associated with the replay connection.
+ *
+ * @param opcode
+ *     The opcode of the instruction to handle.
+ *
+ * @param argc
+ *     The number of arguments (excluding opcode) passed to the instruction
+ *     being handled.
+ *
+ * @param argv
+ *     All arguments (excluding opcode) associated with the instruction being
+ *     handled.
+ *
+ * @return
+ *     Zero if the instruction was handled successfully, non-zero if an error
+ *     occurs.
+ */
+int guac_replay_handle_instruction(guac_client* client, const char* opcode,
+        int argc, char** argv);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "image.h"
+#include "instructions.h"
+#include "replay.h"
+#include "settings.h"
+
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+#include <guacamole/protocol.h>
+#include <guacamole/rect.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The maximum number of milliseconds to sleep at once while waiting for the
+ * next frame to become due, such that the replay thread notices promptly if
+ * the connection is closing.
+ */
+#define GUAC_REPLAY_MAX_SLEEP 250
+
+guac_replay_layer* guac_replay_get_layer(guac_replay_client* replay_client,
+        int index) {
+
+    guac_replay_layer* layer;
+
+    /* Visible layers have non-negative indices */
+    if (index >= 0) {
+
+        if (index >= GUAC_REPLAY_MAX_LAYERS)
+            return NULL;
+
+        layer = &(replay_client->layers[index]);
+        if (layer->layer == NULL) {
+            layer->layer = (index == 0)
+                ? guac_display_default_layer(replay_client->display)
+                : guac_display_alloc_layer(replay_client->display, 0);
+        }
+
+    }
+
+    /* Off-screen buffers have negative indices, starting at -1 */
+    else {
+
+        if (-index - 1 >= GUAC_REPLAY_MAX_BUFFERS)
+            return NULL;
+
+        layer = &(replay_client->buffers[-index - 1]);
+        if (layer->layer == NULL) {
+            layer->layer = guac_display_alloc_buffer(replay_client->display, 0);
+            layer->autosize = true;
+        }
+
+    }
+
+    return layer;
+
+}
+
+void guac_replay_free_layer(guac_replay_client* replay_client, int index) {
+
+    guac_replay_layer* layer;
+
+    /* The default layer cannot be freed */
+    if (index > 0 && index < GUAC_REPLAY_MAX_LAYERS)
+        layer = &(replay_client->layers[index]);
+
+    else if (index < 0 && -index - 1 < GUAC_REPLAY_MAX_BUFFERS)
+        layer = &(replay_client->buffers[-index - 1]);
+
+    else
+        return;
+
+    if (layer->layer != NULL)
+        guac_display_free_layer(layer->layer);
+
+    *layer = (guac_replay_layer) { 0 };
+
+}
+
+void guac_replay_fit_layer(guac_replay_layer* layer, const guac_rect* rect) {
+
+    if (!layer->autosize)
+        return;
+
+    guac_rect bounds;
+    guac_display_layer_get_bounds(layer->layer, &bounds);
+
+    /* Grow (never shrink) buffers to contain the given rectangle */
+    if (rect->right > bounds.right || rect->bottom > bounds.bottom)
+        guac_display_layer_resize(layer->layer,
+                rect->right > bounds.right ? rect->right : bounds.right,
+                rect->bottom > bounds.bottom ? rect->bottom : bounds.bottom);
+
+}
+
+void guac_replay_end_frame(guac_client* client, guac_timestamp timestamp) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+    int speed = replay_client->settings->speed;
+
+    guac_timestamp now = guac_timestamp_current();
+
+    /* Pace all further frames relative to the first */
+    if (replay_client->first_frame == 0) {
+        replay_client->first_frame = timestamp;
+        replay_client->first_frame_replayed = now;
+    }
+
+    /* Wait until the frame is due, unless replaying as fast as possible */
+    else if (speed > 0) {
+
+        guac_timestamp due = replay_client->first_frame_replayed
+            + (timestamp - replay_client->first_frame) * 100 / speed;
+
+        while (now < due && client->state == GUAC_CLIENT_RUNNING) {
+            guac_timestamp remaining = due - now;
+            guac_timestamp_msleep(remaining < GUAC_REPLAY_MAX_SLEEP
+                    ? remaining : GUAC_REPLAY_MAX_SLEEP);
+            now = guac_timestamp_current();
+        }
+
+    }
+
+    guac_display_end_frame(replay_client->display);
+
+}
+
+/**
+ * Reads and replays all instructions within the recording at the given
+ * path, stopping early if the connection is closing.
+ *
+ * @param client
+ *     The guac_client associated with the replay connection.
+ *
+ * @param path
+ *     The path to the recording to replay.
+ *
+ * @return
+ *     Zero if the entire recording was replayed (or the connection is
+ *     closing), non-zero if the recording could not be opened or read.
+ */
+static int guac_replay_read_recording(guac_client* client, const char* path) {
+
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        guac_client_abort(client, GUAC_PROTOCOL_STATUS_SERVER_ERROR,
+                "Unable to open recording \"%s\": %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* The socket takes ownership of the file descriptor */
+    guac_socket* socket = guac_socket_open(fd);
+    guac_parser* parser = guac_parser_alloc();
+
+    /* Each pass through the recording is paced independently */
+    replay_client->first_frame = 0;
+
+    int failed = 0;
+    while (client->state == GUAC_CLIENT_RUNNING) {
+
+        /* Stop at end of file, failing only on parse errors */
+        if (guac_parser_read(parser, socket, -1)) {
+            failed = (guac_error != GUAC_STATUS_CLOSED);
+            break;
+        }
+
+        guac_replay_handle_instruction(client, parser->opcode,
+                parser->argc, parser->argv);
+
+    }
+
+    if (failed)
+        guac_client_abort(client, GUAC_PROTOCOL_STATUS_SERVER_ERROR,
+                "Unable to read recording \"%s\": %s", path,
+                guac_status_string(guac_error));
+
+    guac_parser_free(parser);
+    guac_socket_free(socket);
+
+    return failed;
+
+}
+
+void* guac_replay_client_thread(void* data) {
+
+    guac_client* client = (guac_client*) data;
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+    guac_replay_settings* settings = replay_client->settings;
+
+    guac_client_log(client, GUAC_LOG_INFO, "Replaying \"%s\" at %i%% speed%s.",
+            settings->recording_path, settings->speed,
+            settings->loop ? " (looping)" : "");
+
+    /* Replay until the recording ends, or forever if looping */
+    while (client->state == GUAC_CLIENT_RUNNING) {
+
+        if (guac_replay_read_recording(client, settings->recording_path))
+            break;
+
+        if (!settings->loop)
+            break;
+
+    }
+
+    guac_client_log(client, GUAC_LOG_INFO, "Replay complete.");
+    guac_client_stop(client);
+
+    return NULL;
+
+}
@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_REPLAY_H
+#define GUAC_REPLAY_H
+
+#include "config.h"
+#include "image.h"
+#include "settings.h"
+
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/rect.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/**
+ * The maximum number of visible layers that may be referenced by a replayed
+ * recording, including the default layer (layer 0).
+ */
+#define GUAC_REPLAY_MAX_LAYERS 64
+
+/**
+ * The maximum number of off-screen buffers that may be referenced by a
+ * replayed recording.
+ */
+#define GUAC_REPLAY_MAX_BUFFERS 4096
+
+/**
+ * The state of a layer or buffer referenced by a replayed recording.
+ */
+typedef struct guac_replay_layer {
+
+    /**
+     * The corresponding layer of the guac_display, or NULL if the layer or
+     * buffer has not yet been referenced by the recording (or has been
+     * disposed).
+     */
+    guac_display_layer* layer;
+
+    /**
+     * Whether this is an off-screen buffer which should automatically grow to
+     * fit any drawing operation, as buffers within the Guacamole protocol do.
+     */
+    bool autosize;
+
+    /**
+     * The rectangle most recently added to the path of this layer by a "rect"
+     * instruction, to be filled by a subsequent "cfill" instruction.
+     */
+    guac_rect path;
+
+} guac_replay_layer;
+
+/**
+ * Replay-specific client data.
+ */
+typedef struct guac_replay_client {
+
+    /**
+     * Replay connection settings.
+     */
+    guac_replay_settings* settings;
+
+    /**
+     * The thread which reads and replays the recording.
+     */
+    pthread_t client_thread;
+
+    /**
+     * The display which receives all drawing operations from the recording.
+     */
+    guac_display* display;
+
+    /**
+     * All visible layers referenced by the recording, indexed by layer
+     * index.
+     */
+    guac_replay_layer layers[GUAC_REPLAY_MAX_LAYERS];
+
+    /**
+     * All off-screen buffers referenced by the recording, where the buffer
+     * having index -1 is stored at index 0, -2 at index 1, etc.
+     */
+    guac_replay_layer buffers[GUAC_REPLAY_MAX_BUFFERS];
+
+    /**
+     * All image streams within the recording, indexed by stream index.
+     */
+    guac_replay_image_stream streams[GUAC_CLIENT_MAX_STREAMS];
+
+    /**
+     * The timestamp of the first frame of the current pass through the
+     * recording, as recorded within the recording itself, or zero if no
+     * frame has yet been replayed.
+     */
+    guac_timestamp first_frame;
+
+    /**
+     * The local time at which the first frame of the current pass through the
+     * recording was replayed.
+     */
+    guac_timestamp first_frame_replayed;
+
+} guac_replay_client;
+
+/**
+ * Returns the layer or buffer having the given index within the recording
+ * being replayed, allocating a corresponding layer or buffer within the
+ * guac_display if not yet allocated.
+ *
+ * @param replay_client
+ *     The replay client whose recording references the layer.
+ *
+ * @param index
+ *     The index of the layer (zero or positive) or buffer (negative).
+ *
+ * @return
+ *     The layer or buffer having the given index, or NULL if the index is
+ *     out of range.
+ */
+guac_replay_layer* guac_replay_get_layer(guac_replay_client* replay_client,
+        int index);
+
+/**
+ * Frees the layer or buffer having the given index within the recording
+ * being replayed, if allocated.
+ *
+ * @param replay_client
+ *     The replay client whose recording references the layer.
+ *
+ * @param index
+ *     The index of the layer (positive) or buffer (negative). The default
+ *     layer (zero) cannot be freed.
+ */
+void guac_replay_free_layer(guac_replay_client* replay_client, int index);
+
+/**
+ * Grows the given layer or buffer, if it is an automatically-sized buffer,
+ * such that it contains the given rectangle.
+ *
+ * @param layer
+ *     The layer or buffer that will be drawn to.
+ *
+ * @param rect
+ *     The rectangle that will be drawn within the layer or buffer.
+ */
+void guac_replay_fit_layer(guac_replay_layer* layer, const guac_rect* rect);
+
+/**
+ * Waits until the given recorded frame should be replayed, based on the
+ * configured playback speed and the timestamp of the first frame replayed,
+ * and then ends the current frame of the display.
+ *
+ * @param client
+ *     The guac_client associated with the replay connection.
+ *
+ * @param timestamp
+ *     The timestamp of the frame, as recorded within the recording.
+ */
+void guac_replay_end_frame(guac_client* client, guac_timestamp timestamp);
+
+/**
+ * Replay client thread. This thread reads the configured recording, replaying
+ * its drawing operations to the display until the end of the recording is
+ * reached (or, if looping, until the connection is closed).
+ *
+ * @param data
+ *     The guac_client instance associated with the replay connection.
+ *
+ * @return
+ *     Always NULL.
+ */
+void* guac_replay_client_thread(void* data);
+
+#endif
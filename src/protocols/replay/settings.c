@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "settings.h"
+
+#include <guacamole/mem.h>
+#include <guacamole/user.h>
+
+#include <stdlib.h>
+
+/* Client plugin arguments */
+const char* GUAC_REPLAY_CLIENT_ARGS[] = {
+    "recording-path",
+    "speed",
+    "loop",
+    NULL
+};
+
+enum REPLAY_ARGS_IDX {
+
+    /**
+     * The full path to the Guacamole protocol recording to replay. Required.
+     */
+    IDX_RECORDING_PATH,
+
+    /**
+     * The playback speed, as a percentage of the original speed of the
+     * recording. If zero, the recording is replayed as quickly as possible.
+     * By default, the recording is replayed at its original speed.
+     */
+    IDX_SPEED,
+
+    /**
+     * "true" if the recording should be replayed repeatedly until the
+     * connection is closed, "false" or blank otherwise.
+     */
+    IDX_LOOP,
+
+    REPLAY_ARGS_COUNT
+};
+
+guac_replay_settings* guac_replay_parse_args(guac_user* user,
+        int argc, const char** argv) {
+
+    /* Validate arg count */
+    if (argc != REPLAY_ARGS_COUNT) {
+        guac_user_log(user, GUAC_LOG_WARNING, "Incorrect number of connection "
+                "parameters provided: expected %i, got %i.",
+                REPLAY_ARGS_COUNT, argc);
+        return NULL;
+    }
+
+    guac_replay_settings* settings = guac_mem_zalloc(sizeof(guac_replay_settings));
+
+    /* Read path of recording */
+    settings->recording_path =
+        guac_user_parse_args_string(user, GUAC_REPLAY_CLIENT_ARGS, argv,
+                IDX_RECORDING_PATH, NULL);
+
+    /* Recording is required */
+    if (settings->recording_path == NULL) {
+        guac_user_log(user, GUAC_LOG_WARNING, "The path of the recording to "
+                "replay must be specified.");
+        guac_replay_settings_free(settings);
+        return NULL;
+    }
+
+    /* Read playback speed */
+    settings->speed =
+        guac_user_parse_args_int(user, GUAC_REPLAY_CLIENT_ARGS, argv,
+                IDX_SPEED, GUAC_REPLAY_DEFAULT_SPEED);
+
+    if (settings->speed < 0)
+        settings->speed = 0;
+
+    /* Read whether recording should loop */
+    settings->loop =
+        guac_user_parse_args_boolean(user, GUAC_REPLAY_CLIENT_ARGS, argv,
+                IDX_LOOP, false);
+
+    /* Parsing was successful */
+    return settings;
+
+}
+
+void guac_replay_settings_free(guac_replay_settings* settings) {
+    guac_mem_free(settings->recording_path);
+    guac_mem_free(settings);
+}
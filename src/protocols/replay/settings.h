@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_REPLAY_SETTINGS_H
+#define GUAC_REPLAY_SETTINGS_H
+
+#include "config.h"
+
+#include <guacamole/user.h>
+
+#include <stdbool.h>
+
+/**
+ * The default playback speed, as a percentage of the speed at which the
+ * recording was originally made.
+ */
+#define GUAC_REPLAY_DEFAULT_SPEED 100
+
+/**
+ * Settings for the replay connection. The values for this structure are
+ * parsed from the arguments given during the Guacamole protocol handshake
+ * using the guac_replay_parse_args() function.
+ */
+typedef struct guac_replay_settings {
+
+    /**
+     * The full path to the Guacamole protocol recording that should be
+     * replayed, as produced by guac_recording_create().
+     */
+    char* recording_path;
+
+    /**
+     * The playback speed, as a percentage of the speed at which the recording
+     * was originally made. If zero, the recording is replayed as quickly as
+     * possible, without waiting between frames.
+     */
+    int speed;
+
+    /**
+     * Whether the recording should be replayed again from the beginning once
+     * its end is reached, rather than ending the connection.
+     */
+    bool loop;
+
+} guac_replay_settings;
+
+/**
+ * Parses all given args, storing them in a newly-allocated settings object. If
+ * the args fail to parse, NULL is returned.
+ *
+ * @param user
+ *     The user who submitted the given arguments while joining the
+ *     connection.
+ *
+ * @param argc
+ *     The number of arguments within the argv array.
+ *
+ * @param argv
+ *     The values of all arguments provided by the user.
+ *
+ * @return
+ *     A newly-allocated settings object which must be freed with
+ *     guac_replay_settings_free() when no longer needed. If the arguments
+ *     fail to parse, NULL is returned.
+ */
+guac_replay_settings* guac_replay_parse_args(guac_user* user,
+        int argc, const char** argv);
+
+/**
+ * Frees the given guac_replay_settings object, having been previously
+ * allocated via guac_replay_parse_args().
+ *
+ * @param settings
+ *     The settings object to free.
+ */
+void guac_replay_settings_free(guac_replay_settings* settings);
+
+/**
+ * NULL-terminated array of accepted client args.
+ */
+extern const char* GUAC_REPLAY_CLIENT_ARGS[];
+
+#endif
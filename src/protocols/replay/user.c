@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "replay.h"
+#include "settings.h"
+#include "user.h"
+
+#include <guacamole/client.h>
+#include <guacamole/display.h>
+#include <guacamole/protocol.h>
+#include <guacamole/user.h>
+
+#include <pthread.h>
+
+/**
+ * Handler for mouse events, updating the mouse position displayed to other
+ * users. Replayed connections accept no other input.
+ */
+static int guac_replay_user_mouse_handler(guac_user* user, int x, int y,
+        int mask) {
+
+    guac_replay_client* replay_client =
+        (guac_replay_client*) user->client->data;
+
+    guac_display_notify_user_moved_mouse(replay_client->display, user,
+            x, y, mask);
+
+    return 0;
+
+}
+
+int guac_replay_user_join_handler(guac_user* user, int argc, char** argv) {
+
+    guac_client* client = user->client;
+    guac_replay_client* replay_client = (guac_replay_client*) client->data;
+
+    /* Parse provided arguments */
+    guac_replay_settings* settings = guac_replay_parse_args(user,
+            argc, (const char**) argv);
+
+    /* Fail if settings cannot be parsed */
+    if (settings == NULL) {
+        guac_user_log(user, GUAC_LOG_INFO,
+                "Badly formatted client arguments.");
+        return 1;
+    }
+
+    /* Store settings at user level */
+    user->data = settings;
+
+    /* Begin replay if owner */
+    if (user->owner) {
+
+        /* Store owner's settings at client level */
+        replay_client->settings = settings;
+
+        /* Start client thread */
+        if (pthread_create(&(replay_client->client_thread), NULL,
+                    guac_replay_client_thread, (void*) client)) {
+            replay_client->settings = NULL;
+            guac_client_abort(client, GUAC_PROTOCOL_STATUS_SERVER_ERROR,
+                    "Unable to start replay client thread");
+            return 1;
+        }
+
+    }
+
+    user->mouse_handler = guac_replay_user_mouse_handler;
+
+    return 0;
+
+}
+
+int guac_replay_user_leave_handler(guac_user* user) {
+
+    guac_replay_client* replay_client =
+        (guac_replay_client*) user->client->data;
+
+    /* Remove the user from the display */
+    guac_display_notify_user_left(replay_client->display, user);
+
+    /* Free settings if not owner (owner settings will be freed with client) */
+    if (!user->owner) {
+        guac_replay_settings* settings = (guac_replay_settings*) user->data;
+        guac_replay_settings_free(settings);
+    }
+
+    return 0;
+}
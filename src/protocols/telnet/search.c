@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "search.h"
+#include "settings.h"
+#include "telnet.h"
+#include "terminal/terminal.h"
+
+#include <guacamole/client.h>
+#include <guacamole/protocol.h>
+
+#include <regex.h>
+#include <stdbool.h>
+
+/**
+ * Matches the given line against the given regex, returning true and sending
+ * the given value if a match is found. An enter keypress is automatically
+ * sent after the value is sent.
+ *
+ * @param client
+ *     The guac_client associated with the telnet session.
+ *
+ * @param regex
+ *     The regex to search for within the given line buffer.
+ *
+ * @param value
+ *     The string value to send through STDIN of the telnet session if a
+ *     match is found, or NULL if no value should be sent.
+ *
+ * @param line_buffer
+ *     The line of character data to test.
+ *
+ * @return
+ *     true if a match is found, false otherwise.
+ */
+static bool guac_telnet_regex_exec(guac_client* client, regex_t* regex,
+        const char* value, const char* line_buffer) {
+
+    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
+
+    /* Send value upon match */
+    if (regexec(regex, line_buffer, 0, NULL, 0) == 0) {
+
+        /* Send value */
+        if (value != NULL) {
+            guac_terminal_send_string(telnet_client->term, value);
+            guac_terminal_send_string(telnet_client->term, "\x0D");
+        }
+
+        /* Stop searching for prompt */
+        return true;
+
+    }
+
+    return false;
+
+}
+
+/**
+ * Matches the given line against the various stored regexes, automatically
+ * sending the configured username, password, or reporting login
+ * success/failure depending on context. If no search is in progress, either
+ * because no regexes have been defined or because all applicable searches have
+ * completed, this function has no effect.
+ *
+ * @param client
+ *     The guac_client associated with the telnet session.
+ *
+ * @param line_buffer
+ *     The line of character data to test.
+ */
+static void guac_telnet_search_line(guac_client* client, const char* line_buffer) {
+
+    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
+    guac_telnet_settings* settings = telnet_client->settings;
+
+    /* Continue search for username prompt */
+    if (settings->username_regex != NULL) {
+        if (guac_telnet_regex_exec(client, settings->username_regex,
+                    settings->username, line_buffer)) {
+            guac_client_log(client, GUAC_LOG_DEBUG, "Username sent");
+            guac_telnet_regex_free(&settings->username_regex);
+        }
+    }
+
+    /* Continue search for password prompt */
+    if (settings->password_regex != NULL) {
+        if (guac_telnet_regex_exec(client, settings->password_regex,
+                    settings->password, line_buffer)) {
+
+            guac_client_log(client, GUAC_LOG_DEBUG, "Password sent");
+
+            /* Do not continue searching for username/password once password is sent */
+            guac_telnet_regex_free(&settings->username_regex);
+            guac_telnet_regex_free(&settings->password_regex);
+
+        }
+    }
+
+    /* Continue search for login success */
+    if (settings->login_success_regex != NULL) {
+        if (guac_telnet_regex_exec(client, settings->login_success_regex,
+                    NULL, line_buffer)) {
+
+            /* Allow terminal to render now that login has been deemed successful */
+            guac_client_log(client, GUAC_LOG_DEBUG, "Login successful");
+            guac_terminal_start(telnet_client->term);
+
+            /* Stop all searches */
+            guac_telnet_regex_free(&settings->username_regex);
+            guac_telnet_regex_free(&settings->password_regex);
+            guac_telnet_regex_free(&settings->login_success_regex);
+            guac_telnet_regex_free(&settings->login_failure_regex);
+
+        }
+    }
+
+    /* Continue search for login failure */
+    if (settings->login_failure_regex != NULL) {
+        if (guac_telnet_regex_exec(client, settings->login_failure_regex,
+                    NULL, line_buffer)) {
+
+            /* Advise that login has failed and connection should be closed */
+            guac_client_abort(client,
+                    GUAC_PROTOCOL_STATUS_CLIENT_UNAUTHORIZED,
+                    "Login failed");
+
+            /* Stop all searches */
+            guac_telnet_regex_free(&settings->username_regex);
+            guac_telnet_regex_free(&settings->password_regex);
+            guac_telnet_regex_free(&settings->login_success_regex);
+            guac_telnet_regex_free(&settings->login_failure_regex);
+
+        }
+    }
+
+}
+
+void guac_telnet_search_append(guac_client* client, const char* buffer,
+        int size) {
+
+    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
+    guac_telnet_settings* settings = telnet_client->settings;
+    guac_telnet_search* search = &telnet_client->search;
+
+    /* Nothing to do if all searches have completed */
+    if (settings->username_regex == NULL
+            && settings->password_regex == NULL
+            && settings->login_success_regex == NULL
+            && settings->login_failure_regex == NULL)
+        return;
+
+    /* Append all characters in buffer to current line */
+    const char* current = buffer;
+    for (int i = 0; i < size; i++) {
+
+        char c = *(current++);
+
+        /* Attempt pattern match and clear buffer upon reading newline (unless
+         * that same line was already tested in its entirety) */
+        if (c == '\n') {
+            if (search->length > 0) {
+
+                if (search->tested_length != search->length) {
+                    search->line[search->length] = '\0';
+                    guac_telnet_search_line(client, search->line);
+                }
+
+                search->length = 0;
+                search->tested_length = 0;
+
+            }
+        }
+
+        /* Append all non-newline characters to line buffer as long as space
+         * remains */
+        else if (search->length < sizeof(search->line) - 1)
+            search->line[search->length++] = c;
+
+    }
+
+}
+
+void guac_telnet_search_flush(guac_client* client) {
+
+    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
+    guac_telnet_search* search = &telnet_client->search;
+
+    /* Attempt pattern match if an unfinished line remains that has not yet
+     * been tested (may be a prompt). Any change to that line requires the
+     * whole line to be tested again, as regexec() cannot resume a partial
+     * match from where the previous test left off. */
+    if (search->length > 0 && search->tested_length != search->length) {
+        search->line[search->length] = '\0';
+        guac_telnet_search_line(client, search->line);
+        search->tested_length = search->length;
+    }
+
+}
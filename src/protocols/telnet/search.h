@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TELNET_SEARCH_H
+#define GUAC_TELNET_SEARCH_H
+
+#include "config.h"
+
+#include <guacamole/client.h>
+
+/**
+ * The maximum number of bytes of a single line of output that will be tested
+ * against the username/password and login success/failure regexes, including
+ * the null terminator. Any further bytes of the line are ignored.
+ */
+#define GUAC_TELNET_SEARCH_LINE_SIZE 1024
+
+/**
+ * The state of the search for the username/password prompts and the login
+ * success/failure messages within the output of a single telnet connection.
+ * Each complete line of output is tested exactly once, as soon as that line
+ * ends. An unterminated line (which may be a prompt awaiting a response) is
+ * tested only when the remote end has stopped sending data, such that output
+ * arriving in many small pieces is not retested with each piece.
+ *
+ * POSIX regexes cannot resume a partial match, so each test of an
+ * unterminated line covers the whole line buffered so far, not just the
+ * bytes received since the last test. A line that arrives in pauses may
+ * therefore be tested more than once. Each such test examines at most
+ * GUAC_TELNET_SEARCH_LINE_SIZE - 1 bytes per regex. A line that has filled
+ * the buffer no longer changes, so it is not tested again until it ends.
+ */
+typedef struct guac_telnet_search {
+
+    /**
+     * The current, possibly unterminated, line of output.
+     */
+    char line[GUAC_TELNET_SEARCH_LINE_SIZE];
+
+    /**
+     * The number of bytes currently stored within the line buffer, excluding
+     * the null terminator.
+     */
+    int length;
+
+    /**
+     * The length of the line buffer when the unterminated line was last
+     * tested, or zero if the current line has not yet been tested. An
+     * unterminated line is not retested unless its content has changed.
+     */
+    int tested_length;
+
+} guac_telnet_search;
+
+/**
+ * Adds the given output to the search state of the given telnet connection,
+ * testing each line completed by that output against the various stored
+ * regexes and automatically sending the configured username, password, or
+ * reporting login success/failure depending on context. If no search is in
+ * progress, either because no regexes have been defined or because all
+ * applicable searches have completed, this function has no effect.
+ *
+ * @param client
+ *     The guac_client associated with the telnet session.
+ *
+ * @param buffer
+ *     The buffer of received data to search through.
+ *
+ * @param size
+ *     The size of the given buffer, in bytes.
+ */
+void guac_telnet_search_append(guac_client* client, const char* buffer,
+        int size);
+
+/**
+ * Tests the current unterminated line of output of the given telnet
+ * connection, if any, against the various stored regexes. This function
+ * should be invoked whenever the remote end appears to be waiting for input,
+ * such as after all currently-available data has been received. An
+ * unterminated line that has already been tested is not tested again unless
+ * more output has since been appended to that line, in which case the entire
+ * line is tested again.
+ *
+ * @param client
+ *     The guac_client associated with the telnet session.
+ */
+void guac_telnet_search_flush(guac_client* client);
+
+#endif
@@ -89,181 +89,6 @@ static int __guac_telnet_write_all(int fd, const char* buffer, int size) {
 
 }
 
-/**
- * Matches the given line against the given regex, returning true and sending
- * the given value if a match is found. An enter keypress is automatically
- * sent after the value is sent.
- *
- * @param client
- *     The guac_client associated with the telnet session.
- *
- * @param regex
- *     The regex to search for within the given line buffer.
- *
- * @param value
- *     The string value to send through STDIN of the telnet session if a
- *     match is found, or NULL if no value should be sent.
- *
- * @param line_buffer
- *     The line of character data to test.
- *
- * @return
- *     true if a match is found, false otherwise.
- */
-static bool guac_telnet_regex_exec(guac_client* client, regex_t* regex,
-        const char* value, const char* line_buffer) {
-
-    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
-
-    /* Send value upon match */
-    if (regexec(regex, line_buffer, 0, NULL, 0) == 0) {
-
-        /* Send value */
-        if (value != NULL) {
-            guac_terminal_send_string(telnet_client->term, value);
-            guac_terminal_send_string(telnet_client->term, "\x0D");
-        }
-
-        /* Stop searching for prompt */
-        return true;
-
-    }
-
-    return false;
-
-}
-
-/**
- * Matches the given line against the various stored regexes, automatically
- * sending the configured username, password, or reporting login
- * success/failure depending on context. If no search is in progress, either
- * because no regexes have been defined or because all applicable searches have
- * completed, this function has no effect.
- *
- * @param client
- *     The guac_client associated with the telnet session.
- *
- * @param line_buffer
- *     The line of character data to test.
- */
-static void guac_telnet_search_line(guac_client* client, const char* line_buffer) {
-
-    guac_telnet_client* telnet_client = (guac_telnet_client*) client->data;
-    guac_telnet_settings* settings = telnet_client->settings;
-
-    /* Continue search for username prompt */
-    if (settings->username_regex != NULL) {
-        if (guac_telnet_regex_exec(client, settings->username_regex,
-                    settings->username, line_buffer)) {
-            guac_client_log(client, GUAC_LOG_DEBUG, "Username sent");
-            guac_telnet_regex_free(&settings->username_regex);
-        }
-    }
-
-    /* Continue search for password prompt */
-    if (settings->password_regex != NULL) {
-        if (guac_telnet_regex_exec(client, settings->password_regex,
-                    settings->password, line_buffer)) {
-
-            guac_client_log(client, GUAC_LOG_DEBUG, "Password sent");
-
-            /* Do not continue searching for username/password once password is sent */
-            guac_telnet_regex_free(&settings->username_regex);
-            guac_telnet_regex_free(&settings->password_regex);
-
-        }
-    }
-
-    /* Continue search for login success */
-    if (settings->login_success_regex != NULL) {
-        if (guac_telnet_regex_exec(client, settings->login_success_regex,
-                    NULL, line_buffer)) {
-
-            /* Allow terminal to render now that login has been deemed successful */
-            guac_client_log(client, GUAC_LOG_DEBUG, "Login successful");
-            guac_terminal_start(telnet_client->term);
-
-            /* Stop all searches */
-            guac_telnet_regex_free(&settings->username_regex);
-            guac_telnet_regex_free(&settings->password_regex);
-            guac_telnet_regex_free(&settings->login_success_regex);
-            guac_telnet_regex_free(&settings->login_failure_regex);
-
-        }
-    }
-
-    /* Continue search for login failure */
-    if (settings->login_failure_regex != NULL) {
-        if (guac_telnet_regex_exec(client, settings->login_failure_regex,
-                    NULL, line_buffer)) {
-
-            /* Advise that login has failed and connection should be closed */
-            guac_client_abort(client,
-                    GUAC_PROTOCOL_STATUS_CLIENT_UNAUTHORIZED,
-                    "Login failed");
-
-            /* Stop all searches */
-            guac_telnet_regex_free(&settings->username_regex);
-            guac_telnet_regex_free(&settings->password_regex);
-            guac_telnet_regex_free(&settings->login_success_regex);
-            guac_telnet_regex_free(&settings->login_failure_regex);
-
-        }
-    }
-
-}
-
-/**
- * Searches for a line matching the various stored regexes, automatically
- * sending the configured username, password, or reporting login
- * success/failure depending on context. If no search is in progress, either
- * because no regexes have been defined or because all applicable searches
- * have completed, this function has no effect.
- *
- * @param client
- *     The guac_client associated with the telnet session.
- *
- * @param buffer
- *     The buffer of received data to search through.
- *
- * @param size
- *     The size of the given buffer, in bytes.
- */
-static void guac_telnet_search(guac_client* client, const char* buffer, int size) {
-
-    static char line_buffer[1024] = {0};
-    static int length = 0;
-
-    /* Append all characters in buffer to current line */
-    const char* current = buffer;
-    for (int i = 0; i < size; i++) {
-
-        char c = *(current++);
-
-        /* Attempt pattern match and clear buffer upon reading newline */
-        if (c == '\n') {
-            if (length > 0) {
-                line_buffer[length] = '\0';
-                guac_telnet_search_line(client, line_buffer);
-                length = 0;
-            }
-        }
-
-        /* Append all non-newline characters to line buffer as long as space
-         * remains */
-        else if (length < sizeof(line_buffer) - 1)
-            line_buffer[length++] = c;
-
-    }
-
-    /* Attempt pattern match if an unfinished line remains (may be a prompt) */
-    if (length > 0) {
-        line_buffer[length] = '\0';
-        guac_telnet_search_line(client, line_buffer);
-    }
-
-}
-
 /**
  * Event handler, as defined by libtelnet. This function is passed to
  * telnet_init() and will be called for every event fired by libtelnet,
@@ -280,7 +105,7 @@ static void __guac_telnet_event_handler(telnet_t* telnet, telnet_event_t* event,
         /* Terminal output received */
         case TELNET_EV_DATA:
             guac_terminal_write(telnet_client->term, event->data.buffer, event->data.size);
-            guac_telnet_search(client, event->data.buffer, event->data.size);
+            guac_telnet_search_append(client, event->data.buffer, event->data.size);
             break;
 
         /* Data destined for remote end */
@@ -461,15 +286,16 @@ void guac_telnet_send_user(telnet_t* telnet, const char* username) {
 }
 
 /**
- * Waits for data on the given file descriptor for up to one second. The
- * return value is identical to that of select(): 0 on timeout, < 0 on
- * error, and > 0 on success.
+ * Waits for data on the given file descriptor for up to the given number of
+ * milliseconds. The return value is identical to that of select(): 0 on
+ * timeout, < 0 on error, and > 0 on success.
  *
  * @param socket_fd The file descriptor to wait for.
+ * @param timeout The maximum amount of time to wait, in milliseconds.
  * @return A value greater than zero on success, zero on timeout, and
  *         less than zero on error.
  */
-static int __guac_telnet_wait(int socket_fd) {
+static int __guac_telnet_wait(int socket_fd, int timeout) {
 
     /* Build array of file descriptors */
     struct pollfd fds[] = {{
@@ -478,8 +304,7 @@ static int __guac_telnet_wait(int socket_fd) {
         .revents = 0,
     }};
 
-    /* Wait for one second */
-    return poll(fds, 1, 1000);
+    return poll(fds, 1, timeout);
 
 }
 
@@ -601,7 +426,7 @@ void* guac_telnet_client_thread(void* data) {
     }
 
     /* While data available, write to terminal */
-    while ((wait_result = __guac_telnet_wait(telnet_client->socket_fd)) >= 0) {
+    while ((wait_result = __guac_telnet_wait(telnet_client->socket_fd, 1000)) >= 0) {
 
         /* Resume waiting of no data available */
         if (wait_result == 0)
@@ -613,6 +438,12 @@ void* guac_telnet_client_thread(void* data) {
 
         telnet_recv(telnet_client->telnet, buffer, bytes_read);
 
+        /* Test any unterminated line for prompts only once the remote end
+         * has stopped sending data, as that is when a prompt would be
+         * awaiting a response */
+        if (__guac_telnet_wait(telnet_client->socket_fd, 0) == 0)
+            guac_telnet_search_flush(client);
+
     }
 
     /* Kill client and Wait for input thread to die */
@@ -21,6 +21,7 @@
 #define GUAC_TELNET_H
 
 #include "config.h"
+#include "search.h"
 #include "settings.h"
 #include "terminal/terminal.h"
 
@@ -77,6 +78,12 @@ typedef struct guac_telnet_client {
      */
     guac_recording* recording;
 
+    /**
+     * The state of the search for the username/password prompts and login
+     * success/failure messages within the output of the telnet session.
+     */
+    guac_telnet_search search;
+
 } guac_telnet_client;
 
 /**
@@ -74,48 +74,27 @@ void guac_vnc_update(rfbClient* client, int x, int y, int w, int h) {
         /* Ensure draw is within current bounds of the pending frame */
         guac_rect_constrain(&op_bounds, &context->bounds);
 
+        /* Rebuild conversion tables if the VNC server did not honor the
+         * requested pixel format */
+        guac_vnc_pixel_converter* converter = &vnc_client->pixel_converter;
+        if (!guac_vnc_pixel_converter_matches(converter, &client->format,
+                    vnc_client->settings->swap_red_blue))
+            guac_vnc_pixel_converter_init(converter, &client->format,
+                    vnc_client->settings->swap_red_blue);
+
         const unsigned char* vnc_current_row = GUAC_RECT_CONST_BUFFER(op_bounds, client->frameBuffer, vnc_stride, vnc_bpp);
         unsigned char* layer_current_row = GUAC_RECT_MUTABLE_BUFFER(op_bounds, context->buffer, context->stride, GUAC_DISPLAY_LAYER_RAW_BPP);
         for (int dy = op_bounds.top; dy < op_bounds.bottom; dy++) {
 
-            /* Get current Guacamole buffer row, advance to next */
-            uint32_t* layer_current_pixel = (uint32_t*) layer_current_row;
-            layer_current_row += context->stride;
+            /* Convert current VNC framebuffer row into current Guacamole
+             * buffer row */
+            guac_vnc_pixel_converter_convert_row(converter, vnc_current_row,
+                    (uint32_t*) layer_current_row, guac_rect_width(&op_bounds));
 
-            /* Get current VNC framebuffer row, advance to next */
-            const unsigned char* vnc_current_pixel = vnc_current_row;
+            /* Advance to next row of each */
+            layer_current_row += context->stride;
             vnc_current_row += vnc_stride;
 
-            for (int dx = op_bounds.left; dx < op_bounds.right; dx++) {
-
-                /* Read current VNC pixel value */
-                uint32_t v;
-                switch (vnc_bpp) {
-
-                    case 2:
-                        v = *((uint16_t*) vnc_current_pixel);
-                        break;
-
-                    default:
-                        v = *((uint8_t*) vnc_current_pixel);
-
-                }
-
-                /* Translate value to 32-bit RGB */
-                uint8_t red   = (v >> client->format.redShift)   * 0x100 / (client->format.redMax   + 1);
-                uint8_t green = (v >> client->format.greenShift) * 0x100 / (client->format.greenMax + 1);
-                uint8_t blue  = (v >> client->format.blueShift)  * 0x100 / (client->format.blueMax  + 1);
-
-                /* Output RGB */
-                if (vnc_client->settings->swap_red_blue)
-                    *(layer_current_pixel++) = 0xFF000000 | (blue << 16) | (green << 8) | red;
-                else
-                    *(layer_current_pixel++) = 0xFF000000 | (red  << 16) | (green << 8) | blue;
-
-                /* Advance to next pixel in VNC framebuffer */
-                vnc_current_pixel += vnc_bpp;
-
-            }
         }
 
     } /* end manual convert */
@@ -362,6 +341,13 @@ void guac_vnc_set_pixel_format(rfbClient* client, int color_depth) {
             client->format.redMax       = 0xff;
             client->format.greenMax     = 0xff;
     }
+
+    /* Precompute conversion from the requested format */
+    guac_client* gc = rfbClientGetClientData(client, GUAC_VNC_CLIENT_KEY);
+    guac_vnc_client* vnc_client = (guac_vnc_client*) gc->data;
+    guac_vnc_pixel_converter_init(&vnc_client->pixel_converter,
+            &client->format, vnc_client->settings->swap_red_blue);
+
 }
 
 rfbBool guac_vnc_malloc_framebuffer(rfbClient* rfb_client) {
@@ -122,7 +122,10 @@ void guac_vnc_display_set_size(rfbClient* client, int requested_width, int reque
  * Sets the pixel format to request of the VNC server. The request will be made
  * during the connection handshake with the VNC server using the values
  * specified by this function. Note that the VNC server is not required to
- * honor this request.
+ * honor this request. Any tables needed to convert pixels of the requested
+ * format to the format used by guac_display are built here, and are rebuilt
+ * automatically by guac_vnc_update() if the VNC server uses a different
+ * format.
  *
  * @param client
  *     The VNC client associated with the VNC session whose desired pixel
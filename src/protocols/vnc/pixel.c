@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "pixel.h"
+
+#include <guacamole/mem.h>
+#include <rfb/rfbclient.h>
+#include <rfb/rfbproto.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Converts a single VNC pixel value of the given format to 32-bit ARGB,
+ * scaling each component to 8 bits.
+ *
+ * @param format
+ *     The pixel format of the VNC pixel value.
+ *
+ * @param swap_red_blue
+ *     Whether the red and blue components of the pixel should be swapped.
+ *
+ * @param v
+ *     The VNC pixel value to convert.
+ *
+ * @return
+ *     The converted, fully-opaque 32-bit ARGB pixel.
+ */
+static uint32_t guac_vnc_pixel_convert(const rfbPixelFormat* format,
+        bool swap_red_blue, uint32_t v) {
+
+    /* Translate value to 32-bit RGB */
+    uint8_t red   = ((v >> format->redShift)   & format->redMax)   * 0x100 / (format->redMax   + 1);
+    uint8_t green = ((v >> format->greenShift) & format->greenMax) * 0x100 / (format->greenMax + 1);
+    uint8_t blue  = ((v >> format->blueShift)  & format->blueMax)  * 0x100 / (format->blueMax  + 1);
+
+    /* Output RGB */
+    if (swap_red_blue)
+        return 0xFF000000 | (blue << 16) | (green << 8) | red;
+
+    return 0xFF000000 | (red << 16) | (green << 8) | blue;
+
+}
+
+void guac_vnc_pixel_converter_init(guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, bool swap_red_blue) {
+
+    /* Release table of any previous format */
+    guac_vnc_pixel_converter_free(converter);
+
+    converter->format = *format;
+    converter->swap_red_blue = swap_red_blue;
+    converter->bpp = format->bitsPerPixel / 8;
+
+    /* Formats having 8-bit components need only be shifted and masked */
+    converter->direct = (format->redMax == 0xFF && format->greenMax == 0xFF
+            && format->blueMax == 0xFF);
+
+    converter->red_shift   = swap_red_blue ? format->blueShift : format->redShift;
+    converter->green_shift = format->greenShift;
+    converter->blue_shift  = swap_red_blue ? format->redShift : format->blueShift;
+
+    /* 32-bit formats are converted without a table */
+    if (converter->bpp != 1 && converter->bpp != 2)
+        return;
+
+    /* Precompute the converted value of every possible pixel (the table is
+     * only 1 KB for 8-bit formats and 256 KB for 16-bit formats) */
+    size_t entries = (converter->bpp == 1) ? 0x100 : 0x10000;
+    converter->table = guac_mem_alloc(sizeof(uint32_t), entries);
+
+    /* Each pixel will be converted individually if allocation fails */
+    if (converter->table == NULL)
+        return;
+
+    for (size_t v = 0; v < entries; v++)
+        converter->table[v] = guac_vnc_pixel_convert(format, swap_red_blue, v);
+
+}
+
+bool guac_vnc_pixel_converter_matches(const guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, bool swap_red_blue) {
+
+    const rfbPixelFormat* current = &converter->format;
+
+    return converter->swap_red_blue == swap_red_blue
+        && current->bitsPerPixel    == format->bitsPerPixel
+        && current->redMax          == format->redMax
+        && current->greenMax        == format->greenMax
+        && current->blueMax         == format->blueMax
+        && current->redShift        == format->redShift
+        && current->greenShift      == format->greenShift
+        && current->blueShift       == format->blueShift;
+
+}
+
+/**
+ * Converts a single row of 32-bit VNC pixels whose components are each
+ * exactly 8 bits, shifting and masking each component into place. Where
+ * supported by the CPU, four pixels are converted at a time using SIMD
+ * instructions.
+ *
+ * @param converter
+ *     The converter to use, which must have been initialized for a 32-bit
+ *     format having 8-bit components.
+ *
+ * @param src
+ *     The first pixel of the row of VNC pixels to convert.
+ *
+ * @param dst
+ *     The first pixel of the row of 32-bit ARGB pixels that should receive
+ *     the converted pixels.
+ *
+ * @param width
+ *     The number of pixels in the row.
+ */
+static void guac_vnc_pixel_convert_row_direct(
+        const guac_vnc_pixel_converter* converter, const unsigned char* src,
+        uint32_t* dst, int width) {
+
+    int red_shift   = converter->red_shift;
+    int green_shift = converter->green_shift;
+    int blue_shift  = converter->blue_shift;
+
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i component_mask = _mm_set1_epi32(0xFF);
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+    const __m128i red_count   = _mm_cvtsi32_si128(red_shift);
+    const __m128i green_count = _mm_cvtsi32_si128(green_shift);
+    const __m128i blue_count  = _mm_cvtsi32_si128(blue_shift);
+
+    for (; x + 4 <= width; x += 4) {
+
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + x * 4));
+
+        __m128i red   = _mm_and_si128(_mm_srl_epi32(v, red_count),   component_mask);
+        __m128i green = _mm_and_si128(_mm_srl_epi32(v, green_count), component_mask);
+        __m128i blue  = _mm_and_si128(_mm_srl_epi32(v, blue_count),  component_mask);
+
+        __m128i argb = _mm_or_si128(
+                _mm_or_si128(alpha, _mm_slli_epi32(red, 16)),
+                _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+
+        _mm_storeu_si128((__m128i*) (dst + x), argb);
+
+    }
+#endif
+
+    /* Convert any remaining pixels individually */
+    for (; x < width; x++) {
+
+        uint32_t v;
+        memcpy(&v, src + x * 4, sizeof(v));
+
+        dst[x] = 0xFF000000
+            | (((v >> red_shift)   & 0xFF) << 16)
+            | (((v >> green_shift) & 0xFF) << 8)
+            |  ((v >> blue_shift)  & 0xFF);
+
+    }
+
+}
+
+void guac_vnc_pixel_converter_convert_row(
+        const guac_vnc_pixel_converter* converter, const unsigned char* src,
+        uint32_t* dst, int width) {
+
+    const uint32_t* table = converter->table;
+
+    /* 8-bit and 16-bit pixels are simply looked up */
+    if (table != NULL) {
+
+        if (converter->bpp == 2) {
+            const uint16_t* src_pixel = (const uint16_t*) src;
+            for (int x = 0; x < width; x++)
+                dst[x] = table[src_pixel[x]];
+        }
+
+        else {
+            for (int x = 0; x < width; x++)
+                dst[x] = table[src[x]];
+        }
+
+        return;
+
+    }
+
+    /* 32-bit pixels with 8-bit components need only be rearranged */
+    if (converter->bpp == 4 && converter->direct) {
+        guac_vnc_pixel_convert_row_direct(converter, src, dst, width);
+        return;
+    }
+
+    /* Convert all other pixels individually */
+    for (int x = 0; x < width; x++) {
+
+        /* Read current VNC pixel value */
+        uint32_t v;
+        switch (converter->bpp) {
+
+            case 4:
+                v = *((uint32_t*) src);
+                break;
+
+            case 2:
+                v = *((uint16_t*) src);
+                break;
+
+            default:
+                v = *((uint8_t*) src);
+
+        }
+
+        dst[x] = guac_vnc_pixel_convert(&converter->format,
+                converter->swap_red_blue, v);
+
+        /* Advance to next pixel in VNC framebuffer */
+        src += converter->bpp;
+
+    }
+
+}
+
+void guac_vnc_pixel_converter_free(guac_vnc_pixel_converter* converter) {
+    guac_mem_free(converter->table);
+}
+
@@ -0,0 +1,163 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_VNC_PIXEL_H
+#define GUAC_VNC_PIXEL_H
+
+#include "config.h"
+
+#include <rfb/rfbclient.h>
+#include <rfb/rfbproto.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Converts rows of pixels from the pixel format used by a VNC server to the
+ * 32-bit ARGB format used by guac_display. The work required for each
+ * conversion is performed once, when the converter is initialized, such that
+ * converting each pixel is a single table lookup (for 8-bit and 16-bit
+ * pixels) or a fixed series of shifts and masks performed several pixels at a
+ * time (for 32-bit pixels).
+ */
+typedef struct guac_vnc_pixel_converter {
+
+    /**
+     * The VNC pixel format that this converter was initialized for.
+     */
+    rfbPixelFormat format;
+
+    /**
+     * Whether the red and blue components of each pixel are swapped during
+     * conversion.
+     */
+    bool swap_red_blue;
+
+    /**
+     * The number of bytes in each VNC pixel, which will be either 4, 2, or 1.
+     */
+    unsigned int bpp;
+
+    /**
+     * Lookup table containing the converted ARGB value of every possible
+     * VNC pixel value, for 8-bit (256 entries) or 16-bit (65536 entries)
+     * formats. This will be NULL for 32-bit formats, or if the table could
+     * not be allocated.
+     */
+    uint32_t* table;
+
+    /**
+     * Whether each component of each 32-bit VNC pixel is exactly 8 bits, such
+     * that conversion requires only shifting and masking each component.
+     */
+    bool direct;
+
+    /**
+     * The number of bits that each 32-bit VNC pixel must be shifted right to
+     * obtain the component which will become the red component of the
+     * converted pixel. This value is only used if direct is true.
+     */
+    int red_shift;
+
+    /**
+     * The number of bits that each 32-bit VNC pixel must be shifted right to
+     * obtain the component which will become the green component of the
+     * converted pixel. This value is only used if direct is true.
+     */
+    int green_shift;
+
+    /**
+     * The number of bits that each 32-bit VNC pixel must be shifted right to
+     * obtain the component which will become the blue component of the
+     * converted pixel. This value is only used if direct is true.
+     */
+    int blue_shift;
+
+} guac_vnc_pixel_converter;
+
+/**
+ * Initializes the given converter for the given VNC pixel format, building
+ * any lookup table required by that format. If the converter was previously
+ * initialized, the resources associated with its previous format are
+ * released. The converter must be zeroed before it is first initialized.
+ *
+ * @param converter
+ *     The converter to initialize.
+ *
+ * @param format
+ *     The pixel format used by the VNC server.
+ *
+ * @param swap_red_blue
+ *     Whether the red and blue components of each pixel should be swapped.
+ */
+void guac_vnc_pixel_converter_init(guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, bool swap_red_blue);
+
+/**
+ * Returns whether the given converter was initialized for the given pixel
+ * format and red/blue swap setting.
+ *
+ * @param converter
+ *     The converter to test.
+ *
+ * @param format
+ *     The pixel format to compare against the format of the converter.
+ *
+ * @param swap_red_blue
+ *     Whether the red and blue components of each pixel should be swapped.
+ *
+ * @return
+ *     true if the converter can be used to convert pixels of the given
+ *     format, false otherwise.
+ */
+bool guac_vnc_pixel_converter_matches(const guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, bool swap_red_blue);
+
+/**
+ * Converts a single row of pixels from the VNC pixel format of the given
+ * converter to 32-bit ARGB.
+ *
+ * @param converter
+ *     The converter to use.
+ *
+ * @param src
+ *     The first pixel of the row of VNC pixels to convert.
+ *
+ * @param dst
+ *     The first pixel of the row of 32-bit ARGB pixels that should receive
+ *     the converted pixels.
+ *
+ * @param width
+ *     The number of pixels in the row.
+ */
+void guac_vnc_pixel_converter_convert_row(
+        const guac_vnc_pixel_converter* converter, const unsigned char* src,
+        uint32_t* dst, int width);
+
+/**
+ * Releases all resources associated with the given converter. The converter
+ * itself is not freed, but must be reinitialized before it is used again.
+ *
+ * @param converter
+ *     The converter to free.
+ */
+void guac_vnc_pixel_converter_free(guac_vnc_pixel_converter* converter);
+
+#endif
+
@@ -24,6 +24,7 @@
 #include "common/defaults.h"
 #include "settings.h"
 
+#include <guacamole/audio-constants.h>
 #include <guacamole/mem.h>
 #include <guacamole/user.h>
 #include <guacamole/wol-constants.h>
@@ -56,6 +57,9 @@ const char* GUAC_VNC_CLIENT_ARGS[] = {
 #ifdef ENABLE_PULSE
     "enable-audio",
     "audio-servername",
+    "audio-packet-duration",
+    "audio-silence-threshold",
+    "audio-silence-hold",
 #endif
 
 #ifdef ENABLE_VNC_LISTEN
@@ -202,6 +206,29 @@ enum VNC_ARGS_IDX {
      * default sink of the local machine will be used as the source for audio.
      */
     IDX_AUDIO_SERVERNAME,
+
+    /**
+     * The duration of audio, in milliseconds, to accumulate before each audio
+     * packet is sent. Longer durations reduce the number of packets sent at
+     * the cost of added latency. If zero, audio is sent as soon as it is
+     * received. If omitted, GUAC_AUDIO_DEFAULT_PACKET_DURATION is used.
+     */
+    IDX_AUDIO_PACKET_DURATION,
+
+    /**
+     * The RMS level, scaled to the range of a signed 16-bit sample, below
+     * which audio is considered silent and is not sent. If zero, silence is
+     * sent like any other audio. If omitted,
+     * GUAC_AUDIO_DEFAULT_SILENCE_THRESHOLD is used.
+     */
+    IDX_AUDIO_SILENCE_THRESHOLD,
+
+    /**
+     * The duration of continuous silence, in milliseconds, after which
+     * silence is no longer sent. If omitted, GUAC_AUDIO_DEFAULT_SILENCE_HOLD
+     * is used.
+     */
+    IDX_AUDIO_SILENCE_HOLD,
 #endif
 
 #ifdef ENABLE_VNC_LISTEN
@@ -562,6 +589,22 @@ guac_vnc_settings* guac_vnc_parse_args(guac_user* user,
         settings->pa_servername =
             guac_user_parse_args_string(user, GUAC_VNC_CLIENT_ARGS, argv,
                     IDX_AUDIO_SERVERNAME, NULL);
+
+    /* Audio packet duration */
+    settings->audio_packet_duration =
+        guac_user_parse_args_int(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_AUDIO_PACKET_DURATION, GUAC_AUDIO_DEFAULT_PACKET_DURATION);
+
+    /* Audio silence suppression threshold */
+    settings->audio_silence_threshold =
+        guac_user_parse_args_int(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_AUDIO_SILENCE_THRESHOLD,
+                GUAC_AUDIO_DEFAULT_SILENCE_THRESHOLD);
+
+    /* Duration of silence before suppression */
+    settings->audio_silence_hold =
+        guac_user_parse_args_int(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_AUDIO_SILENCE_HOLD, GUAC_AUDIO_DEFAULT_SILENCE_HOLD);
 #endif
 
     /* Set clipboard encoding if specified */
@@ -145,6 +145,25 @@ typedef struct guac_vnc_settings {
      * The name of the PulseAudio server to connect to.
      */
     char* pa_servername;
+
+    /**
+     * The duration of audio, in milliseconds, to accumulate before each audio
+     * packet is sent, or zero to send audio as soon as it is received.
+     */
+    int audio_packet_duration;
+
+    /**
+     * The RMS level, scaled to the range of a signed 16-bit sample, below
+     * which audio is considered silent, or zero to send silence like any
+     * other audio.
+     */
+    int audio_silence_threshold;
+
+    /**
+     * The duration of continuous silence, in milliseconds, after which
+     * silence is no longer sent.
+     */
+    int audio_silence_hold;
 #endif
 
     /**
@@ -411,7 +411,9 @@ void* guac_vnc_client_thread(void* data) {
     /* If audio is enabled, start streaming via PulseAudio */
     if (settings->audio_enabled)
         vnc_client->audio = guac_pa_stream_alloc(client, 
-                settings->pa_servername);
+                settings->pa_servername, settings->audio_packet_duration,
+                settings->audio_silence_threshold,
+                settings->audio_silence_hold);
 #endif
 
 #ifdef ENABLE_COMMON_SSH
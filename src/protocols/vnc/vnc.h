@@ -25,6 +25,7 @@
 #include "common/clipboard.h"
 #include "common/iconv.h"
 #include "display.h"
+#include "pixel.h"
 #include "settings.h"
 
 #include <guacamole/client.h>
@@ -113,6 +114,12 @@ typedef struct guac_vnc_client {
      */
     guac_display_layer_raw_context* current_context;
 
+    /**
+     * Converter which translates pixels from the format used by the VNC
+     * server to the format used by guac_display, if those formats differ.
+     */
+    guac_vnc_pixel_converter pixel_converter;
+
     /**
      * The current instance of the guac_display render thread. If the thread
      * has not yet been started, this will be NULL.
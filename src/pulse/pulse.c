@@ -27,38 +27,6 @@
 #include <guacamole/user.h>
 #include <pulse/pulseaudio.h>
 
-/**
- * Returns whether the given buffer contains only silence (only null bytes).
- *
- * @param buffer
- *     The audio buffer to check.
- *
- * @param length
- *     The length of the buffer to check.
- *
- * @return
- *     Non-zero if the audio buffer contains silence, zero otherwise.
- */
-static int guac_pa_is_silence(const void* buffer, size_t length) {
-
-    int i;
-
-    const unsigned char* current = (const unsigned char*) buffer;
-
-    /* For each byte in buffer */
-    for (i = 0; i < length; i++) {
-
-        /* If current value non-zero, then not silence */
-        if (*(current++))
-            return 0;
-
-    }
-
-    /* Otherwise, the buffer contains 100% silence */
-    return 1;
-
-}
-
 /**
  * Callback invoked by PulseAudio when PCM data is available for reading
  * from the given stream. The PCM data can be read using pa_stream_peek().
@@ -84,12 +52,11 @@ static void __stream_read_callback(pa_stream* stream, size_t length,
     /* Read data */
     pa_stream_peek(stream, &buffer, &length);
 
-    /* Continuously write received PCM data */
-    if (!guac_pa_is_silence(buffer, length))
-        guac_audio_stream_write_pcm(audio, buffer, length);
-
-    /* Flush upon silence */
-    else
+    /* Continuously write received PCM data. Silence is suppressed and
+     * packets are flushed by the audio stream itself, unless packets are to
+     * be sent as soon as PCM data is received. */
+    guac_audio_stream_write_pcm(audio, buffer, length);
+    if (audio->packet_duration <= 0)
         guac_audio_stream_flush(audio);
 
     /* Advance buffer */
@@ -302,7 +269,8 @@ static void __context_state_callback(pa_context* context, void* data) {
 }
 
 guac_pa_stream* guac_pa_stream_alloc(guac_client* client,
-        const char* server_name) {
+        const char* server_name, int packet_duration, int silence_threshold,
+        int silence_hold) {
 
     guac_audio_stream* audio = guac_audio_stream_alloc(client, NULL,
             GUAC_PULSE_AUDIO_RATE, GUAC_PULSE_AUDIO_CHANNELS,
@@ -312,6 +280,12 @@ guac_pa_stream* guac_pa_stream_alloc(guac_client* client,
     if (audio == NULL)
         return NULL;
 
+    /* Send PCM in packets of the requested duration, omitting silence if
+     * requested */
+    guac_audio_stream_set_packet_duration(audio, packet_duration);
+    guac_audio_stream_set_silence_threshold(audio, silence_threshold,
+            silence_hold);
+
     /* Init main loop */
     guac_pa_stream* stream = guac_mem_alloc(sizeof(guac_pa_stream));
     stream->client = client;
@@ -88,12 +88,27 @@ typedef struct guac_pa_stream {
  *     The hostname of the PulseAudio server to connect to, or NULL to connect
  *     to the default (local) server.
  *
+ * @param packet_duration
+ *     The duration of PCM data to accumulate before each audio packet is
+ *     sent, in milliseconds, or zero to send PCM data as soon as it is
+ *     received from PulseAudio. See guac_audio_stream_set_packet_duration().
+ *
+ * @param silence_threshold
+ *     The RMS level, scaled to the range of a signed 16-bit sample, below
+ *     which PCM data is considered silent, or zero to send silence like any
+ *     other audio. See guac_audio_stream_set_silence_threshold().
+ *
+ * @param silence_hold
+ *     The duration of continuous silence, in milliseconds, which must be
+ *     observed before silence is no longer sent.
+ *
  * @return
  *     A newly-allocated PulseAudio stream, or NULL if audio cannot be
  *     streamed.
  */
 guac_pa_stream* guac_pa_stream_alloc(guac_client* client,
-        const char* server_name);
+        const char* server_name, int packet_duration, int silence_threshold,
+        int silence_hold);
 
 /**
  * Notifies the given PulseAudio stream that a user has joined the connection.
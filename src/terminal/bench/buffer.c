@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "terminal/buffer.h"
+#include "terminal/types.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * The maximum number of rows of each terminal buffer benchmarked. The buffer
+ * of an actual terminal is never smaller than GUAC_TERMINAL_MAX_ROWS.
+ */
+static const int bench_scrollback_sizes[] = { 1024, 10000, 100000 };
+
+/**
+ * The number of rows within the visible area of the terminal.
+ */
+#define BENCH_BUFFER_HEIGHT 50
+
+/**
+ * The number of columns within the visible area of the terminal.
+ */
+#define BENCH_BUFFER_WIDTH 120
+
+/**
+ * The number of times each buffer is allocated when measuring allocation
+ * time.
+ */
+#define BENCH_BUFFER_ALLOCATIONS 100
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Writes the given number of lines of text to the bottom row of the given
+ * buffer, scrolling the buffer up by one row after each line, as a terminal
+ * does for ordinary command output. The text of each line varies in length
+ * and contains occasional changes in color.
+ */
+static void bench_write_lines(guac_terminal_buffer* buffer,
+        const guac_terminal_char* default_char, int lines) {
+
+    guac_terminal_char current = *default_char;
+
+    for (int line = 0; line < lines; line++) {
+
+        int length = (line * 37) % BENCH_BUFFER_WIDTH;
+        for (int column = 0; column < length; column++) {
+
+            /* Change color every few words */
+            if (column % 24 == 0)
+                current.attributes.foreground.palette_index = (line + column) % 8;
+
+            current.value = (column % 6 == 5) ? ' ' : 'a' + (line + column) % 26;
+            guac_terminal_buffer_set_columns(buffer, BENCH_BUFFER_HEIGHT - 1,
+                    column, column, &current);
+
+        }
+
+        guac_terminal_buffer_scroll_up(buffer, 1);
+        guac_terminal_buffer_set_columns(buffer, BENCH_BUFFER_HEIGHT - 1,
+                0, BENCH_BUFFER_WIDTH - 1, (guac_terminal_char*) default_char);
+
+    }
+
+}
+
+/**
+ * Prints the results of a single benchmark in the tab-separated format shared
+ * by all benchmarks: one line per metric, each consisting of the benchmark
+ * name, the metric name, the value of the metric, and its unit. The metrics
+ * reported are the average time to allocate the buffer, the bytes used by a
+ * newly-allocated buffer, the bytes used once the visible area has been
+ * filled, and the bytes used once the entire scrollback has been filled.
+ */
+static void bench_report(const char* name, uint64_t alloc_time,
+        size_t idle, size_t screen, size_t full) {
+    printf("%s\ttime_per_allocation\t%.2f\tns\n", name,
+            (double) alloc_time / BENCH_BUFFER_ALLOCATIONS);
+    printf("%s\tmemory_idle\t%zu\tbytes\n", name, idle);
+    printf("%s\tmemory_screen\t%zu\tbytes\n", name, screen);
+    printf("%s\tmemory_full\t%zu\tbytes\n", name, full);
+}
+
+int main(int argc, char** argv) {
+
+    guac_terminal_char default_char = {
+        .value = 0,
+        .width = 1,
+        .attributes = {
+            .foreground = { .palette_index = 7 },
+            .background = { .palette_index = 0 }
+        }
+    };
+
+    int sizes = sizeof(bench_scrollback_sizes) / sizeof(bench_scrollback_sizes[0]);
+    for (int i = 0; i < sizes; i++) {
+
+        int rows = bench_scrollback_sizes[i];
+
+        /* Measure connection startup cost */
+        uint64_t start = bench_now();
+        for (int j = 0; j < BENCH_BUFFER_ALLOCATIONS; j++)
+            guac_terminal_buffer_free(guac_terminal_buffer_alloc(rows, &default_char));
+        uint64_t alloc_time = bench_now() - start;
+
+        /* Measure memory used by an idle session, a session that has filled
+         * the screen, and a session that has filled its scrollback */
+        guac_terminal_buffer* buffer = guac_terminal_buffer_alloc(rows, &default_char);
+        size_t idle = guac_terminal_buffer_memory_usage(buffer);
+
+        bench_write_lines(buffer, &default_char, BENCH_BUFFER_HEIGHT);
+        size_t screen = guac_terminal_buffer_memory_usage(buffer);
+
+        bench_write_lines(buffer, &default_char, rows);
+        size_t full = guac_terminal_buffer_memory_usage(buffer);
+
+        guac_terminal_buffer_free(buffer);
+
+        char name[64];
+        snprintf(name, sizeof(name), "terminal_buffer_%i", rows);
+        bench_report(name, alloc_time, idle, screen, full);
+
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,228 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "terminal/terminal.h"
+
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The approximate size of each synthetic stream of terminal output, in bytes.
+ */
+#define BENCH_WRITE_STREAM_SIZE 8388608
+
+/**
+ * The number of bytes passed to each call to guac_terminal_write(), matching
+ * the size of the buffers used by the SSH and telnet protocols when reading
+ * output from the remote end.
+ */
+#define BENCH_WRITE_CHUNK_SIZE 4096
+
+/**
+ * The width of the terminal display, in pixels.
+ */
+#define BENCH_WRITE_WIDTH 1024
+
+/**
+ * The height of the terminal display, in pixels.
+ */
+#define BENCH_WRITE_HEIGHT 768
+
+/**
+ * The resolution of the terminal display, in DPI.
+ */
+#define BENCH_WRITE_DPI 96
+
+/**
+ * Returns the current value of a monotonic clock, in nanoseconds.
+ *
+ * @return
+ *     The current value of a monotonic clock, in nanoseconds.
+ */
+static uint64_t bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Allocates a synthetic stream of terminal output consisting of the given
+ * text, repeated until the stream is roughly BENCH_WRITE_STREAM_SIZE bytes
+ * long.
+ *
+ * @param text
+ *     The text to repeat.
+ *
+ * @param length
+ *     Pointer to a size_t which will receive the length of the stream.
+ *
+ * @return
+ *     A newly-allocated buffer containing the stream.
+ */
+static char* bench_repeat(const char* text, size_t* length) {
+
+    size_t text_length = strlen(text);
+    size_t count = BENCH_WRITE_STREAM_SIZE / text_length + 1;
+
+    char* stream = malloc(count * text_length);
+    for (size_t i = 0; i < count; i++)
+        memcpy(stream + i * text_length, text, text_length);
+
+    *length = count * text_length;
+    return stream;
+
+}
+
+/**
+ * Reads the entire contents of the given file, such as the data file of a
+ * typescript, into a newly-allocated buffer.
+ *
+ * @param path
+ *     The path of the file to read.
+ *
+ * @param length
+ *     Pointer to a size_t which will receive the length of the file.
+ *
+ * @return
+ *     A newly-allocated buffer containing the file contents, or NULL if the
+ *     file cannot be read.
+ */
+static char* bench_read_file(const char* path, size_t* length) {
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    size_t capacity = 65536;
+    size_t used = 0;
+    char* buffer = malloc(capacity);
+
+    size_t read;
+    while ((read = fread(buffer + used, 1, capacity - used, file)) > 0) {
+        used += read;
+        if (used == capacity) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+        }
+    }
+
+    fclose(file);
+    *length = used;
+    return buffer;
+
+}
+
+/**
+ * Writes the given stream of terminal output to a new terminal in
+ * BENCH_WRITE_CHUNK_SIZE chunks, as a protocol's output thread would,
+ * printing the resulting throughput in the tab-separated format shared by
+ * all benchmarks: one line per metric, each consisting of the benchmark
+ * name, the metric name, the value of the metric, and its unit. The
+ * terminal renders frames concurrently, as it does for a real connection.
+ */
+static void bench_write(guac_client* client, const char* name,
+        const char* stream, size_t length) {
+
+    guac_terminal_options* options = guac_terminal_options_create(
+            BENCH_WRITE_WIDTH, BENCH_WRITE_HEIGHT, BENCH_WRITE_DPI);
+
+    guac_terminal* term = guac_terminal_create(client, options);
+    guac_mem_free(options);
+
+    if (term == NULL) {
+        fprintf(stderr, "%s: Terminal could not be created.\n", name);
+        return;
+    }
+
+    guac_terminal_start(term);
+
+    uint64_t start = bench_now();
+    for (size_t offset = 0; offset < length; offset += BENCH_WRITE_CHUNK_SIZE) {
+
+        size_t chunk = length - offset;
+        if (chunk > BENCH_WRITE_CHUNK_SIZE)
+            chunk = BENCH_WRITE_CHUNK_SIZE;
+
+        guac_terminal_write(term, stream + offset, chunk);
+
+    }
+    uint64_t duration = bench_now() - start;
+
+    guac_terminal_free(term);
+
+    printf("%s\tthroughput\t%.1f\tMB/s\n", name, length * 1000.0 / duration);
+
+}
+
+int main(int argc, char** argv) {
+
+    size_t length;
+    char* stream;
+
+    guac_client* client = guac_client_alloc();
+
+    /* Build or compiler output: plain ASCII */
+    stream = bench_repeat("gcc -DHAVE_CONFIG_H -I. -I../.. -Werror -Wall "
+            "-pedantic -g -O2 -MT terminal.lo -MD -MP -c terminal.c\r\n",
+            &length);
+    bench_write(client, "terminal_write_plain", stream, length);
+    free(stream);
+
+    /* Colorized directory listings: short runs of text between SGR
+     * escape sequences */
+    stream = bench_repeat("-rw-r--r-- 1 user user  4096 Jan  1 00:00 "
+            "\x1B[01;34mdirectory\x1B[0m  \x1B[01;32mexecutable\x1B[0m  "
+            "\x1B[01;36mlink\x1B[0m -> \x1B[38;5;208mtarget\x1B[0m\r\n",
+            &length);
+    bench_write(client, "terminal_write_colored", stream, length);
+    free(stream);
+
+    /* Text mixing ASCII with multibyte and double-width characters */
+    stream = bench_repeat("Guacamole \xc3\xa9t\xc3\xa9 \xe7\x8a\xac "
+            "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e clientless remote "
+            "desktop gateway\r\n", &length);
+    bench_write(client, "terminal_write_utf8", stream, length);
+    free(stream);
+
+    /* Typescripts of actual sessions */
+    for (int i = 1; i < argc; i++) {
+
+        stream = bench_read_file(argv[i], &length);
+        if (stream == NULL)
+            return 1;
+
+        char name[256];
+        snprintf(name, sizeof(name), "terminal_write_typescript:%s", argv[i]);
+        bench_write(client, name, stream, length);
+        free(stream);
+
+    }
+
+    guac_client_free(client);
+    return 0;
+
+}
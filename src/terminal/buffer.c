@@ -23,6 +23,7 @@
 
 #include <guacamole/assert.h>
 #include <guacamole/mem.h>
+#include <guacamole/unicode.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -35,16 +36,116 @@
  */
 #define GUAC_TERMINAL_BUFFER_ROW_MIN_SIZE 256
 
+/**
+ * The number of rows within each chunk of buffer rows. Chunks are allocated
+ * only once any of their rows are first used, such that the memory used by a
+ * buffer grows with the number of rows actually produced rather than the
+ * maximum scrollback.
+ */
+#define GUAC_TERMINAL_BUFFER_CHUNK_SIZE 64
+
+/**
+ * Marker byte within the packed values of a guac_terminal_buffer_packed_row
+ * representing a single GUAC_CHAR_CONTINUATION cell. This byte can never
+ * begin a UTF-8 character.
+ */
+#define GUAC_TERMINAL_BUFFER_PACKED_CONTINUATION 0xFE
+
+/**
+ * Marker byte within the packed values of a guac_terminal_buffer_packed_row
+ * indicating that the following byte is the width of the cell, which is then
+ * followed by the UTF-8 encoding of that cell's value. This is used for
+ * valid codepoints with a width other than 1 (wide characters). This byte can
+ * never begin a UTF-8 character.
+ */
+#define GUAC_TERMINAL_BUFFER_PACKED_WIDTH 0xFD
+
+/**
+ * Marker byte within the packed values of a guac_terminal_buffer_packed_row
+ * indicating that the value and width of the cell follow as raw ints. This is
+ * used only for cells that cannot otherwise be represented. This byte can
+ * never begin a UTF-8 character.
+ */
+#define GUAC_TERMINAL_BUFFER_PACKED_RAW 0xFF
+
+/**
+ * The maximum number of bytes required to pack the value and width of a
+ * single cell.
+ */
+#define GUAC_TERMINAL_BUFFER_PACKED_MAX_CELL_SIZE (1 + 2 * sizeof(int))
+
+/**
+ * A contiguous run of cells within a packed row that share the same
+ * attributes.
+ */
+typedef struct guac_terminal_buffer_attribute_run {
+
+    /**
+     * The attributes shared by all cells within the run.
+     */
+    guac_terminal_attributes attributes;
+
+    /**
+     * The number of cells within the run.
+     */
+    unsigned int length;
+
+} guac_terminal_buffer_attribute_run;
+
+/**
+ * The compact representation of a row which has scrolled off screen. Rather
+ * than storing a full guac_terminal_char for each cell, attributes are stored
+ * once per run of cells sharing those attributes, and values are packed as
+ * UTF-8. Trailing cells that are identical to the default character are not
+ * stored at all. The packed values immediately follow the array of runs
+ * within the same allocation.
+ */
+typedef struct guac_terminal_buffer_packed_row {
+
+    /**
+     * The total size of this packed row, including the runs and packed
+     * values, in bytes.
+     */
+    size_t size;
+
+    /**
+     * The number of cells stored within this packed row. All cells of the
+     * row beyond this number are identical to the default character.
+     */
+    unsigned int cells;
+
+    /**
+     * The number of elements within the runs array.
+     */
+    unsigned int run_count;
+
+    /**
+     * The attribute runs of all stored cells, in order. The packed values of
+     * those cells follow the final run.
+     */
+    guac_terminal_buffer_attribute_run runs[];
+
+} guac_terminal_buffer_packed_row;
+
 /**
  * A single variable-length row of terminal data.
  */
 typedef struct guac_terminal_buffer_row {
 
     /**
-     * Array of guac_terminal_char representing the contents of the row.
+     * Array of guac_terminal_char representing the contents of the row. If
+     * the row is packed, this will be NULL.
      */
     guac_terminal_char* characters;
 
+    /**
+     * The compact representation of the contents of this row, or NULL if
+     * the row is not packed or if every character of the packed row is the
+     * default character. Rows are packed as they scroll off screen and are
+     * unpacked only if modified. See guac_terminal_buffer_row_is_packed().
+     */
+    guac_terminal_buffer_packed_row* packed;
+
     /**
      * The length of this row in characters. This is the number of initialized
      * characters in the buffer, usually equal to the number of characters
@@ -74,11 +175,18 @@ struct guac_terminal_buffer {
     guac_terminal_char default_character;
 
     /**
-     * Array of buffer rows. This array functions as a ring buffer.
-     * When a new row needs to be appended, the top reference is moved down
-     * and the old top row is replaced.
+     * Array of chunks of buffer rows, each chunk containing
+     * GUAC_TERMINAL_BUFFER_CHUNK_SIZE rows. Together, these rows function as
+     * a ring buffer. When a new row needs to be appended, the top reference
+     * is moved down and the old top row is replaced. Each chunk is NULL until
+     * one of its rows is first used.
+     */
+    guac_terminal_buffer_row** chunks;
+
+    /**
+     * The number of elements in the chunks array.
      */
-    guac_terminal_buffer_row* rows;
+    unsigned int chunk_count;
 
     /**
      * The index of the first row in the buffer (the row which represents row 0
@@ -99,6 +207,17 @@ struct guac_terminal_buffer {
      */
     unsigned int available;
 
+    /**
+     * Storage for the unpacked contents of the packed row most recently
+     * requested with guac_terminal_buffer_get_columns().
+     */
+    guac_terminal_char* unpacked;
+
+    /**
+     * The number of elements in the unpacked array.
+     */
+    unsigned int unpacked_available;
+
 };
 
 guac_terminal_buffer* guac_terminal_buffer_alloc(int rows,
@@ -108,55 +227,72 @@ guac_terminal_buffer* guac_terminal_buffer_alloc(int rows,
     guac_terminal_buffer* buffer =
         guac_mem_alloc(sizeof(guac_terminal_buffer));
 
-    int i;
-    guac_terminal_buffer_row* row;
-
-    /* Init scrollback data */
+    /* Init scrollback data (rows are allocated only as they are used) */
     buffer->default_character = *default_character;
     buffer->available = rows;
     buffer->top = 0;
     buffer->length = 0;
-    buffer->rows = guac_mem_alloc(sizeof(guac_terminal_buffer_row), buffer->available);
+    buffer->chunk_count = (rows + GUAC_TERMINAL_BUFFER_CHUNK_SIZE - 1)
+        / GUAC_TERMINAL_BUFFER_CHUNK_SIZE;
+    buffer->chunks = guac_mem_zalloc(sizeof(guac_terminal_buffer_row*),
+            buffer->chunk_count);
+    buffer->unpacked = NULL;
+    buffer->unpacked_available = 0;
+
+    return buffer;
 
-    /* Init scrollback rows */
-    row = buffer->rows;
-    for (i=0; i<rows; i++) {
+}
 
-        /* Allocate row  */
-        row->available = GUAC_TERMINAL_BUFFER_ROW_MIN_SIZE;
-        row->length = 0;
-        row->wrapped_row = false;
-        row->characters = guac_mem_alloc(sizeof(guac_terminal_char), row->available);
+/**
+ * Frees all chunks of rows within the given buffer, including the contents
+ * of those rows. All rows of the buffer will be empty once this function
+ * returns.
+ *
+ * @param buffer
+ *     The buffer whose chunks should be freed.
+ */
+static void guac_terminal_buffer_free_chunks(guac_terminal_buffer* buffer) {
 
-        /* Next row */
-        row++;
+    for (unsigned int i = 0; i < buffer->chunk_count; i++) {
 
-    }
+        guac_terminal_buffer_row* row = buffer->chunks[i];
+        if (row == NULL)
+            continue;
 
-    return buffer;
+        /* Free all rows within chunk */
+        for (int j = 0; j < GUAC_TERMINAL_BUFFER_CHUNK_SIZE; j++) {
+            guac_mem_free(row->characters);
+            guac_mem_free(row->packed);
+            row++;
+        }
+
+        guac_mem_free(buffer->chunks[i]);
+
+    }
 
 }
 
 void guac_terminal_buffer_free(guac_terminal_buffer* buffer) {
 
-    int i;
-    guac_terminal_buffer_row* row = buffer->rows;
-
     /* Free all rows */
-    for (i=0; i<buffer->available; i++) {
-        guac_mem_free(row->characters);
-        row++;
-    }
+    guac_terminal_buffer_free_chunks(buffer);
 
     /* Free actual buffer */
-    guac_mem_free(buffer->rows);
+    guac_mem_free(buffer->unpacked);
+    guac_mem_free(buffer->chunks);
     guac_mem_free(buffer);
 
 }
 
 void guac_terminal_buffer_reset(guac_terminal_buffer* buffer) {
+
+    /* Release all memory used by previous rows, as the buffer may never again
+     * grow to its previous size */
+    guac_terminal_buffer_free_chunks(buffer);
+
     buffer->top = 0;
     buffer->length = 0;
+
 }
 
 /**
@@ -179,9 +315,20 @@ static guac_terminal_buffer_row* guac_terminal_buffer_get_row(guac_terminal_buff
     if (abs(row) >= buffer->available)
         return NULL;
 
-    /* Normalize row index into a scrollback buffer index */
-    unsigned int index = (buffer->top + row) % buffer->available;
-    return &(buffer->rows[index]);
+    /* Normalize row index into a scrollback buffer index (NOTE: the sum is
+     * offset by the buffer size to avoid unsigned wraparound, which would
+     * otherwise yield the wrong row for buffer sizes that are not a power of
+     * two) */
+    unsigned int index = (buffer->top + buffer->available + row) % buffer->available;
+
+    /* Allocate the chunk containing the row upon first use (all rows of new
+     * chunks are initially empty) */
+    guac_terminal_buffer_row** chunk = &(buffer->chunks[index / GUAC_TERMINAL_BUFFER_CHUNK_SIZE]);
+    if (*chunk == NULL)
+        *chunk = guac_mem_zalloc(sizeof(guac_terminal_buffer_row),
+                GUAC_TERMINAL_BUFFER_CHUNK_SIZE);
+
+    return &((*chunk)[index % GUAC_TERMINAL_BUFFER_CHUNK_SIZE]);
 
 }
 
@@ -252,6 +399,365 @@ static void guac_terminal_buffer_row_expand(guac_terminal_buffer_row* row, int l
 
 }
 
+/**
+ * Returns whether the given colors are identical, including their palette
+ * indices.
+ *
+ * @param a
+ *     The first color to compare.
+ *
+ * @param b
+ *     The second color to compare.
+ *
+ * @return
+ *     true if the colors are identical, false otherwise.
+ */
+static bool guac_terminal_buffer_color_equal(const guac_terminal_color* a,
+        const guac_terminal_color* b) {
+    return a->palette_index == b->palette_index
+        && a->red == b->red
+        && a->green == b->green
+        && a->blue == b->blue;
+}
+
+/**
+ * Returns whether the given attributes are identical. Unlike comparing with
+ * memcmp(), any padding within the attributes is ignored.
+ *
+ * @param a
+ *     The first set of attributes to compare.
+ *
+ * @param b
+ *     The second set of attributes to compare.
+ *
+ * @return
+ *     true if the attributes are identical, false otherwise.
+ */
+static bool guac_terminal_buffer_attributes_equal(
+        const guac_terminal_attributes* a, const guac_terminal_attributes* b) {
+    return a->bold == b->bold
+        && a->half_bright == b->half_bright
+        && a->cursor == b->cursor
+        && a->reverse == b->reverse
+        && a->underscore == b->underscore
+        && guac_terminal_buffer_color_equal(&a->foreground, &b->foreground)
+        && guac_terminal_buffer_color_equal(&a->background, &b->background);
+}
+
+/**
+ * Returns whether the given row is packed, and thus must be unpacked before
+ * its characters can be accessed. A packed row has no array of characters
+ * yet has a non-zero length. Packed rows that consist entirely of the default
+ * character additionally have no packed representation, and thus occupy no
+ * memory beyond the row itself.
+ *
+ * @param row
+ *     The row to test.
+ *
+ * @return
+ *     true if the given row is packed, false otherwise.
+ */
+static bool guac_terminal_buffer_row_is_packed(
+        const guac_terminal_buffer_row* row) {
+    return row->characters == NULL && row->length > 0;
+}
+
+/**
+ * Returns the attributes of the given character as they should be stored
+ * within a packed row. Packed rows never contain the cursor, as only rows
+ * that have scrolled off screen are packed.
+ *
+ * @param character
+ *     The character whose attributes should be returned.
+ *
+ * @return
+ *     The attributes of the given character, without the cursor.
+ */
+static guac_terminal_attributes guac_terminal_buffer_packed_attributes(
+        const guac_terminal_char* character) {
+
+    guac_terminal_attributes attributes = character->attributes;
+    attributes.cursor = false;
+    return attributes;
+
+}
+
+/**
+ * Packs the value and width of the given character into the given buffer,
+ * which must have at least GUAC_TERMINAL_BUFFER_PACKED_MAX_CELL_SIZE bytes
+ * available. Ordinary single-width characters are packed as UTF-8.
+ *
+ * @param character
+ *     The character to pack.
+ *
+ * @param packed
+ *     The buffer to pack the character into.
+ *
+ * @return
+ *     The number of bytes written to the buffer.
+ */
+static size_t guac_terminal_buffer_pack_value(const guac_terminal_char* character,
+        unsigned char* packed) {
+
+    int value = character->value;
+    int width = character->width;
+
+    /* Continuation cells are represented by their marker alone */
+    if (value == GUAC_CHAR_CONTINUATION && width == 0) {
+        packed[0] = GUAC_TERMINAL_BUFFER_PACKED_CONTINUATION;
+        return 1;
+    }
+
+    if (value >= 0 && value <= 0x10FFFF) {
+
+        /* Single-width characters are packed as plain UTF-8 */
+        if (width == 1)
+            return guac_utf8_write(value, (char*) packed, 4);
+
+        /* Characters of any other reasonable width are preceded by that
+         * width */
+        if (width >= 0 && width <= 0xFF) {
+            packed[0] = GUAC_TERMINAL_BUFFER_PACKED_WIDTH;
+            packed[1] = width;
+            return 2 + guac_utf8_write(value, (char*) packed + 2, 4);
+        }
+
+    }
+
+    /* Store anything else verbatim */
+    packed[0] = GUAC_TERMINAL_BUFFER_PACKED_RAW;
+    memcpy(packed + 1, &value, sizeof(value));
+    memcpy(packed + 1 + sizeof(value), &width, sizeof(width));
+    return 1 + sizeof(value) + sizeof(width);
+
+}
+
+/**
+ * Unpacks the value and width of a single character previously packed with
+ * guac_terminal_buffer_pack_value(). The attributes of the character are not
+ * modified.
+ *
+ * @param packed
+ *     The buffer containing the packed character.
+ *
+ * @param character
+ *     The character to store the unpacked value and width within.
+ *
+ * @return
+ *     The number of bytes read from the buffer.
+ */
+static size_t guac_terminal_buffer_unpack_value(const unsigned char* packed,
+        guac_terminal_char* character) {
+
+    switch (packed[0]) {
+
+        case GUAC_TERMINAL_BUFFER_PACKED_CONTINUATION:
+            character->value = GUAC_CHAR_CONTINUATION;
+            character->width = 0;
+            return 1;
+
+        case GUAC_TERMINAL_BUFFER_PACKED_WIDTH:
+            character->width = packed[1];
+            return 2 + guac_utf8_read((const char*) packed + 2, 4,
+                    &character->value);
+
+        case GUAC_TERMINAL_BUFFER_PACKED_RAW:
+            memcpy(&character->value, packed + 1, sizeof(character->value));
+            memcpy(&character->width, packed + 1 + sizeof(character->value),
+                    sizeof(character->width));
+            return 1 + sizeof(character->value) + sizeof(character->width);
+
+    }
+
+    character->width = 1;
+    return guac_utf8_read((const char*) packed, 4, &character->value);
+
+}
+
+/**
+ * Replaces the contents of the given row with their compact, packed
+ * representation, freeing the original array of characters. The row will be
+ * unpacked automatically if later modified. If the row is already packed,
+ * this function has no effect.
+ *
+ * @param buffer
+ *     The buffer containing the row.
+ *
+ * @param row
+ *     The row to pack.
+ */
+static void guac_terminal_buffer_row_pack(guac_terminal_buffer* buffer,
+        guac_terminal_buffer_row* row) {
+
+    /* Nothing to pack if the row is already packed or has never been
+     * used */
+    if (row->characters == NULL)
+        return;
+
+    guac_terminal_char* characters = row->characters;
+    const guac_terminal_char* default_character = &buffer->default_character;
+
+    /* Trailing cells identical to the default character need not be
+     * stored */
+    unsigned int cells = row->length;
+    while (cells > 0) {
+
+        const guac_terminal_char* last = &characters[cells - 1];
+        guac_terminal_attributes attributes = guac_terminal_buffer_packed_attributes(last);
+
+        if (last->value != default_character->value
+                || last->width != default_character->width
+                || !guac_terminal_buffer_attributes_equal(&attributes,
+                    &default_character->attributes))
+            break;
+
+        cells--;
+
+    }
+
+    /* Blank rows need no packed representation at all */
+    if (cells == 0) {
+        guac_mem_free(row->characters);
+        row->characters = NULL;
+        row->available = 0;
+        return;
+    }
+
+    /* Determine the number of attribute runs and space required for the
+     * packed values of all stored cells */
+    unsigned char value[GUAC_TERMINAL_BUFFER_PACKED_MAX_CELL_SIZE];
+    unsigned int run_count = 0;
+    size_t values_size = 0;
+    guac_terminal_attributes previous;
+
+    for (unsigned int i = 0; i < cells; i++) {
+
+        guac_terminal_attributes attributes = guac_terminal_buffer_packed_attributes(&characters[i]);
+        if (i == 0 || !guac_terminal_buffer_attributes_equal(&attributes, &previous))
+            run_count++;
+
+        values_size += guac_terminal_buffer_pack_value(&characters[i], value);
+        previous = attributes;
+
+    }
+
+    size_t size = guac_mem_ckd_add_or_die(sizeof(guac_terminal_buffer_packed_row),
+            guac_mem_ckd_mul_or_die(run_count, sizeof(guac_terminal_buffer_attribute_run)),
+            values_size);
+
+    guac_terminal_buffer_packed_row* packed = guac_mem_alloc(size);
+    packed->size = size;
+    packed->cells = cells;
+    packed->run_count = run_count;
+
+    /* Store runs and values */
+    guac_terminal_buffer_attribute_run* run = packed->runs - 1;
+    unsigned char* values = (unsigned char*) (packed->runs + run_count);
+
+    for (unsigned int i = 0; i < cells; i++) {
+
+        guac_terminal_attributes attributes = guac_terminal_buffer_packed_attributes(&characters[i]);
+        if (i == 0 || !guac_terminal_buffer_attributes_equal(&attributes, &run->attributes)) {
+            run++;
+            run->attributes = attributes;
+            run->length = 0;
+        }
+
+        run->length++;
+        values += guac_terminal_buffer_pack_value(&characters[i], values);
+
+    }
+
+    guac_mem_free(row->characters);
+    row->characters = NULL;
+    row->available = 0;
+    row->packed = packed;
+
+}
+
+/**
+ * Unpacks the contents of the given packed row into the given array of
+ * characters, which must have space for at least the length of the row.
+ *
+ * @param buffer
+ *     The buffer containing the row.
+ *
+ * @param row
+ *     The packed row to unpack.
+ *
+ * @param characters
+ *     The array that should receive the unpacked contents of the row.
+ */
+static void guac_terminal_buffer_row_unpack(guac_terminal_buffer* buffer,
+        const guac_terminal_buffer_row* row, guac_terminal_char* characters) {
+
+    const guac_terminal_buffer_packed_row* packed = row->packed;
+    guac_terminal_char* current = characters;
+    unsigned int cells = 0;
+
+    /* Restore all stored cells (blank rows have none) */
+    if (packed != NULL) {
+
+        const unsigned char* values = (const unsigned char*) (packed->runs + packed->run_count);
+        const guac_terminal_buffer_attribute_run* run = packed->runs;
+        for (unsigned int i = 0; i < packed->run_count; i++) {
+
+            for (unsigned int j = 0; j < run->length; j++) {
+                current->attributes = run->attributes;
+                values += guac_terminal_buffer_unpack_value(values, current);
+                current++;
+            }
+
+            run++;
+
+        }
+
+        cells = packed->cells;
+
+    }
+
+    /* All remaining cells are the default character */
+    for (unsigned int i = cells; i < row->length; i++)
+        *(current++) = buffer->default_character;
+
+}
+
+/**
+ * Returns the row at the given location, unpacking that row if necessary such
+ * that its characters may be modified.
+ *
+ * @param buffer
+ *     The buffer to retrieve a row from.
+ *
+ * @param row
+ *     The index of the row to retrieve, where zero is the top-most row.
+ *     Negative indices represent rows in the scrollback buffer, above the
+ *     top-most row.
+ *
+ * @return
+ *     The unpacked buffer row at the given location, or NULL if there is no
+ *     such row.
+ */
+static guac_terminal_buffer_row* guac_terminal_buffer_get_mutable_row(
+        guac_terminal_buffer* buffer, int row) {
+
+    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer, row);
+    if (buffer_row == NULL || !guac_terminal_buffer_row_is_packed(buffer_row))
+        return buffer_row;
+
+    unsigned int available = guac_terminal_buffer_row_length(buffer_row->length);
+    guac_terminal_char* characters = guac_mem_alloc(sizeof(guac_terminal_char), available);
+    guac_terminal_buffer_row_unpack(buffer, buffer_row, characters);
+
+    guac_mem_free(buffer_row->packed);
+    buffer_row->packed = NULL;
+    buffer_row->characters = characters;
+    buffer_row->available = available;
+
+    return buffer_row;
+
+}
+
 /**
  * Enforces a character break at the given edge, ensuring that the left side
  * of the edge is the final column of a character, and the right side of the
@@ -269,7 +775,7 @@ static void guac_terminal_buffer_row_expand(guac_terminal_buffer_row* row, int l
  */
 static void guac_terminal_buffer_force_break(guac_terminal_buffer* buffer, int row, int edge) {
 
-    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer, row);
+    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_mutable_row(buffer, row);
     if (buffer_row == NULL)
         return;
 
@@ -348,7 +854,7 @@ void guac_terminal_buffer_copy_columns(guac_terminal_buffer* buffer, int row,
         int start_column, int end_column, int offset) {
 
     /* Get row */
-    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer, row);
+    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_mutable_row(buffer, row);
     if (buffer_row == NULL)
         return;
 
@@ -403,8 +909,8 @@ void guac_terminal_buffer_copy_rows(guac_terminal_buffer* buffer,
     for (i = start_row; i <= end_row; i++) {
 
         /* Get source and destination rows */
-        guac_terminal_buffer_row* src_row = guac_terminal_buffer_get_row(buffer, current_row);
-        guac_terminal_buffer_row* dst_row = guac_terminal_buffer_get_row(buffer, current_row + offset);
+        guac_terminal_buffer_row* src_row = guac_terminal_buffer_get_mutable_row(buffer, current_row);
+        guac_terminal_buffer_row* dst_row = guac_terminal_buffer_get_mutable_row(buffer, current_row + offset);
 
         if (src_row == NULL || dst_row == NULL)
             continue;
@@ -438,6 +944,18 @@ void guac_terminal_buffer_scroll_up(guac_terminal_buffer* buffer, int amount) {
     if (buffer->length > buffer->available)
         buffer->length = buffer->available;
 
+    /* Rows that have scrolled off screen are rarely modified again and are
+     * stored in packed form unless and until they are */
+    for (int row = 1; row <= amount; row++) {
+
+        guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer, -row);
+        if (buffer_row == NULL)
+            break;
+
+        guac_terminal_buffer_row_pack(buffer, buffer_row);
+
+    }
+
 }
 
 void guac_terminal_buffer_scroll_down(guac_terminal_buffer* buffer, int amount) {
@@ -445,7 +963,8 @@ void guac_terminal_buffer_scroll_down(guac_terminal_buffer* buffer, int amount)
     if (amount <= 0)
         return;
 
-    buffer->top = (buffer->top - amount) % buffer->available;
+    buffer->top = (buffer->top + buffer->available - amount % buffer->available)
+        % buffer->available;
 
 }
 
@@ -456,8 +975,28 @@ unsigned int guac_terminal_buffer_get_columns(guac_terminal_buffer* buffer,
     if (buffer_row == NULL)
         return 0;
 
-    if (characters != NULL)
-        *characters = buffer_row->characters;
+    if (characters != NULL) {
+
+        /* Packed rows are unpacked into temporary storage without unpacking
+         * the row itself, as rows that are merely being viewed or copied are
+         * unlikely to be modified */
+        if (guac_terminal_buffer_row_is_packed(buffer_row)) {
+
+            if (buffer->unpacked_available < buffer_row->length) {
+                buffer->unpacked_available = guac_terminal_buffer_row_length(buffer_row->length);
+                buffer->unpacked = guac_mem_realloc_or_die(buffer->unpacked,
+                        sizeof(guac_terminal_char), buffer->unpacked_available);
+            }
+
+            guac_terminal_buffer_row_unpack(buffer, buffer_row, buffer->unpacked);
+            *characters = buffer->unpacked;
+
+        }
+
+        else
+            *characters = buffer_row->characters;
+
+    }
 
     if (is_wrapped != NULL)
         *is_wrapped = buffer_row->wrapped_row;
@@ -477,7 +1016,7 @@ void guac_terminal_buffer_set_columns(guac_terminal_buffer* buffer, int row,
 
     /* Do nothing if there is no such row within the buffer (the given row index
      * does not refer to an actual row, even considering scrollback) */
-    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer, row);
+    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_mutable_row(buffer, row);
     if (buffer_row == NULL)
         return;
 
@@ -532,6 +1071,17 @@ void guac_terminal_buffer_set_cursor(guac_terminal_buffer* buffer, int row,
     if (buffer_row == NULL)
         return;
 
+    /* Packed rows never contain the cursor, so there is no need to unpack a
+     * row merely to clear the cursor */
+    if (guac_terminal_buffer_row_is_packed(buffer_row)) {
+
+        if (!is_cursor)
+            return;
+
+        buffer_row = guac_terminal_buffer_get_mutable_row(buffer, row);
+
+    }
+
     column = guac_terminal_fit_to_range(column, 0, GUAC_TERMINAL_MAX_COLUMNS - 1);
 
     guac_terminal_buffer_row_expand(buffer_row, column + 1, &buffer->default_character);
@@ -564,3 +1114,34 @@ void guac_terminal_buffer_set_wrapped(guac_terminal_buffer* buffer, int row, boo
 
 }
 
+
+size_t guac_terminal_buffer_memory_usage(guac_terminal_buffer* buffer) {
+
+    size_t usage = sizeof(guac_terminal_buffer)
+        + sizeof(guac_terminal_buffer_row*) * buffer->chunk_count
+        + sizeof(guac_terminal_char) * buffer->unpacked_available;
+
+    for (unsigned int i = 0; i < buffer->chunk_count; i++) {
+
+        guac_terminal_buffer_row* row = buffer->chunks[i];
+        if (row == NULL)
+            continue;
+
+        usage += sizeof(guac_terminal_buffer_row) * GUAC_TERMINAL_BUFFER_CHUNK_SIZE;
+
+        for (int j = 0; j < GUAC_TERMINAL_BUFFER_CHUNK_SIZE; j++) {
+
+            if (row->packed != NULL)
+                usage += row->packed->size;
+            else
+                usage += sizeof(guac_terminal_char) * row->available;
+
+            row++;
+
+        }
+
+    }
+
+    return usage;
+
+}
@@ -17,7 +17,6 @@
  * under the License.
  */
 
-#include "common/surface.h"
 #include "terminal/common.h"
 #include "terminal/display.h"
 #include "terminal/palette.h"
@@ -26,6 +25,7 @@
 #include "terminal/types.h"
 
 #include <math.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -34,9 +34,10 @@
 #include <glib-object.h>
 #include <guacamole/assert.h>
 #include <guacamole/client.h>
+#include <guacamole/display.h>
 #include <guacamole/mem.h>
 #include <guacamole/protocol.h>
-#include <guacamole/socket.h>
+#include <guacamole/rect.h>
 #include <pango/pangocairo.h>
 
 /* Maps any codepoint onto a number between 0 and 511 inclusive */
@@ -101,9 +102,13 @@ int __guac_terminal_set_colors(guac_terminal_display* display,
 /**
  * Sends the given character to the terminal at the given row and column,
  * rendering the character immediately. This bypasses the guac_terminal_display
- * mechanism and is intended for flushing of updates only.
+ * mechanism and is intended for flushing of updates only. The character is
+ * rendered directly into the image buffer of the terminal layer through the
+ * given raw context.
  */
-int __guac_terminal_set(guac_terminal_display* display, int row, int col, int codepoint) {
+int __guac_terminal_set(guac_terminal_display* display,
+        guac_display_layer_raw_context* context, int row, int col,
+        int codepoint) {
 
     int width;
 
@@ -142,9 +147,22 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
     ideal_layout_width = surface_width * PANGO_SCALE;
     ideal_layout_height = surface_height * PANGO_SCALE;
 
-    /* Prepare surface */
-    surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
-                                         surface_width, surface_height);
+    /* Determine the region of the terminal layer occupied by the glyph,
+     * clipping any portion of wide glyphs that would extend beyond the edge */
+    guac_rect glyph_rect;
+    guac_rect_init(&glyph_rect, display->char_width * col,
+            display->char_height * row, surface_width, surface_height);
+    guac_rect_constrain(&glyph_rect, &context->bounds);
+
+    /* Do nothing if glyph is entirely outside the layer */
+    if (guac_rect_is_empty(&glyph_rect))
+        return 0;
+
+    /* Prepare surface wrapping the glyph region of the terminal layer */
+    surface = cairo_image_surface_create_for_data(
+            GUAC_DISPLAY_LAYER_RAW_BUFFER(context, glyph_rect),
+            CAIRO_FORMAT_RGB24, guac_rect_width(&glyph_rect),
+            guac_rect_height(&glyph_rect), context->stride);
     cairo = cairo_create(surface);
 
     /* Fill background */
@@ -188,11 +206,9 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
     cairo_move_to(cairo, 0.0, 0.0);
     pango_cairo_show_layout(cairo, layout);
 
-    /* Draw */
-    guac_common_surface_draw(display->display_surface,
-        display->char_width * col,
-        display->char_height * row,
-        surface);
+    /* Commit glyph to terminal layer */
+    cairo_surface_flush(surface);
+    guac_rect_extend(&context->dirty, &glyph_rect);
 
     /* Free all */
     g_object_unref(layout);
@@ -217,6 +233,7 @@ static int get_margin_by_dpi(int dpi) {
 }
 
 guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
+        guac_display* graphical_display,
         const char* font_name, int font_size, int dpi,
         guac_terminal_color* foreground, guac_terminal_color* background,
         guac_terminal_color (*palette)[256]) {
@@ -230,25 +247,27 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     display->char_width = 0;
     display->char_height = 0;
 
-    /* Create default surface */
-    display->display_layer = guac_client_alloc_layer(client);
-    display->select_layer = guac_client_alloc_layer(client);
-    display->display_surface = guac_common_surface_alloc(client,
-            client->socket, display->display_layer, 0, 0);
+    /* Create layers for terminal text and selection highlight */
+    display->graphical_display = graphical_display;
+    display->display_layer = guac_display_alloc_layer(graphical_display, 1);
+    display->select_layer = guac_display_alloc_layer(graphical_display, 0);
 
     /* Never use lossy compression for terminal contents */
-    guac_common_surface_set_lossless(display->display_surface, 1);
+    guac_display_layer_set_lossless(display->display_layer, 1);
+    guac_display_layer_set_lossless(display->select_layer, 1);
 
     /* Select layer is a child of the display layer */
-    guac_protocol_send_move(client->socket, display->select_layer,
-            display->display_layer, 0, 0, 0);
+    guac_display_layer_set_parent(display->select_layer,
+            display->display_layer);
 
     /* Calculate margin size by DPI */
     display->margin = get_margin_by_dpi(dpi);
 
     /* Offset the Default Layer to make margins even on all sides */
-    guac_protocol_send_move(client->socket, display->display_layer,
-        GUAC_DEFAULT_LAYER, display->margin, display->margin, 0);
+    guac_display_layer_set_parent(display->display_layer,
+            guac_display_default_layer(graphical_display));
+    guac_display_layer_move(display->display_layer,
+            display->margin, display->margin);
 
     display->default_foreground = display->glyph_foreground = *foreground;
     display->default_background = display->glyph_background = *background;
@@ -276,6 +295,10 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
 
 void guac_terminal_display_free(guac_terminal_display* display) {
 
+    /* Free layers */
+    guac_display_free_layer(display->select_layer);
+    guac_display_free_layer(display->display_layer);
+
     /* Free font description */
     pango_font_description_free(display->font_desc);
 
@@ -546,19 +569,92 @@ void guac_terminal_display_resize(guac_terminal_display* display, int width, int
     display->height = height;
 
     /* Send display size */
-    guac_common_surface_resize(
-            display->display_surface,
+    guac_display_layer_resize(display->display_layer,
             display->char_width  * width,
             display->char_height * height);
 
-    guac_protocol_send_size(display->client->socket,
-            display->select_layer,
+    guac_display_layer_resize(display->select_layer,
             display->char_width  * width,
             display->char_height * height);
 
 }
 
-void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
+/**
+ * Copies a rectangle of image data from one location within the terminal
+ * layer to another, as would be done by a copy between character cells. The
+ * source and destination rectangles may overlap. Any portion of either
+ * rectangle which would extend beyond the bounds of the layer is clipped.
+ *
+ * @param context
+ *     The raw context of the terminal layer.
+ *
+ * @param src_x
+ *     The X coordinate of the upper-left corner of the source rectangle.
+ *
+ * @param src_y
+ *     The Y coordinate of the upper-left corner of the source rectangle.
+ *
+ * @param width
+ *     The width of the rectangle, in pixels.
+ *
+ * @param height
+ *     The height of the rectangle, in pixels.
+ *
+ * @param dst_x
+ *     The X coordinate of the upper-left corner of the destination rectangle.
+ *
+ * @param dst_y
+ *     The Y coordinate of the upper-left corner of the destination rectangle.
+ */
+static void guac_terminal_display_copy_rect(
+        guac_display_layer_raw_context* context, int src_x, int src_y,
+        int width, int height, int dst_x, int dst_y) {
+
+    /* Clip the copied region such that both source and destination lie
+     * entirely within the layer */
+    guac_rect src;
+    guac_rect_init(&src, src_x, src_y, width, height);
+    guac_rect_constrain(&src, &context->bounds);
+
+    guac_rect dst;
+    guac_rect_init(&dst, dst_x, dst_y, guac_rect_width(&src),
+            guac_rect_height(&src));
+    guac_rect_constrain(&dst, &context->bounds);
+
+    if (guac_rect_is_empty(&dst))
+        return;
+
+    width = guac_rect_width(&dst);
+    height = guac_rect_height(&dst);
+    size_t length = (size_t) width * GUAC_DISPLAY_LAYER_RAW_BPP;
+
+    const unsigned char* src_row = GUAC_DISPLAY_LAYER_RAW_BUFFER(context, src);
+    unsigned char* dst_row = GUAC_DISPLAY_LAYER_RAW_BUFFER(context, dst);
+
+    /* Copy rows from the bottom up if moving data downward, such that
+     * overlapping source rows are not overwritten before being copied */
+    ptrdiff_t step = context->stride;
+    if (dst.top > src.top) {
+        src_row += (height - 1) * step;
+        dst_row += (height - 1) * step;
+        step = -step;
+    }
+
+    for (int y = 0; y < height; y++) {
+        memmove(dst_row, src_row, length);
+        src_row += step;
+        dst_row += step;
+    }
+
+    /* The guac_display will recognize this region as having been copied from
+     * elsewhere within the same layer, as the raw context hints that the
+     * layer itself should be searched for copies */
+    guac_rect_extend(&context->dirty, &dst);
+
+}
+
+void __guac_terminal_display_flush_copy(guac_terminal_display* display,
+        guac_display_layer_raw_context* context) {
 
     guac_terminal_operation* current = display->operations;
     int row, col;
@@ -660,16 +756,12 @@ void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
                 }
 
-                /* Send copy */
-                guac_common_surface_copy(
-
-                        display->display_surface,
+                /* Perform copy */
+                guac_terminal_display_copy_rect(context,
                         current->column * display->char_width,
                         current->row * display->char_height,
                         rect_width * display->char_width,
                         rect_height * display->char_height,
-
-                        display->display_surface,
                         col * display->char_width,
                         row * display->char_height);
 
@@ -683,7 +775,8 @@ void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
 }
 
-void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
+void __guac_terminal_display_flush_clear(guac_terminal_display* display,
+        guac_display_layer_raw_context* context) {
 
     guac_terminal_operation* current = display->operations;
     int row, col;
@@ -797,15 +890,23 @@ void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 
                 }
 
-                /* Send rect */
-                guac_common_surface_set(
-                        display->display_surface,
+                /* Fill rect */
+                guac_rect fill_rect;
+                guac_rect_init(&fill_rect,
                         col * display->char_width,
                         row * display->char_height,
                         rect_width * display->char_width,
-                        rect_height * display->char_height,
-                        color.red, color.green, color.blue,
-                        0xFF);
+                        rect_height * display->char_height);
+
+                guac_rect_constrain(&fill_rect, &context->bounds);
+                if (!guac_rect_is_empty(&fill_rect)) {
+                    guac_display_layer_raw_context_set(context, &fill_rect,
+                            0xFF000000
+                            | (color.red   << 16)
+                            | (color.green << 8)
+                            |  color.blue);
+                    guac_rect_extend(&context->dirty, &fill_rect);
+                }
 
             } /* end if clear operation */
 
@@ -817,7 +918,8 @@ void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 
 }
 
-void __guac_terminal_display_flush_set(guac_terminal_display* display) {
+void __guac_terminal_display_flush_set(guac_terminal_display* display,
+        guac_display_layer_raw_context* context) {
 
     guac_terminal_operation* current = display->operations;
     int row, col;
@@ -840,7 +942,7 @@ void __guac_terminal_display_flush_set(guac_terminal_display* display) {
                         &(current->character.attributes));
 
                 /* Send character */
-                __guac_terminal_set(display, row, col, codepoint);
+                __guac_terminal_set(display, context, row, col, codepoint);
 
                 /* Mark operation as handled */
                 current->type = GUAC_CHAR_NOP;
@@ -857,43 +959,100 @@ void __guac_terminal_display_flush_set(guac_terminal_display* display) {
 
 void guac_terminal_display_flush(guac_terminal_display* display) {
 
+    guac_display_layer_raw_context* context =
+        guac_display_layer_open_raw(display->display_layer);
+
     /* Flush operations, copies first, then clears, then sets. */
-    __guac_terminal_display_flush_copy(display);
-    __guac_terminal_display_flush_clear(display);
-    __guac_terminal_display_flush_set(display);
+    __guac_terminal_display_flush_copy(display, context);
+    __guac_terminal_display_flush_clear(display, context);
+    __guac_terminal_display_flush_set(display, context);
 
-    /* Flush surface */
-    guac_common_surface_flush(display->display_surface);
+    guac_display_layer_close_raw(display->display_layer, context);
 
 }
 
-void guac_terminal_display_dup(
-        guac_terminal_display* display, guac_client* client, guac_socket* socket) {
+/**
+ * The color of the selection highlight, as a premultiplied ARGB value
+ * equivalent to the color 0x0080FF at an opacity of 0x60.
+ */
+#define GUAC_TERMINAL_SELECTION_COLOR 0x60003060
+
+/**
+ * Fills the given rectangle of the select layer with the selection highlight
+ * color, if the rectangle lies at least partially within that layer.
+ *
+ * @param context
+ *     The raw context of the select layer.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle.
+ *
+ * @param width
+ *     The width of the rectangle, in pixels.
+ *
+ * @param height
+ *     The height of the rectangle, in pixels.
+ */
+static void guac_terminal_display_highlight(
+        guac_display_layer_raw_context* context,
+        int x, int y, int width, int height) {
 
-    /* Create default surface */
-    guac_common_surface_dup(display->display_surface, client, socket);
+    guac_rect highlight;
+    guac_rect_init(&highlight, x, y, width, height);
+    guac_rect_constrain(&highlight, &context->bounds);
 
-    /* Select layer is a child of the display layer */
-    guac_protocol_send_move(socket, display->select_layer,
-            display->display_layer, 0, 0, 0);
+    if (!guac_rect_is_empty(&highlight))
+        guac_display_layer_raw_context_set(context, &highlight,
+                GUAC_TERMINAL_SELECTION_COLOR);
 
-    /* Offset the Default Layer to make margins even on all sides */
-    guac_protocol_send_move(socket, display->display_layer,
-        GUAC_DEFAULT_LAYER, display->margin, display->margin, 0);
+}
 
-    /* Send select layer size */
-    guac_protocol_send_size(socket, display->select_layer,
-            display->char_width  * display->width,
-            display->char_height * display->height);
+/**
+ * Clears the selection highlight from all rows of the select layer which were
+ * covered by the current selection, if any, marking those rows as dirty. If
+ * no text is currently selected, this function has no effect.
+ *
+ * @param display
+ *     The guac_terminal_display whose selection highlight should be cleared.
+ *
+ * @param context
+ *     The raw context of the select layer.
+ */
+static void guac_terminal_display_erase_select(guac_terminal_display* display,
+        guac_display_layer_raw_context* context) {
+
+    if (!display->text_selected)
+        return;
+
+    int start_row = display->selection_start_row;
+    int end_row = display->selection_end_row;
+
+    /* Ensure proper ordering of rows */
+    if (start_row > end_row) {
+        int temp = start_row;
+        start_row = end_row;
+        end_row = temp;
+    }
+
+    guac_rect selected_rows;
+    guac_rect_init(&selected_rows, 0, start_row * display->char_height,
+            display->width * display->char_width,
+            (end_row - start_row + 1) * display->char_height);
+    guac_rect_constrain(&selected_rows, &context->bounds);
+
+    if (!guac_rect_is_empty(&selected_rows)) {
+        guac_display_layer_raw_context_set(context, &selected_rows, 0x00000000);
+        guac_rect_extend(&context->dirty, &selected_rows);
+    }
 
 }
 
 void guac_terminal_display_select(guac_terminal_display* display,
         int start_row, int start_col, int end_row, int end_col) {
 
-    guac_socket* socket = display->client->socket;
-    guac_layer* select_layer = display->select_layer;
-
     /* Do nothing if selection is unchanged */
     if (display->text_selected
             && display->selection_start_row    == start_row
@@ -902,6 +1061,12 @@ void guac_terminal_display_select(guac_terminal_display* display,
             && display->selection_end_column   == end_col)
         return;
 
+    guac_display_layer_raw_context* context =
+        guac_display_layer_open_raw(display->select_layer);
+
+    /* Erase old selection */
+    guac_terminal_display_erase_select(display, context);
+
     /* Text is now selected */
     display->text_selected = true;
 
@@ -921,7 +1086,7 @@ void guac_terminal_display_select(guac_terminal_display* display,
         }
 
         /* Select characters between columns */
-        guac_protocol_send_rect(socket, select_layer,
+        guac_terminal_display_highlight(context,
 
                 start_col * display->char_width,
                 start_row * display->char_height,
@@ -950,7 +1115,7 @@ void guac_terminal_display_select(guac_terminal_display* display,
         }
 
         /* First row */
-        guac_protocol_send_rect(socket, select_layer,
+        guac_terminal_display_highlight(context,
 
                 start_col * display->char_width,
                 start_row * display->char_height,
@@ -959,7 +1124,7 @@ void guac_terminal_display_select(guac_terminal_display* display,
                 display->char_height);
 
         /* Middle */
-        guac_protocol_send_rect(socket, select_layer,
+        guac_terminal_display_highlight(context,
 
                 0,
                 (start_row + 1) * display->char_height,
@@ -968,7 +1133,7 @@ void guac_terminal_display_select(guac_terminal_display* display,
                 (end_row - start_row - 1) * display->char_height);
 
         /* Last row */
-        guac_protocol_send_rect(socket, select_layer,
+        guac_terminal_display_highlight(context,
 
                 0,
                 end_row * display->char_height,
@@ -978,9 +1143,19 @@ void guac_terminal_display_select(guac_terminal_display* display,
 
     }
 
-    /* Draw new selection, erasing old */
-    guac_protocol_send_cfill(socket, GUAC_COMP_SRC, select_layer,
-            0x00, 0x80, 0xFF, 0x60);
+    /* Mark all rows of new selection as dirty */
+    guac_rect selected_rows;
+    guac_rect_init(&selected_rows, 0, start_row * display->char_height,
+            display->width * display->char_width,
+            (end_row - start_row + 1) * display->char_height);
+    guac_rect_constrain(&selected_rows, &context->bounds);
+
+    if (!guac_rect_is_empty(&selected_rows))
+        guac_rect_extend(&context->dirty, &selected_rows);
+
+    /* The selection highlight is never copied from elsewhere */
+    context->hint_from = NULL;
+    guac_display_layer_close_raw(display->select_layer, context);
 
 }
 
@@ -990,12 +1165,14 @@ void guac_terminal_display_clear_select(guac_terminal_display* display) {
     if (!display->text_selected)
         return;
 
-    guac_socket* socket = display->client->socket;
-    guac_layer* select_layer = display->select_layer;
+    guac_display_layer_raw_context* context =
+        guac_display_layer_open_raw(display->select_layer);
+
+    /* Erase old selection */
+    guac_terminal_display_erase_select(display, context);
 
-    guac_protocol_send_rect(socket, select_layer, 0, 0, 1, 1);
-    guac_protocol_send_cfill(socket, GUAC_COMP_SRC, select_layer,
-            0x00, 0x00, 0x00, 0x00);
+    context->hint_from = NULL;
+    guac_display_layer_close_raw(display->select_layer, context);
 
     /* Text is no longer selected */
     display->text_selected = false;
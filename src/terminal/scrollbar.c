@@ -20,23 +20,25 @@
 #include "terminal/scrollbar.h"
 
 #include <guacamole/client.h>
-#include <guacamole/layer.h>
+#include <guacamole/display.h>
 #include <guacamole/mem.h>
-#include <guacamole/socket.h>
-#include <guacamole/protocol.h>
+#include <guacamole/rect.h>
 #include <guacamole/user.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 
 guac_terminal_scrollbar* guac_terminal_scrollbar_alloc(guac_client* client,
-        const guac_layer* parent, int parent_width, int parent_height, int visible_area) {
+        guac_display* graphical_display, const guac_display_layer* parent,
+        int parent_width, int parent_height, int visible_area) {
 
     /* Allocate scrollbar */
     guac_terminal_scrollbar* scrollbar =
         guac_mem_alloc(sizeof(guac_terminal_scrollbar));
 
-    /* Associate client */
+    /* Associate client and display */
     scrollbar->client = client;
+    scrollbar->graphical_display = graphical_display;
 
     /* Init default min/max and value */
     scrollbar->min   = 0;
@@ -62,8 +64,13 @@ guac_terminal_scrollbar* guac_terminal_scrollbar_alloc(guac_client* client,
     scrollbar->render_state.container_height = 0;
 
     /* Allocate and init layers */
-    scrollbar->container = guac_client_alloc_layer(client);
-    scrollbar->handle    = guac_client_alloc_layer(client);
+    scrollbar->container = guac_display_alloc_layer(graphical_display, 0);
+    scrollbar->handle    = guac_display_alloc_layer(graphical_display, 0);
+
+    /* Handle is contained within the scrollbar, which is itself contained
+     * within the parent layer */
+    guac_display_layer_set_parent(scrollbar->container, parent);
+    guac_display_layer_set_parent(scrollbar->handle, scrollbar->container);
 
     /* Init mouse event state tracking */
     scrollbar->dragging_handle = 0;
@@ -79,18 +86,42 @@ guac_terminal_scrollbar* guac_terminal_scrollbar_alloc(guac_client* client,
 void guac_terminal_scrollbar_free(guac_terminal_scrollbar* scrollbar) {
 
     /* Free layers */
-    guac_client_free_layer(scrollbar->client, scrollbar->handle);
-    guac_client_free_layer(scrollbar->client, scrollbar->container);
+    guac_display_free_layer(scrollbar->handle);
+    guac_display_free_layer(scrollbar->container);
 
     /* Free scrollbar */
     guac_mem_free(scrollbar);
 
 }
 
+/**
+ * Fills the entirety of the given layer with a single color, replacing its
+ * current contents.
+ *
+ * @param layer
+ *     The layer to fill.
+ *
+ * @param color
+ *     The color to fill the layer with, as a premultiplied ARGB value.
+ */
+static void guac_terminal_scrollbar_fill(guac_display_layer* layer,
+        uint32_t color) {
+
+    guac_display_layer_raw_context* context = guac_display_layer_open_raw(layer);
+
+    if (!guac_rect_is_empty(&context->bounds)) {
+        guac_display_layer_raw_context_set(context, &context->bounds, color);
+        guac_rect_extend(&context->dirty, &context->bounds);
+    }
+
+    context->hint_from = NULL;
+    guac_display_layer_close_raw(layer, context);
+
+}
+
 /**
  * Moves the main scrollbar layer to the position indicated within the given
- * scrollbar render state, sending any necessary Guacamole instructions over
- * the given socket.
+ * scrollbar render state.
  *
  * @param scrollbar
  *     The scrollbar to reposition.
@@ -98,29 +129,21 @@ void guac_terminal_scrollbar_free(guac_terminal_scrollbar* scrollbar) {
  * @param state
  *     The guac_terminal_scrollbar_render_state describing the new scrollbar
  *     position.
- *
- * @param socket
- *     The guac_socket over which any instructions necessary to perform the
- *     render operation should be sent.
  */
 static void guac_terminal_scrollbar_move_container(
         guac_terminal_scrollbar* scrollbar,
-        guac_terminal_scrollbar_render_state* state,
-        guac_socket* socket) {
+        guac_terminal_scrollbar_render_state* state) {
 
-    /* Send scrollbar position */
-    guac_protocol_send_move(socket,
-            scrollbar->container, scrollbar->parent,
+    /* Set scrollbar position */
+    guac_display_layer_move(scrollbar->container,
             state->container_x,
-            state->container_y,
-            0);
+            state->container_y);
 
 }
 
 /**
  * Resizes and redraws the main scrollbar layer according to the given
- * scrollbar render state, sending any necessary Guacamole instructions over
- * the given socket.
+ * scrollbar render state.
  *
  * @param scrollbar
  *     The scrollbar to resize and redraw.
@@ -128,37 +151,26 @@ static void guac_terminal_scrollbar_move_container(
  * @param state
  *     The guac_terminal_scrollbar_render_state describing the new scrollbar
  *     size and appearance.
- *
- * @param socket
- *     The guac_socket over which any instructions necessary to perform the
- *     render operation should be sent.
  */
 static void guac_terminal_scrollbar_draw_container(
         guac_terminal_scrollbar* scrollbar,
-        guac_terminal_scrollbar_render_state* state,
-        guac_socket* socket) {
+        guac_terminal_scrollbar_render_state* state) {
 
     /* Set container size */
-    guac_protocol_send_size(socket, scrollbar->container,
-            state->container_width,
-            state->container_height);
-
-    /* Fill container with solid color */
-    guac_protocol_send_rect(socket, scrollbar->container, 0, 0,
+    guac_display_layer_resize(scrollbar->container,
             state->container_width,
             state->container_height);
 
-    guac_protocol_send_cfill(socket, GUAC_COMP_SRC, scrollbar->container,
-            0x80, 0x80, 0x80, 0x40);
+    /* Fill container with solid color (0x808080 at an opacity of 0x40) */
+    guac_terminal_scrollbar_fill(scrollbar->container, 0x40202020);
 
 }
 
 /**
  * Moves the handle layer of the scrollbar to the position indicated within the
- * given scrollbar render state, sending any necessary Guacamole instructions
- * over the given socket. The handle is the portion of the scrollbar that
- * indicates the current scroll value and which the user can click and drag to
- * change the value.
+ * given scrollbar render state. The handle is the portion of the scrollbar
+ * that indicates the current scroll value and which the user can click and
+ * drag to change the value.
  *
  * @param scrollbar
  *     The scrollbar associated with the handle being repositioned.
@@ -166,31 +178,23 @@ static void guac_terminal_scrollbar_draw_container(
  * @param state
  *     The guac_terminal_scrollbar_render_state describing the new scrollbar
  *     handle position.
- *
- * @param socket
- *     The guac_socket over which any instructions necessary to perform the
- *     render operation should be sent.
  */
 static void guac_terminal_scrollbar_move_handle(
         guac_terminal_scrollbar* scrollbar,
-        guac_terminal_scrollbar_render_state* state,
-        guac_socket* socket) {
+        guac_terminal_scrollbar_render_state* state) {
 
-    /* Send handle position */
-    guac_protocol_send_move(socket,
-            scrollbar->handle, scrollbar->container,
+    /* Set handle position */
+    guac_display_layer_move(scrollbar->handle,
             state->handle_x,
-            state->handle_y,
-            0);
+            state->handle_y);
 
 }
 
 /**
  * Resizes and redraws the handle layer of the scrollbar according to the given
- * scrollbar render state, sending any necessary Guacamole instructions over
- * the given socket. The handle is the portion of the scrollbar that indicates
- * the current scroll value and which the user can click and drag to change the
- * value.
+ * scrollbar render state. The handle is the portion of the scrollbar that
+ * indicates the current scroll value and which the user can click and drag to
+ * change the value.
  *
  * @param scrollbar
  *     The scrollbar associated with the handle being resized and redrawn.
@@ -198,28 +202,18 @@ static void guac_terminal_scrollbar_move_handle(
  * @param state
  *     The guac_terminal_scrollbar_render_state describing the new scrollbar
  *     handle size and appearance.
- *
- * @param socket
- *     The guac_socket over which any instructions necessary to perform the
- *     render operation should be sent.
  */
 static void guac_terminal_scrollbar_draw_handle(
         guac_terminal_scrollbar* scrollbar,
-        guac_terminal_scrollbar_render_state* state,
-        guac_socket* socket) {
+        guac_terminal_scrollbar_render_state* state) {
 
     /* Set handle size */
-    guac_protocol_send_size(socket, scrollbar->handle,
-            state->handle_width,
-            state->handle_height);
-
-    /* Fill handle with solid color */
-    guac_protocol_send_rect(socket, scrollbar->handle, 0, 0,
+    guac_display_layer_resize(scrollbar->handle,
             state->handle_width,
             state->handle_height);
 
-    guac_protocol_send_cfill(socket, GUAC_COMP_SRC, scrollbar->handle,
-            0xA0, 0xA0, 0xA0, 0x8F);
+    /* Fill handle with solid color (0xA0A0A0 at an opacity of 0x8F) */
+    guac_terminal_scrollbar_fill(scrollbar->handle, 0x8F595959);
 
 }
 
@@ -333,26 +327,8 @@ static void calculate_state(guac_terminal_scrollbar* scrollbar,
 
 }
 
-void guac_terminal_scrollbar_dup(guac_terminal_scrollbar* scrollbar,
-        guac_client* client, guac_socket* socket) {
-
-    /* Get old state */
-    guac_terminal_scrollbar_render_state* state = &scrollbar->render_state;
-
-    /* Send scrollbar container */
-    guac_terminal_scrollbar_draw_container(scrollbar, state, socket);
-    guac_terminal_scrollbar_move_container(scrollbar, state, socket);
-
-    /* Send handle */
-    guac_terminal_scrollbar_draw_handle(scrollbar, state, socket);
-    guac_terminal_scrollbar_move_handle(scrollbar, state, socket);
-
-}
-
 void guac_terminal_scrollbar_flush(guac_terminal_scrollbar* scrollbar) {
 
-    guac_socket* socket = scrollbar->client->socket;
-
     /* Get old state */
     int old_value = scrollbar->value;
     guac_terminal_scrollbar_render_state* old_state = &scrollbar->render_state;
@@ -369,25 +345,25 @@ void guac_terminal_scrollbar_flush(guac_terminal_scrollbar* scrollbar) {
     /* Reposition container if moved */
     if (old_state->container_x != new_state.container_x
      || old_state->container_y != new_state.container_y) {
-        guac_terminal_scrollbar_move_container(scrollbar, &new_state, socket);
+        guac_terminal_scrollbar_move_container(scrollbar, &new_state);
     }
 
     /* Resize and redraw container if size changed */
     if (old_state->container_width  != new_state.container_width
      || old_state->container_height != new_state.container_height) {
-        guac_terminal_scrollbar_draw_container(scrollbar, &new_state, socket);
+        guac_terminal_scrollbar_draw_container(scrollbar, &new_state);
     }
 
     /* Reposition handle if moved */
     if (old_state->handle_x != new_state.handle_x
      || old_state->handle_y != new_state.handle_y) {
-        guac_terminal_scrollbar_move_handle(scrollbar, &new_state, socket);
+        guac_terminal_scrollbar_move_handle(scrollbar, &new_state);
     }
 
     /* Resize and redraw handle if size changed */
     if (old_state->handle_width  != new_state.handle_width
      || old_state->handle_height != new_state.handle_height) {
-        guac_terminal_scrollbar_draw_handle(scrollbar, &new_state, socket);
+        guac_terminal_scrollbar_draw_handle(scrollbar, &new_state);
     }
 
     /* Store current render state */
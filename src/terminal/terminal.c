@@ -18,7 +18,6 @@
  */
 
 #include "common/clipboard.h"
-#include "common/cursor.h"
 #include "common/iconv.h"
 #include "terminal/buffer.h"
 #include "terminal/color-scheme.h"
@@ -44,10 +43,12 @@
 #include <wchar.h>
 
 #include <guacamole/client.h>
+#include <guacamole/display.h>
 #include <guacamole/error.h>
 #include <guacamole/flag.h>
 #include <guacamole/mem.h>
 #include <guacamole/protocol.h>
+#include <guacamole/rect.h>
 #include <guacamole/socket.h>
 #include <guacamole/string.h>
 #include <guacamole/timestamp.h>
@@ -172,13 +173,8 @@ void guac_terminal_reset(guac_terminal* term) {
  *
  * @param terminal
  *     The terminal whose background should be painted or repainted.
- *
- * @param socket
- *     The socket over which instructions required to paint / repaint the
- *     terminal background should be send.
  */
-static void guac_terminal_repaint_default_layer(guac_terminal* terminal,
-        guac_socket* socket) {
+static void guac_terminal_repaint_default_layer(guac_terminal* terminal) {
 
     int width = terminal->width;
     int height = terminal->height;
@@ -188,12 +184,25 @@ static void guac_terminal_repaint_default_layer(guac_terminal* terminal,
     const guac_terminal_color* color = &display->default_background;
 
     /* Reset size */
-    guac_protocol_send_size(socket, GUAC_DEFAULT_LAYER, width, height);
+    guac_display_layer* default_layer =
+        guac_display_default_layer(terminal->graphical_display);
+    guac_display_layer_resize(default_layer, width, height);
 
     /* Paint background color */
-    guac_protocol_send_rect(socket, GUAC_DEFAULT_LAYER, 0, 0, width, height);
-    guac_protocol_send_cfill(socket, GUAC_COMP_OVER, GUAC_DEFAULT_LAYER,
-            color->red, color->green, color->blue, 0xFF);
+    guac_display_layer_raw_context* context =
+        guac_display_layer_open_raw(default_layer);
+
+    if (!guac_rect_is_empty(&context->bounds)) {
+        guac_display_layer_raw_context_set(context, &context->bounds,
+                0xFF000000
+                | (color->red   << 16)
+                | (color->green << 8)
+                |  color->blue);
+        guac_rect_extend(&context->dirty, &context->bounds);
+    }
+
+    context->hint_from = NULL;
+    guac_display_layer_close_raw(default_layer, context);
 
 }
 
@@ -220,9 +229,8 @@ void* guac_terminal_thread(void* data) {
         if (guac_terminal_render_frame(terminal))
             break;
 
-        /* Signal end of frame */
-        guac_client_end_frame(client);
-        guac_socket_flush(client->socket);
+        /* Signal end of frame, encoding any changes in parallel */
+        guac_display_end_frame(terminal->graphical_display);
 
     }
 
@@ -399,8 +407,12 @@ guac_terminal* guac_terminal_create(guac_client* client,
     term->current_buffer = term->normal_buffer = guac_terminal_buffer_alloc(initial_scrollback, &default_char);
     term->alternate_buffer = guac_terminal_buffer_alloc(GUAC_TERMINAL_MAX_ROWS, &default_char);
 
+    /* Init graphical display shared by all terminal layers */
+    term->graphical_display = guac_display_alloc(client);
+
     /* Init display */
     term->display = guac_terminal_display_alloc(client,
+            term->graphical_display,
             options->font_name, options->font_size, options->dpi,
             &default_char.attributes.foreground,
             &default_char.attributes.background,
@@ -409,13 +421,11 @@ guac_terminal* guac_terminal_create(guac_client* client,
     /* Fail if display init failed */
     if (term->display == NULL) {
         guac_client_log(client, GUAC_LOG_DEBUG, "Display initialization failed");
+        guac_display_free(term->graphical_display);
         guac_mem_free(term);
         return NULL;
     }
 
-    /* Init common cursor */
-    term->cursor = guac_common_cursor_alloc(client);
-
     /* Init terminal state */
     term->current_attributes = default_char.attributes;
     term->default_char = default_char;
@@ -465,12 +475,14 @@ guac_terminal* guac_terminal_create(guac_client* client,
     pthread_mutex_init(&(term->lock), NULL);
 
     /* Repaint and resize overall display */
-    guac_terminal_repaint_default_layer(term, term->client->socket);
+    guac_terminal_repaint_default_layer(term);
     guac_terminal_display_resize(term->display,
             term->term_width, term->term_height);
 
     /* Allocate scrollbar */
-    term->scrollbar = guac_terminal_scrollbar_alloc(term->client, GUAC_DEFAULT_LAYER,
+    term->scrollbar = guac_terminal_scrollbar_alloc(term->client,
+            term->graphical_display,
+            guac_display_default_layer(term->graphical_display),
             term->outer_width, term->outer_height, term->term_height);
 
     /* Associate scrollbar with this terminal */
@@ -491,7 +503,7 @@ guac_terminal* guac_terminal_create(guac_client* client,
 
     /* Initialize mouse cursor */
     term->current_cursor = GUAC_TERMINAL_CURSOR_BLANK;
-    guac_common_cursor_set_blank(term->cursor);
+    guac_display_set_cursor(term->graphical_display, GUAC_DISPLAY_CURSOR_NONE);
 
     /* Start terminal thread */
     if (pthread_create(&(term->thread), NULL,
@@ -548,6 +560,13 @@ void guac_terminal_free(guac_terminal* term) {
 
     /* Free display */
     guac_terminal_display_free(term->display);
+    guac_display_free(term->graphical_display);
+
+    guac_client_log(term->client, GUAC_LOG_DEBUG, "Terminal buffers "
+            "occupied %zu bytes (including scrollback) and %zu bytes "
+            "(alternate buffer).",
+            guac_terminal_buffer_memory_usage(term->normal_buffer),
+            guac_terminal_buffer_memory_usage(term->alternate_buffer));
 
     /* Free buffers */
     guac_terminal_buffer_free(term->normal_buffer);
@@ -1326,9 +1345,6 @@ static void __guac_terminal_resize(guac_terminal* term, int width, int height) {
 
 int guac_terminal_resize(guac_terminal* terminal, int width, int height) {
 
-    guac_terminal_display* display = terminal->display;
-    guac_client* client = display->client;
-
     /* Acquire exclusive access to terminal */
     guac_terminal_lock(terminal);
 
@@ -1351,7 +1367,7 @@ int guac_terminal_resize(guac_terminal* terminal, int width, int height) {
     terminal->width = adjusted_width;
 
     /* Resize default layer to given pixel dimensions */
-    guac_terminal_repaint_default_layer(terminal, client->socket);
+    guac_terminal_repaint_default_layer(terminal);
 
     /* Resize terminal if row/column dimensions have changed */
     if (columns != terminal->term_width || rows != terminal->term_height) {
@@ -1434,7 +1450,8 @@ static int __guac_terminal_send_key(guac_terminal* term, int keysym, int pressed
     /* Hide mouse cursor if not already hidden */
     if (term->current_cursor != GUAC_TERMINAL_CURSOR_BLANK) {
         term->current_cursor = GUAC_TERMINAL_CURSOR_BLANK;
-        guac_common_cursor_set_blank(term->cursor);
+        guac_display_set_cursor(term->graphical_display,
+                GUAC_DISPLAY_CURSOR_NONE);
         guac_terminal_notify(term);
     }
 
@@ -1741,7 +1758,8 @@ static int __guac_terminal_send_mouse(guac_terminal* term, guac_user* user,
     int pressed_mask  = ~term->mouse_mask &  mask;
 
     /* Store current mouse location/state */
-    guac_common_cursor_update(term->cursor, user, x, y, mask);
+    guac_display_notify_user_moved_mouse(term->graphical_display, user,
+            x, y, mask);
 
     /* Notify scrollbar, do not handle anything handled by scrollbar */
     if (guac_terminal_scrollbar_handle_mouse(term->scrollbar, x, y, mask)) {
@@ -1749,7 +1767,8 @@ static int __guac_terminal_send_mouse(guac_terminal* term, guac_user* user,
         /* Set pointer cursor if mouse is over scrollbar */
         if (term->current_cursor != GUAC_TERMINAL_CURSOR_POINTER) {
             term->current_cursor = GUAC_TERMINAL_CURSOR_POINTER;
-            guac_common_cursor_set_pointer(term->cursor);
+            guac_display_set_cursor(term->graphical_display,
+                    GUAC_DISPLAY_CURSOR_POINTER);
             guac_terminal_notify(term);
         }
 
@@ -1767,7 +1786,8 @@ static int __guac_terminal_send_mouse(guac_terminal* term, guac_user* user,
     /* Show mouse cursor if not already shown */
     if (term->current_cursor != GUAC_TERMINAL_CURSOR_IBAR) {
         term->current_cursor = GUAC_TERMINAL_CURSOR_IBAR;
-        guac_common_cursor_set_ibar(term->cursor);
+        guac_display_set_cursor(term->graphical_display,
+                GUAC_DISPLAY_CURSOR_IBAR);
         guac_terminal_notify(term);
     }
 
@@ -1849,6 +1869,10 @@ int guac_terminal_send_mouse(guac_terminal* term, guac_user* user,
     result = __guac_terminal_send_mouse(term, user, x, y, mask);
     guac_terminal_unlock(term);
 
+    /* Update mouse position for other users immediately if nothing else
+     * has changed */
+    guac_display_end_mouse_frame(term->graphical_display);
+
     return result;
 
 }
@@ -2078,15 +2102,9 @@ int guac_terminal_create_typescript(guac_terminal* term, const char* path,
 static void __guac_terminal_sync_socket(
         guac_client* client, guac_terminal* term, guac_socket* socket) {
 
-    /* Synchronize display state with new user */
-    guac_terminal_repaint_default_layer(term, socket);
-    guac_terminal_display_dup(term->display, client, socket);
-
-    /* Synchronize mouse cursor */
-    guac_common_cursor_dup(term->cursor, client, socket);
-
-    /* Paint scrollbar for joining users */
-    guac_terminal_scrollbar_dup(term->scrollbar, client, socket);
+    /* Synchronize display state, including the terminal text, scrollbar,
+     * and mouse cursor, with new users */
+    guac_display_dup(term->graphical_display, socket);
 
 }
 
@@ -2125,7 +2143,7 @@ void guac_terminal_apply_color_scheme(guac_terminal* terminal,
     display->default_background = default_char->attributes.background;
 
     /* Redraw terminal text and background */
-    guac_terminal_repaint_default_layer(terminal, client->socket);
+    guac_terminal_repaint_default_layer(terminal);
     __guac_terminal_redraw_rect(terminal, 0, 0,
             terminal->term_height - 1,
             terminal->term_width - 1);
@@ -2151,7 +2169,6 @@ const char* guac_terminal_get_color_scheme(guac_terminal* terminal) {
 void guac_terminal_apply_font(guac_terminal* terminal, const char* font_name,
         int font_size, int dpi) {
 
-    guac_client* client = terminal->client;
     guac_terminal_display* display = terminal->display;
 
     if (guac_terminal_display_set_font(display, font_name, font_size, dpi))
@@ -2163,7 +2180,7 @@ void guac_terminal_apply_font(guac_terminal* terminal, const char* font_name,
             terminal->outer_height);
 
     /* Redraw terminal text and background */
-    guac_terminal_repaint_default_layer(terminal, client->socket);
+    guac_terminal_repaint_default_layer(terminal);
     __guac_terminal_redraw_rect(terminal, 0, 0,
             terminal->term_height - 1,
             terminal->term_width - 1);
@@ -2230,5 +2247,5 @@ void guac_terminal_clipboard_append(guac_terminal* terminal,
 void guac_terminal_remove_user(guac_terminal* terminal, guac_user* user) {
 
     /* Remove the user from the terminal cursor */
-    guac_common_cursor_remove_user(terminal->cursor, user);
+    guac_display_notify_user_left(terminal->graphical_display, user);
 }
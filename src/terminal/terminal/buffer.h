@@ -35,6 +35,8 @@
 
 #include "types.h"
 
+#include <stddef.h>
+
 /**
  * A buffer containing a constant number of arbitrary-length rows.
  * New rows can be appended to the buffer, with the oldest row replaced with
@@ -44,7 +46,9 @@ typedef struct guac_terminal_buffer guac_terminal_buffer;
 
 /**
  * Allocates a new buffer having the given maximum number of rows. New character cells will
- * be initialized to the given character.
+ * be initialized to the given character. Storage for rows is allocated in
+ * chunks only as rows are used, such that a buffer with a large maximum
+ * number of rows is no more expensive to allocate than a small one.
  */
 guac_terminal_buffer* guac_terminal_buffer_alloc(int rows,
         const guac_terminal_char* default_character);
@@ -55,10 +59,9 @@ guac_terminal_buffer* guac_terminal_buffer_alloc(int rows,
 void guac_terminal_buffer_free(guac_terminal_buffer* buffer);
 
 /**
- * Resets the state of the given buffer such that it effectively no longer
- * contains any rows. Space for previous rows, including the data from those
- * previous rows, may still be maintained internally to avoid needing to
- * reallocate rows again later.
+ * Resets the state of the given buffer such that it no longer contains any
+ * rows. All memory used by previous rows is released, and rows are again
+ * allocated only as they are used.
  *
  * @param buffer
  *     The buffer to reset.
@@ -117,19 +120,31 @@ void guac_terminal_buffer_set_columns(guac_terminal_buffer* buffer, int row,
         int start_column, int end_column, guac_terminal_char* character);
 
 /**
- * Get the char (int ASCII code) at a specific row/col of the display.
+ * Retrieves the characters and wrapped state of the given row. Rows that have
+ * scrolled off screen may be stored in a compact form, in which case those
+ * rows are unpacked into storage owned by the buffer. The returned characters
+ * must be treated as read-only and are valid only until the next call to any
+ * guac_terminal_buffer function for the same buffer.
+ *
+ * @param buffer
+ *     The buffer containing the row.
  *
- * @param terminal
- *     The terminal on which we want to read a character.
+ * @param characters
+ *     A pointer to the pointer that should receive the characters of the
+ *     row, or NULL if the characters are not needed.
+ *
+ * @param is_wrapped
+ *     A pointer to the bool that should receive whether the row has been
+ *     wrapped, or NULL if the wrapped state is not needed.
  *
  * @param row
- *     The row where to read the character.
- * 
- * @param col
- *     The column where to read the character.
- * 
+ *     The index of the row to retrieve, where zero is the top-most row.
+ *     Negative indices represent rows in the scrollback buffer, above the
+ *     top-most row.
+ *
  * @return
- *     The ASCII code of the character at the given row/col.
+ *     The number of characters within the row, or zero if there is no such
+ *     row.
  */
 unsigned int guac_terminal_buffer_get_columns(guac_terminal_buffer* buffer,
         guac_terminal_char** characters, bool* is_wrapped, int row);
@@ -186,5 +201,17 @@ void guac_terminal_buffer_set_wrapped(guac_terminal_buffer* buffer, int row, boo
 void guac_terminal_buffer_set_cursor(guac_terminal_buffer* buffer, int row,
         int column, bool is_cursor);
 
+/**
+ * Returns the number of bytes of memory currently used to store the contents
+ * of the given buffer, including all rows of scrollback.
+ *
+ * @param buffer
+ *     The buffer whose memory usage should be determined.
+ *
+ * @return
+ *     The number of bytes of memory used by the given buffer.
+ */
+size_t guac_terminal_buffer_memory_usage(guac_terminal_buffer* buffer);
+
 #endif
 
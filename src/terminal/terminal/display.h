@@ -26,12 +26,11 @@
  * @file display.h
  */
 
-#include "common/surface.h"
 #include "palette.h"
 #include "types.h"
 
 #include <guacamole/client.h>
-#include <guacamole/layer.h>
+#include <guacamole/display.h>
 #include <pango/pangocairo.h>
 
 #include <stdbool.h>
@@ -186,19 +185,20 @@ typedef struct guac_terminal_display {
     guac_terminal_color glyph_background;
 
     /**
-     * The surface containing the actual terminal.
+     * The guac_display shared by all graphical elements of the terminal,
+     * through which all terminal rendering is ultimately performed.
      */
-    guac_common_surface* display_surface;
+    guac_display* graphical_display;
 
     /**
      * Layer which contains the actual terminal.
      */
-    guac_layer* display_layer;
+    guac_display_layer* display_layer;
 
     /**
      * Sub-layer of display layer which highlights selected text.
      */
-    guac_layer* select_layer;
+    guac_display_layer* select_layer;
 
     /**
      * Whether text is currently selected.
@@ -229,9 +229,12 @@ typedef struct guac_terminal_display {
 
 /**
  * Allocates a new display having the given default foreground and background
- * colors.
+ * colors. The terminal text and selection highlight are rendered to layers
+ * allocated from the given guac_display, with the layer containing the
+ * terminal text positioned within the default layer of that guac_display.
  */
 guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
+        guac_display* graphical_display,
         const char* font_name, int font_size, int dpi,
         guac_terminal_color* foreground, guac_terminal_color* background,
         guac_terminal_color (*palette)[256]);
@@ -317,29 +320,15 @@ void guac_terminal_display_set_columns(guac_terminal_display* display, int row,
 void guac_terminal_display_resize(guac_terminal_display* display, int width, int height);
 
 /**
- * Flushes all pending operations within the given guac_terminal_display.
+ * Flushes all pending operations within the given guac_terminal_display to the
+ * pending frame of its underlying guac_display. Rows which have been copied
+ * within the terminal are copied within the image buffer of the terminal
+ * layer, allowing the guac_display to send those changes as copies rather
+ * than as newly-encoded image data. The changes will not be sent to connected
+ * users until the frame is ended with guac_display_end_frame().
  */
 void guac_terminal_display_flush(guac_terminal_display* display);
 
-/**
- * Initializes and syncs the current terminal display state for all joining
- * users associated with the provided socket, sending the necessary instructions
- * to completely recreate and redraw the terminal rendering over the given
- * socket.
- *
- * @param display
- *     The terminal display to sync to the users associated with the provided
- *     socket.
- *
- * @param client
- *     The client whose users are joining.
- *
- * @param socket
- *     The socket over which any necessary instructions should be sent.
- */
-void guac_terminal_display_dup(
-        guac_terminal_display* display, guac_client* client, guac_socket* socket);
-
 /**
  * Draws the text selection rectangle from the given coordinates to the given end coordinates.
  */
@@ -27,7 +27,7 @@
  */
 
 #include <guacamole/client.h>
-#include <guacamole/layer.h>
+#include <guacamole/display.h>
 
 /**
  * The width of the scrollbar, in pixels.
@@ -118,10 +118,16 @@ struct guac_terminal_scrollbar {
      */
     guac_client* client;
 
+    /**
+     * The guac_display from which the layers of this scrollbar were
+     * allocated.
+     */
+    guac_display* graphical_display;
+
     /**
      * The layer containing the scrollbar.
      */
-    const guac_layer* parent;
+    const guac_display_layer* parent;
 
     /**
      * The width of the parent layer, in pixels.
@@ -136,13 +142,13 @@ struct guac_terminal_scrollbar {
     /**
      * The scrollbar itself.
      */
-    guac_layer* container;
+    guac_display_layer* container;
 
     /**
      * The draggable handle within the scrollbar, representing the current
      * scroll value.
      */
-    guac_layer* handle;
+    guac_display_layer* handle;
 
     /**
      * The minimum scroll value.
@@ -206,12 +212,13 @@ struct guac_terminal_scrollbar {
  * position of the scrollbar. Currently, the scrollbar is always anchored to
  * the right edge of the parent layer.
  *
- * This will cause instructions to be written to the client's socket, but the
- * client's socket will not be automatically flushed.
- *
  * @param client
  *     The client to associate with the new scrollbar.
  *
+ * @param graphical_display
+ *     The guac_display from which the layers of the scrollbar should be
+ *     allocated.
+ *
  * @param parent
  *     The layer which will contain the newly-allocated scrollbar.
  *
@@ -230,8 +237,8 @@ struct guac_terminal_scrollbar {
  *     A newly allocated scrollbar.
  */
 guac_terminal_scrollbar* guac_terminal_scrollbar_alloc(guac_client* client,
-        const guac_layer* parent, int parent_width, int parent_height,
-        int visible_area);
+        guac_display* graphical_display, const guac_display_layer* parent,
+        int parent_width, int parent_height, int visible_area);
 
 /**
  * Frees the given scrollbar.
@@ -242,35 +249,15 @@ guac_terminal_scrollbar* guac_terminal_scrollbar_alloc(guac_client* client,
 void guac_terminal_scrollbar_free(guac_terminal_scrollbar* scrollbar);
 
 /**
- * Flushes the render state of the given scrollbar, updating the remote display
- * accordingly.
- *
- * This may cause instructions to be written to the client's socket, but the
- * client's socket will not be automatically flushed.
+ * Flushes the render state of the given scrollbar, updating the pending frame
+ * of the associated guac_display accordingly. The changes will not be sent to
+ * connected users until that frame is ended.
  *
  * @param scrollbar
  *     The scrollbar whose render state is to be flushed.
  */
 void guac_terminal_scrollbar_flush(guac_terminal_scrollbar* scrollbar);
 
-/**
- * Forces a complete redraw / resync of scrollbar state for all joining users
- * associated with the provided socket, sending the necessary instructions to
- * completely recreate and redraw the scrollbar rendering over the given
- * socket.
- *
- * @param scrollbar
- *     The scrollbar to sync to the given users.
- *
- * @param client
- *     The client associated with the joining users.
- *
- * @param socket
- *     The socket over which any necessary instructions should be sent.
- */
-void guac_terminal_scrollbar_dup(guac_terminal_scrollbar* scrollbar,
-        guac_client* client, guac_socket* socket);
-
 /**
  * Sets the minimum and maximum allowed scroll values of the given scrollbar
  * to the given values. If necessary, the current value of the scrollbar will
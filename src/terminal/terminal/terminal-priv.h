@@ -21,13 +21,13 @@
 #define GUAC_TERMINAL_PRIV_H
 
 #include "common/clipboard.h"
-#include "common/cursor.h"
 #include "buffer.h"
 #include "display.h"
 #include "scrollbar.h"
 #include "terminal.h"
 #include "typescript.h"
 
+#include <guacamole/display.h>
 #include <guacamole/flag.h>
 
 /**
@@ -152,9 +152,11 @@ struct guac_terminal {
     guac_terminal_typescript* typescript;
 
     /**
-     * Terminal-wide mouse cursor, synchronized across all users.
+     * The guac_display to which all graphical elements of the terminal are
+     * rendered, including the terminal-wide mouse cursor. Frames of this
+     * display are encoded in parallel and synchronized across all users.
      */
-    guac_common_cursor* cursor;
+    guac_display* graphical_display;
 
     /**
      * Graphical representation of the current scroll state.
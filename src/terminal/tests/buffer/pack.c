@@ -0,0 +1,285 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "terminal/buffer.h"
+#include "terminal/types.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The number of rows within each buffer tested.
+ */
+#define TEST_BUFFER_ROWS 16
+
+/**
+ * The default character of each buffer tested.
+ */
+static const guac_terminal_char test_default_char = {
+    .value = 0,
+    .attributes = {
+        .foreground = { .palette_index = 7 },
+        .background = { .palette_index = 0 }
+    },
+    .width = 1
+};
+
+/**
+ * Asserts that the given characters are identical, including their
+ * attributes.
+ *
+ * @param expected
+ *     The character expected.
+ *
+ * @param actual
+ *     The character actually read from the buffer.
+ */
+static void assert_char_equal(const guac_terminal_char* expected,
+        const guac_terminal_char* actual) {
+
+    CU_ASSERT_EQUAL(actual->value, expected->value);
+    CU_ASSERT_EQUAL(actual->width, expected->width);
+
+    const guac_terminal_attributes* a = &expected->attributes;
+    const guac_terminal_attributes* b = &actual->attributes;
+
+    CU_ASSERT_EQUAL(b->bold, a->bold);
+    CU_ASSERT_EQUAL(b->half_bright, a->half_bright);
+    CU_ASSERT_EQUAL(b->cursor, a->cursor);
+    CU_ASSERT_EQUAL(b->reverse, a->reverse);
+    CU_ASSERT_EQUAL(b->underscore, a->underscore);
+
+    CU_ASSERT_EQUAL(b->foreground.palette_index, a->foreground.palette_index);
+    CU_ASSERT_EQUAL(b->foreground.red, a->foreground.red);
+    CU_ASSERT_EQUAL(b->foreground.green, a->foreground.green);
+    CU_ASSERT_EQUAL(b->foreground.blue, a->foreground.blue);
+
+    CU_ASSERT_EQUAL(b->background.palette_index, a->background.palette_index);
+    CU_ASSERT_EQUAL(b->background.red, a->background.red);
+    CU_ASSERT_EQUAL(b->background.green, a->background.green);
+    CU_ASSERT_EQUAL(b->background.blue, a->background.blue);
+
+}
+
+/**
+ * Writes the given character to the top row of the given buffer, starting
+ * at the given column. Characters wider than one column are followed by the
+ * continuation cells that the buffer adds automatically.
+ *
+ * @param buffer
+ *     The buffer to write to.
+ *
+ * @param column
+ *     The column at which the character should be written.
+ *
+ * @param character
+ *     The character to write.
+ *
+ * @return
+ *     The column immediately following the written character.
+ */
+static int write_char(guac_terminal_buffer* buffer, int column,
+        guac_terminal_char character) {
+
+    guac_terminal_buffer_set_columns(buffer, 0, column,
+            column + character.width - 1, &character);
+
+    return column + character.width;
+
+}
+
+/**
+ * Verifies that rows which scroll off screen, and are thus packed, read back
+ * exactly as written. The row written covers attribute changes, multi-byte
+ * UTF-8, wide characters and their continuation cells, values which are
+ * numerically equal to the marker bytes used within packed rows, and values
+ * and widths which cannot be stored as UTF-8 at all.
+ */
+void test_buffer__pack_roundtrip() {
+
+    guac_terminal_buffer* buffer = guac_terminal_buffer_alloc(TEST_BUFFER_ROWS,
+            &test_default_char);
+
+    guac_terminal_char current = test_default_char;
+    int column = 0;
+
+    /* Plain ASCII followed by a run of varied attributes */
+    current.value = 'a';
+    column = write_char(buffer, column, current);
+
+    current.value = 'b';
+    current.attributes.bold = true;
+    current.attributes.underscore = true;
+    column = write_char(buffer, column, current);
+
+    current.value = 'c';
+    current.attributes.reverse = true;
+    current.attributes.half_bright = true;
+    current.attributes.foreground = (guac_terminal_color) {
+        .palette_index = -1, .red = 0x12, .green = 0x34, .blue = 0x56
+    };
+    column = write_char(buffer, column, current);
+
+    current.attributes.background = (guac_terminal_color) {
+        .palette_index = 200, .red = 0xFD, .green = 0xFE, .blue = 0xFF
+    };
+
+    /* Multi-byte UTF-8 of every length */
+    current.value = 0xE9; /* LATIN SMALL LETTER E WITH ACUTE (2 bytes) */
+    column = write_char(buffer, column, current);
+
+    current.value = 0x20AC; /* EURO SIGN (3 bytes) */
+    column = write_char(buffer, column, current);
+
+    current.value = 0x1F600; /* GRINNING FACE (4 bytes) */
+    column = write_char(buffer, column, current);
+
+    /* Values equal to the marker bytes */
+    current.attributes = test_default_char.attributes;
+    for (int value = 0xFD; value <= 0xFF; value++) {
+        current.value = value;
+        column = write_char(buffer, column, current);
+    }
+
+    /* Wide characters followed by continuation cells */
+    current.value = 0x4E2D; /* CJK UNIFIED IDEOGRAPH-4E2D */
+    current.width = 2;
+    column = write_char(buffer, column, current);
+
+    current.value = 0xFF;
+    current.attributes.bold = true;
+    column = write_char(buffer, column, current);
+
+    /* Widths equal to the marker bytes */
+    for (int width = 0xFD; width <= 0xFF; width++) {
+        current.value = 'w';
+        current.width = width;
+        column = write_char(buffer, column, current);
+    }
+
+    /* Characters which cannot be stored as UTF-8 */
+    current.width = 1;
+    current.value = 0x110000;
+    column = write_char(buffer, column, current);
+
+    current.value = -2;
+    column = write_char(buffer, column, current);
+
+    /* Trailing default characters with differing attributes must not be
+     * dropped */
+    current = test_default_char;
+    current.attributes.reverse = true;
+    column = write_char(buffer, column, current);
+
+    /* Default characters trailing the row must be restored */
+    current = test_default_char;
+    column = write_char(buffer, column + 3, current);
+
+    /* Record the row as written */
+    guac_terminal_char* characters;
+    int length = guac_terminal_buffer_get_columns(buffer, &characters, NULL, 0);
+    CU_ASSERT_EQUAL_FATAL(length, column);
+
+    guac_terminal_char* expected = guac_mem_alloc(sizeof(guac_terminal_char), length);
+    for (int i = 0; i < length; i++)
+        expected[i] = characters[i];
+
+    /* Scroll the row off screen, packing it */
+    size_t unpacked_usage = guac_terminal_buffer_memory_usage(buffer);
+    guac_terminal_buffer_scroll_up(buffer, 1);
+    CU_ASSERT(guac_terminal_buffer_memory_usage(buffer) < unpacked_usage);
+
+    /* The packed row must read back exactly as written */
+    CU_ASSERT_EQUAL_FATAL(guac_terminal_buffer_get_columns(buffer, &characters,
+                NULL, -1), length);
+
+    for (int i = 0; i < length; i++)
+        assert_char_equal(&expected[i], &characters[i]);
+
+    /* The row must also be unpacked correctly if modified */
+    current.value = 'z';
+    guac_terminal_buffer_set_columns(buffer, -1, length - 1, length - 1, &current);
+    expected[length - 1] = current;
+
+    CU_ASSERT_EQUAL_FATAL(guac_terminal_buffer_get_columns(buffer, &characters,
+                NULL, -1), length);
+
+    for (int i = 0; i < length; i++)
+        assert_char_equal(&expected[i], &characters[i]);
+
+    guac_mem_free(expected);
+    guac_terminal_buffer_free(buffer);
+
+}
+
+/**
+ * Verifies that rows consisting entirely of the default character occupy no
+ * memory once scrolled off screen, and still read back as written.
+ */
+void test_buffer__pack_blank() {
+
+    guac_terminal_buffer* buffer = guac_terminal_buffer_alloc(TEST_BUFFER_ROWS,
+            &test_default_char);
+
+    /* An otherwise identical buffer whose top row was never written */
+    guac_terminal_buffer* unused = guac_terminal_buffer_alloc(TEST_BUFFER_ROWS,
+            &test_default_char);
+    guac_terminal_buffer_get_columns(unused, NULL, NULL, 0);
+
+    guac_terminal_char blank = test_default_char;
+    guac_terminal_buffer_set_columns(buffer, 0, 0, 79, &blank);
+    guac_terminal_buffer_scroll_up(buffer, 1);
+
+    CU_ASSERT_EQUAL(guac_terminal_buffer_memory_usage(buffer),
+            guac_terminal_buffer_memory_usage(unused));
+
+    guac_terminal_char* characters;
+    CU_ASSERT_EQUAL_FATAL(guac_terminal_buffer_get_columns(buffer, &characters,
+                NULL, -1), 80);
+
+    for (int i = 0; i < 80; i++)
+        assert_char_equal(&test_default_char, &characters[i]);
+
+    /* The blank row must be restored if modified */
+    guac_terminal_char modified = test_default_char;
+    modified.value = 'm';
+    guac_terminal_buffer_set_columns(buffer, -1, 40, 40, &modified);
+
+    CU_ASSERT_EQUAL_FATAL(guac_terminal_buffer_get_columns(buffer, &characters,
+                NULL, -1), 80);
+
+    for (int i = 0; i < 80; i++)
+        assert_char_equal(i == 40 ? &modified : &test_default_char,
+                &characters[i]);
+
+    /* Setting the cursor within a blank row must also restore that row */
+    guac_terminal_buffer_set_columns(buffer, 0, 0, 79, &blank);
+    guac_terminal_buffer_scroll_up(buffer, 1);
+    guac_terminal_buffer_set_cursor(buffer, -1, 10, true);
+
+    CU_ASSERT_EQUAL_FATAL(guac_terminal_buffer_get_columns(buffer, &characters,
+                NULL, -1), 80);
+    CU_ASSERT_TRUE(characters[10].attributes.cursor);
+
+    guac_terminal_buffer_free(unused);
+    guac_terminal_buffer_free(buffer);
+
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env perl
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+#
+# compare-bench-results.pl
+#
+# Compares two sets of benchmark results, as produced by "make bench", and
+# prints the relative change of each metric present in both. Each line of
+# the given files must consist of the following tab-separated values:
+#
+#     BENCHMARK	METRIC	VALUE	UNIT
+#
+# Lines beginning with "#" are ignored. The unit of each metric declares
+# which direction of change is for the worse:
+#
+#     */s      Throughput, for which larger values are better.
+#     count    A count describing the work done, such as the number of
+#              operations in a display plan, which is neither better nor worse
+#              and is never marked as a regression.
+#     (other)  A cost, such as time or size, for which smaller values are
+#              better.
+#
+# Changes for the worse which exceed the given threshold percentage (5% by
+# default) are marked as regressions.
+#
+# Usage: compare-bench-results.pl OLD_RESULTS NEW_RESULTS [THRESHOLD]
+#
+
+use strict;
+
+#
+# Reads the benchmark results within the given file, returning a reference to
+# a hash of each "BENCHMARK\tMETRIC" pair to its value and unit, along with a
+# reference to an array of those pairs in the order read.
+#
+sub read_results {
+
+    my $filename = shift;
+    my %results;
+    my @order;
+
+    open(my $file, '<', $filename) or die "$filename: $!\n";
+    while (my $line = <$file>) {
+
+        chomp $line;
+        next if $line =~ /^#/ || $line eq '';
+
+        my ($benchmark, $metric, $value, $unit) = split /\t/, $line;
+        next unless defined $unit;
+
+        my $key = "$benchmark\t$metric";
+        push @order, $key unless exists $results{$key};
+        $results{$key} = { value => $value, unit => $unit };
+
+    }
+    close $file;
+
+    return (\%results, \@order);
+
+}
+
+#
+# Returns the direction in which a metric having the given unit changes for
+# the worse: 1 if larger values are worse, -1 if smaller values are worse, or
+# 0 if the metric is purely descriptive and can never regress.
+#
+sub metric_direction {
+
+    my $unit = shift;
+
+    return -1 if $unit =~ m{/s$};
+    return 0 if $unit eq 'count';
+    return 1;
+
+}
+
+die "Usage: $0 OLD_RESULTS NEW_RESULTS [THRESHOLD]\n" if @ARGV < 2;
+
+my ($old, undef) = read_results($ARGV[0]);
+my ($new, $order) = read_results($ARGV[1]);
+my $threshold = $ARGV[2] // 5;
+
+for my $key (@$order) {
+
+    next unless exists $old->{$key};
+
+    my $before = $old->{$key}{value};
+    my $after = $new->{$key}{value};
+    my $unit = $new->{$key}{unit};
+
+    my $change = $before != 0 ? ($after - $before) * 100.0 / $before : 0;
+
+    my $worse = metric_direction($unit) * $change;
+
+    printf "%s\t%s\t%s\t%+.1f%%%s\n", $key, $before, $after, $change,
+        $worse > $threshold ? "\tREGRESSION" : "";
+
+}
@@ -0,0 +1,122 @@
+#!/usr/bin/env perl
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+#
+# guac-trace-to-json.pl
+#
+# Converts render pipeline traces, as written by guac_trace_dump() (and thus
+# by guacd upon receiving SIGUSR1 if "trace_dir" is set in guacd.conf), to
+# the JSON trace event format understood by Chrome's trace viewer
+# (chrome://tracing) and Perfetto. Each given trace is represented as a
+# separate process named after its file, and each thread within that trace is
+# numbered in the order it first appears. The JSON is written to STDOUT.
+#
+# Traces must be converted on a system with the same byte order as the system
+# that produced them.
+#
+# Usage: guac-trace-to-json.pl TRACE [TRACE...]
+#
+
+use strict;
+
+# Size of each fixed-length structure within a trace, in bytes
+my $HEADER_SIZE = 16;
+my $NAME_LENGTH = 32;
+my $EVENT_SIZE  = 32;
+
+#
+# Reads exactly the given number of bytes from the given file, dying if the
+# file ends early.
+#
+sub read_exactly {
+
+    my ($file, $filename, $length) = @_;
+
+    my $buffer = '';
+    while (length($buffer) < $length) {
+        my $read = read($file, $buffer, $length - length($buffer),
+                length($buffer));
+        die "$filename: $!\n" unless defined $read;
+        die "$filename: Trace is truncated\n" if $read == 0;
+    }
+
+    return $buffer;
+
+}
+
+#
+# Escapes the given string for inclusion within a JSON string literal.
+#
+sub json_string {
+    my $value = shift;
+    $value =~ s/(["\\])/\\$1/g;
+    $value =~ s/([\x00-\x1F])/sprintf("\\u%04x", ord($1))/ge;
+    return "\"$value\"";
+}
+
+die "Usage: $0 TRACE [TRACE...]\n" if @ARGV < 1;
+
+my @events;
+my $pid = 0;
+
+for my $filename (@ARGV) {
+
+    $pid++;
+
+    open(my $file, '<:raw', $filename) or die "$filename: $!\n";
+
+    my ($magic, $types, $count) = unpack('a8 L L',
+            read_exactly($file, $filename, $HEADER_SIZE));
+    die "$filename: Not a render pipeline trace\n" if $magic ne 'GUACTRC1';
+
+    my @names = map { unpack('Z*', $_) }
+        unpack("(a$NAME_LENGTH)$types",
+            read_exactly($file, $filename, $types * $NAME_LENGTH));
+
+    push @events, sprintf('{"name":"process_name","ph":"M","pid":%d,'
+            . '"args":{"name":%s}}', $pid, json_string($filename));
+
+    my %tids;
+    for (my $i = 0; $i < $count; $i++) {
+
+        my ($start, $thread, $duration, $type, $arg) = unpack('Q Q L L L',
+                read_exactly($file, $filename, $EVENT_SIZE));
+
+        # Number threads in order of appearance
+        my $tid = $tids{$thread};
+        if (!defined $tid) {
+            $tid = $tids{$thread} = keys(%tids) + 1;
+            push @events, sprintf('{"name":"thread_name","ph":"M","pid":%d,'
+                    . '"tid":%d,"args":{"name":"thread %d"}}',
+                    $pid, $tid, $tid);
+        }
+
+        my $name = $type < $types ? $names[$type] : "unknown_$type";
+        push @events, sprintf('{"name":%s,"ph":"X","ts":%s,"dur":%d,'
+                . '"pid":%d,"tid":%d,"args":{"arg":%d}}',
+                json_string($name), $start, $duration, $pid, $tid, $arg);
+
+    }
+
+    close $file;
+
+}
+
+print "{\"traceEvents\":[\n", join(",\n", @events), "\n]}\n";
+